@@ -100,10 +100,24 @@ namespace MMS {
     ERROR_T_ENTRY(LISTENER_TERMINATE_THREAD, "Listener will stop loop hence terminate the thread. All allocation must be RAII for this to be successful.") \
     \
     ERROR_T_ENTRY(HPACK_TABLE_OUT_OF_RANGE, "HPACK table index out of range") \
+    ERROR_T_ENTRY(HPACK_INTEGER_OVERFLOW, "HPACK integer is truncated or too large") \
+    ERROR_T_ENTRY(HPACK_HUFFMAN_DECODE_FAILED, "HPACK Huffman string has invalid padding or EOS") \
+    ERROR_T_ENTRY(HPACK_TABLE_SIZE_UPDATE_FAILED, "HPACK table size update is over SETTINGS_HEADER_TABLE_SIZE") \
+    \
+    ERROR_T_ENTRY(QPACK_DECOMPRESSION_FAILED, "QPACK failed to decompress field section") \
+    ERROR_T_ENTRY(QPACK_ENCODER_STREAM_ERROR, "QPACK failed to interpret encoder instruction") \
+    ERROR_T_ENTRY(QPACK_DECODER_STREAM_ERROR, "QPACK failed to interpret decoder instruction") \
     \
     ERROR_T_ENTRY(HTTP2_HPACK_TABLE_ERROR, "HTTP 2 HPACK internal error") \
     ERROR_T_ENTRY(HTTP2_INITIATE_GOAWAY, "HTTP 2 goaway initiated") \
     \
+    ERROR_T_ENTRY(HTTP3_FRAME_ERROR, "HTTP 3 frame is malformed") \
+    ERROR_T_ENTRY(HTTP3_FRAME_UNEXPECTED, "HTTP 3 frame is not permitted on this stream") \
+    ERROR_T_ENTRY(HTTP3_MISSING_SETTINGS, "HTTP 3 control stream did not start with SETTINGS") \
+    ERROR_T_ENTRY(HTTP3_SETTINGS_ERROR, "HTTP 3 SETTINGS frame is invalid") \
+    ERROR_T_ENTRY(HTTP3_STREAM_CREATION_ERROR, "HTTP 3 critical stream is opened more than once") \
+    ERROR_T_ENTRY(HTTP3_CLOSED_CRITICAL_STREAM, "HTTP 3 critical stream is closed") \
+    \
     ERROR_T_ENTRY(SSL_CONNECT_FAILED, "Failed to create SSL session") \
     ERROR_T_ENTRY(SSL_SESSION_NULL, "SSL session in NULL") \
     ERROR_T_ENTRY(CRYPTO_MEMORY_BAD_ASSIGNMENT, "Assigning to non null memory, make sure to free it first") \
@@ -125,6 +139,9 @@ namespace MMS {
     ERROR_T_ENTRY(HTTP11_PARSER_FAILURE, "HTTP 1.1 parser failed") \
     \
     ERROR_T_ENTRY(QUIC_ENCODE_INTEGER_FAILED, "Quick unable to encode given integer value") \
+    ERROR_T_ENTRY(QUIC_PACKET_MALFORMED, "QUIC packet header is malformed") \
+    ERROR_T_ENTRY(QUIC_VERSION_UNSUPPORTED, "QUIC packet version is not supported") \
+    ERROR_T_ENTRY(QUIC_CONNECTION_TABLE_FULL, "QUIC connection ID routing table is full") \
     \
     ERROR_T_ENTRY(NOT_FOUND, "Not Found") \
     \
@@ -398,4 +415,14 @@ public:
     using HTTPException::HTTPException;
 };
 
+class QPACKException : public HTTPException {
+public:
+    using HTTPException::HTTPException;
+};
+
+class HTTP3Exception : public HTTPException {
+public:
+    using HTTPException::HTTPException;
+};
+
 } // namespace MMS
\ No newline at end of file
@@ -18,7 +18,9 @@
 #pragma once
 #include <mms/base/error.h>
 #include <charconv>
+#include <string_view>
 #include <concepts>
+#include <memory>
 #include <type_traits>
 
 namespace MMS {
@@ -134,6 +136,8 @@ public:
             } else static_assert(false, "Unsupported type");
         } else if constexpr (std::is_same_v<ValueType, std::string>) {
             Copy(value);
+        } else if constexpr (std::is_same_v<ValueType, std::string_view>) {
+            Copy(value.data(), value.size());
         } else static_assert(false, "Unsupported type");
     }
 
@@ -331,6 +335,18 @@ public:
     constexpr inline uint8_t *GetCurrAndIncrease(const size_t len) override { CheckResize(len); auto temp = _curr; _curr += len; return temp; }
     constexpr inline const uint8_t *GetCurrAndIncrease(const size_t len) const override { auto temp = _curr; _curr += len; CheckOverflow(); return temp; }
 
+    // Doubles buffer, returns false once buffer is at MaxReadBuffer
+    bool Grow() {
+        auto new_capacity = capacity() * 2;
+        if (new_capacity > limits->MaxReadBuffer) return false;
+        auto curr_index = index();
+        _begin = reinterpret_cast<uint8_t *>(realloc(reinterpret_cast<void *>(_begin), new_capacity));
+        if (_begin == nullptr) throw MemoryAllocationException { };
+        _end = _begin + new_capacity;
+        _curr = _begin + curr_index;
+        return true;
+    }
+
     auto ReturnOldAndAlloc() { 
         FullStream stream { _begin, _end, _curr };
         _begin = reinterpret_cast<uint8_t *>(malloc(limits->MinReadBuffer));
@@ -344,14 +360,18 @@ public:
 class FixedBuffer {
     uint8_t *_begin;
     uint8_t *_end;
+    // Buffer refers to memory kept by owner, it is not freed here
+    std::shared_ptr<const void> owner { };
 
 public:
     FixedBuffer(auto *_begin, auto *_end) : _begin { reinterpret_cast<uint8_t *>(_begin) }, _end { reinterpret_cast<uint8_t *>(_end) } { }
     FixedBuffer(auto *_begin, size_t size) : _begin { reinterpret_cast<uint8_t *>(_begin) }, _end { reinterpret_cast<uint8_t *>(_begin) + size } { }
-    FixedBuffer(FixedBuffer &&buffer) : _begin { buffer._begin }, _end { buffer._end } { buffer._begin = buffer._end = nullptr;}
+    FixedBuffer(const void *_begin, size_t size, std::shared_ptr<const void> owner)
+        : _begin { reinterpret_cast<uint8_t *>(const_cast<void *>(_begin)) }, _end { this->_begin + size }, owner { std::move(owner) } { }
+    FixedBuffer(FixedBuffer &&buffer) : _begin { buffer._begin }, _end { buffer._end }, owner { std::move(buffer.owner) } { buffer._begin = buffer._end = nullptr;}
     FixedBuffer(FullStream &&stream) : _begin { stream._begin }, _end { stream._curr } { stream._begin = stream._curr = stream._end = nullptr;}
     FixedBuffer(const FixedBuffer &) = delete;
-    ~FixedBuffer() { if (_begin) free(_begin); }
+    ~FixedBuffer() { if (_begin && !owner) free(_begin); }
 
     FixedBuffer &operator=(const FixedBuffer &) = delete;
 
@@ -387,11 +407,11 @@ constexpr inline Stream make_stream(std::string &string) { return Stream { strin
 
 template <typename ChT> constexpr inline const Stream make_const_stream(const ChT *begin, const ChT *end) { return Stream { const_cast<ChT *>(begin), const_cast<ChT *>(end) }; }
 template <typename ChT> constexpr inline const Stream make_const_stream(const ChT *begin, size_t size) { return Stream { const_cast<ChT *>(begin), size }; }
-constexpr inline const Stream make_const_stream(const std::string &string) { return Stream { const_cast<char *>(string.data()), string.size() }; }
+constexpr inline const Stream make_const_stream(const std::string_view string) { return Stream { const_cast<char *>(string.data()), string.size() }; }
 
 template <typename ChT> constexpr inline const FullStream make_const_fullstream(const ChT *begin, const ChT *end) { return FullStream { const_cast<ChT *>(begin), const_cast<ChT *>(end) }; }
 template <typename ChT> constexpr inline const FullStream make_const_fullstream(const ChT *begin, size_t size) { return FullStream { const_cast<ChT *>(begin), size }; }
-constexpr inline const FullStream make_const_fullstream(const std::string &string) { return FullStream { const_cast<char *>(string.data()), string.size() }; }
+constexpr inline const FullStream make_const_fullstream(const std::string_view string) { return FullStream { const_cast<char *>(string.data()), string.size() }; }
 template <typename ChT> constexpr inline const FullStream make_const_fullstream(const ChT *begin, const ChT *end, const ChT *curr) { return FullStream { const_cast<ChT *>(begin), const_cast<ChT *>(end), const_cast<ChT *>(curr) }; }
 
 } // namespace MMS
\ No newline at end of file
@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace MMS {
+
+// Perfect hash map for fixed string keys, it is built at compile time.
+// Key is hashed once and compared with only one entry, there is no allocation in lookup.
+// Hash and displace: key goes to a bucket, displacement of bucket moves all its keys to free slots.
+template <typename value_t, size_t count, bool case_insensitive = false>
+class perfecthashmap {
+public:
+    using entry_t = std::pair<std::string_view, value_t>;
+    static constexpr size_t slot_count = std::bit_ceil(count * 2);
+    static constexpr size_t bucket_count = count / 4 + 1;
+
+private:
+    static constexpr size_t slot_mask = slot_count - 1;
+
+    std::array<entry_t, count> entries;
+    uint64_t seed { 0 };
+    std::array<uint32_t, bucket_count> displacement { };
+    // Entry index + 1, 0 is empty slot
+    std::array<uint16_t, slot_count> slots { };
+
+    static constexpr uint8_t normalize(const char ch) {
+        if constexpr (case_insensitive) {
+            if (ch >= 'A' && ch <= 'Z') return static_cast<uint8_t>(ch | 0x20);
+        }
+        return static_cast<uint8_t>(ch);
+    }
+
+    // Hash is only for distributing keys, hence case is folded by setting 0x20 bit in all characters
+    static constexpr uint64_t fold = case_insensitive ? 0x2020202020202020ULL : 0;
+    static constexpr uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+
+    // Little endian word from characters
+    static constexpr uint64_t load(const char *data, const size_t size) {
+        uint64_t word { 0 };
+        for(size_t index { 0 }; index < size; ++index) {
+            word |= static_cast<uint64_t>(static_cast<uint8_t>(data[index])) << (index * 8);
+        }
+        return word;
+    }
+
+    static constexpr uint64_t load8(const char *data) {
+        if !consteval {
+            if constexpr (std::endian::native == std::endian::little) {
+                uint64_t word;
+                std::memcpy(&word, data, sizeof(word));
+                return word;
+            }
+        }
+        return load(data, 8);
+    }
+
+    // Eight characters at a time
+    static constexpr uint64_t hash(const std::string_view key, const uint64_t seed) {
+        uint64_t value { seed ^ (key.size() * multiplier) };
+        size_t index { 0 };
+        for(; index + 8 <= key.size(); index += 8) {
+            value = (value ^ (load8(key.data() + index) | fold)) * multiplier;
+            value ^= value >> 32;
+        }
+        value = (value ^ (load(key.data() + index, key.size() - index) | fold)) * multiplier;
+        value ^= value >> 29;
+        return value;
+    }
+
+    static constexpr bool equal(const std::string_view lhs, const std::string_view rhs) {
+        if (lhs.size() != rhs.size()) return false;
+        for(size_t index { 0 }; index < lhs.size(); ++index) {
+            if (normalize(lhs[index]) != normalize(rhs[index])) return false;
+        }
+        return true;
+    }
+
+    static constexpr size_t get_bucket(const uint64_t value) { return static_cast<size_t>(value >> 32) % bucket_count; }
+    static constexpr size_t get_slot(const uint64_t value, const uint32_t displacement) { return (static_cast<uint32_t>(value) ^ displacement) & slot_mask; }
+
+    constexpr bool build() {
+        std::array<uint64_t, count> hashes { };
+        std::array<size_t, bucket_count + 1> bucket_start { };
+        for(size_t index { 0 }; index < count; ++index) {
+            hashes[index] = hash(entries[index].first, seed);
+            ++bucket_start[get_bucket(hashes[index]) + 1];
+        }
+        for(size_t bucket { 0 }; bucket < bucket_count; ++bucket) bucket_start[bucket + 1] += bucket_start[bucket];
+
+        // Entries grouped by bucket
+        std::array<size_t, count> members { };
+        auto fill = bucket_start;
+        for(size_t index { 0 }; index < count; ++index) members[fill[get_bucket(hashes[index])]++] = index;
+
+        // Largest bucket is placed first
+        auto bucket_size = [&bucket_start](const size_t bucket) { return bucket_start[bucket + 1] - bucket_start[bucket]; };
+        std::array<size_t, bucket_count> order { };
+        for(size_t bucket { 0 }; bucket < bucket_count; ++bucket) order[bucket] = bucket;
+        for(size_t index { 1 }; index < bucket_count; ++index) {
+            for(size_t pos { index }; pos > 0 && bucket_size(order[pos - 1]) < bucket_size(order[pos]); --pos) {
+                std::swap(order[pos - 1], order[pos]);
+            }
+        }
+
+        slots = { };
+        displacement = { };
+        for(const auto bucket: order) {
+            const auto first = bucket_start[bucket];
+            const auto last = bucket_start[bucket + 1];
+            if (first == last) break;
+            bool placed { false };
+            for(uint32_t trial { 0 }; trial < slot_count && !placed; ++trial) {
+                auto member = first;
+                for(; member < last; ++member) {
+                    const auto slot = get_slot(hashes[members[member]], trial);
+                    if (slots[slot] != 0) break;
+                    slots[slot] = static_cast<uint16_t>(members[member] + 1);
+                }
+                placed = member == last;
+                if (placed) {
+                    displacement[bucket] = trial;
+                } else {
+                    // Undo partial placement
+                    for(auto undo = first; undo < member; ++undo) slots[get_slot(hashes[members[undo]], trial)] = 0;
+                }
+            }
+            if (!placed) return false;
+        }
+        return true;
+    }
+
+public:
+    constexpr perfecthashmap(const std::array<entry_t, count> &entries) : entries { entries } {
+        while(!build()) ++seed;
+    }
+
+    constexpr const value_t *find(const std::string_view key) const {
+        const auto value = hash(key, seed);
+        const auto index = slots[get_slot(value, displacement[get_bucket(value)])];
+        if (index == 0) return nullptr;
+        const auto &entry = entries[index - 1];
+        if (!equal(entry.first, key)) return nullptr;
+        return &entry.second;
+    }
+
+    constexpr value_t find(const std::string_view key, const value_t notfound) const {
+        const auto value = find(key);
+        return value ? *value : notfound;
+    }
+};
+
+} // namespace MMS
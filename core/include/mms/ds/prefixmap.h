@@ -104,8 +104,10 @@ public:
         current->value = std::move(value);
     }
 
-    /*! Search will return value for largest prefix match */
-    auto &search(const stringtype &key, stringtype &newkey) const {
+    /*! Search will return value for largest prefix match
+     *  Key can be string view of stringtype to avoid copy */
+    template <typename keytype>
+    auto &search(const keytype &key, stringtype &newkey) const {
         size_t index { 0 };
         auto current = &root;
         decltype(current) prev = nullptr;
@@ -125,8 +127,8 @@ public:
                 }
                 break;
             }
-            auto childitr = current->children.find(key[index]);
             if (index == key.size()) return current->value;
+            auto childitr = current->children.find(key[index]);
             if (childitr == std::end(current->children)) {
                 newkey = key.substr(index, key.size() - index);
                 return current->value;
@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace MMS {
+
+// Vector with first N items inside object, heap is used only when more items are added.
+// Once spilled all items are moved to heap, hence items are always contiguous.
+template <typename T, size_t N>
+class smallvector {
+private:
+    std::array<T, N> inline_items { };
+    std::vector<T> spill_items { };
+    size_t count { 0 };
+
+public:
+    static constexpr size_t inline_count = N;
+
+    constexpr smallvector() { }
+    constexpr smallvector(const smallvector &) = default;
+    constexpr smallvector &operator=(const smallvector &) = default;
+    constexpr smallvector(smallvector &&other)
+        : inline_items { other.inline_items }, spill_items { std::move(other.spill_items) }, count { std::exchange(other.count, 0) } { }
+    constexpr smallvector &operator=(smallvector &&other) {
+        inline_items = other.inline_items;
+        spill_items = std::move(other.spill_items);
+        other.spill_items.clear();
+        count = std::exchange(other.count, 0);
+        return *this;
+    }
+
+    constexpr T *data() { return spill_items.empty() ? inline_items.data() : spill_items.data(); }
+    constexpr const T *data() const { return spill_items.empty() ? inline_items.data() : spill_items.data(); }
+
+    constexpr T *begin() { return data(); }
+    constexpr T *end() { return data() + count; }
+    constexpr const T *begin() const { return data(); }
+    constexpr const T *end() const { return data() + count; }
+
+    constexpr size_t size() const { return count; }
+    constexpr bool empty() const { return count == 0; }
+    constexpr bool spilled() const { return !spill_items.empty(); }
+
+    constexpr T &operator[](const size_t index) { return data()[index]; }
+    constexpr const T &operator[](const size_t index) const { return data()[index]; }
+
+    constexpr void push_back(const T &item) {
+        if (spill_items.empty()) {
+            if (count < N) {
+                inline_items[count++] = item;
+                return;
+            }
+            spill_items.reserve(N * 2);
+            spill_items.assign(inline_items.begin(), inline_items.end());
+        }
+        spill_items.push_back(item);
+        ++count;
+    }
+
+    constexpr void clear() {
+        spill_items.clear();
+        count = 0;
+    }
+}; // class smallvector
+
+} // namespace MMS
@@ -19,12 +19,16 @@
 #include <mms/base/stream.h>
 #include <sys/epoll.h>
 #include <thread>
+#include <mutex>
 #include <mms/base/error.h>
 #include <mms/base/types.h>
 #include <mms/log/log.h>
 #include <mms/lockfree/fixedqueue.h>
 #include <unordered_set>
+#include <deque>
+#include <vector>
 #include <typeinfo>
+#include <utility>
 
 namespace MMS::listener {
 using namespace std::chrono_literals;
@@ -36,6 +40,9 @@ public:
     // All buffer must be created using malloc
     virtual void WriteNoCopy(FixedBuffer &&) { };
 
+    // Connection is closed once all pending buffers are written
+    virtual void CloseAfterWrite() { };
+
     inline void Write(const std::string &buffer) {
         auto newbuffer = reinterpret_cast<char *>(malloc(buffer.size()));
         std::copy(std::begin(buffer), std::end(buffer), newbuffer);
@@ -64,10 +71,31 @@ class listener_t;
 
 class processor_t : public writer_t {
     int fd;
+    listener_t *listener { nullptr };
+    // Read event is not enabled while paused, peer is held back by TCP window
+    std::atomic<bool> read_paused { false };
+    // Below are guarded by event_lock
+    // Listener thread is processing event for this, listener enables it once done
+    bool in_event { false };
+    // Event received by other thread while in_event, it is enabled again at end of event
+    bool missed_event { false };
+    // Notify from other thread, it is taken with next event
+    bool notified { false };
+    // Waiting in listener notify queue
+    bool queued { false };
+    // Removed from listener, late notify and stale epoll event are ignored
+    bool deleted { false };
+    std::mutex event_lock { };
+
+    // event_lock must be held
+    void Wake();
+
 protected:
     friend class listener_t;
 
     processor_t(int fd) : fd { fd } { }
+    processor_t(const processor_t &) = delete;
+    processor_t &operator=(const processor_t &) = delete;
 
     static streamlimit_t readlimits;
 
@@ -90,11 +118,24 @@ public:
     virtual err_t ProcessWrite() { return err_t::SUCCESS; }
 
     void Close() {
-        ::close(fd);
-        fd = 0;
+        if (fd) {
+            ::close(fd);
+            fd = 0;
+        }
     }
 
     auto GetAndRenewReadBuffer() { return readbuffer.ReturnOldAndAlloc(); }
+
+    // Backpressure, read remaining data is kept in socket till ResumeRead is called
+    void PauseRead() { read_paused = true; }
+    // This must be called from listener thread
+    void ResumeRead();
+    bool IsReadPaused() const { return read_paused; }
+
+    // This can be called from any thread, listener calls ProcessNotify in its thread with next event
+    void Notify();
+    // Work completed by other thread is taken here, it is called before ProcessRead and ProcessWrite
+    virtual void ProcessNotify() { }
 };
 
 class terminate_t : public processor_t {
@@ -105,6 +146,21 @@ public:
     void StopListenerThread(bool from_listener);
 }; // terminate_t
 
+/*! Processor waiting for enable from other thread is queued here,
+ * listener thread enables it when eventfd is read. Other thread never calls epoll_ctl.
+*/
+class notifier_t : public processor_t {
+    listener_t &listener;
+    std::mutex queue_lock { };
+    std::vector<processor_t *> queue { };
+public:
+    notifier_t(listener_t &listener);
+    // event_lock of processor must be held
+    void Push(processor_t *processor);
+    void Erase(processor_t *processor);
+    err_t ProcessRead() override;
+}; // notifier_t
+
 class thread_stopper_t : public processor_t {
 public:
     thread_stopper_t();
@@ -120,6 +176,8 @@ public:
 
 private:
     friend class terminate_t;
+    friend class notifier_t;
+    friend class processor_t;
     size_t threadcount;
     std::atomic<size_t> running_thread { 0 };
 
@@ -137,6 +195,19 @@ private:
     void init_log_thread(const std::filesystem::path &filename);
 
     terminate_t terminatehandler;
+    notifier_t notifier;
+
+    // Deleted processor may still be in epoll event array of other thread.
+    // It is freed once every thread has started epoll_wait again, that is seen epoch is past retire epoch.
+    std::mutex retire_lock { };
+    std::atomic<uint64_t> epoch { 0 };
+    std::atomic<size_t> retired_count { 0 };
+    std::vector<std::pair<uint64_t, processor_t *>> retired { };
+    std::deque<std::atomic<uint64_t>> seen_epochs { };
+
+    std::atomic<uint64_t> &AddThreadEpoch();
+    void Retire(processor_t *processor);
+    void Reclaim(std::atomic<uint64_t> &seen_epoch);
 
     static bool created;
 
@@ -144,9 +215,34 @@ private:
     std::unordered_set<processor_t *> active_processors { };
 #endif
 
+    // Must be called by thread in event of processor
     void Delete(processor_t *processor) {
+        {
+            std::lock_guard guard { processor->event_lock };
+            processor->deleted = true;
+            if (processor->queued) notifier.Erase(processor);
+        }
         remove(processor);
-        delete processor;
+        // Peer must not wait for close till processor is freed
+        processor->Close();
+        Retire(processor);
+    }
+
+    // Write event is enabled as well if processor is notified while event is processed
+    void EndEvent(processor_t *processor, bool enablewrite) {
+        std::lock_guard guard { processor->event_lock };
+        processor->in_event = false;
+        enablewrite = enablewrite || processor->notified || std::exchange(processor->missed_event, false);
+        enable(processor, enablewrite);
+    }
+
+    // Called from notifier in listener thread
+    void EnableQueued(processor_t *processor) {
+        std::lock_guard guard { processor->event_lock };
+        processor->queued = false;
+        // Thread in event enables it at end of event
+        if (processor->deleted || processor->in_event) return;
+        enable(processor, true);
     }
 
 public:
@@ -155,6 +251,7 @@ public:
 
     err_t add(processor_t *processor) {
         const auto fd = processor->GetFD();
+        processor->listener = this;
         epoll_event epoll_data { EPOLLIN | EPOLLONESHOT | EPOLLRDHUP, { reinterpret_cast<void *>(processor) } };
         auto ret = epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &epoll_data);
 
@@ -172,7 +269,8 @@ public:
 
     err_t enable(processor_t *processor, bool enablewrite) const {
         const auto fd = processor->GetFD();
-        epoll_event epoll_data { EPOLLIN | EPOLLONESHOT | EPOLLRDHUP, { reinterpret_cast<void *>(processor) } };
+        epoll_event epoll_data { EPOLLONESHOT | EPOLLRDHUP, { reinterpret_cast<void *>(processor) } };
+        if (!processor->read_paused) epoll_data.events |= EPOLLIN;
         if (enablewrite) epoll_data.events |= EPOLLOUT;
         auto ret = epoll_ctl(epollfd, EPOLL_CTL_MOD, fd, &epoll_data);
 
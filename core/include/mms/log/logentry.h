@@ -72,6 +72,7 @@ namespace MMS {
     LOGGER_MODULE_ENTRY(LISTENER) \
     LOGGER_MODULE_ENTRY(TCP_SERVER) \
     LOGGER_MODULE_ENTRY(HTTPSERVER) \
+    LOGGER_MODULE_ENTRY(QUIC) \
     LOGGER_MODULE_ENTRY(TEST) \
     LOGGER_MODULE_ENTRY(MAX_MODULE) \
     LOGGER_MODULE_ENTRY(UNKNOWN) \
@@ -134,6 +135,12 @@ namespace MMS {
     LOGGER_ENTRY(TCP_CONNECTION_READ, DEBUG, TCP_SERVER, "FD %i: TCP read %lu bytes") \
     LOGGER_ENTRY(UDP_CONNECTION_EMPTY_READ, DEBUG, TCP_SERVER, "FD %i: UDP empty read") \
     LOGGER_ENTRY(UDP_CONNECTION_READ, DEBUG, TCP_SERVER, "FD %i: UDP read %lu bytes") \
+    LOGGER_ENTRY(UDP_CONNECTION_TRUNCATED, INFO, TCP_SERVER, "FD %i: UDP datagram truncated to %lu bytes, dropping") \
+    \
+    LOGGER_ENTRY(QUIC_PACKET_DROPPED, DEBUG, QUIC, "FD %i: QUIC packet dropped with error %vE") \
+    LOGGER_ENTRY(QUIC_VERSION_NEGOTIATION, DEBUG, QUIC, "FD %i: QUIC version negotiation sent for version %x") \
+    LOGGER_ENTRY(QUIC_STATELESS_RESET, DEBUG, QUIC, "FD %i: QUIC stateless reset sent for unknown connection") \
+    LOGGER_ENTRY(QUIC_CONNECTION_CREATE_FAILED, INFO, QUIC, "FD %i: QUIC failed to create connection with error %vE") \
     \
     LOGGER_ENTRY(TCP_SSL_CREATION_FAILED, ERROR, TCP_SERVER, "FD %i: SSL TCP Server is unable to create SSL for peer %i") \
     LOGGER_ENTRY(TCP_SSL_INITIALIZATION_FAILED, ERROR, TCP_SERVER, "FD %i: SSL TCP Server unable to initialize peer %i, failed with error %vc") \
@@ -148,6 +155,7 @@ namespace MMS {
     \
     LOGGER_ENTRY(HTTP2_PRI_KNOWLEDGE, INFO, HTTPSERVER, "FD %i: HTTP 2 Protocol created with prior knowledge") \
     LOGGER_ENTRY(HTTP2_UPGRADE, INFO, HTTPSERVER, "FD %i: HTTP 2 Protocol upgrade from HTTP 1.1") \
+    LOGGER_ENTRY(HTTP2_CONNECTION_ERROR, INFO, HTTPSERVER, "FD %i: HTTP 2 connection error, GOAWAY sent") \
     \
     LOGGER_ENTRY(TEST_GUID_LOG, INFO, TEST, "IOT Error '%vg' caps '%vG'") \
     LOGGER_ENTRY(TEST_FLOAT_LOGS, INFO, TEST, "Test float %%%hf, double %f") \
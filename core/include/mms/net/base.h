@@ -57,8 +57,18 @@ public:
     void SetProcessor(listener::processor_t *processor) { this->processor = processor; }
 
     virtual void ProcessRead(const Stream &stream) = 0;
+    // Work of other thread is written here, see listener::processor_t::Notify
+    virtual void ProcessNotify() { }
 
     void WriteNoCopy(FixedBuffer &&buffer) { processor->WriteNoCopy(std::move(buffer)); };
+    void CloseAfterWrite() { processor->CloseAfterWrite(); }
+    // Writes pending buffers without waiting for read to complete, remaining is written later
+    void Flush() { processor->ProcessWrite(); }
+    // Backpressure, connection does not read till ResumeRead is called
+    void PauseRead() { processor->PauseRead(); }
+    void ResumeRead() { processor->ResumeRead(); }
+    // This can be called from any thread, ProcessNotify is called in listener thread
+    void Notify() { processor->Notify(); }
 
     inline void Write(const std::string &buffer) {
         processor->Write(buffer);
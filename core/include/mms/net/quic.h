@@ -21,6 +21,14 @@
 
 #pragma once
 #include <mms/base/stream.h>
+#include <mms/net/base.h>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace MMS::net::quic {
 
@@ -85,4 +93,387 @@ constexpr void EncodeUnsignedInteger(uint64_t value, Stream &stream) {
     }
 }
 
-} // MMS::net::quic
\ No newline at end of file
+constexpr uint32_t version_negotiation { 0x00000000 };
+constexpr uint32_t version_1 { 0x00000001 };
+constexpr uint32_t supported_versions[] { version_1 };
+
+constexpr bool IsSupportedVersion(uint32_t version) {
+    return std::ranges::find(supported_versions, version) != std::end(supported_versions);
+}
+
+// 17.2 - Version 1 limits connection ID to 20 bytes
+constexpr size_t max_connection_id_length { 20 };
+
+// 14.1 - Server must drop Initial packet in datagram smaller than this
+// same limit is used before sending version negotiation
+constexpr size_t min_initial_datagram_size { 1200 };
+
+// 10.3 - 5 bytes of unpredictable bits followed by 16 bytes of token
+constexpr size_t stateless_reset_token_length { 16 };
+constexpr size_t min_stateless_reset_size { 21 };
+constexpr size_t max_stateless_reset_size { 43 };
+
+enum class packet_type_t : uint8_t {
+    Initial,
+    ZeroRTT,
+    Handshake,
+    Retry,
+    VersionNegotiation,
+    OneRTT
+};
+
+constexpr bool IsLongHeader(uint8_t first_byte) { return (first_byte & 0x80) != 0; }
+
+// Connection ID is kept in three 64 bit words with length in first byte
+// this make comparison and atomic store in routing table word based.
+class connection_id_t {
+public:
+    static constexpr size_t word_count { 3 };
+
+private:
+    std::array<uint64_t, word_count> words { };
+
+    uint8_t *bytes() { return reinterpret_cast<uint8_t *>(words.data()); }
+    const uint8_t *bytes() const { return reinterpret_cast<const uint8_t *>(words.data()); }
+
+public:
+    constexpr connection_id_t() = default;
+    connection_id_t(const uint8_t *id, size_t length) {
+        bytes()[0] = static_cast<uint8_t>(length);
+        std::memcpy(bytes() + 1, id, length);
+    }
+    explicit connection_id_t(const std::array<uint64_t, word_count> &words) : words { words } { }
+
+    size_t size() const { return bytes()[0]; }
+    bool empty() const { return size() == 0; }
+    const uint8_t *data() const { return bytes() + 1; }
+    uint64_t word(size_t index) const { return words[index]; }
+
+    bool operator==(const connection_id_t &rhs) const { return words == rhs.words; }
+
+    // Server chooses connection ID randomly, mixing is only to spread client chosen Initial IDs
+    uint64_t hash() const {
+        uint64_t value = words[0] ^ (words[1] * 0x9e3779b97f4a7c15ULL) ^ (words[2] * 0xc2b2ae3d27d4eb4fULL);
+        value ^= value >> 29;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        return value ^ (value >> 32);
+    }
+
+    void Write(Stream &stream) const {
+        *stream++ = static_cast<uint8_t>(size());
+        stream.Copy(data(), size());
+    }
+}; // connection_id_t
+
+struct packet_header_t {
+    packet_type_t type { packet_type_t::OneRTT };
+    uint32_t version { };
+    connection_id_t dcid { };
+    connection_id_t scid { };
+
+    // Initial and Retry token, points inside the packet
+    const uint8_t *token { nullptr };
+    size_t token_length { };
+
+    // Complete packet including header, packet number and payload are still protected
+    const uint8_t *packet { nullptr };
+    size_t packet_size { };
+
+    // Offset of protected packet number from start of packet
+    size_t header_size { };
+
+    bool IsLongHeader() const { return type != packet_type_t::OneRTT; }
+};
+
+// Parses one packet from stream and moves stream to next coalesced packet.
+// Short header do not carry length of destination connection ID, server
+// must use same length for all connection ID it issues.
+// Returns QUIC_VERSION_UNSUPPORTED with version and connection IDs filled
+// so that caller can create version negotiation packet.
+err_t ParseHeader(const Stream &stream, size_t short_dcid_length, packet_header_t &header);
+
+// 17.2.1 - Version negotiation is sent in response to client packet
+void CreateVersionNegotiation(const packet_header_t &header, Stream &stream);
+
+// 17.3.1 - Used by client and test, packet number is of 4 bytes
+void CreateShortHeader(const connection_id_t &dcid, uint32_t packet_number, Stream &stream);
+
+// 17.2.2 - Used by client and test, payload is padded to min_initial_datagram_size
+void CreateInitial(const connection_id_t &dcid, const connection_id_t &scid, uint32_t version, uint32_t packet_number, const Stream &payload, Stream &stream);
+
+using stateless_reset_token_t = std::array<uint8_t, stateless_reset_token_length>;
+
+// 10.3.2 - Token is derived from connection ID using static key, so
+// server need not to store any state for connection that it forgot.
+class stateless_reset_t {
+public:
+    static constexpr size_t key_length { 32 };
+    using key_t = std::array<uint8_t, key_length>;
+
+private:
+    key_t key { };
+
+public:
+    // Random key, tokens are valid till server restarts
+    stateless_reset_t();
+    stateless_reset_t(const key_t &key) : key { key } { }
+
+    stateless_reset_token_t GetToken(const connection_id_t &cid) const;
+
+    // Reset must be smaller than packet that triggered it to avoid infinite loop 10.3.3.
+    // Returns false if received packet was too small to respond.
+    bool Create(const connection_id_t &cid, size_t received_size, Stream &stream) const;
+
+    static bool IsStatelessReset(const Stream &stream, const stateless_reset_token_t &token);
+}; // stateless_reset_t
+
+// Open addressed connection ID to connection table.
+// Lookup is lock free, reader validates slot state after reading it (seqlock).
+// Insert and remove of same connection ID are serialized by lock striped on hash, so that
+// duplicate check and slot claim are one step. Slot is claimed using CAS on slot state
+// as writer of other stripe may share probe sequence.
+// Deleted slots are rebuilt to empty under all writer locks once they are quarter of table,
+// else miss would probe whole table. Lookup missing during rebuild is repeated.
+// Removed value is not freed by the table; caller must keep connection alive
+// till no thread can be reading it (i.e. till end of current listener event).
+template <typename value_type>
+class connection_table_t {
+    // Low 2 bits are tag, bit 2..31 is generation and bit 32..63 hash of connection ID
+    static constexpr uint64_t tag_mask { 0x3 };
+    static constexpr uint64_t tag_empty { 0x0 };
+    static constexpr uint64_t tag_busy { 0x1 };
+    static constexpr uint64_t tag_deleted { 0x2 };
+    static constexpr uint64_t tag_ready { 0x3 };
+    static constexpr uint64_t generation_mask { 0xfffffffcULL };
+    static constexpr uint64_t hash_mask { 0xffffffff00000000ULL };
+    static constexpr size_t writer_lock_count { 64 };
+
+    struct slot_t {
+        std::atomic<uint64_t> state { tag_empty };
+        std::array<std::atomic<uint64_t>, connection_id_t::word_count> words { };
+        std::atomic<value_type *> value { nullptr };
+    };
+
+    const size_t capacity;
+    const size_t mask;
+    std::unique_ptr<slot_t[]> slots;
+    std::atomic<size_t> count { 0 };
+    std::atomic<size_t> deleted_count { 0 };
+    // Odd while slots are rebuilt
+    std::atomic<uint64_t> rebuild_sequence { 0 };
+    std::array<std::mutex, writer_lock_count> writer_locks { };
+
+    std::mutex &GetWriterLock(uint64_t hash) { return writer_locks[(hash >> 32) % writer_lock_count]; }
+
+    static constexpr uint64_t NextGeneration(uint64_t state) { return (state + 4) & generation_mask; }
+
+    bool IsMatch(const slot_t &slot, uint64_t state, const connection_id_t &cid) const {
+        for(size_t index { 0 }; index < connection_id_t::word_count; ++index) {
+            if (slot.words[index].load(std::memory_order_relaxed) != cid.word(index)) return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.state.load(std::memory_order_relaxed) == state;
+    }
+
+    value_type *Probe(const connection_id_t &cid, const uint64_t hash) const {
+        const auto hash_state = hash & hash_mask;
+        for(size_t probe { 0 }; probe < capacity; ++probe) {
+            const slot_t &slot = slots[(hash + probe) & mask];
+            const auto state = slot.state.load(std::memory_order_acquire);
+            const auto tag = state & tag_mask;
+            if (tag == tag_empty) return nullptr;
+            if (tag != tag_ready || (state & hash_mask) != hash_state) continue;
+            auto value = slot.value.load(std::memory_order_relaxed);
+            if (IsMatch(slot, state, cid)) return value;
+        }
+        return nullptr;
+    }
+
+    // Slot is busy with busy_state, it is made ready for connection ID
+    void Fill(slot_t &slot, const uint64_t busy_state, const connection_id_t &cid, const uint64_t hash_state, value_type *value) {
+        for(size_t index { 0 }; index < connection_id_t::word_count; ++index) {
+            slot.words[index].store(cid.word(index), std::memory_order_relaxed);
+        }
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.state.store(hash_state | NextGeneration(busy_state) | tag_ready, std::memory_order_release);
+    }
+
+    void Rebuild() {
+        std::array<std::unique_lock<std::mutex>, writer_lock_count> guards { };
+        for(size_t index { 0 }; index < writer_lock_count; ++index) guards[index] = std::unique_lock { writer_locks[index] };
+        // Other remove has rebuilt it
+        if (deleted_count.load(std::memory_order_relaxed) < capacity / 4) return;
+
+        const auto sequence = rebuild_sequence.load(std::memory_order_relaxed);
+        rebuild_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::vector<std::pair<connection_id_t, value_type *>> entries { };
+        entries.reserve(count.load(std::memory_order_relaxed));
+        for(size_t index { 0 }; index < capacity; ++index) {
+            slot_t &slot = slots[index];
+            const auto state = slot.state.load(std::memory_order_relaxed);
+            if ((state & tag_mask) == tag_ready) {
+                std::array<uint64_t, connection_id_t::word_count> words { };
+                for(size_t word { 0 }; word < connection_id_t::word_count; ++word) words[word] = slot.words[word].load(std::memory_order_relaxed);
+                entries.emplace_back(connection_id_t { words }, slot.value.load(std::memory_order_relaxed));
+            }
+            // Generation changes, reader of old slot fails validation
+            slot.state.store(NextGeneration(state) | tag_empty, std::memory_order_release);
+        }
+        for(const auto &[cid, value]: entries) {
+            const auto hash = cid.hash();
+            for(size_t probe { 0 };; ++probe) {
+                slot_t &slot = slots[(hash + probe) & mask];
+                const auto state = slot.state.load(std::memory_order_relaxed);
+                if ((state & tag_mask) != tag_empty) continue;
+                slot.state.store((state & generation_mask) | tag_busy, std::memory_order_relaxed);
+                Fill(slot, state, cid, hash & hash_mask, value);
+                break;
+            }
+        }
+        deleted_count.store(0, std::memory_order_relaxed);
+        rebuild_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+public:
+    // Capacity is rounded to power of 2
+    connection_table_t(size_t capacity = 16384) : capacity { std::bit_ceil(capacity) }, mask { this->capacity - 1 }, slots { std::make_unique<slot_t[]>(this->capacity) } { }
+    connection_table_t(const connection_table_t &) = delete;
+    connection_table_t &operator=(const connection_table_t &) = delete;
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // Deleted slots not yet rebuilt to empty
+    size_t deleted_size() const { return deleted_count.load(std::memory_order_relaxed); }
+
+    value_type *Find(const connection_id_t &cid) const {
+        const auto hash = cid.hash();
+        for(;;) {
+            const auto sequence = rebuild_sequence.load(std::memory_order_acquire);
+            auto value = Probe(cid, hash);
+            if (value) return value;
+            // Connection ID may be moved by rebuild, miss is true only if no rebuild overlapped lookup
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((sequence & 1) == 0 && rebuild_sequence.load(std::memory_order_relaxed) == sequence) return nullptr;
+        }
+    }
+
+    // Returns false if connection ID already exists
+    bool Insert(const connection_id_t &cid, value_type *value) {
+        const auto hash = cid.hash();
+        const auto hash_state = hash & hash_mask;
+        std::lock_guard guard { GetWriterLock(hash) };
+        for(;;) {
+            // First free slot is used, connection ID may be after deleted slot hence probe continues till empty slot
+            slot_t *free_slot { nullptr };
+            uint64_t free_state { };
+            for(size_t probe { 0 }; probe < capacity; ++probe) {
+                slot_t &slot = slots[(hash + probe) & mask];
+                const auto state = slot.state.load(std::memory_order_acquire);
+                const auto tag = state & tag_mask;
+                if (tag == tag_ready) {
+                    if ((state & hash_mask) == hash_state && IsMatch(slot, state, cid)) return false;
+                    continue;
+                }
+                if (tag == tag_busy) continue;
+                if (!free_slot) {
+                    free_slot = &slot;
+                    free_state = state;
+                }
+                if (tag == tag_empty) break;
+            }
+            if (!free_slot) throw exception_t { err_t::QUIC_CONNECTION_TABLE_FULL };
+
+            // Writer of other connection ID has taken it, probe again
+            if (!free_slot->state.compare_exchange_strong(free_state, (free_state & generation_mask) | tag_busy, std::memory_order_acquire)) continue;
+            if ((free_state & tag_mask) == tag_deleted) deleted_count.fetch_sub(1, std::memory_order_relaxed);
+            Fill(*free_slot, free_state, cid, hash_state, value);
+            count.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    value_type *Remove(const connection_id_t &cid) {
+        value_type *value { nullptr };
+        {
+            const auto hash = cid.hash();
+            const auto hash_state = hash & hash_mask;
+            std::lock_guard guard { GetWriterLock(hash) };
+            for(size_t probe { 0 }; probe < capacity; ++probe) {
+                slot_t &slot = slots[(hash + probe) & mask];
+                auto state = slot.state.load(std::memory_order_acquire);
+                const auto tag = state & tag_mask;
+                if (tag == tag_empty) return nullptr;
+                if (tag != tag_ready || (state & hash_mask) != hash_state) continue;
+                auto slot_value = slot.value.load(std::memory_order_relaxed);
+                if (!IsMatch(slot, state, cid)) continue;
+                if (!slot.state.compare_exchange_strong(state, NextGeneration(state) | tag_deleted, std::memory_order_acq_rel)) return nullptr;
+                count.fetch_sub(1, std::memory_order_relaxed);
+                deleted_count.fetch_add(1, std::memory_order_relaxed);
+                value = slot_value;
+                break;
+            }
+        }
+        // All writer locks are taken in order, hence stripe lock is released first
+        if (value && deleted_count.load(std::memory_order_relaxed) >= capacity / 4) Rebuild();
+        return value;
+    }
+}; // connection_table_t
+
+// One QUIC connection, packet protection and TLS handshake is part of connection.
+class connection_t {
+public:
+    virtual ~connection_t() = default;
+
+    // Packet belongs to this connection, writer sends to address packet came from
+    virtual void ProcessPacket(const packet_header_t &header, net::protocol_t *writer) = 0;
+};
+
+class connection_creator_t {
+public:
+    virtual ~connection_creator_t() = default;
+
+    // Called for Initial packet with unknown destination connection ID.
+    // Returned connection is routed by client chosen DCID, connection must
+    // add connection IDs it issues using routing table.
+    // Creator owns the connection, nullptr drops the packet.
+    virtual connection_t *create_connection(const packet_header_t &header) = 0;
+
+    // Connection is not used as same DCID was routed by other thread first, or table is full.
+    virtual void release_connection(connection_t *connection) = 0;
+};
+
+class protocol_creator_t;
+
+// Packet layer over udp::server_t, every datagram from recvmmsg batch
+// comes to ProcessRead which splits coalesced packets and routes them.
+class protocol_t : public net::protocol_t {
+    protocol_creator_t &creator;
+
+public:
+    protocol_t(protocol_creator_t &creator) : creator { creator } { }
+
+    void ProcessRead(const Stream &stream) override;
+}; // protocol_t
+
+// Shared by all UDP socket so that routing table is common for all threads.
+class protocol_creator_t : public net::protocol_creator_t {
+    friend class protocol_t;
+    connection_creator_t &connection_creator;
+    const size_t connection_id_length;
+    connection_table_t<connection_t> routing_table;
+    stateless_reset_t stateless_reset { };
+
+public:
+    protocol_creator_t(connection_creator_t &connection_creator, size_t connection_id_length = 8, size_t table_capacity = 16384)
+        : connection_creator { connection_creator }, connection_id_length { connection_id_length }, routing_table { table_capacity } { }
+
+    net::protocol_t *create_protocol(int, const std::string_view &) override { return new protocol_t { *this }; }
+
+    auto &GetRoutingTable() { return routing_table; }
+    const auto &GetStatelessReset() const { return stateless_reset; }
+    auto GetConnectionIDLength() const { return connection_id_length; }
+}; // protocol_creator_t
+
+} // MMS::net::quic
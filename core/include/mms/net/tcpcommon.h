@@ -20,6 +20,7 @@
 #include <mms/base/types.h>
 #include <mms/net/socket.h>
 #include <mms/net/base.h>
+#include <deque>
 #include <memory>
 
 namespace MMS::net::tcp {
@@ -27,7 +28,12 @@ namespace MMS::net::tcp {
 class connection_base_t : public listener::processor_t {
 protected:
     std::unique_ptr<protocol_t> protocol_implementation;
-    std::queue<FixedBuffer> pending_wirte { };
+    // Deque so that queued buffers are given to socket in one write
+    std::deque<FixedBuffer> pending_wirte { };
+    bool close_after_write { false };
+
+    // Gives read buffer to protocol and resets it
+    void ProcessReadBuffer();
 
 public:
     connection_base_t(int fd, protocol_t *protocol_implementation)
@@ -41,6 +47,8 @@ public:
     }
 
     void WriteNoCopy(FixedBuffer &&buffer) override;
+    void CloseAfterWrite() override { close_after_write = true; }
+    void ProcessNotify() override { if (protocol_implementation) protocol_implementation->ProcessNotify(); }
 
     auto get_peer_ipv6_addr() const { return MMS::net::get_peer_ipv6_addr(GetFD()); }
 }; // connection_base_t
@@ -21,11 +21,15 @@
 #include <mms/net/socket.h>
 #include <mms/net/base.h>
 #include <mms/net/tcpcommon.h>
+#include <sys/uio.h>
+#include <array>
 
 namespace MMS::net::tcp {
 
 class connection_t : public connection_base_t {
 protected:
+    // Buffers given to socket in one write, this is below IOV_MAX
+    static constexpr size_t write_batch_max { 64 };
     size_t writeoffset { 0 };
 
 public:
@@ -45,8 +49,8 @@ public:
     server_t(const int port, protocol_creator_t &protocol_creator, listener::listener_t *listener)
         : listener::processor_t { CreateTCPServerSocket(port) }, 
             protocol_creator { protocol_creator }, listener { listener } { }
-    server_t(const server_t &) = default;
-    server_t &operator=(const server_t &) = default;
+    server_t(const server_t &) = delete;
+    server_t &operator=(const server_t &) = delete;
     err_t ProcessRead() override;
 }; // server_t
 
@@ -22,6 +22,7 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <memory>
+#include <string>
 #include <mms/net/tcpcommon.h>
 
 
@@ -29,8 +30,13 @@ namespace MMS::net::tcp::ssl {
 
 class connection_t : public connection_base_t {
 protected:
+    // Largest TLS record plaintext https://www.rfc-editor.org/rfc/rfc8446.html#section-5.1
+    static constexpr size_t record_size_max { 16384 };
+    // Buffer smaller than this is joined with next ones before it is written
+    static constexpr size_t coalesce_size_max { 4096 };
     SSL *ssl;
     size_t writeoffset { 0 };
+    std::string coalesced { };
     
 public:
     connection_t(int fd, SSL *ssl, protocol_t *protocol_implementation)
@@ -56,8 +62,8 @@ public:
         : listener::processor_t { CreateTCPServerSocket(port) }, protocol_creator { protocol_creator }, listener { listener }, ssl_common { ssl_common }
     { }
 
-    server_t(const server_t &) = default;
-    server_t &operator=(const server_t &) = default;
+    server_t(const server_t &) = delete;
+    server_t &operator=(const server_t &) = delete;
     err_t ProcessRead() override;
 
     static const std::string_view get_protocol(SSL *ssl);
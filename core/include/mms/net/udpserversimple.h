@@ -22,16 +22,46 @@
 #include <mms/net/base.h>
 #include <mms/net/tcpcommon.h>
 #include <sys/socket.h>
+#include <array>
+#include <deque>
+#include <memory>
 
 namespace MMS::net::udp {
 
+// Receive buffers for recvmmsg, one instance per thread similar to readbuffer.
+class datagram_batch_t {
+public:
+    static constexpr size_t max_datagrams { 16 };
+    static constexpr size_t max_datagram_size { 4096 };
+
+private:
+    std::array<mmsghdr, max_datagrams> headers { };
+    std::array<iovec, max_datagrams> iov { };
+    std::array<sockaddr_in6, max_datagrams> addresses { };
+    std::unique_ptr<uint8_t[]> buffers;
+
+public:
+    datagram_batch_t();
+    datagram_batch_t(const datagram_batch_t &) = delete;
+    datagram_batch_t &operator=(const datagram_batch_t &) = delete;
+
+    // Returns number of datagram received or -1 with errno set
+    int Receive(int fd);
+
+    const Stream GetDatagram(size_t index) const { return make_const_stream(buffers.get() + index * max_datagram_size, headers[index].msg_len); }
+    sockaddr_in6 *GetAddress(size_t index) { return &addresses[index]; }
+    bool IsTruncated(size_t index) const { return (headers[index].msg_hdr.msg_flags & MSG_TRUNC) != 0; }
+}; // datagram_batch_t
+
 
 class server_t : public listener::processor_t {
     std::unique_ptr<protocol_t> protocol_implementation;
-    std::queue<std::pair<sockaddr_in6, FixedBuffer>> pending_wirte { };
+    std::deque<std::pair<sockaddr_in6, FixedBuffer>> pending_wirte { };
 
     sockaddr_in6 *current_client_addr { nullptr };
 
+    static thread_local datagram_batch_t readbatch;
+
 public:
     server_t(const int port, protocol_creator_t &protocol_creator, listener::listener_t *)
         : listener::processor_t { CreateUDPServerSocket(port) }, 
@@ -40,8 +70,8 @@ public:
         protocol_implementation->SetProcessor(this);
     }
     virtual ~server_t() = default;
-    server_t(const server_t &) = default;
-    server_t &operator=(const server_t &) = default;
+    server_t(const server_t &) = delete;
+    server_t &operator=(const server_t &) = delete;
     err_t ProcessRead() override;
     err_t ProcessWrite() override;
     void WriteNoCopy(FixedBuffer &&) override;
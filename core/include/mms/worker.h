@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MMS::worker {
+
+// Threads for work that must not hold listener thread, e.g. handler waiting for other service.
+// Tasks are started in order they are submitted, they may complete in any order.
+class pool_t {
+public:
+    // Task must handle its exceptions
+    using task_t = std::move_only_function<void()>;
+
+private:
+    std::mutex lock { };
+    std::condition_variable ready { };
+    std::deque<task_t> tasks { };
+    bool stopping { false };
+    std::vector<std::jthread> threads { };
+
+    void loop();
+
+public:
+    pool_t(const size_t thread_count);
+    pool_t(const pool_t &) = delete;
+    pool_t &operator=(const pool_t &) = delete;
+    // Tasks already submitted are run before threads exit
+    ~pool_t();
+
+    void Submit(task_t &&task);
+
+    size_t GetThreadCount() const { return threads.size(); }
+};
+
+} // namespace MMS::worker
@@ -19,6 +19,9 @@
 #include <signal.h>
 #include <sys/signalfd.h>
 #include <sys/eventfd.h>
+#include <utility>
+#include <limits>
+#include <algorithm>
 
 
 namespace MMS::listener {
@@ -27,6 +30,28 @@ streamlimit_t processor_t::readlimits { };
 
 thread_local FullStreamAutoAllocLimits processor_t::readbuffer { &readlimits };
 
+void processor_t::ResumeRead() {
+    std::lock_guard guard { event_lock };
+    read_paused = false;
+    // Listener enables read after event is processed.
+    // Write is enabled as well, as pending write may be waiting for it.
+    if (!deleted) Wake();
+}
+
+void processor_t::Notify() {
+    std::lock_guard guard { event_lock };
+    if (deleted) return;
+    notified = true;
+    Wake();
+}
+
+void processor_t::Wake() {
+    // Listener enables write at end of event, notify is taken with that event
+    if (in_event || queued || !listener) return;
+    queued = true;
+    listener->notifier.Push(this);
+}
+
 static int CreateSignalFD() {
     sigset_t sigmaskignore { };
     sigemptyset(&sigmaskignore);
@@ -89,6 +114,36 @@ void terminate_t::StopListenerThread(bool from_listener) {
 
 }
 
+notifier_t::notifier_t(listener_t &listener) : processor_t { eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) }, listener { listener } { }
+
+void notifier_t::Push(processor_t *processor) {
+    std::lock_guard guard { queue_lock };
+    queue.push_back(processor);
+    if (queue.size() == 1) {
+        const uint64_t value { 1 };
+        if (write(GetFD(), &value, sizeof(value)) == -1) log<log_t::LISTNER_EVENT_ENABLE_FAILED>(GetFD(), errno);
+    }
+}
+
+void notifier_t::Erase(processor_t *processor) {
+    std::lock_guard guard { queue_lock };
+    std::erase(queue, processor);
+}
+
+err_t notifier_t::ProcessRead() {
+    uint64_t value { };
+    if (read(GetFD(), &value, sizeof(value)) == -1 && errno != EAGAIN) log<log_t::LISTNER_EVENT_ENABLE_FAILED>(GetFD(), errno);
+
+    std::vector<processor_t *> current { };
+    {
+        std::lock_guard guard { queue_lock };
+        std::swap(current, queue);
+    }
+    // Processor deleted after swap is retired, it is not freed till this thread waits again
+    for (auto processor: current) listener.EnableQueued(processor);
+    return err_t::SUCCESS;
+}
+
 thread_stopper_t::thread_stopper_t() : processor_t { eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC)  } {}
 
 err_t thread_stopper_t::ProcessRead() {
@@ -96,6 +151,12 @@ err_t thread_stopper_t::ProcessRead() {
 }
 
 void listener_t::close() {
+    {
+        std::lock_guard guard { retire_lock };
+        for (auto &[retire_epoch, processor]: retired) delete processor;
+        retired.clear();
+        retired_count = 0;
+    }
 #ifdef MMS_LISTENER_CLOSE_AT_EXIT
     for (auto processor: active_processors) {
         // We must not call listener remove here as it will modify active_processors
@@ -109,7 +170,7 @@ void listener_t::close() {
 bool listener_t::created { false };
 
 listener_t::listener_t(const std::filesystem::path &filename, const size_t max_event_epoll_return) 
-    :  threadcount { static_cast<size_t>(sysconf(_SC_NPROCESSORS_ONLN)) }, max_event_epoll_return { max_event_epoll_return }, terminatehandler { *this }
+    :  threadcount { static_cast<size_t>(sysconf(_SC_NPROCESSORS_ONLN)) }, max_event_epoll_return { max_event_epoll_return }, terminatehandler { *this }, notifier { *this }
 {
     if (created) {
         log<log_t::LISTENER_ALREADY_CREATED_FAILED>();
@@ -126,6 +187,7 @@ listener_t::listener_t(const std::filesystem::path &filename, const size_t max_e
     }
 
     add(&terminatehandler);
+    add(&notifier);
 
     log<log_t::LISTENER_CREATE_SUCCESS>();
 }
@@ -175,12 +237,51 @@ public:
     ~RunningThread() { --running_thread; }
 };
 
+std::atomic<uint64_t> &listener_t::AddThreadEpoch() {
+    std::lock_guard guard { retire_lock };
+    return seen_epochs.emplace_back(epoch.load());
+}
+
+void listener_t::Retire(processor_t *processor) {
+    std::lock_guard guard { retire_lock };
+    retired.emplace_back(epoch++, processor);
+    ++retired_count;
+}
+
+void listener_t::Reclaim(std::atomic<uint64_t> &seen_epoch) {
+    // Thread is out of its last event array, next epoll_wait will not return retired processor
+    seen_epoch = epoch.load();
+    if (!retired_count) return;
+
+    std::lock_guard guard { retire_lock };
+    auto min_epoch = std::numeric_limits<uint64_t>::max();
+    for (auto &thread_epoch: seen_epochs) min_epoch = std::min<uint64_t>(min_epoch, thread_epoch);
+
+    std::erase_if(retired, [min_epoch](const auto &entry) {
+        if (entry.first >= min_epoch) return false;
+        delete entry.second;
+        return true;
+    });
+    retired_count = retired.size();
+}
+
+class ThreadEpoch {
+    std::atomic<uint64_t> &seen_epoch;
+public:
+    ThreadEpoch(std::atomic<uint64_t> &seen_epoch) : seen_epoch { seen_epoch } { }
+    // Exited thread must not hold back reclaim
+    ~ThreadEpoch() { seen_epoch = std::numeric_limits<uint64_t>::max(); }
+    auto &get() { return seen_epoch; }
+};
+
 void listener_t::loop() {
     log<log_t::LISTENER_LOOP_CREATED>();
     RunningThread raii_running_thread { running_thread };
+    ThreadEpoch raii_thread_epoch { AddThreadEpoch() };
     auto events = std::make_unique<epoll_event[]>(max_event_epoll_return);
     try {
         for(;;) {
+            Reclaim(raii_thread_epoch.get());
             auto ret = epoll_wait(epollfd, events.get(), max_event_epoll_return, -1);
 
             if (ret == -1) {
@@ -193,34 +294,56 @@ void listener_t::loop() {
                 epoll_event &event = events[index];
                 auto processor = reinterpret_cast<listener::processor_t *>(event.data.ptr);
 
+                bool notified { false };
+                {
+                    std::lock_guard guard { processor->event_lock };
+                    // Stale event of deleted processor, it is freed once this thread waits again
+                    if (processor->deleted) continue;
+                    // Other thread is processing it, that thread enables it again
+                    if (processor->in_event) {
+                        processor->missed_event = true;
+                        continue;
+                    }
+                    processor->in_event = true;
+                    notified = std::exchange(processor->notified, false);
+                }
+
                 log<log_t::LISTENER_EVENT_RECEIVED>(processor->GetFD(), event.events);
                 if ((event.events & EPOLLRDHUP)) {
                     log<log_t::TCP_SERVER_PEER_CONNECTION_CLOSED>(processor->GetFD());
                     Delete(processor);
                 } else {
                     err_t ret { err_t::SUCCESS };
-                    if ((event.events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
-                        // EPOLLHUP | EPOLLERR
-                        // recv() will return 0 for EPOLLHUP and -1 for EPOLLERR
-                        // recv() 0 means end of file.
-                        processor->readbuffer.Reset();
-                        ret = processor->ProcessRead();
-                        if (ret == err_t::SUCCESS) {
+                    try {
+                        if (notified) processor->ProcessNotify();
+                        if ((event.events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                            // EPOLLHUP | EPOLLERR
+                            // recv() will return 0 for EPOLLHUP and -1 for EPOLLERR
+                            // recv() 0 means end of file.
+                            processor->readbuffer.Reset();
+                            ret = processor->ProcessRead();
+                            if (ret == err_t::SUCCESS) {
+                                ret = processor->ProcessWrite();
+                            }
+                        } else if ((event.events & EPOLLOUT)) {
                             ret = processor->ProcessWrite();
                         }
-                    } else if ((event.events & EPOLLOUT)) {
-                        ret = processor->ProcessWrite();
+                    } catch(listener_terminate_thread_t &) {
+                        // Thread stopper is enabled again for next thread
+                        std::lock_guard guard { processor->event_lock };
+                        processor->in_event = false;
+                        throw;
                     }
 
                     switch(ret) {
                         case err_t::SUCCESS:
-                            enable(processor, false);
+                            EndEvent(processor, false);
                             break;
                         
                         // SOCKET_RETRY will only happen for Write
                         // read converts it to SUCCESS
                         case err_t::SOCKET_RETRY:
-                            enable(processor, true);
+                            EndEvent(processor, true);
                             break;
 
                         // case err_t::BAD_FILE_DESCRIPTOR:
@@ -0,0 +1,266 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <mms/net/quic.h>
+#include <mms/log/log.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+namespace MMS::net::quic {
+
+namespace {
+inline uint32_t ReadVersion(const uint8_t *data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+inline void WriteU32(uint32_t value, Stream &stream) {
+    *stream++ = (value >> 24) & 0xff;
+    *stream++ = (value >> 16) & 0xff;
+    *stream++ = (value >> 8) & 0xff;
+    *stream++ = value & 0xff;
+}
+
+inline uint8_t RandomByte() {
+    uint8_t value { };
+    RAND_bytes(&value, 1);
+    return value;
+}
+
+// Variable length integer with bound check, stream is untrusted
+inline bool DecodeLength(const Stream &stream, uint64_t &value) {
+    if (!stream.remaining_buffer()) return false;
+    const size_t length = 1ULL << (*stream >> 6);
+    if (stream.remaining_buffer() < length) return false;
+    value = DecodeUnsignedInteger(stream);
+    return true;
+}
+
+inline bool ParseConnectionID(const Stream &stream, connection_id_t &cid) {
+    if (!stream.remaining_buffer()) return false;
+    const size_t length = *stream++;
+    if (length > max_connection_id_length || stream.remaining_buffer() < length) return false;
+    cid = connection_id_t { stream.curr(), length };
+    stream += length;
+    return true;
+}
+} // namespace
+
+err_t ParseHeader(const Stream &stream, size_t short_dcid_length, packet_header_t &header) {
+    const uint8_t *packet = stream.curr();
+    const size_t remaining = stream.remaining_buffer();
+    header.packet = packet;
+    if (remaining == 0) return err_t::QUIC_PACKET_MALFORMED;
+
+    const uint8_t first_byte = packet[0];
+    if (!IsLongHeader(first_byte)) {
+        // 17.3.1 - 1 byte flags, DCID and at least 1 byte of packet number
+        if (short_dcid_length > max_connection_id_length || remaining < 1 + short_dcid_length + 1 || (first_byte & 0x40) == 0) return err_t::QUIC_PACKET_MALFORMED;
+        header.type = packet_type_t::OneRTT;
+        header.dcid = connection_id_t { packet + 1, short_dcid_length };
+        header.header_size = 1 + short_dcid_length;
+        header.packet_size = remaining;
+        stream += remaining;
+        return err_t::SUCCESS;
+    }
+
+    // 17.2 - 1 byte flags, 4 bytes version and 2 connection ID length
+    if (remaining < 7) return err_t::QUIC_PACKET_MALFORMED;
+    const Stream parser = make_const_stream(packet + 1, remaining - 1);
+    header.version = ReadVersion(parser.GetCurrAndIncrease(4));
+    if (!ParseConnectionID(parser, header.dcid) || !ParseConnectionID(parser, header.scid)) return err_t::QUIC_PACKET_MALFORMED;
+
+    if (header.version == version_negotiation) {
+        header.type = packet_type_t::VersionNegotiation;
+        header.header_size = static_cast<size_t>(parser.curr() - packet);
+        header.packet_size = remaining;
+        stream += remaining;
+        return err_t::SUCCESS;
+    }
+
+    if (!IsSupportedVersion(header.version)) {
+        header.packet_size = remaining;
+        stream += remaining;
+        return err_t::QUIC_VERSION_UNSUPPORTED;
+    }
+
+    if ((first_byte & 0x40) == 0) return err_t::QUIC_PACKET_MALFORMED;
+    header.type = static_cast<packet_type_t>((first_byte >> 4) & 0x03);
+
+    if (header.type == packet_type_t::Retry) {
+        // 17.2.5 - Token is everything except last 16 bytes of integrity tag
+        constexpr size_t integrity_tag_size { 16 };
+        if (parser.remaining_buffer() < integrity_tag_size) return err_t::QUIC_PACKET_MALFORMED;
+        header.token = parser.curr();
+        header.token_length = parser.remaining_buffer() - integrity_tag_size;
+        header.header_size = static_cast<size_t>(parser.curr() - packet);
+        header.packet_size = remaining;
+        stream += remaining;
+        return err_t::SUCCESS;
+    }
+
+    if (header.type == packet_type_t::Initial) {
+        uint64_t token_length { };
+        if (!DecodeLength(parser, token_length) || parser.remaining_buffer() < token_length) return err_t::QUIC_PACKET_MALFORMED;
+        header.token = parser.curr();
+        header.token_length = token_length;
+        parser += token_length;
+    }
+
+    uint64_t length { };
+    if (!DecodeLength(parser, length) || parser.remaining_buffer() < length || length == 0) return err_t::QUIC_PACKET_MALFORMED;
+    header.header_size = static_cast<size_t>(parser.curr() - packet);
+    header.packet_size = header.header_size + length;
+    stream += header.packet_size;
+    return err_t::SUCCESS;
+}
+
+void CreateVersionNegotiation(const packet_header_t &header, Stream &stream) {
+    // 17.2.1 - Unused bits are random, connection IDs are echoed in reverse
+    *stream++ = 0x80 | (RandomByte() & 0x7f);
+    WriteU32(version_negotiation, stream);
+    header.scid.Write(stream);
+    header.dcid.Write(stream);
+    for(auto version: supported_versions) WriteU32(version, stream);
+}
+
+void CreateShortHeader(const connection_id_t &dcid, uint32_t packet_number, Stream &stream) {
+    // Fixed bit and 4 bytes packet number
+    *stream++ = 0x40 | 0x03;
+    stream.Copy(dcid.data(), dcid.size());
+    WriteU32(packet_number, stream);
+}
+
+void CreateInitial(const connection_id_t &dcid, const connection_id_t &scid, uint32_t version, uint32_t packet_number, const Stream &payload, Stream &stream) {
+    const uint8_t *start = stream.curr();
+    *stream++ = 0xc0 | 0x03;
+    WriteU32(version, stream);
+    dcid.Write(stream);
+    scid.Write(stream);
+    // Token length zero
+    *stream++ = 0x00;
+
+    const size_t header_size = static_cast<size_t>(stream.curr() - start) + 2 + 4;
+    const size_t payload_size = std::max(payload.remaining_buffer() + 4, min_initial_datagram_size - header_size + 4);
+    EncodeUnsignedInteger<2>(payload_size, stream);
+    WriteU32(packet_number, stream);
+    stream.Copy(payload.curr(), payload.remaining_buffer());
+    const size_t padding = payload_size - 4 - payload.remaining_buffer();
+    std::fill_n(stream.GetCurrAndIncrease(padding), padding, 0);
+}
+
+stateless_reset_t::stateless_reset_t() {
+    if (RAND_bytes(key.data(), static_cast<int>(key.size())) != 1) throw exception_t { err_t::CRYPTO_KEY_GENERATION_FAILED };
+}
+
+stateless_reset_token_t stateless_reset_t::GetToken(const connection_id_t &cid) const {
+    std::array<uint8_t, EVP_MAX_MD_SIZE> digest { };
+    unsigned int digest_length { };
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), cid.data(), cid.size(), digest.data(), &digest_length);
+    stateless_reset_token_t token { };
+    std::copy_n(digest.begin(), token.size(), token.begin());
+    return token;
+}
+
+bool stateless_reset_t::Create(const connection_id_t &cid, size_t received_size, Stream &stream) const {
+    if (received_size <= min_stateless_reset_size) return false;
+    const size_t size = std::min(received_size - 1, max_stateless_reset_size);
+    const size_t random_size = size - stateless_reset_token_length;
+
+    auto random_bytes = stream.GetCurrAndIncrease(random_size);
+    RAND_bytes(random_bytes, static_cast<int>(random_size));
+    // 10.3 - Must look like short header, fixed bit set
+    random_bytes[0] = (random_bytes[0] & 0x3f) | 0x40;
+    const auto token = GetToken(cid);
+    stream.Copy(token.data(), token.size());
+    return true;
+}
+
+bool stateless_reset_t::IsStatelessReset(const Stream &stream, const stateless_reset_token_t &token) {
+    if (stream.remaining_buffer() < min_stateless_reset_size || IsLongHeader(*stream)) return false;
+    return std::equal(token.begin(), token.end(), stream.end() - stateless_reset_token_length);
+}
+
+void protocol_t::ProcessRead(const Stream &stream) {
+    const size_t datagram_size = stream.remaining_buffer();
+    while(stream.remaining_buffer()) {
+        packet_header_t header { };
+        const auto ret = ParseHeader(stream, creator.connection_id_length, header);
+
+        if (ret == err_t::QUIC_VERSION_UNSUPPORTED) {
+            // 6.1 - Version negotiation only for datagram large enough for Initial
+            if (datagram_size < min_initial_datagram_size) return;
+            const size_t size = 1 + 4 + 2 + header.dcid.size() + header.scid.size() + 4 * std::size(supported_versions);
+            FullStream output { reinterpret_cast<uint8_t *>(malloc(size)), size };
+            if (output.IsNull()) throw MemoryAllocationException { };
+            CreateVersionNegotiation(header, output);
+            WriteNoCopy(FixedBuffer { std::move(output) });
+            log<log_t::QUIC_VERSION_NEGOTIATION>(GetFD(), header.version);
+            return;
+        }
+
+        if (ret != err_t::SUCCESS) {
+            log<log_t::QUIC_PACKET_DROPPED>(GetFD(), ret);
+            return;
+        }
+
+        // Client does not expect version negotiation from server
+        if (header.type == packet_type_t::VersionNegotiation) return;
+
+        auto connection = creator.routing_table.Find(header.dcid);
+        if (connection) {
+            connection->ProcessPacket(header, this);
+            continue;
+        }
+
+        if (header.type == packet_type_t::Initial) {
+            if (datagram_size < min_initial_datagram_size) {
+                log<log_t::QUIC_PACKET_DROPPED>(GetFD(), err_t::QUIC_PACKET_MALFORMED);
+                return;
+            }
+            connection = creator.connection_creator.create_connection(header);
+            if (!connection) continue;
+            try {
+                if (!creator.routing_table.Insert(header.dcid, connection)) {
+                    // Retransmitted Initial processed by other thread has created connection first
+                    creator.connection_creator.release_connection(connection);
+                    connection = creator.routing_table.Find(header.dcid);
+                    if (!connection) continue;
+                }
+            } catch(const exception_t &excep) {
+                // Connection was never routed, it is given back to creator
+                creator.connection_creator.release_connection(connection);
+                log<log_t::QUIC_CONNECTION_CREATE_FAILED>(GetFD(), static_cast<err_t>(excep));
+                return;
+            }
+            connection->ProcessPacket(header, this);
+            continue;
+        }
+
+        if (header.type == packet_type_t::OneRTT) {
+            FullStream output { reinterpret_cast<uint8_t *>(malloc(max_stateless_reset_size)), max_stateless_reset_size };
+            if (output.IsNull()) throw MemoryAllocationException { };
+            if (creator.stateless_reset.Create(header.dcid, datagram_size, output)) {
+                WriteNoCopy(FixedBuffer { std::move(output) });
+                log<log_t::QUIC_STATELESS_RESET>(GetFD());
+            } else free(output.Move());
+        }
+        // Handshake and 0-RTT for unknown connection are dropped
+    }
+}
+
+} // namespace MMS::net::quic
@@ -20,7 +20,12 @@
 namespace MMS::net::tcp {
 
 err_t connection_t::ProcessRead() {
-    while(true) {
+    while(!IsReadPaused() && !close_after_write) {
+        if (readbuffer.full() && !readbuffer.Grow()) {
+            // Read buffer is at limit, protocol gets data read till now and read continues
+            ProcessReadBuffer();
+            continue;
+        }
         auto [buffer, buffer_size] = readbuffer.GetRawCurrentBuffer();
         auto ret = ::recv(GetFD(), buffer, buffer_size, MSG_DONTWAIT);
         switch(ret) {
@@ -58,59 +63,75 @@ err_t connection_t::ProcessRead() {
     }
 
 EXIT_LOOP:
-    if (readbuffer.index()) {
-        protocol_implementation->ProcessRead(make_const_stream(readbuffer.begin(), readbuffer.curr()));
-        log<log_t::TCP_CONNECTION_READ>(GetFD(), readbuffer.index());
-    }
+    if (readbuffer.index()) ProcessReadBuffer();
     else log<log_t::TCP_CONNECTION_EMPTY_READ>(GetFD());
 
     return err_t::SUCCESS;
 }
 
 err_t connection_t::ProcessWrite() {
+    // Write can be called again after failed flush from protocol
+    if (GetFD() == 0) return err_t::BAD_FILE_DESCRIPTOR;
     while(!pending_wirte.empty()) {
-        auto &currentbuffer = pending_wirte.front();
-        while(writeoffset != currentbuffer.size()) {
-            const auto buffer = currentbuffer.begin() + writeoffset;
-            size_t size = currentbuffer.size() - writeoffset;
-            auto ret = ::send(GetFD(), buffer, size, MSG_DONTWAIT );
-            if (ret <= -1) {
-                switch(ret) {
-                case EAGAIN:
-                case EALREADY:
-                case ENOBUFS:
-                // case EWOULDBLOCK: EWOULDBLOCK == EAGAIN
-                    return err_t::SOCKET_RETRY;
-
-                case EFAULT:
-                case ENOMEM:
-                    throw exception_t(err_t::CRITICAL_FAILURE);
-
-                // case ECONNREFUSED:
-                // case ENOTCONN:
-                // case EPIPE:
-                // case EBADF:
-                // case EINTR:
-                // case EINVAL:
-                default:
-                    // Close will take care of termination
-                    log<log_t::TCP_SERVER_PEER_WRITE_FAILED>(GetFD(), errno);
-                    Close();
-                    return err_t::BAD_FILE_DESCRIPTOR;
-                }
+        // Queued buffers are written together, frame header and referenced body are not joined in user space
+        std::array<iovec, write_batch_max> iov;
+        size_t count { 0 };
+        size_t size { 0 };
+        for(auto bufferitr = pending_wirte.begin(); bufferitr != pending_wirte.end() && count < iov.size(); ++bufferitr, ++count) {
+            const size_t offset { count ? 0 : writeoffset };
+            iov[count] = iovec { bufferitr->begin() + offset, bufferitr->size() - offset };
+            size += iov[count].iov_len;
+        }
+        msghdr message { };
+        message.msg_iov = iov.data();
+        message.msg_iovlen = count;
+        auto ret = ::sendmsg(GetFD(), &message, MSG_DONTWAIT);
+        if (ret <= -1) {
+            switch(errno) {
+            case EAGAIN:
+            case EALREADY:
+            case ENOBUFS:
+            // case EWOULDBLOCK: EWOULDBLOCK == EAGAIN
+                return err_t::SOCKET_RETRY;
+
+            case EFAULT:
+            case ENOMEM:
+                throw exception_t(err_t::CRITICAL_FAILURE);
+
+            // case ECONNREFUSED:
+            // case ENOTCONN:
+            // case EPIPE:
+            // case EBADF:
+            // case EINTR:
+            // case EINVAL:
+            default:
+                // Close will take care of termination
+                log<log_t::TCP_SERVER_PEER_WRITE_FAILED>(GetFD(), errno);
+                Close();
+                return err_t::BAD_FILE_DESCRIPTOR;
             }
-            writeoffset += ret;
-            if (static_cast<size_t>(ret) < size) return err_t::SOCKET_RETRY;
         }
 
-        writeoffset = 0;
-        pending_wirte.pop();
+        // Written buffers are released, offset is kept in partly written one
+        auto written = writeoffset + static_cast<size_t>(ret);
+        while(!pending_wirte.empty() && written >= pending_wirte.front().size()) {
+            written -= pending_wirte.front().size();
+            pending_wirte.pop_front();
+        }
+        writeoffset = written;
+        if (static_cast<size_t>(ret) < size) return err_t::SOCKET_RETRY;
     }
-    return err_t::SUCCESS;
+    return close_after_write ? err_t::INITIATE_CLOSE : err_t::SUCCESS;
+}
+
+void connection_base_t::ProcessReadBuffer() {
+    protocol_implementation->ProcessRead(make_const_stream(readbuffer.begin(), readbuffer.curr()));
+    log<log_t::TCP_CONNECTION_READ>(GetFD(), readbuffer.index());
+    readbuffer.Reset();
 }
 
 void connection_base_t::WriteNoCopy(FixedBuffer &&buffer) {
-    pending_wirte.emplace(std::move(buffer));
+    pending_wirte.emplace_back(std::move(buffer));
 }
 
 err_t server_t::ProcessRead() {
@@ -35,7 +35,13 @@ const std::string_view server_t::get_protocol(SSL *ssl) {
 }
 
 err_t connection_t::ProcessRead() {
-    while(true) {
+    // Decrypted data kept by SSL does not raise event after resume, hence it is read even when paused
+    while((!IsReadPaused() || SSL_pending(ssl)) && !close_after_write) {
+        if (readbuffer.full() && !readbuffer.Grow()) {
+            // Read buffer is at limit, protocol gets data read till now and read continues
+            ProcessReadBuffer();
+            continue;
+        }
         auto [buffer, buffer_size] = readbuffer.GetRawCurrentBuffer();
         size_t actualread { };
         auto ret = SSL_read_ex(ssl, buffer, buffer_size, &actualread);
@@ -67,50 +73,60 @@ err_t connection_t::ProcessRead() {
     }
 
 EXIT_LOOP:
-    if (readbuffer.index()) {
-        protocol_implementation->ProcessRead(make_const_stream(readbuffer.begin(), readbuffer.curr()));
-        log<log_t::TCP_CONNECTION_READ>(GetFD(), readbuffer.index());
-    }
+    if (readbuffer.index()) ProcessReadBuffer();
     else log<log_t::TCP_CONNECTION_EMPTY_READ>(GetFD());
 
     return err_t::SUCCESS;
 }
 
 err_t connection_t::ProcessWrite() {
-    while(!pending_wirte.empty()) {
-        auto &currentbuffer = pending_wirte.front();
-        while(writeoffset != currentbuffer.size()) {
-            const auto buffer = currentbuffer.begin() + writeoffset;
-            size_t size = currentbuffer.size() - writeoffset;
-            size_t actualwritten { };
-            auto ret = SSL_write_ex(ssl, buffer, size, &actualwritten);
-            if (!ret) {
-                auto ssl_error = SSL_get_error(ssl, ret);
-                switch(ssl_error) {
-                case SSL_ERROR_ZERO_RETURN:
-                    return err_t::ORDERLY_SHUTDOWN;
-
-                case SSL_ERROR_WANT_READ:
-                    return err_t::SUCCESS;
-
-                case SSL_ERROR_WANT_WRITE:
-                    return err_t::SOCKET_RETRY;
-
-                default:
-                    // Close will take care of termination
-                    log<log_t::TCP_SERVER_PEER_WRITE_FAILED>(GetFD(), errno);
-                    Close();
-                    return err_t::BAD_FILE_DESCRIPTOR;
-                }
+    // Write can be called again after failed flush from protocol
+    if (GetFD() == 0) return err_t::BAD_FILE_DESCRIPTOR;
+    while(!pending_wirte.empty() || !coalesced.empty()) {
+        // Small buffers such as frame headers are joined, each write is at least one TLS record.
+        // Large buffer is encrypted from where it is, retry must be with same buffer hence joined buffer is not changed till written.
+        if (coalesced.empty() && writeoffset == 0) {
+            while(!pending_wirte.empty() && pending_wirte.front().size() < coalesce_size_max
+                    && coalesced.size() + pending_wirte.front().size() <= record_size_max) {
+                auto &currentbuffer = pending_wirte.front();
+                coalesced.append(reinterpret_cast<const char *>(currentbuffer.begin()), currentbuffer.size());
+                pending_wirte.pop_front();
             }
-            writeoffset += actualwritten;
-            if (static_cast<size_t>(actualwritten) < size)  return err_t::SOCKET_RETRY;
         }
+        const bool joined { !coalesced.empty() };
+        // Only empty buffers were left
+        if (!joined && pending_wirte.empty()) break;
+        const auto buffer = joined ? reinterpret_cast<const uint8_t *>(coalesced.data()) + writeoffset : pending_wirte.front().begin() + writeoffset;
+        const size_t size { (joined ? coalesced.size() : pending_wirte.front().size()) - writeoffset };
+        size_t actualwritten { };
+        auto ret = SSL_write_ex(ssl, buffer, size, &actualwritten);
+        if (!ret) {
+            auto ssl_error = SSL_get_error(ssl, ret);
+            switch(ssl_error) {
+            case SSL_ERROR_ZERO_RETURN:
+                return err_t::ORDERLY_SHUTDOWN;
+
+            case SSL_ERROR_WANT_READ:
+                return err_t::SUCCESS;
+
+            case SSL_ERROR_WANT_WRITE:
+                return err_t::SOCKET_RETRY;
+
+            default:
+                // Close will take care of termination
+                log<log_t::TCP_SERVER_PEER_WRITE_FAILED>(GetFD(), errno);
+                Close();
+                return err_t::BAD_FILE_DESCRIPTOR;
+            }
+        }
+        writeoffset += actualwritten;
+        if (static_cast<size_t>(actualwritten) < size)  return err_t::SOCKET_RETRY;
 
         writeoffset = 0;
-        pending_wirte.pop();
+        if (joined) coalesced.clear();
+        else pending_wirte.pop_front();
     }
-    return err_t::SUCCESS;
+    return close_after_write ? err_t::INITIATE_CLOSE : err_t::SUCCESS;
 }
 
 err_t server_t::ProcessRead() {
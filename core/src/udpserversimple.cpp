@@ -22,23 +22,36 @@
 namespace MMS::net::udp {
 void server_t::WriteNoCopy(FixedBuffer &&buffer) {
 
-    pending_wirte.emplace(*current_client_addr, std::move(buffer));
+    pending_wirte.emplace_back(*current_client_addr, std::move(buffer));
 }
 
-err_t server_t::ProcessRead() {
-    while(true) {
-        sockaddr_in6 client_addr;
-        client_addr.sin6_family = AF_INET6;
-        socklen_t client_len = sizeof(client_addr);
+thread_local datagram_batch_t server_t::readbatch { };
+
+datagram_batch_t::datagram_batch_t() : buffers { std::make_unique<uint8_t[]>(max_datagrams * max_datagram_size) } {
+    for(size_t index { 0 }; index < max_datagrams; ++index) {
+        iov[index].iov_base = buffers.get() + index * max_datagram_size;
+        iov[index].iov_len = max_datagram_size;
+        auto &msg_hdr = headers[index].msg_hdr;
+        msg_hdr.msg_iov = &iov[index];
+        msg_hdr.msg_iovlen = 1;
+        msg_hdr.msg_name = &addresses[index];
+    }
+}
 
-        auto [buffer, buffer_size] = readbuffer.GetRawCurrentBuffer();
-        ssize_t ret = recvfrom(GetFD(), buffer, buffer_size, 0, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
+int datagram_batch_t::Receive(int fd) {
+    for(size_t index { 0 }; index < max_datagrams; ++index) {
+        // Kernel updates both for every call
+        headers[index].msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+        headers[index].msg_hdr.msg_flags = 0;
+    }
+    return recvmmsg(fd, headers.data(), max_datagrams, MSG_DONTWAIT, nullptr);
+}
 
-        switch(ret) {
-        case 0:
-            return err_t::ORDERLY_SHUTDOWN;
+err_t server_t::ProcessRead() {
+    while(true) {
+        const int ret = readbatch.Receive(GetFD());
 
-        case -1:
+        if (ret == -1) {
             switch(errno) {
             case EAGAIN: // This will be called if no data is available from peer
             // case EWOULDBLOCK: EWOULDBLOCK == EAGAIN
@@ -59,28 +72,47 @@ err_t server_t::ProcessRead() {
                 Close();
                 return err_t::BAD_FILE_DESCRIPTOR;
             }
-            break;
-
-        default:
-            readbuffer += ret;
-            break;
         }
-        if (readbuffer.index()) {
-            current_client_addr = &client_addr;
-            protocol_implementation->ProcessRead(make_const_stream(readbuffer.begin(), readbuffer.curr()));
-            current_client_addr = nullptr;
-            log<log_t::UDP_CONNECTION_READ>(GetFD(), readbuffer.index());
+
+        for(size_t index { 0 }; index < static_cast<size_t>(ret); ++index) {
+            const auto datagram = readbatch.GetDatagram(index);
+            if (readbatch.IsTruncated(index)) {
+                log<log_t::UDP_CONNECTION_TRUNCATED>(GetFD(), datagram.remaining_buffer());
+                continue;
+            }
+            const size_t datagram_size = datagram.remaining_buffer();
+            if (datagram_size) {
+                current_client_addr = readbatch.GetAddress(index);
+                protocol_implementation->ProcessRead(datagram);
+                current_client_addr = nullptr;
+                log<log_t::UDP_CONNECTION_READ>(GetFD(), datagram_size);
+            }
+            else log<log_t::UDP_CONNECTION_EMPTY_READ>(GetFD());
         }
-        else log<log_t::UDP_CONNECTION_EMPTY_READ>(GetFD());
+
+        // Partial batch means socket is drained, epoll will call again for new data
+        if (static_cast<size_t>(ret) < datagram_batch_t::max_datagrams) return err_t::SUCCESS;
     }
 
     return err_t::SUCCESS;
 }
 
 err_t server_t::ProcessWrite() {
+    std::array<mmsghdr, datagram_batch_t::max_datagrams> headers;
+    std::array<iovec, datagram_batch_t::max_datagrams> iov;
     while(!pending_wirte.empty()) {
-        auto &[saddr, currentbuffer] = pending_wirte.front();
-        auto ret = ::sendto(GetFD(), currentbuffer.begin(), currentbuffer.size(), MSG_NOSIGNAL, reinterpret_cast<sockaddr*>(&saddr), sizeof(sockaddr_in6) );
+        const size_t count = std::min(pending_wirte.size(), datagram_batch_t::max_datagrams);
+        for(size_t index { 0 }; index < count; ++index) {
+            auto &[saddr, currentbuffer] = pending_wirte[index];
+            iov[index] = { currentbuffer.begin(), currentbuffer.size() };
+            headers[index] = { };
+            headers[index].msg_hdr.msg_name = &saddr;
+            headers[index].msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+            headers[index].msg_hdr.msg_iov = &iov[index];
+            headers[index].msg_hdr.msg_iovlen = 1;
+        }
+
+        auto ret = ::sendmmsg(GetFD(), headers.data(), static_cast<unsigned int>(count), MSG_NOSIGNAL);
         if (ret <= -1) {
             switch(errno) {
             case EAGAIN:
@@ -106,9 +138,10 @@ err_t server_t::ProcessWrite() {
                 return err_t::BAD_FILE_DESCRIPTOR;
             }
         }
-        if (static_cast<size_t>(ret) < currentbuffer.size()) return err_t::SOCKET_RETRY;
 
-        pending_wirte.pop();
+        // Datagram is either sent completely or not at all
+        for(int index { 0 }; index < ret; ++index) pending_wirte.pop_front();
+        if (static_cast<size_t>(ret) < count) return err_t::SOCKET_RETRY;
     }
     return err_t::SUCCESS;
 }
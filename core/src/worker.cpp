@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <mms/worker.h>
+
+namespace MMS::worker {
+
+pool_t::pool_t(const size_t thread_count) {
+    threads.reserve(thread_count);
+    for(size_t index { 0 }; index < thread_count; ++index) {
+        threads.emplace_back(&pool_t::loop, this);
+    }
+}
+
+pool_t::~pool_t() {
+    {
+        std::lock_guard guard { lock };
+        stopping = true;
+    }
+    ready.notify_all();
+    threads.clear();
+}
+
+void pool_t::Submit(task_t &&task) {
+    {
+        std::lock_guard guard { lock };
+        tasks.push_back(std::move(task));
+    }
+    ready.notify_one();
+}
+
+void pool_t::loop() {
+    for(;;) {
+        task_t task { };
+        {
+            std::unique_lock guard { lock };
+            ready.wait(guard, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace MMS::worker
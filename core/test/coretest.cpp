@@ -17,6 +17,8 @@
 
 
 #include <mms/ds/prefixmap.h>
+#include <mms/net/tcpserver.h>
+#include <mms/worker.h>
 #include <gtest/gtest.h>
 
 bool InsertAndFind() {
@@ -58,6 +60,41 @@ TEST(PrefixMapTest, PrefixMapTest_Insert_Search) {
     EXPECT_TRUE(InsertAndFind());
 }
 
+// Queued buffers are written in one call, owned and referenced buffers are kept in order
+TEST(TCPTest, GatherWrite) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    MMS::net::tcp::connection_t connection { fds[0], nullptr };
+
+    auto owner = std::make_shared<std::string>("referenced body");
+    const std::string_view header { "header:" };
+    auto copied = reinterpret_cast<char *>(malloc(header.size()));
+    std::copy(header.begin(), header.end(), copied);
+    connection.WriteNoCopy(MMS::FixedBuffer { copied, header.size() });
+    connection.WriteNoCopy(MMS::FixedBuffer { owner->data(), owner->size(), owner });
+    EXPECT_EQ(connection.ProcessWrite(), MMS::err_t::SUCCESS);
+    EXPECT_EQ(owner.use_count(), 1);
+
+    char received[64];
+    const auto size = recv(fds[1], received, sizeof(received), MSG_DONTWAIT);
+    EXPECT_EQ(std::string_view(received, size > 0 ? size : 0), "header:referenced body");
+    close(fds[1]);
+}
+
+// Tasks submitted before pool is destroyed are all run
+TEST(WorkerTest, RunsTasks) {
+    constexpr size_t task_count { 1000 };
+    std::atomic<size_t> count { 0 };
+    {
+        MMS::worker::pool_t pool { 4 };
+        EXPECT_EQ(pool.GetThreadCount(), 4);
+        for(size_t index { 0 }; index < task_count; ++index) {
+            pool.Submit([&count]() { ++count; });
+        }
+    }
+    EXPECT_EQ(count, task_count);
+}
+
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <mms/net/quic.h>
+#include <mms/net/udpserversimple.h>
+#include <benchmark/benchmark.h>
+#include <arpa/inet.h>
+
+namespace quic = MMS::net::quic;
+
+class bench_processor_t : public MMS::listener::processor_t {
+public:
+    size_t written { 0 };
+
+    bench_processor_t() : processor_t { 0 } { }
+    MMS::err_t ProcessRead() override { return MMS::err_t::SUCCESS; }
+    void WriteNoCopy(MMS::FixedBuffer &&) override { ++written; }
+};
+
+class bench_connection_t : public quic::connection_t {
+public:
+    size_t packets { 0 };
+    void ProcessPacket(const quic::packet_header_t &, MMS::net::protocol_t *) override { ++packets; }
+};
+
+class bench_connection_creator_t : public quic::connection_creator_t {
+public:
+    std::vector<std::unique_ptr<bench_connection_t>> connections { };
+
+    quic::connection_t *create_connection(const quic::packet_header_t &) override {
+        return connections.emplace_back(std::make_unique<bench_connection_t>()).get();
+    }
+
+    void release_connection(quic::connection_t *connection) override {
+        std::erase_if(connections, [connection](const auto &entry) { return entry.get() == connection; });
+    }
+};
+
+class bench_server_t {
+public:
+    static constexpr size_t cid_length { 8 };
+    static constexpr size_t connection_count { 1024 };
+
+    bench_connection_creator_t connection_creator { };
+    quic::protocol_creator_t protocol_creator { connection_creator, cid_length, connection_count * 4 };
+    bench_processor_t processor { };
+    std::unique_ptr<MMS::net::protocol_t> protocol { protocol_creator.create_protocol(0, { }) };
+    std::vector<quic::connection_id_t> cids { };
+
+    bench_server_t() {
+        protocol->SetProcessor(&processor);
+        for(size_t index { 0 }; index < connection_count; ++index) {
+            std::array<uint8_t, cid_length> id { };
+            for(auto &value: id) value = static_cast<uint8_t>(rand());
+            cids.emplace_back(id.data(), id.size());
+            protocol_creator.GetRoutingTable().Insert(cids.back(), connection_creator.create_connection({ }));
+        }
+    }
+
+    // 1-RTT packet of given size for every connection
+    std::vector<std::vector<uint8_t>> CreatePackets(size_t packet_size) const {
+        std::vector<std::vector<uint8_t>> packets { };
+        for(auto &cid: cids) {
+            auto &packet = packets.emplace_back(packet_size, 0);
+            MMS::FullStream stream { packet.data(), packet.size() };
+            quic::CreateShortHeader(cid, 1, stream);
+        }
+        return packets;
+    }
+};
+
+// Header parse and routing table lookup per packet
+static void BM_QUICParseAndRoute(benchmark::State &state) {
+    bench_server_t server { };
+    const auto packets = server.CreatePackets(static_cast<size_t>(state.range(0)));
+    size_t index { 0 };
+    for (auto _ : state) {
+        const auto &packet = packets[index++ % packets.size()];
+        server.protocol->ProcessRead(MMS::make_const_stream(packet.data(), packet.size()));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["pps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_QUICParseAndRoute)->Arg(64)->Arg(1200);
+
+// Packets sent over loopback with sendmmsg and received by recvmmsg batch
+static void BM_QUICLoopbackBatch(benchmark::State &state) {
+    bench_server_t server { };
+    const auto packets = server.CreatePackets(static_cast<size_t>(state.range(0)));
+
+    const int server_fd = MMS::net::CreateUDPServerSocket(0);
+    sockaddr_in6 server_addr { };
+    socklen_t server_len = sizeof(server_addr);
+    getsockname(server_fd, reinterpret_cast<sockaddr *>(&server_addr), &server_len);
+    inet_pton(AF_INET6, "::1", &server_addr.sin6_addr);
+    const int client_fd = socket(AF_INET6, SOCK_DGRAM, 0);
+    connect(client_fd, reinterpret_cast<sockaddr *>(&server_addr), sizeof(server_addr));
+
+    constexpr size_t batch_size { MMS::net::udp::datagram_batch_t::max_datagrams };
+    std::array<mmsghdr, batch_size> headers { };
+    std::array<iovec, batch_size> iov { };
+    MMS::net::udp::datagram_batch_t batch { };
+    size_t next { 0 };
+    size_t received { 0 };
+
+    for (auto _ : state) {
+        for(size_t index { 0 }; index < batch_size; ++index) {
+            auto &packet = packets[next++ % packets.size()];
+            iov[index] = { const_cast<uint8_t *>(packet.data()), packet.size() };
+            headers[index] = { };
+            headers[index].msg_hdr.msg_iov = &iov[index];
+            headers[index].msg_hdr.msg_iovlen = 1;
+        }
+        sendmmsg(client_fd, headers.data(), batch_size, 0);
+
+        size_t pending { batch_size };
+        while(pending) {
+            const int ret = batch.Receive(server_fd);
+            if (ret <= 0) continue;
+            for(size_t index { 0 }; index < static_cast<size_t>(ret); ++index) {
+                server.protocol->ProcessRead(batch.GetDatagram(index));
+            }
+            pending -= std::min(pending, static_cast<size_t>(ret));
+            received += static_cast<size_t>(ret);
+        }
+    }
+    close(client_fd);
+    close(server_fd);
+
+    state.SetItemsProcessed(static_cast<int64_t>(received));
+    state.counters["pps"] = benchmark::Counter(static_cast<double>(received), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_QUICLoopbackBatch)->Arg(64)->Arg(1200);
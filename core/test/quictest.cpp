@@ -20,7 +20,11 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <mms/net/quic.h>
+#include <mms/net/udpserversimple.h>
 #include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <thread>
+#include <barrier>
 
 std::vector<uint64_t> values16 { 16383, 64, 65, 88, 330, 2345, 2034, 3934, 12445 };
 std::vector<uint64_t> values32 { 16384, 1073741823ULL, 20000, 8000000ULL, 330345677ULL, 43455555ULL, 203432423ULL, 39342344ULL, 124544343ULL };
@@ -69,4 +73,340 @@ TEST(QUICTest, IntegerTestU64) {
         EXPECT_EQ(size, 8);
         EXPECT_EQ(value, decoded);
     }
-}
\ No newline at end of file
+}
+
+namespace quic = MMS::net::quic;
+
+// Captures everything server writes, stands in for udp::server_t
+class loopback_processor_t : public MMS::listener::processor_t {
+public:
+    std::vector<std::vector<uint8_t>> written { };
+
+    loopback_processor_t() : processor_t { 0 } { }
+    MMS::err_t ProcessRead() override { return MMS::err_t::SUCCESS; }
+    void WriteNoCopy(MMS::FixedBuffer &&buffer) override { written.emplace_back(buffer.begin(), buffer.end()); }
+};
+
+class test_connection_t : public quic::connection_t {
+public:
+    size_t packets { 0 };
+    quic::packet_type_t last_type { };
+
+    void ProcessPacket(const quic::packet_header_t &header, MMS::net::protocol_t *writer) override {
+        ++packets;
+        last_type = header.type;
+        writer->Write(std::string_view { "ACK" });
+    }
+};
+
+class test_connection_creator_t : public quic::connection_creator_t {
+public:
+    std::vector<std::unique_ptr<test_connection_t>> connections { };
+
+    quic::connection_t *create_connection(const quic::packet_header_t &) override {
+        return connections.emplace_back(std::make_unique<test_connection_t>()).get();
+    }
+
+    void release_connection(quic::connection_t *connection) override {
+        std::erase_if(connections, [connection](const auto &entry) { return entry.get() == connection; });
+    }
+};
+
+// Local loopback client, it builds client packets and feeds them to QUIC
+// protocol the same way udp::server_t does for every datagram in a batch.
+class loopback_client_t {
+public:
+    static constexpr size_t cid_length { 8 };
+
+    test_connection_creator_t connection_creator { };
+    quic::protocol_creator_t protocol_creator { connection_creator, cid_length, 64 };
+    loopback_processor_t processor { };
+    std::unique_ptr<MMS::net::protocol_t> protocol { protocol_creator.create_protocol(0, { }) };
+    MMS::FullStreamAutoAlloc datagram { 2048 };
+
+    loopback_client_t() { protocol->SetProcessor(&processor); }
+
+    static quic::connection_id_t MakeCID(uint8_t seed, size_t length = cid_length) {
+        std::array<uint8_t, quic::max_connection_id_length> id { };
+        for(size_t index { 0 }; index < length; ++index) id[index] = static_cast<uint8_t>(seed + index);
+        return quic::connection_id_t { id.data(), length };
+    }
+
+    void AddInitial(const quic::connection_id_t &dcid, uint32_t version = quic::version_1) {
+        const std::string payload { "CRYPTO" };
+        quic::CreateInitial(dcid, MakeCID(0xa0), version, 0, MMS::make_const_stream(payload), datagram);
+    }
+
+    void AddShort(const quic::connection_id_t &dcid, size_t payload_size) {
+        quic::CreateShortHeader(dcid, 1, datagram);
+        std::fill_n(datagram.GetCurrAndIncrease(payload_size), payload_size, 0x55);
+    }
+
+    void Send() {
+        protocol->ProcessRead(MMS::make_const_stream(datagram.begin(), datagram.curr()));
+        datagram.Reset();
+    }
+};
+
+TEST(QUICTest, ParseInitialHeader) {
+    loopback_client_t client { };
+    const auto dcid = loopback_client_t::MakeCID(0x10, 20);
+    client.AddInitial(dcid);
+
+    quic::packet_header_t header { };
+    const auto stream = MMS::make_const_stream(client.datagram.begin(), client.datagram.curr());
+    EXPECT_EQ(quic::ParseHeader(stream, loopback_client_t::cid_length, header), MMS::err_t::SUCCESS);
+    EXPECT_EQ(header.type, quic::packet_type_t::Initial);
+    EXPECT_EQ(header.version, quic::version_1);
+    EXPECT_EQ(header.dcid, dcid);
+    EXPECT_EQ(header.scid, loopback_client_t::MakeCID(0xa0));
+    EXPECT_EQ(header.token_length, 0);
+    EXPECT_EQ(header.packet_size, client.datagram.index());
+    EXPECT_GE(header.packet_size, quic::min_initial_datagram_size);
+    EXPECT_EQ(stream.remaining_buffer(), 0);
+}
+
+TEST(QUICTest, ParseShortHeader) {
+    loopback_client_t client { };
+    const auto dcid = loopback_client_t::MakeCID(0x20);
+    client.AddShort(dcid, 30);
+
+    quic::packet_header_t header { };
+    const auto stream = MMS::make_const_stream(client.datagram.begin(), client.datagram.curr());
+    EXPECT_EQ(quic::ParseHeader(stream, loopback_client_t::cid_length, header), MMS::err_t::SUCCESS);
+    EXPECT_EQ(header.type, quic::packet_type_t::OneRTT);
+    EXPECT_EQ(header.dcid, dcid);
+    EXPECT_EQ(header.header_size, 1 + loopback_client_t::cid_length);
+    EXPECT_EQ(header.packet_size, 1 + loopback_client_t::cid_length + 4 + 30);
+}
+
+TEST(QUICTest, ParseMalformedHeader) {
+    // Connection ID length is more than 20 for version 1
+    const uint8_t bad_cid[] { 0xc0, 0x00, 0x00, 0x00, 0x01, 21, 0x00 };
+    // Length is more than remaining packet
+    const uint8_t bad_length[] { 0xc0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x40, 0x20, 0x00 };
+    // Fixed bit is not set
+    const uint8_t bad_fixed[] { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09 };
+    for(auto [data, size]: { std::make_pair(bad_cid, sizeof(bad_cid)), std::make_pair(bad_length, sizeof(bad_length)), std::make_pair(bad_fixed, sizeof(bad_fixed)) }) {
+        quic::packet_header_t header { };
+        EXPECT_EQ(quic::ParseHeader(MMS::make_const_stream(data, size), loopback_client_t::cid_length, header), MMS::err_t::QUIC_PACKET_MALFORMED);
+    }
+}
+
+TEST(QUICTest, CoalescedPacketRouting) {
+    loopback_client_t client { };
+    const auto dcid = loopback_client_t::MakeCID(0x30);
+    client.AddInitial(dcid);
+    client.Send();
+    ASSERT_EQ(client.connection_creator.connections.size(), 1);
+    auto &connection = *client.connection_creator.connections[0];
+    EXPECT_EQ(connection.packets, 1);
+
+    // Initial followed by short header in same datagram, both belong to same connection
+    client.AddInitial(dcid);
+    client.AddShort(dcid, 20);
+    client.Send();
+    EXPECT_EQ(client.connection_creator.connections.size(), 1);
+    EXPECT_EQ(connection.packets, 3);
+    EXPECT_EQ(connection.last_type, quic::packet_type_t::OneRTT);
+    EXPECT_EQ(client.processor.written.size(), 3);
+}
+
+TEST(QUICTest, RoutingTableFull) {
+    loopback_client_t client { };
+    test_connection_t routed { };
+    for(uint8_t index { 0 }; index < 64; ++index) client.protocol_creator.GetRoutingTable().Insert(loopback_client_t::MakeCID(index, 4), &routed);
+
+    // Connection that could not be routed is given back to creator
+    client.AddInitial(loopback_client_t::MakeCID(0x30));
+    client.Send();
+    EXPECT_TRUE(client.connection_creator.connections.empty());
+}
+
+TEST(QUICTest, VersionNegotiation) {
+    loopback_client_t client { };
+    const auto dcid = loopback_client_t::MakeCID(0x40);
+    client.AddInitial(dcid, 0x1a2a3a4a);
+    client.Send();
+    EXPECT_TRUE(client.connection_creator.connections.empty());
+    ASSERT_EQ(client.processor.written.size(), 1);
+
+    const auto &response = client.processor.written[0];
+    quic::packet_header_t header { };
+    EXPECT_EQ(quic::ParseHeader(MMS::make_const_stream(response.data(), response.size()), 0, header), MMS::err_t::SUCCESS);
+    EXPECT_EQ(header.type, quic::packet_type_t::VersionNegotiation);
+    EXPECT_EQ(header.dcid, loopback_client_t::MakeCID(0xa0));
+    EXPECT_EQ(header.scid, dcid);
+    const uint8_t version_1[] { 0x00, 0x00, 0x00, 0x01 };
+    EXPECT_TRUE(std::equal(std::begin(version_1), std::end(version_1), response.data() + header.header_size));
+
+    // Too small to be Initial, no negotiation
+    const uint8_t small[] { 0xc0, 0x1a, 0x2a, 0x3a, 0x4a, 0x00, 0x00 };
+    client.protocol->ProcessRead(MMS::make_const_stream(small, sizeof(small)));
+    EXPECT_EQ(client.processor.written.size(), 1);
+}
+
+TEST(QUICTest, StatelessReset) {
+    loopback_client_t client { };
+    const auto dcid = loopback_client_t::MakeCID(0x50);
+    client.AddShort(dcid, 60);
+    const auto sent_size = client.datagram.index();
+    client.Send();
+    ASSERT_EQ(client.processor.written.size(), 1);
+
+    const auto &response = client.processor.written[0];
+    EXPECT_LT(response.size(), sent_size);
+    EXPECT_GE(response.size(), quic::min_stateless_reset_size);
+    const auto token = client.protocol_creator.GetStatelessReset().GetToken(dcid);
+    EXPECT_TRUE(quic::stateless_reset_t::IsStatelessReset(MMS::make_const_stream(response.data(), response.size()), token));
+    EXPECT_FALSE(quic::stateless_reset_t::IsStatelessReset(MMS::make_const_stream(response.data(), response.size()), client.protocol_creator.GetStatelessReset().GetToken(loopback_client_t::MakeCID(0x51))));
+
+    // Reset for smallest reset would create loop, nothing is sent
+    client.AddShort(dcid, 8);
+    client.Send();
+    EXPECT_EQ(client.processor.written.size(), 1);
+}
+
+TEST(QUICTest, ConnectionTable) {
+    quic::connection_table_t<int> table { 8 };
+    std::array<int, 8> values { };
+    for(uint8_t index { 0 }; index < 8; ++index) EXPECT_TRUE(table.Insert(loopback_client_t::MakeCID(index * 16), &values[index]));
+    EXPECT_FALSE(table.Insert(loopback_client_t::MakeCID(0), &values[0]));
+    EXPECT_THROW(table.Insert(loopback_client_t::MakeCID(0xf0), &values[0]), MMS::exception_t);
+    EXPECT_EQ(table.size(), 8);
+
+    for(uint8_t index { 0 }; index < 8; ++index) EXPECT_EQ(table.Find(loopback_client_t::MakeCID(index * 16)), &values[index]);
+    EXPECT_EQ(table.Find(loopback_client_t::MakeCID(0x01)), nullptr);
+
+    EXPECT_EQ(table.Remove(loopback_client_t::MakeCID(0x20)), &values[2]);
+    EXPECT_EQ(table.Find(loopback_client_t::MakeCID(0x20)), nullptr);
+    EXPECT_EQ(table.Remove(loopback_client_t::MakeCID(0x20)), nullptr);
+    EXPECT_TRUE(table.Insert(loopback_client_t::MakeCID(0xf0), &values[2]));
+    EXPECT_EQ(table.Find(loopback_client_t::MakeCID(0xf0)), &values[2]);
+    for(uint8_t index { 3 }; index < 8; ++index) EXPECT_EQ(table.Find(loopback_client_t::MakeCID(index * 16)), &values[index]);
+}
+
+TEST(QUICTest, ConnectionTableDeletedSlots) {
+    quic::connection_table_t<int> table { 64 };
+    std::array<int, 48> values { };
+    // Churn of distinct connection IDs leaves deleted slots, they are rebuilt to empty
+    for(size_t round { 0 }; round < 16; ++round) {
+        for(size_t index { 0 }; index < values.size(); ++index) {
+            EXPECT_TRUE(table.Insert(loopback_client_t::MakeCID(static_cast<uint8_t>(index), static_cast<uint8_t>(4 + round)), &values[index]));
+        }
+        for(size_t index { 1 }; index < values.size(); ++index) {
+            EXPECT_EQ(table.Remove(loopback_client_t::MakeCID(static_cast<uint8_t>(index), static_cast<uint8_t>(4 + round))), &values[index]);
+        }
+        EXPECT_LT(table.deleted_size(), 16);
+        EXPECT_EQ(table.size(), round + 1);
+    }
+    for(size_t round { 0 }; round < 16; ++round) EXPECT_EQ(table.Find(loopback_client_t::MakeCID(0, static_cast<uint8_t>(4 + round))), &values[0]);
+    EXPECT_EQ(table.Find(loopback_client_t::MakeCID(1, 4)), nullptr);
+}
+
+TEST(QUICTest, ConnectionTableConcurrentLookup) {
+    quic::connection_table_t<int> table { 1024 };
+    std::array<int, 256> values { };
+    for(size_t index { 0 }; index < 128; ++index) table.Insert(loopback_client_t::MakeCID(static_cast<uint8_t>(index)), &values[index]);
+
+    std::atomic<bool> stop { false };
+    std::atomic<size_t> mismatch { 0 };
+    std::vector<std::jthread> readers { };
+    for(size_t thread { 0 }; thread < 4; ++thread) {
+        readers.emplace_back([&]() {
+            while(!stop.load()) {
+                for(size_t index { 0 }; index < 128; ++index) {
+                    if (table.Find(loopback_client_t::MakeCID(static_cast<uint8_t>(index))) != &values[index]) ++mismatch;
+                }
+            }
+        });
+    }
+
+    // Churn other connection IDs while readers are looking up stable one.
+    // Length changes every round, deleted slots pile up and table is rebuilt under readers.
+    for(size_t round { 0 }; round < 2000; ++round) {
+        const size_t length { 4 + round % 16 };
+        for(size_t index { 128 }; index < 256; ++index) table.Insert(loopback_client_t::MakeCID(static_cast<uint8_t>(index), length), &values[index]);
+        for(size_t index { 128 }; index < 256; ++index) table.Remove(loopback_client_t::MakeCID(static_cast<uint8_t>(index), length));
+    }
+    stop = true;
+    readers.clear();
+    EXPECT_EQ(mismatch.load(), 0);
+    EXPECT_EQ(table.size(), 128);
+}
+
+TEST(QUICTest, ConnectionTableConcurrentInsert) {
+    constexpr size_t thread_count { 4 };
+    constexpr size_t cid_count { 64 };
+    constexpr size_t round_count { 2000 };
+    quic::connection_table_t<int> table { 128 };
+    std::array<int, thread_count> values { };
+
+    // Every thread inserts same connection IDs, alternate thread in reverse order so that they cross.
+    // Only one insert of each must succeed. All are removed at end of round, hence deleted slots are reused.
+    std::array<std::atomic<size_t>, cid_count> inserted { };
+    size_t round { 0 };
+    size_t mismatch { 0 };
+    auto end_round = [&]() noexcept {
+        if (table.size() != cid_count) ++mismatch;
+        for(size_t index { 0 }; index < cid_count; ++index) {
+            const auto cid = loopback_client_t::MakeCID(static_cast<uint8_t>(index));
+            if (inserted[index].exchange(0) != 1) ++mismatch;
+            table.Remove(cid);
+            if (table.Find(cid)) ++mismatch;
+        }
+        if (table.size()) ++mismatch;
+        ++round;
+    };
+    std::barrier end { thread_count, end_round };
+
+    std::vector<std::jthread> writers { };
+    for(size_t thread { 0 }; thread < thread_count; ++thread) {
+        writers.emplace_back([&, thread]() {
+            for(size_t current { 0 }; current < round_count; ++current) {
+                for(size_t count { 0 }; count < cid_count; ++count) {
+                    const auto index = thread % 2 ? cid_count - 1 - count : count;
+                    if (table.Insert(loopback_client_t::MakeCID(static_cast<uint8_t>(index)), &values[thread])) ++inserted[index];
+                }
+                end.arrive_and_wait();
+            }
+        });
+    }
+    writers.clear();
+    EXPECT_EQ(round, round_count);
+    EXPECT_EQ(mismatch, 0);
+}
+
+TEST(QUICTest, DatagramBatchReceive) {
+    const int server = MMS::net::CreateUDPServerSocket(0);
+    sockaddr_in6 server_addr { };
+    socklen_t server_len = sizeof(server_addr);
+    getsockname(server, reinterpret_cast<sockaddr *>(&server_addr), &server_len);
+    inet_pton(AF_INET6, "::1", &server_addr.sin6_addr);
+
+    const int client = socket(AF_INET6, SOCK_DGRAM, 0);
+    ASSERT_GE(client, 0);
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr *>(&server_addr), sizeof(server_addr)), 0);
+    for(size_t index { 0 }; index < 5; ++index) {
+        const std::string datagram(100 + index, 'a');
+        ASSERT_EQ(send(client, datagram.data(), datagram.size(), 0), static_cast<ssize_t>(datagram.size()));
+    }
+
+    MMS::net::udp::datagram_batch_t batch { };
+    size_t received { 0 };
+    for(size_t attempt { 0 }; attempt < 100 && received < 5; ++attempt) {
+        const int ret = batch.Receive(server);
+        if (ret <= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        for(size_t index { 0 }; index < static_cast<size_t>(ret); ++index) {
+            EXPECT_EQ(batch.GetDatagram(index).remaining_buffer(), 100 + received);
+            EXPECT_FALSE(batch.IsTruncated(index));
+            ++received;
+        }
+    }
+    EXPECT_EQ(received, 5);
+    close(client);
+    close(server);
+}
@@ -35,4 +35,16 @@ TEST(StreamTest, ConstStream) {
     auto stream = MMS::make_const_stream(text, textsize);
 
     EXPECT_TRUE(stream.remaining_buffer() == textsize);
-}
\ No newline at end of file
+}
+TEST(StreamTest, FixedBufferOwner) {
+    auto owner = std::make_shared<std::string>("Shared body");
+    {
+        MMS::FixedBuffer buffer { owner->data() + 7, 4, owner };
+        EXPECT_EQ(owner.use_count(), 2);
+        MMS::FixedBuffer moved { std::move(buffer) };
+        EXPECT_EQ(owner.use_count(), 2);
+        EXPECT_EQ(std::string_view(reinterpret_cast<const char *>(moved.begin()), moved.size()), "body");
+    }
+    // Memory is kept by owner, buffer does not free it
+    EXPECT_EQ(owner.use_count(), 1);
+}
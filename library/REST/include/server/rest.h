@@ -29,6 +29,8 @@ public:
     handler(const handler &) = delete;
     handler &operator=(const handler &) = delete;
 
+    // Service API takes body as string, hence HTTP/1.1 request view is copied by base
+    using http::handler_t::ProcessRead;
     void ProcessRead(const MMS::http::request &request, const std::string &relative_path, http::protocol_t *writer) override;
 
     constexpr const std::vector<http::METHOD> &GetSupportedMethod() override {
@@ -45,6 +47,9 @@ public:
         return method == http::METHOD::GET || method == http::METHOD::PUT || method == http::METHOD::POST || method == http::METHOD::DELETE;
     }
 
+    // Service call may wait on its backend
+    bool IsBlocking() const override { return true; }
+
 };
 
 } // namespace MMS::server::rest
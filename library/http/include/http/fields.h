@@ -0,0 +1,134 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <http/httpdef.h>
+#include <mms/ds/smallvector.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace MMS::http {
+
+// Fields of one message. All values are appended to one buffer and entry keeps offset and length in it.
+// Entries are searched linearly, for usual field count this stays in few cache lines and is faster than hash.
+// Method and path have dedicated slot, hence request line lookup does not scan fields.
+class fields_t {
+public:
+    static constexpr size_t inline_count = 16;
+    // Buffer is reserved once, this is enough for most requests
+    static constexpr size_t initial_buffer = 512;
+
+    struct entry_t {
+        FIELD field { FIELD::IGNORE_THIS };
+        uint32_t offset { 0 };
+        uint32_t length { 0 };
+    };
+
+    using value_type = std::pair<FIELD, std::string_view>;
+
+    class const_iterator {
+        const entry_t *entry;
+        const char *buffer;
+
+    public:
+        constexpr const_iterator(const entry_t *entry, const char *buffer) : entry { entry }, buffer { buffer } { }
+        constexpr value_type operator*() const { return { entry->field, { buffer + entry->offset, entry->length } }; }
+        constexpr const_iterator &operator++() { ++entry; return *this; }
+        constexpr bool operator==(const const_iterator &other) const { return entry == other.entry; }
+    };
+
+private:
+    std::string buffer { };
+    smallvector<entry_t, inline_count> entries { };
+    entry_t method { FIELD::Method };
+    entry_t path { FIELD::Path };
+
+    constexpr entry_t append(const FIELD field, const std::string_view value) {
+        if (buffer.empty()) buffer.reserve(initial_buffer);
+        entry_t entry { field, static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(value.size()) };
+        buffer.append(value);
+        return entry;
+    }
+
+    constexpr std::string_view view(const entry_t &entry) const { return { buffer.data() + entry.offset, entry.length }; }
+
+    constexpr entry_t *find(const FIELD field) {
+        if (field == FIELD::Method) return &method;
+        if (field == FIELD::Path) return &path;
+        for(auto &entry: entries) {
+            if (entry.field == field) return &entry;
+        }
+        return nullptr;
+    }
+
+    constexpr const entry_t *find(const FIELD field) const { return const_cast<fields_t *>(this)->find(field); }
+
+    // Slot without value is not set, request line does not have empty method or path
+    constexpr bool is_empty_slot(const entry_t *entry) const { return (entry == &method || entry == &path) && !entry->length; }
+
+public:
+    constexpr fields_t() { }
+
+    constexpr const_iterator begin() const { return { entries.begin(), buffer.data() }; }
+    constexpr const_iterator end() const { return { entries.end(), buffer.data() }; }
+    // Method and path are not counted
+    constexpr size_t size() const { return entries.size(); }
+    constexpr bool empty() const { return entries.empty(); }
+
+    constexpr bool contains(const FIELD field) const {
+        auto entry = find(field);
+        return entry && !is_empty_slot(entry);
+    }
+
+    constexpr std::string_view get(const FIELD field) const {
+        auto entry = find(field);
+        if (entry) return view(*entry);
+        return { };
+    }
+
+    constexpr std::string_view get_method() const { return view(method); }
+    constexpr std::string_view get_path() const { return view(path); }
+
+    // Existing value is kept, returns false in that case
+    constexpr bool add(const FIELD field, const std::string_view value) {
+        auto entry = find(field);
+        if (entry && !is_empty_slot(entry)) return false;
+        auto newentry = append(field, value);
+        if (entry) *entry = newentry;
+        else entries.push_back(newentry);
+        return true;
+    }
+
+    // Existing value is replaced, old value stays in buffer till clear
+    constexpr void set(const FIELD field, const std::string_view value) {
+        auto entry = find(field);
+        auto newentry = append(field, value);
+        if (entry) *entry = newentry;
+        else entries.push_back(newentry);
+    }
+
+    constexpr void clear() {
+        buffer.clear();
+        entries.clear();
+        method = { FIELD::Method };
+        path = { FIELD::Path };
+    }
+}; // class fields_t
+
+} // namespace MMS::http
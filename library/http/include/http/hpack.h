@@ -22,7 +22,11 @@
 #pragma once
 #include <http/httpparser.h>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <limits>
+#include <utility>
 #include <mms/base/error.h>
 #include <mms/listener.h>
 
@@ -53,7 +57,9 @@ private:
 
 public:
     inline map_table_t() { }
-    inline map_table_t(const std::initializer_list<std::pair<FIELD, std::string>> &list) : entries { list } { }
+    inline map_table_t(const std::initializer_list<std::pair<FIELD, std::string>> &list) {
+        for(auto &entry: list) push_back(entry);
+    }
     map_table_t(const map_table_t &) = delete;
     map_table_t &operator=(const map_table_t &) = delete;
 
@@ -144,28 +150,104 @@ public:
 
 };
 
-class dynamic_table_t : public map_table_t {
+// rfc7541 - 4.1.  Calculating Table Size
+constexpr size_t entry_overhead { 32 };
+constexpr size_t entry_size(const size_t name_size, const size_t value_size) { return name_size + value_size + entry_overhead; }
+
+// rfc7541 - 2.3.2.  Dynamic Table
+// Entries are kept in ring buffer in insertion order and evicted from oldest, size is in octets.
+// Entry gets absolute index on insert which never changes, newest entry is index 0 of table.
+// Lookup maps keep absolute index hence insert and evict do not update other entries.
+class dynamic_table_t {
 private:
+    struct entry_t {
+        std::pair<FIELD, std::string> header { };
+        size_t size { 0 };
+    };
+
+    static constexpr size_t initial_entries { 16 };
+
+    // Capacity is power of two, absolute index masked by capacity is position
+    std::vector<entry_t> entries;
+    std::unordered_map<std::pair<FIELD, std::string>, uint64_t> entry_value_map { };
+    std::unordered_map<FIELD, uint64_t> entry_map { };
+
+    // Decoder only addresses by index, lookup maps are for encoder
+    const bool lookup;
+    // SETTINGS_HEADER_TABLE_SIZE, size update can not go over it
+    size_t size_limit;
     size_t max_size;
+    size_t table_size { 0 };
+    uint64_t insert_count { 0 };
+    uint64_t dropped_count { 0 };
+    // Encoder must signal new maximum size at start of next header block
+    bool size_update_pending { false };
+
+    inline auto &entry(const uint64_t absolute_index) { return entries[absolute_index & (entries.size() - 1)]; }
+    inline const auto &entry(const uint64_t absolute_index) const { return entries[absolute_index & (entries.size() - 1)]; }
+
+    void evict();
+    void grow();
 
 public:
-    dynamic_table_t(size_t max_size = 12) : map_table_t { }, max_size { max_size } {}
+    static constexpr size_t npos { static_cast<size_t>(-1) };
 
-    inline void update_size(size_t new_size) {
-        if (max_size == new_size) return;
-        max_size = new_size;
-        while (new_size < size()) {
-            pop_back();
-        }
+    dynamic_table_t(const size_t size_limit = 4096, const bool lookup = true)
+        : entries(initial_entries), lookup { lookup }, size_limit { size_limit }, max_size { size_limit } { }
+    dynamic_table_t(const dynamic_table_t &) = delete;
+    dynamic_table_t &operator=(const dynamic_table_t &) = delete;
+
+    inline size_t count() const { return static_cast<size_t>(insert_count - dropped_count); }
+    inline size_t size() const { return table_size; }
+    inline size_t get_max_size() const { return max_size; }
+    inline size_t get_size_limit() const { return size_limit; }
+    inline uint64_t get_insert_count() const { return insert_count; }
+
+    // Index 0 is newest entry, index 62 on wire
+    inline const auto &operator[](const size_t index) const {
+        if (index >= count()) throw HPACKException { err_t::HPACK_TABLE_OUT_OF_RANGE };
+        return entry(insert_count - 1 - index).header;
     }
 
-    inline void insert(const std::pair<FIELD, std::string> &entry) {
-        if (size() >= max_size) {
-            // rfc7541 - 4.4.  Entry Eviction When Adding New Entries
-            clear();
-        }
-        push_back(entry);
+    // Size of name as it was on wire
+    inline size_t get_name_size(const size_t index) const {
+        const auto &header = (*this)[index];
+        return entry(insert_count - 1 - index).size - header.second.size() - entry_overhead;
     }
+
+    // Returns index of newest entry or npos
+    inline size_t find(const std::pair<FIELD, std::string> &header_line) const {
+        auto entry_itr = entry_value_map.find(header_line);
+        if (entry_itr == entry_value_map.end()) return npos;
+        return static_cast<size_t>(insert_count - 1 - entry_itr->second);
+    }
+
+    inline size_t find(const FIELD field) const {
+        auto entry_itr = entry_map.find(field);
+        if (entry_itr == entry_map.end()) return npos;
+        return static_cast<size_t>(insert_count - 1 - entry_itr->second);
+    }
+
+    // Returns index of entry inserted as absolute_index, npos if it is evicted
+    inline size_t find_absolute(const uint64_t absolute_index) const {
+        if (absolute_index < dropped_count || absolute_index >= insert_count) return npos;
+        return static_cast<size_t>(insert_count - 1 - absolute_index);
+    }
+
+    // name_size is size of name on wire, FIELD::IGNORE_THIS does not carry it.
+    // Entry larger than maximum size empties table, this is not an error.
+    // Returns absolute index of new entry, npos if it is not inserted.
+    uint64_t insert(const std::pair<FIELD, std::string> &header_line, const size_t name_size);
+
+    // Dynamic table size update from encoder in header block
+    // https://www.rfc-editor.org/rfc/rfc7541.html#section-6.3
+    void update_size(const size_t new_size);
+
+    // Encoder follows peer SETTINGS_HEADER_TABLE_SIZE, change is signalled in next header block
+    void set_size_limit(const size_t new_limit);
+
+    // Returns true once after maximum size is changed by set_size_limit
+    inline bool take_size_update() { return std::exchange(size_update_pending, false); }
 };
 
 class static_table_t : public map_table_t {
@@ -175,6 +257,14 @@ public:
 
 extern const static_table_t static_table;
 
+// Static table is followed by dynamic table in index space
+// https://www.rfc-editor.org/rfc/rfc7541.html#section-2.3.3
+constexpr uint32_t dynamic_table_first_index { 62 };
+
+inline const std::pair<FIELD, std::string> &get_indexed(const dynamic_table_t &dynamic_table, const size_t index) {
+    return index < dynamic_table_first_index ? static_table[index] : dynamic_table[index - dynamic_table_first_index];
+}
+
 // Static table entry defined in
 // https://www.rfc-editor.org/rfc/rfc7541.html#appendix-A
 #define HTTP2_STATIC_TABLE_LIST \
@@ -242,25 +332,6 @@ extern const static_table_t static_table;
     HTTP2_STATIC_TABLE_ENTRY(61, FIELD::WWW_Authenticate, "") \
     LIST_DEFINITION_END
 
-class node {
-    int16_t symbol { -1 };
-
-public:
-    node *left { nullptr };
-    node *right { nullptr };
-
-    constexpr node() { }
-
-    constexpr auto is_leaf() const { return left == nullptr && right == nullptr; }
-    
-    constexpr void set_leaf(const uint16_t symbol) {
-        this->symbol = symbol;
-    }
-
-    constexpr auto is_eos() const { return symbol == 256; }
-    constexpr auto get_symbol() const { return static_cast<char>(symbol); }
-};
-
 // Integer representation, decode and encode is defined in
 // https://www.rfc-editor.org/rfc/rfc7541.html#section-5.1
 template <uint32_t N>
@@ -270,16 +341,14 @@ constexpr auto decode_integer(const Stream &stream) {
     if (value < mask) {
         return value;
     }
-    value = mask;
-    while(!stream.full()) {
-        if ((*stream & 0x80) != 0) {
-            value = *stream++ & 0x7f;
-        } else {
-            value = *stream++;
-            break;
-        }
+    for(uint32_t shift { 0 }; !stream.full() && shift <= 28; shift += 7) {
+        const uint32_t octet { *stream++ };
+        const uint64_t newvalue { value + (static_cast<uint64_t>(octet & 0x7f) << shift) };
+        if (newvalue > std::numeric_limits<uint32_t>::max()) break;
+        value = static_cast<uint32_t>(newvalue);
+        if ((octet & 0x80) == 0) return value;
     }
-    return value;
+    throw HPACKException { err_t::HPACK_INTEGER_OVERFLOW };
 }
 
 template <uint32_t N>
@@ -291,7 +360,7 @@ constexpr void encode_integer(Stream &stream, const uint8_t head, std::unsigned_
         *stream++ = head + mask;
         value -= mask;
         while(value >= 128) {
-            *stream++ = 0x80 & (value % 128);
+            *stream++ = 0x80 | (value % 128);
             value >>= 7;
         }
         *stream++ = value;
@@ -310,7 +379,7 @@ struct huffman_entry {
 // Huffnam table entry defined at
 // https://www.rfc-editor.org/rfc/rfc7541.html#appendix-B
 constexpr const huffman_entry static_huffman[] = {
-    {    0x1ff8, 13}, {  0x7fffd8, 23}, { 0xfffffe2, 28}, { 0xfffffe3, 28}, { 0xfffffe4, 28}, { 0xfffffe5, 28}, { 0xfffffe5, 28}, { 0xfffffe7, 28}, //000-007
+    {    0x1ff8, 13}, {  0x7fffd8, 23}, { 0xfffffe2, 28}, { 0xfffffe3, 28}, { 0xfffffe4, 28}, { 0xfffffe5, 28}, { 0xfffffe6, 28}, { 0xfffffe7, 28}, //000-007
     { 0xfffffe8, 28}, {  0xffffea, 24}, {0x3ffffffc, 30}, { 0xfffffe9, 28}, { 0xfffffea, 28}, {0x3ffffffd, 30}, { 0xfffffeb, 28}, { 0xfffffec, 28}, //008-015
     { 0xfffffed, 28}, { 0xfffffee, 28}, { 0xfffffef, 28}, { 0xffffff0, 28}, { 0xffffff1, 28}, { 0xffffff2, 28}, {0x3ffffffe, 30}, { 0xffffff3, 28}, //016-023
     { 0xffffff4, 28}, { 0xffffff5, 28}, { 0xffffff6, 28}, { 0xffffff7, 28}, { 0xffffff8, 28}, { 0xffffff9, 28}, { 0xffffffa, 28}, { 0xffffffb, 28}, //024-031
@@ -345,9 +414,33 @@ constexpr const huffman_entry static_huffman[] = {
     {0x3fffffff, 30}                                                                                                                                //256
 };
 
-node *created_huffman_tree();
+// Huffman decoding is driven by table with 4 bits of input at a time.
+// State is internal node of Huffman tree, 257 symbols have 256 internal nodes.
+// Shortest code is 5 bits, hence one nibble decodes at most one symbol.
+struct huffman_decode_entry {
+    enum flag_t : uint8_t {
+        SYMBOL  = 0x01, // Symbol is decoded with this nibble
+        ACCEPT  = 0x02, // String can end in next state, it is padding of at most 7 one bits
+        FAIL    = 0x04, // EOS is decoded
+    };
+
+    uint8_t state;
+    uint8_t flags;
+    uint8_t symbol;
+};
+
+using huffman_decode_table_t = std::array<std::array<huffman_decode_entry, 16>, 256>;
+
+// Table is created at compile time from static_huffman
+extern const huffman_decode_table_t huffman_decode_table;
 
-extern const node *huffman_root;
+// Every symbol is at least 5 bits, one more byte is for decoder which writes before it checks for symbol
+constexpr size_t huffman_decoded_max_size(const size_t size) { return size * 8 / 5 + 1; }
+
+// Output must have huffman_decoded_max_size of input.
+// Returns end of decoded string, nullptr if padding is not EOS prefix or EOS is decoded.
+// https://www.rfc-editor.org/rfc/rfc7541.html#section-5.2
+char *decode_huffman(const uint8_t *begin, const uint8_t *end, char *output);
 
 std::string get_huffman_string(const Stream &stream);
 
@@ -362,10 +455,10 @@ std::string get_huffman_string(const Stream &stream);
 // N must be 4 for above example
 template <uint32_t N>
 inline auto get_header_string(const Stream &stream) {
+    const bool H = *stream & (1 << (N - 1));
     const size_t len = hpack::decode_integer<N - 1>(stream);
-    bool H = *stream & (1 << (N - 1));
-    ++stream;
-    std::string value = H ? get_huffman_string(stream.GetSimpleStream()) : std::string { reinterpret_cast<const char *>(stream.curr()), len };
+    if (stream.remaining_buffer() < len) throw HPACKException { err_t::HPACK_INTEGER_OVERFLOW };
+    std::string value = H ? get_huffman_string(make_const_stream(stream.curr(), len)) : std::string { reinterpret_cast<const char *>(stream.curr()), len };
     stream += len;
     return value;
 }
@@ -376,22 +469,162 @@ inline size_t huffman_string_size(const Stream &stream) {
     return size / 8;
 }
 
+// Longest code is 30 bits, encoder may write this many bytes beyond limit before it checks limit
+constexpr size_t huffman_encode_slack { 8 };
+constexpr size_t huffman_encoded_max_size(const size_t size) { return (size * 30 + 7) / 8; }
+
+// Bits are collected in 64 bit accumulator and written 32 bits at a time.
+// Encoding stops once limit is reached, limit is returned in that case.
+// Output must have limit + huffman_encode_slack bytes.
+size_t encode_huffman(const uint8_t *begin, const uint8_t *end, uint8_t *output, const size_t limit);
+
+// Encodes in per thread scratch buffer which is valid till next call.
+// Returns empty if Huffman encoding is not smaller than value.
+std::string_view encode_huffman(const std::string_view value);
+
 void add_huffman_string(Stream &stream, const Stream &valstream);
 
-inline auto add_header_string(Stream &stream, const std::string &value) {
-    auto strstream = make_const_fullstream(value);
-    size_t size = huffman_string_size(strstream);
-    if (size < value.size()) {
+// Few Huffman encoded values of a connection, two way set associative by hash of value.
+// Values like content-type, cache-control and ETag format repeat in every response.
+class huffman_cache_t {
+public:
+    static constexpr size_t set_count { 16 };
+    // Longer values are unlikely to repeat
+    static constexpr size_t max_value_size { 128 };
+
+    struct entry_t {
+        size_t hash { 0 };
+        std::string value { };
+        // Empty if Huffman encoding is not smaller
+        std::string encoded { };
+    };
+
+private:
+    std::array<std::array<entry_t, 2>, set_count> entries { };
+    // Way used last in each set, other way is replaced
+    std::array<uint8_t, set_count> recent { };
+
+public:
+    // Least recently used entry of set is replaced if value is not found
+    const entry_t &get(const std::string_view value);
+};
+
+//! N must include H same as get_header_string, head is bits before H
+// encoded is Huffman encoding of value, value is written as it is if encoded is empty
+template <uint32_t N>
+inline void add_encoded_header_string(Stream &stream, const uint8_t head, const std::string_view &encoded, const std::string_view &value) {
+    constexpr uint8_t H { 1 << (N - 1) };
+    if (!encoded.empty()) {
         // Encoded string is smaller hence we are encoded
-        encode_integer<7>(stream, static_cast<uint8_t>(0x80), size);
-        strstream.Reset();
-        add_huffman_string(stream, strstream);
+        encode_integer<N - 1>(stream, static_cast<uint8_t>(head | H), encoded.size());
+        stream.Copy(encoded.data(), encoded.size());
     } else {
-        encode_integer<7>(stream, static_cast<uint8_t>(0x80), value.size());
-        stream.curr() = std::copy(value.begin(), value.end(), stream.curr());
+        encode_integer<N - 1>(stream, head, value.size());
+        stream.Copy(value.data(), value.size());
     }
 }
 
+template <uint32_t N>
+inline void add_header_string(Stream &stream, const uint8_t head, const std::string_view &value) {
+    add_encoded_header_string<N>(stream, head, encode_huffman(value), value);
+}
+
+template <uint32_t N>
+inline void add_header_string(Stream &stream, const uint8_t head, const std::string_view &value, huffman_cache_t *cache) {
+    if (cache == nullptr || value.size() > huffman_cache_t::max_value_size) {
+        add_header_string<N>(stream, head, value);
+    } else {
+        add_encoded_header_string<N>(stream, head, cache->get(value).encoded, value);
+    }
+}
+
+inline auto add_header_string(Stream &stream, const std::string &value, huffman_cache_t *cache = nullptr) {
+    add_header_string<8>(stream, 0x00, value, cache);
+}
+
+// HTTP/2 and HTTP/3 carry field names in lower case and pseudo header with colon
+std::string to_wire_name(const FIELD field);
+FIELD wire_to_field(const std::string &name);
+
+constexpr size_t wire_name_size(const FIELD field) {
+    switch(field) {
+    case FIELD::Authority:
+    case FIELD::Method:
+    case FIELD::Path:
+    case FIELD::Scheme:
+    case FIELD::Status:
+        return to_string_view(field).size() + 1;
+    default:
+        return to_string_view(field).size();
+    }
+}
+
+inline size_t get_indexed_name_size(const dynamic_table_t &dynamic_table, const size_t index) {
+    return index < dynamic_table_first_index ? wire_name_size(static_table[index].first) : dynamic_table.get_name_size(index - dynamic_table_first_index);
+}
+
+// Field encoded once, either full match in static table or literal with incremental indexing.
+// Fields like server and content-type repeat in every response, encoding is not repeated.
+struct encoded_field_t {
+    std::pair<FIELD, std::string> header { };
+    // Index of header in static table, 0 if it is not there
+    size_t static_index { 0 };
+    std::string literal { };
+
+    encoded_field_t() = default;
+    encoded_field_t(const std::pair<FIELD, std::string> &header);
+};
+
+// Response fields for encoder of one connection.
+// Literal is written once, field is one indexed representation while its entry is in dynamic table.
+class encoder_cache_t {
+public:
+    static constexpr size_t set_count { 16 };
+    // Longer values are unlikely to repeat
+    static constexpr size_t max_value_size { 128 };
+
+    // Values of these fields change with every response, indexing them only evicts other entries
+    static constexpr bool is_cacheable(const FIELD field) {
+        switch(field) {
+        case FIELD::Age:
+        case FIELD::Content_Length:
+        case FIELD::Content_Range:
+        case FIELD::Date:
+        case FIELD::ETag:
+        case FIELD::Expires:
+        case FIELD::Last_Modified:
+        case FIELD::Set_Cookie:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+private:
+    struct entry_t {
+        size_t hash { 0 };
+        encoded_field_t field { };
+        uint64_t absolute_index { dynamic_table_t::npos };
+    };
+
+    std::array<std::array<entry_t, 2>, set_count> entries { };
+    // Way used last in each set, other way is replaced
+    std::array<uint8_t, set_count> recent { };
+    // Absolute index of each fixed field, same order as fixed fields
+    std::vector<uint64_t> fixed_indexes { };
+
+    static void encode(dynamic_table_t &dynamic_table, Stream &stream, const encoded_field_t &field, uint64_t &absolute_index);
+
+public:
+    // Value of fields not cached is Huffman encoded with this
+    huffman_cache_t huffman_cache { };
+
+    // Fixed fields are same for every response of connection, they are encoded once by configuration
+    void encode(dynamic_table_t &dynamic_table, Stream &stream, const std::vector<encoded_field_t> &fixed_fields);
+    // Field must be cacheable, least recently used entry of set is replaced if field is not found
+    void encode(dynamic_table_t &dynamic_table, Stream &stream, const std::pair<FIELD, std::string> &header_line);
+};
+
 inline auto get_header_field(const Stream &stream) {
     auto header_string = get_header_string<8>(stream);
     return to_field(header_string);
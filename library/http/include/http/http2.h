@@ -23,6 +23,11 @@
 #include <iostream>
 #include <mms/listener.h>
 #include <ranges>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <utility>
 
 namespace MMS::http::v2 {
 
@@ -33,6 +38,8 @@ namespace constant {
     constexpr uint32_t SETTINGS_INITIAL_WINDOW_SIZE = 65535;
     constexpr uint32_t SETTINGS_MAX_FRAME_SIZE = 16777215;
     constexpr uint32_t SETTINGS_MAX_HEADER_LIST_SIZE = 1024;
+    // https://www.rfc-editor.org/rfc/rfc9113.html#name-flow-control-window
+    constexpr uint32_t MAX_WINDOW_SIZE = 0x7fffffff;
 
 } // namespace constant
 
@@ -64,6 +71,8 @@ struct frame {
         GOAWAY          = 0x07,
         WINDOW_UPDATE   = 0x08,
         CONTINUATION    = 0x09,
+        // https://www.rfc-editor.org/rfc/rfc9218.html#name-the-priority_update-frame
+        PRIORITY_UPDATE = 0x10,
     };
 
     static constexpr auto get_string(const type_t type) {
@@ -78,6 +87,7 @@ struct frame {
             case type_t::GOAWAY: return "GOAWAY";
             case type_t::WINDOW_UPDATE: return "WINDOW UPDATE";
             case type_t::CONTINUATION: return "CONTINUATION";
+            case type_t::PRIORITY_UPDATE: return "PRIORITY UPDATE";
             default: return "BAD TYPE";
         }
     }
@@ -150,12 +160,11 @@ private:
     uint32_t    reserved:1;
     uint32_t    stream_identifier:31; */
 
-    // Little endian format
+    // Little endian format, stream identifier is kept big endian as 31 bit field would drop its bit 7
     uint32_t    length:24 { };
     type_t      type { };
     flags_t     flags { };
-    uint32_t    stream_identifier:31 { };
-    uint32_t    reserved:1 { };
+    uint32_t    stream_identifier { };
 
 public:
 
@@ -169,16 +178,15 @@ public:
     constexpr void clean_flag() { flags = flags_t::NONE; }
     constexpr void set_flag(const flags_t flag) { flags = (flags_t)((uint8_t)flags | (uint8_t)flag); }
     constexpr bool contains(const flags_t flag) const { return (flags_t)((uint8_t)flags & (uint8_t)flag) == flag; }
-    constexpr uint32_t get_stream_identifier() const { return changeEndian<std::endian::big, std::endian::native>(stream_identifier); }
+    constexpr uint32_t get_stream_identifier() const { return changeEndian<std::endian::big, std::endian::native>(stream_identifier) & 0x7fffffff; }
     constexpr void set_stream_identifier(const uint32_t stream_identifier) {
-        this->stream_identifier = changeEndian<std::endian::native, std::endian::big>(stream_identifier);
+        this->stream_identifier = changeEndian<std::endian::native, std::endian::big>(stream_identifier & 0x7fffffff);
     }
 
     constexpr void init_frame(uint32_t length, type_t type, flags_t flag, uint32_t stream_identifier) {
         set_length(length);
         set_type(type);
         flags = flag; // This will also clean flag
-        reserved = 0;
         set_stream_identifier(stream_identifier); 
     }
 
@@ -186,7 +194,6 @@ public:
         set_length(length);
         set_type(type);
         flags = (flags_t)((uint8_t)flag | (uint8_t)flag1); // This will also clean flag
-        reserved = 0;
         set_stream_identifier(stream_identifier); 
     }
 
@@ -194,7 +201,6 @@ public:
         set_length(length);
         set_type(type);
         flags = (flags_t)((uint8_t)flag | (uint8_t)flag1 | (uint8_t)flag2); // This will also clean flag
-        reserved = 0;
         set_stream_identifier(stream_identifier); 
     }
 
@@ -203,7 +209,7 @@ public:
 
     constexpr frame(uint32_t length, type_t type, flags_t flags, uint32_t stream_identifier)
             : length(changeEndian<std::endian::native, std::endian::big>(length) >> 8),
-              type(type), flags(flags), stream_identifier(changeEndian<std::endian::native, std::endian::big>(stream_identifier)), reserved(0) {}
+              type(type), flags(flags), stream_identifier(changeEndian<std::endian::native, std::endian::big>(stream_identifier & 0x7fffffff)) {}
 } __attribute__((packed)); // struct frame
 
 inline std::ostream& operator<<(std::ostream& os, const frame::type_t &http2frametype) {
@@ -268,6 +274,8 @@ struct settings {
         SETTINGS_INITIAL_WINDOW_SIZE        = 0x04,
         SETTINGS_MAX_FRAME_SIZE             = 0x05,
         SETTINGS_MAX_HEADER_LIST_SIZE       = 0x06,
+        // https://www.rfc-editor.org/rfc/rfc9218.html#name-disabling-rfc-7540-prioriti
+        SETTINGS_NO_RFC7540_PRIORITIES      = 0x09,
     };
 
     static constexpr auto get_string(const identifier_t id) {
@@ -278,6 +286,7 @@ struct settings {
             case identifier_t::SETTINGS_INITIAL_WINDOW_SIZE: return "INITIAL WINDOW SIZE";
             case identifier_t::SETTINGS_MAX_FRAME_SIZE: return "MAX FRAME SIZE";
             case identifier_t::SETTINGS_MAX_HEADER_LIST_SIZE: return "MAX HEADER LIST SIZE";
+            case identifier_t::SETTINGS_NO_RFC7540_PRIORITIES: return "NO RFC7540 PRIORITIES";
             default: return "UNKNOWN SETTINGS";
         }
     }
@@ -356,7 +365,8 @@ public:
             SETTINGS_MAX_CONCURRENT_STREAMS = configuration->GetConcurrentStreams(psettings->get_value());
             break;
         case settings::identifier_t::SETTINGS_INITIAL_WINDOW_SIZE:
-            SETTINGS_INITIAL_WINDOW_SIZE = configuration->GetWindowsSize(psettings->get_value());
+            // Peer window is used as is for sending, configuration limits only our receive window
+            SETTINGS_INITIAL_WINDOW_SIZE = std::min(psettings->get_value(), constant::MAX_WINDOW_SIZE);
             break;
         case settings::identifier_t::SETTINGS_MAX_FRAME_SIZE:
             SETTINGS_MAX_FRAME_SIZE = configuration->GetFrameSize(psettings->get_value());
@@ -393,11 +403,26 @@ inline std::ostream& operator<<(std::ostream& os, const settings &settings) {
     return os << "[" << settings.get_identifier() << "," << settings.get_value() << "]";
 }
 
+// Index of status in static table, 0 if it is not there
+constexpr size_t status_static_index(const CODE code) {
+    switch(code) {
+    case CODE::OK: return 8;
+    case CODE::No_Content: return 9;
+    case CODE::Partial_Content: return 10;
+    case CODE::Not_Modified: return 11;
+    case CODE::Bad_Request: return 12;
+    case CODE::Not_Found: return 13;
+    case CODE::_500: return 14;
+    default: return 0;
+    }
+}
+
 inline void copy_http_header_response(
             hpack::dynamic_table_t &dynamic_table,
             Stream &stream,
             const std::pair<FIELD, std::string> &header_line,
-            bool add_index) {
+            bool add_index,
+            hpack::huffman_cache_t *huffman_cache = nullptr) {
     // 6.1.  Indexed Header Field Representation
     // Case 1: found entry in static table
     if (hpack::static_table.contains(header_line)) {
@@ -406,11 +431,13 @@ inline void copy_http_header_response(
     }
 
     // Case 2: found entry in dynamic table
-    if (dynamic_table.contains(header_line)) {
-        hpack::encode_integer<7>(stream, (uint8_t)0x80, dynamic_table[header_line]);
+    const auto dynamic_index = dynamic_table.find(header_line);
+    if (dynamic_index != hpack::dynamic_table_t::npos) {
+        hpack::encode_integer<7>(stream, (uint8_t)0x80, dynamic_index + hpack::dynamic_table_first_index);
         return;
     }
 
+    const auto dynamic_name_index = dynamic_table.find(header_line.first);
     // TODO: Cover never indexed case
     if (add_index) {
         // 6.2.1.  Literal Header Field with Incremental Indexing
@@ -419,21 +446,20 @@ inline void copy_http_header_response(
         if (hpack::static_table.contains(header_line.first)) {
             // Subcase 1: Static table
             hpack::encode_integer<6>(stream, (uint8_t)0x40, hpack::static_table[header_line.first]);
-            hpack::add_header_string(stream, header_line.second);
+            hpack::add_header_string(stream, header_line.second, huffman_cache);
         } else
-        if (dynamic_table.contains(header_line.first)) {
+        if (dynamic_name_index != hpack::dynamic_table_t::npos) {
             // Subcase 2: Dynamic table
-            hpack::encode_integer<6>(stream, (uint8_t)0x40, dynamic_table[header_line.first]);
-            hpack::add_header_string(stream, header_line.second);
-            return;
+            hpack::encode_integer<6>(stream, (uint8_t)0x40, dynamic_name_index + hpack::dynamic_table_first_index);
+            hpack::add_header_string(stream, header_line.second, huffman_cache);
         } else {
             // Case 2: No index
             *stream++ = 0x40;
-            hpack::add_header_string(stream, to_string(header_line.first));
-            hpack::add_header_string(stream, header_line.second);
+            hpack::add_header_string(stream, hpack::to_wire_name(header_line.first), huffman_cache);
+            hpack::add_header_string(stream, header_line.second, huffman_cache);
         }
 
-        dynamic_table.insert(header_line);
+        dynamic_table.insert(header_line, hpack::wire_name_size(header_line.first));
         return;
     } else {
         // 6.2.2.  Literal Header Field without Indexing
@@ -441,18 +467,17 @@ inline void copy_http_header_response(
         if (hpack::static_table.contains(header_line.first)) {
             // Subcase 1: Static table
             hpack::encode_integer<4>(stream, (uint8_t)0x00, hpack::static_table[header_line.first]);
-            hpack::add_header_string(stream, header_line.second);
+            hpack::add_header_string(stream, header_line.second, huffman_cache);
         } else
-        if (dynamic_table.contains(header_line.first)) {
+        if (dynamic_name_index != hpack::dynamic_table_t::npos) {
             // Subcase 2: Dynamic table
-            hpack::encode_integer<4>(stream, (uint8_t)0x00, dynamic_table[header_line.first]);
-            hpack::add_header_string(stream, header_line.second);
-            return;
+            hpack::encode_integer<4>(stream, (uint8_t)0x00, dynamic_name_index + hpack::dynamic_table_first_index);
+            hpack::add_header_string(stream, header_line.second, huffman_cache);
         } else {
             // Case 2: No index
             *stream++ = 0x00;
-            hpack::add_header_string(stream, to_string(header_line.first));
-            hpack::add_header_string(stream, header_line.second);
+            hpack::add_header_string(stream, hpack::to_wire_name(header_line.first), huffman_cache);
+            hpack::add_header_string(stream, header_line.second, huffman_cache);
         }
         return;
     }
@@ -461,19 +486,17 @@ inline void copy_http_header_response(
 
 struct goaway {
 private:
-    // GCC endianness
-    uint32_t        last_stream_id:31;
-    uint32_t        reserved:1;
+    // Big endian, first bit of last stream id is reserved
+    uint32_t        last_stream_id;
     uint32_t        error_code;
 
 public:
     constexpr goaway(
                 const uint32_t &last_stream_id,
                 const frame::error_t &error_code)
-            :   last_stream_id(changeEndian<std::endian::native, std::endian::big>(last_stream_id)),
-                reserved(0),
+            :   last_stream_id(changeEndian<std::endian::native, std::endian::big>(last_stream_id & 0x7fffffff)),
                 error_code(changeEndian<std::endian::native, std::endian::big>((uint32_t)error_code)) {}
-    constexpr uint32_t get_last_stream_id() const { return changeEndian<std::endian::big, std::endian::native>(last_stream_id);}
+    constexpr uint32_t get_last_stream_id() const { return changeEndian<std::endian::big, std::endian::native>(last_stream_id) & 0x7fffffff;}
     constexpr frame::error_t get_error_code() const { return (frame::error_t)changeEndian<std::endian::big, std::endian::native>(error_code); }
 
     template <size_t debug_data_size>
@@ -487,9 +510,9 @@ public:
                 uint32_t max_stream,
                 frame::error_t error_code,
                 const char (&debug_data)[debug_data_size]) {
-        const uint32_t length = sizeof(frame) + sizeof(goaway) + debug_data_size;
+        const uint32_t length = sizeof(goaway) + debug_data_size;
         frame *pframe = reinterpret_cast<frame *>(stream.GetCurrAndIncrease(sizeof(frame)));
-        pframe->init_frame(length, frame::type_t::SETTINGS, frame::flags_t::ACK, 0x00);
+        pframe->init_frame(length, frame::type_t::GOAWAY, frame::flags_t::NONE, 0x00);
         
         auto goaway_buffer = stream.GetCurrAndIncrease(sizeof(goaway));
         new (goaway_buffer) goaway {max_stream, error_code};
@@ -505,22 +528,79 @@ inline std::ostream& operator<<(std::ostream& os, const goaway &goaway) {
 
 struct window_update {
 private:
-    /* Big endian
-    uint32_t    reserved:1;
-    uint32_t    window_size_increment:31; */
-
-    // Little endian
-    uint32_t    window_size_increment:31;
-    uint32_t    reserved:1;
+    // Big endian, first bit is reserved
+    uint32_t    window_size_increment;
 
 public:
-    uint32_t get_window_size_increment() const { return changeEndian<std::endian::big, std::endian::native>(window_size_increment); }
+    constexpr window_update(const uint32_t window_size_increment)
+            : window_size_increment(changeEndian<std::endian::native, std::endian::big>(window_size_increment & 0x7fffffff)) {}
+    constexpr uint32_t get_window_size_increment() const { return changeEndian<std::endian::big, std::endian::native>(window_size_increment) & 0x7fffffff; }
 } __attribute__((packed));
 
 inline std::ostream& operator<<(std::ostream& os, const window_update &windowupdate) {
     return os << '[' << windowupdate.get_window_size_increment() << ']';
 }
 
+void CreateWindowUpdateFrame(Stream &stream, uint32_t stream_identifier, uint32_t increment);
+void CreateResetFrame(Stream &stream, uint32_t stream_identifier, frame::error_t error);
+// https://www.rfc-editor.org/rfc/rfc9113.html#name-ping
+constexpr size_t ping_payload_size { 8 };
+void CreatePingFrame(Stream &stream, uint64_t opaque_data, bool ack = false);
+
+// Receive window autotuning from bandwidth delay product.
+// PING is sent with DATA, DATA received till its ACK is the product for that round trip.
+// Window is doubled once peer is limited by it, and halved once peer has used less than quarter of it for some round trips.
+class window_estimator_t {
+public:
+    using clock = std::chrono::steady_clock;
+    // Opaque data of PING sent by estimator, ACK of other PING is ignored
+    static constexpr uint64_t ping_data { 0x4d4d5342445000ULL };
+    static constexpr uint32_t shrink_samples { 4 };
+
+private:
+    uint32_t window_min;
+    uint32_t window_max;
+    uint32_t window;
+    bool ping_pending { false };
+    clock::time_point ping_sent { };
+    uint64_t sample { 0 };
+    uint32_t low_samples { 0 };
+    clock::duration rtt { };
+    clock::duration min_rtt { };
+    uint64_t bdp { 0 };
+
+public:
+    constexpr window_estimator_t(const uint32_t window, const uint32_t window_min, const uint32_t window_max)
+        : window_min { window_min }, window_max { std::min(window_max, constant::MAX_WINDOW_SIZE) }, window { window } { }
+
+    // Returns true if PING is to be sent, PingSent must be called once it is written
+    bool Received(const uint32_t length);
+    void PingSent(const clock::time_point now) { ping_pending = true; ping_sent = now; sample = 0; }
+    // Returns true if window is changed
+    bool PingAck(const uint64_t opaque_data, const clock::time_point now);
+
+    uint32_t GetWindow() const { return window; }
+    // Smoothed as TCP https://www.rfc-editor.org/rfc/rfc6298.html#section-2
+    clock::duration GetRTT() const { return rtt; }
+    clock::duration GetMinRTT() const { return min_rtt; }
+    // Bytes received in last round trip
+    uint64_t GetBDP() const { return bdp; }
+};
+
+// https://www.rfc-editor.org/rfc/rfc9218.html#name-priority-parameters
+struct priority_t {
+    static constexpr uint8_t default_urgency { 3 };
+    static constexpr uint8_t lowest_urgency { 7 };
+
+    uint8_t urgency { default_urgency };
+    bool incremental { false };
+
+    constexpr bool operator==(const priority_t &) const = default;
+};
+
+// Parses Priority field value or PRIORITY_UPDATE value, unknown and invalid parameters are ignored
+priority_t parse_priority(const std::string_view value);
+
 inline void displaymem(std::ostream& os, const uint8_t *pstart, const uint8_t *const pend) {
     os << '[';
     for(;pstart < pend; ++pstart) {
@@ -534,6 +614,8 @@ public:
     uint32_t stream_identifier;
     uint8_t weight;
     frame::error_t error;
+    // Body is complete, DATA after this read is given to data handler
+    bool end_stream;
 
     // Doubly linked list
     header_request *next;
@@ -544,6 +626,7 @@ public:
                     stream_identifier(stream_identifier),
                     weight(weight),
                     error(frame::error_t::NO_ERROR),
+                    end_stream(true),
                     next(nullptr), previous(nullptr) {}
 
     // Upgrade from http 1.1
@@ -552,11 +635,26 @@ public:
                     stream_identifier(1),   // Upgrade stream is 1
                     weight(16),             // Setting up default
                     error(frame::error_t::NO_ERROR),
+                    end_stream(true),       // Upgrade request is complete
                     next(nullptr), previous(nullptr) {}
 
     header_request(const header_request &) = delete;
     header_request &operator=(const header_request &) = delete;
 
+    // Pooled request is reused for new stream, field and body buffers are kept
+    void reset(const uint32_t stream_identifier) {
+        version = VERSION::VER_2;
+        method = METHOD::IGNORE_THIS;
+        fields.clear();
+        body.clear();
+        this->stream_identifier = stream_identifier;
+        weight = 16;
+        error = frame::error_t::NO_ERROR;
+        end_stream = true;
+        next = nullptr;
+        previous = nullptr;
+    }
+
     void parse_header(const Stream &stream, const uint32_t stream_identifier, hpack::dynamic_table_t &dynamic_table) {
         this->stream_identifier = stream_identifier;
         while(stream.remaining_buffer()) {
@@ -565,22 +663,22 @@ public:
                 // rfc7541 # 6.1 Indexed Header Field Representation
                 uint32_t index = hpack::decode_integer<7>(stream);
                 // Dynamic table check is internal
-                auto &header = index < 62 ? hpack::static_table[index] : dynamic_table[index - 62];
-                add_field(header);
+                add_field(hpack::get_indexed(dynamic_table, index));
             } else if (*stream == 0x40) {
                 ++stream;
-                auto field = hpack::get_header_field(stream);
+                auto name = hpack::get_header_string<8>(stream);
                 auto value = hpack::get_header_string<8>(stream);
-                auto header = std::make_pair(field, value);
-                dynamic_table.insert(header);
+                auto header = std::make_pair(to_field(name), value);
+                dynamic_table.insert(header, name.size());
                 add_field(header);
             } else if ((*stream & 0xc0) == 0x40) {
                 // rfc7541 # 6.2.1 Literal Header Field with Incremental Indexing
                 uint32_t index = hpack::decode_integer<6>(stream);
-                auto header_for_field = index < 62 ? hpack::static_table[index] : dynamic_table[index - 62];
+                const auto field = hpack::get_indexed(dynamic_table, index).first;
+                const auto name_size = hpack::get_indexed_name_size(dynamic_table, index);
                 auto value = hpack::get_header_string<8>(stream);
-                auto header = std::make_pair(header_for_field.first, value);
-                dynamic_table.insert(header);
+                auto header = std::make_pair(field, value);
+                dynamic_table.insert(header, name_size);
                 add_field(header);
             } else if (*stream == 0x00) {
                 ++stream;
@@ -590,7 +688,7 @@ public:
                 add_field(header);
             } else if ((*stream & 0xf0) == 0x00) {
                 uint32_t index = hpack::decode_integer<4>(stream);
-                auto header_for_field = index < 62 ? hpack::static_table[index] : dynamic_table[index - 62];
+                auto header_for_field = hpack::get_indexed(dynamic_table, index);
                 auto value = hpack::get_header_string<8>(stream);
                 auto header = std::make_pair(header_for_field.first, value);
                 add_field(header);
@@ -602,28 +700,27 @@ public:
                 add_field(header);
             } else if ((*stream & 0xf0) == 0x10) {
                 uint32_t index = hpack::decode_integer<4>(stream);
-                auto header_for_field = index < 62 ? hpack::static_table[index] : dynamic_table[index - 62];
+                auto header_for_field = hpack::get_indexed(dynamic_table, index);
                 auto value = hpack::get_header_string<8>(stream);
                 auto header = std::make_pair(header_for_field.first, value);
                 add_field(header);
             } else if ((*stream &0xe0) == 0x20) {
+                // rfc7541 # 6.3 Dynamic Table Size Update
                 uint32_t index = hpack::decode_integer<5>(stream);;
                 dynamic_table.update_size(index);
             }
         }
 
-        // Update version
+        // Update version, method is set by add_field
         version = VERSION::VER_2;
-        auto method_itr = fields.find(FIELD::Method);
-        if (method_itr != fields.end()) {
-            SetMethod(method_itr->second);
-        }
     }
 
     void set_error(const frame::error_t error) {
         this->error = error;
     }
 
+    void append_body(const Stream &stream) { body.append(reinterpret_cast<const char *>(stream.curr()), stream.remaining_buffer()); }
+
     constexpr header_request *get_next() { return next; }
     constexpr header_request *get_previous() { return previous; }
     constexpr const header_request *get_next() const { return next; }
@@ -631,49 +728,184 @@ public:
 
 }; // class header_request
 
+// Streams keyed by stream identifier, open addressing with linear probing.
+// Records are pooled, erase and clear give them back. Record address is stable till then.
+// Record is constructed and reset with stream identifier and has stream_identifier member.
+template <typename record_t>
+class stream_table_t {
+    static constexpr size_t initial_capacity = 16;
+    // Pool beyond this is freed, connection rarely has more streams
+    static constexpr size_t pool_max = 64;
+
+    struct slot_t {
+        // Stream 0 never has record, it marks empty slot
+        uint32_t stream_identifier { 0 };
+        std::unique_ptr<record_t> record { };
+    };
+
+    std::vector<slot_t> slots;
+    std::vector<std::unique_ptr<record_t>> pool { };
+    size_t count { 0 };
+
+    // Client stream identifiers are odd, lowest bit is dropped
+    constexpr size_t slot_index(const uint32_t stream_identifier) const { return (stream_identifier >> 1) & (slots.size() - 1); }
+    constexpr size_t next_index(const size_t index) const { return (index + 1) & (slots.size() - 1); }
+
+    void place(std::unique_ptr<record_t> &&record) {
+        auto index = slot_index(record->stream_identifier);
+        while(slots[index].stream_identifier != 0) index = next_index(index);
+        slots[index].stream_identifier = record->stream_identifier;
+        slots[index].record = std::move(record);
+    }
+
+    void grow() {
+        auto previous = std::exchange(slots, std::vector<slot_t>(slots.size() * 2));
+        for(auto &slot: previous) {
+            if (slot.record) place(std::move(slot.record));
+        }
+    }
+
+    void release(std::unique_ptr<record_t> &&record) {
+        if (pool.size() < pool_max) pool.push_back(std::move(record));
+    }
+
+public:
+    stream_table_t() : slots(initial_capacity) { }
+
+    record_t *find(const uint32_t stream_identifier) const {
+        if (stream_identifier == 0) return nullptr;
+        for(auto index = slot_index(stream_identifier); slots[index].stream_identifier != 0; index = next_index(index)) {
+            if (slots[index].stream_identifier == stream_identifier) return slots[index].record.get();
+        }
+        return nullptr;
+    }
+
+    // Stream must not be present
+    record_t *insert(const uint32_t stream_identifier) {
+        // Load factor is kept at most half
+        if ((count + 1) * 2 > slots.size()) grow();
+        std::unique_ptr<record_t> record { };
+        if (pool.empty()) {
+            record = std::make_unique<record_t>(stream_identifier);
+        } else {
+            record = std::move(pool.back());
+            pool.pop_back();
+            record->reset(stream_identifier);
+        }
+        auto result = record.get();
+        place(std::move(record));
+        ++count;
+        return result;
+    }
+
+    void erase(const uint32_t stream_identifier) {
+        if (stream_identifier == 0) return;
+        auto index = slot_index(stream_identifier);
+        while(slots[index].stream_identifier != stream_identifier) {
+            if (slots[index].stream_identifier == 0) return;
+            index = next_index(index);
+        }
+        slots[index].stream_identifier = 0;
+        release(std::move(slots[index].record));
+        --count;
+        // Backward shift, probe sequence of following records stays unbroken without tombstone
+        for(auto next = next_index(index); slots[next].stream_identifier != 0; next = next_index(next)) {
+            const auto home = slot_index(slots[next].stream_identifier);
+            // Record stays if its home is cyclically in (index, next]
+            if (index <= next ? (index < home && home <= next) : (index < home || home <= next)) continue;
+            slots[index] = std::move(slots[next]);
+            slots[next].stream_identifier = 0;
+            index = next;
+        }
+    }
+
+    void clear() {
+        if (count == 0) return;
+        for(auto &slot: slots) {
+            if (!slot.record) continue;
+            slot.stream_identifier = 0;
+            release(std::move(slot.record));
+        }
+        if (slots.size() > initial_capacity) slots = std::vector<slot_t>(initial_capacity);
+        count = 0;
+    }
+
+    // Function must not insert or erase
+    template <typename function_t>
+    void for_each(function_t &&function) {
+        for(auto &slot: slots) {
+            if (slot.record) function(*slot.record);
+        }
+    }
+
+    constexpr size_t size() const { return count; }
+    constexpr size_t capacity() const { return slots.size(); }
+}; // class stream_table_t
+
 class request {
     //Stream_count
-    hpack::dynamic_table_t &dynamic_table; // This will be share by the multiple request in a connection
+    hpack::dynamic_table_t &dynamic_table; // Decoder table, this will be share by the multiple request in a connection
     header_request *first;
     header_request *last;
 
-    // <stream identifier> <request header> map
-    std::unordered_map<uint32_t, header_request *> header_map;
+    // Requests are owned by table, they are valid till next parse
+    stream_table_t<header_request> streams;
+    // Trailer section is decoded to keep decoder table in sync, its fields are dropped
+    header_request trailers;
     MMS::http::v2::settings_store &peer_settings;
 
     uint32_t max_stream;
+    // Highest stream opened by HEADERS, stream above it is idle https://www.rfc-editor.org/rfc/rfc9113.html#section-5.1.1
+    uint32_t last_open_stream;
 
     friend std::ostream& operator<<(std::ostream& os, const request &request);
 
+    // Trailer section carries END_STREAM, it ends body like last DATA
+    void end_trailers(const uint32_t stream_identifier) {
+        auto request = streams.find(stream_identifier);
+        if (request != nullptr) {
+            request->end_stream = true;
+        } else if (data_handler) {
+            data_handler(stream_identifier, make_const_stream(std::string_view { }), true);
+        }
+    }
+
 public:
+    // DATA for stream whose HEADERS is not in this parse, arguments are stream identifier, payload and END_STREAM.
+    // Trailers of such stream are given as empty payload with END_STREAM.
+    std::function<void(uint32_t, const Stream &, bool)> data_handler { };
+    // Stream whose HEADERS is not in this parse is open for body, HEADERS on it are trailers
+    std::function<bool(uint32_t)> stream_open_handler { };
+    // Length of every DATA frame including padding, it is counted against receive window.
+    // Arguments are stream identifier, length and END_STREAM.
+    std::function<void(uint32_t, uint32_t, bool)> received_handler { };
+    // Non zero window increment, arguments are stream identifier and increment
+    std::function<void(uint32_t, uint32_t)> window_update_handler { };
+    // Arguments are prioritized stream identifier and priority field value
+    std::function<void(uint32_t, std::string_view)> priority_update_handler { };
+    // PING with ACK, argument is opaque data. PING without ACK is answered by parser.
+    std::function<void(uint64_t)> ping_ack_handler { };
+
     inline request(
             hpack::dynamic_table_t &dynamic_table,
             MMS::http::v2::settings_store &peer_settings)
                 :   dynamic_table(dynamic_table),
-                    first(nullptr), last(nullptr), header_map(),
-                    peer_settings(peer_settings), max_stream(0) {}
+                    first(nullptr), last(nullptr), streams(), trailers(),
+                    peer_settings(peer_settings), max_stream(0), last_open_stream(0) {}
 
     request(const request &) = delete;
     request &operator=(const request &) = delete;
 
-    inline ~request() {
-        // This class allocate memory, hence will be freeing it
-        while(first) {
-            header_request *next = first->next;
-            delete first;
-            first = next;
-        }
-    }
+    // Upgrade request of HTTP/1.1 opens stream 1 https://www.rfc-editor.org/rfc/rfc9113.html#section-3.1
+    void upgrade() { if (last_open_stream == 0) last_open_stream = 1; }
 
     inline void insert(header_request *pheader, uint32_t stream_dependency) {
         if (stream_dependency != 0) {
-            auto header_itr = header_map.find(stream_dependency);
-            header_request *request;
-            if (header_itr == header_map.end()) {
+            header_request *request = streams.find(stream_dependency);
+            if (request == nullptr) {
                 // Dependency stream is not present
                 // We are creating dummy header and appending it at the end
-                request = new header_request(stream_dependency);
-                header_map.insert(std::make_pair(stream_dependency, request));
+                request = streams.insert(stream_dependency);
                 request->next = pheader;
                 if (last != nullptr)
                     last->next = request;
@@ -682,7 +914,6 @@ public:
                 }
                 last = pheader;
             } else {
-                request = header_itr->second;
                 pheader->next = request->next;
                 request->next = pheader;
                 if (request == last) {
@@ -698,8 +929,6 @@ public:
             }
             last = pheader;
         }
-
-        header_map.insert(std::make_pair(pheader->stream_identifier, pheader));
     }
 
     bool CheckAndParseSetting(const Stream &stream, const http_limits_t *configuration) {
@@ -712,29 +941,86 @@ public:
                 auto frameStreamBuffer = stream.GetCurrAndIncrease(frame_length);
                 auto frameStream = make_const_stream(frameStreamBuffer, frameStreamBuffer +  frame_length - padded_bytes);
                 peer_settings.parse_frame(frameStream, configuration);
-                dynamic_table.update_size(peer_settings.SETTINGS_HEADER_TABLE_SIZE);
                 return true;
             }
         }
         return false;
     }
 
+    // Header block split in CONTINUATION must be complete in stream, GetFramesEnd keeps it so.
+    // Parsing stops at incomplete frame, stream is left at its start.
+    // Requests of previous parse are given back to pool.
     err_t parse(const Stream &stream, Stream &writestream) {
+        first = nullptr;
+        last = nullptr;
+        streams.clear();
+        // Stream of header block waiting for CONTINUATION, no other frame is allowed till it ends
+        uint32_t continuation_stream { 0 };
+        header_request *continuation_request { nullptr };
+        std::string header_block { };
         while(stream.CheckCapacity(sizeof(frame))) {
-            const frame *pframe = reinterpret_cast<const frame *>(stream.GetCurrAndIncrease(sizeof(frame)));
+            const frame *pframe = reinterpret_cast<const frame *>(stream.curr());
+            const auto frame_length = pframe->get_length();
+            if (!stream.CheckCapacity(sizeof(frame) + frame_length)) break;
+            stream += sizeof(frame);
             const auto stream_identifier = pframe->get_stream_identifier();
             if (stream_identifier > max_stream) max_stream = stream_identifier;
-            const uint8_t padded_bytes = pframe->contains(frame::flags_t::PADDED) ? *stream++ : 0;
-            const auto frame_length = pframe->get_length();
             auto frameStreamBuffer = stream.GetCurrAndIncrease(frame_length);
-            auto frameStream = make_const_stream(frameStreamBuffer, frameStreamBuffer +  frame_length - padded_bytes);
+            // Pad length is first octet of DATA and HEADERS payload
+            const bool padded = (pframe->get_type() == frame::type_t::DATA || pframe->get_type() == frame::type_t::HEADERS) && pframe->contains(frame::flags_t::PADDED);
+            const size_t padded_bytes = padded && frame_length ? *frameStreamBuffer : 0;
+            if (padded && padded_bytes + 1 > frame_length) {
+                goaway::add_frame(
+                            writestream,
+                            max_stream,
+                            frame::error_t::PROTOCOL_ERROR,
+                            "Padding is larger than frame");
+                return err_t::HTTP2_INITIATE_GOAWAY;
+            }
+            auto frameStream = make_const_stream(frameStreamBuffer + (padded ? 1 : 0), frameStreamBuffer + frame_length - padded_bytes);
+
+            if (continuation_stream != 0x00 && (pframe->get_type() != frame::type_t::CONTINUATION || stream_identifier != continuation_stream)) {
+                goaway::add_frame(
+                            writestream,
+                            max_stream,
+                            frame::error_t::PROTOCOL_ERROR,
+                            "Header block must be followed by CONTINUATION");
+                return err_t::HTTP2_INITIATE_GOAWAY;
+            }
 
             switch(pframe->get_type()) {
                 // rfc7540 - 6.1.  DATA
-            case frame::type_t::DATA:
-                // TODO: data handling
+            case frame::type_t::DATA: {
+                if (stream_identifier == 0x00) {
+                    // PROTOCOL_ERROR we will stop parsing
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::PROTOCOL_ERROR,
+                                "DATA frame requires stream ID to be set");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+
+                if (stream_identifier > last_open_stream) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::PROTOCOL_ERROR,
+                                "DATA on idle stream");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
 
+                const auto end_stream = pframe->contains(frame::flags_t::END_STREAM);
+                if (received_handler) received_handler(stream_identifier, frame_length, end_stream);
+                auto request = streams.find(stream_identifier);
+                if (request != nullptr) {
+                    request->append_body(frameStream);
+                    if (end_stream) request->end_stream = true;
+                } else if (data_handler) {
+                    data_handler(stream_identifier, frameStream, end_stream);
+                }
                 break;
+            }
 
             case frame::type_t::HEADERS: {
                 // rfc7540 - 6.2.  HEADERS
@@ -747,6 +1033,8 @@ public:
                 } else {
                     stream_dependency = 0x00;
                 }
+                // Stream cannot depend on itself, dependency is only ordering here hence it is dropped
+                if (stream_dependency == stream_identifier) stream_dependency = 0x00;
 
                 if (stream_identifier == 0x00) {
                     // PROTOCOL_ERROR we will stop parsing
@@ -758,16 +1046,39 @@ public:
                     return err_t::HTTP2_INITIATE_GOAWAY;
                 }
 
-                auto header_itr = header_map.find(stream_identifier);
-                header_request *request;
-                if (header_itr == header_map.end()) {
-                    request = new header_request();
-                    insert(request, stream_dependency);
+                header_request *request = streams.find(stream_identifier);
+                // rfc9113 - 8.1.  HEADERS on stream with request header is trailer section
+                const bool trailer_section = request != nullptr ? request->GetMethod() != METHOD::IGNORE_THIS
+                                                : stream_open_handler && stream_open_handler(stream_identifier);
+                if (trailer_section) {
+                    if (!pframe->contains(frame::flags_t::END_STREAM)) {
+                        goaway::add_frame(
+                                    writestream,
+                                    max_stream,
+                                    frame::error_t::PROTOCOL_ERROR,
+                                    "Trailers must end stream");
+                        return err_t::HTTP2_INITIATE_GOAWAY;
+                    }
+                    trailers.reset(stream_identifier);
+                    request = &trailers;
                 } else {
-                    request = header_itr->second;
+                    if (request == nullptr) {
+                        request = streams.insert(stream_identifier);
+                        insert(request, stream_dependency);
+                    }
+                    request->end_stream = pframe->contains(frame::flags_t::END_STREAM);
+                    if (stream_identifier > last_open_stream) last_open_stream = stream_identifier;
                 }
 
-                request->parse_header(frameStream, stream_identifier, dynamic_table);
+                if (pframe->contains(frame::flags_t::END_HEADERS)) {
+                    request->parse_header(frameStream, stream_identifier, dynamic_table);
+                    if (trailer_section) end_trailers(stream_identifier);
+                } else {
+                    // Field may be split across frames, block is decoded once complete
+                    continuation_stream = stream_identifier;
+                    continuation_request = request;
+                    header_block.assign(reinterpret_cast<const char *>(frameStream.curr()), frameStream.remaining_buffer());
+                }
                 break;
             }
             case frame::type_t::PRIORITY: {
@@ -779,7 +1090,16 @@ public:
                 break;
             }
             case frame::type_t::RST_STREAM: {
-                const uint32_t error_code = *reinterpret_cast<const uint32_t *>(frameStream.curr());
+                // rfc9113 - 6.4.  RST_STREAM
+                if (frame_length != sizeof(uint32_t)) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::FRAME_SIZE_ERROR,
+                                "RST_STREAM length must be 4");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+                const uint32_t error_code = changeEndian<std::endian::big, std::endian::native>(*reinterpret_cast<const uint32_t *>(frameStream.curr()));
                 if (stream_identifier == 0x00) {
                     // PROTOCOL_ERROR we will stop parsing
                     goaway::add_frame(
@@ -790,13 +1110,10 @@ public:
                     return err_t::HTTP2_INITIATE_GOAWAY;
                 }
 
-                auto header_itr = header_map.find(stream_identifier);
-                header_request *request;
-                if (header_itr == header_map.end()) {
-                    request = new header_request();
+                header_request *request = streams.find(stream_identifier);
+                if (request == nullptr) {
+                    request = streams.insert(stream_identifier);
                     insert(request, 0x00);
-                } else {
-                    request = header_itr->second;
                 }
 
                 request->set_error((frame::error_t)error_code);
@@ -824,9 +1141,6 @@ public:
                 return err_t::HTTP2_INITIATE_GOAWAY;
             }
             case frame::type_t::PING: {
-                // Ping contains 64 octet
-                constexpr size_t ping_payload_size = 64;
-
                 if (stream_identifier != 0x00) {
                     // PROTOCOL_ERROR we will stop parsing
                     goaway::add_frame(
@@ -842,25 +1156,107 @@ public:
                                 writestream,
                                 max_stream,
                                 frame::error_t::PROTOCOL_ERROR,
-                                "PING frame length can only be 64");
+                                "PING frame length can only be 8");
                     return err_t::HTTP2_INITIATE_GOAWAY;
                 }
-                frame *response_frame = reinterpret_cast<frame *>(writestream.GetCurrAndIncrease(sizeof(frame)));
-                response_frame->init_frame(ping_payload_size, frame::type_t::PING, frame::flags_t::ACK, 0x00);
-                std::copy(frameStream.curr(), frameStream.curr() + ping_payload_size, writestream.GetCurrAndIncrease(ping_payload_size));
+                uint64_t opaque_data;
+                std::copy_n(frameStreamBuffer, sizeof(opaque_data), reinterpret_cast<uint8_t *>(&opaque_data));
+                opaque_data = changeEndian<std::endian::big, std::endian::native>(opaque_data);
+                // ACK is not answered
+                if (pframe->contains(frame::flags_t::ACK)) {
+                    if (ping_ack_handler) ping_ack_handler(opaque_data);
+                    break;
+                }
+                CreatePingFrame(writestream, opaque_data, true);
                 break;
             }
             case frame::type_t::GOAWAY: {
                 return err_t::HTTP2_INITIATE_GOAWAY;
             }
             case frame::type_t::WINDOW_UPDATE: {
-                // TODO: Implement Windows Update
+                // rfc9113 - 6.9.  WINDOW_UPDATE
+                if (frame_length != sizeof(window_update)) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::FRAME_SIZE_ERROR,
+                                "WINDOW_UPDATE length must be 4");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+                if (stream_identifier > last_open_stream) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::PROTOCOL_ERROR,
+                                "WINDOW_UPDATE on idle stream");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+                const auto increment = reinterpret_cast<const window_update *>(frameStreamBuffer)->get_window_size_increment();
+                if (increment == 0) {
+                    if (stream_identifier == 0x00) {
+                        goaway::add_frame(
+                                    writestream,
+                                    max_stream,
+                                    frame::error_t::PROTOCOL_ERROR,
+                                    "WINDOW_UPDATE increment can not be zero");
+                        return err_t::HTTP2_INITIATE_GOAWAY;
+                    }
+                    CreateResetFrame(writestream, stream_identifier, frame::error_t::PROTOCOL_ERROR);
+                    break;
+                }
+                if (window_update_handler) window_update_handler(stream_identifier, increment);
+                break;
+            }
+            case frame::type_t::PRIORITY_UPDATE: {
+                // rfc9218 - 7.1.  HTTP/2 PRIORITY_UPDATE Frame
+                if (stream_identifier != 0x00) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::PROTOCOL_ERROR,
+                                "PRIORITY_UPDATE must be on stream 0");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+                if (frame_length < sizeof(uint32_t)) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::FRAME_SIZE_ERROR,
+                                "PRIORITY_UPDATE is too short");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+                uint32_t prioritized_stream;
+                std::copy_n(frameStreamBuffer, sizeof(prioritized_stream), reinterpret_cast<uint8_t *>(&prioritized_stream));
+                prioritized_stream = changeEndian<std::endian::big, std::endian::native>(prioritized_stream) & 0x7fffffff;
+                if (prioritized_stream == 0x00) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::PROTOCOL_ERROR,
+                                "PRIORITY_UPDATE requires prioritized stream");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+                const std::string_view value { reinterpret_cast<const char *>(frameStreamBuffer) + sizeof(prioritized_stream), frame_length - sizeof(prioritized_stream) };
+                if (priority_update_handler) priority_update_handler(prioritized_stream, value);
                 break;
             }
             case frame::type_t::CONTINUATION: {
-                // TODO: Implement Continuation, this is required only for POST call
-                // We may not choose to support ignoring this call
-                // Best implementation would be RST_STREAM
+                // rfc9113 - 6.10.  CONTINUATION
+                if (continuation_stream == 0x00) {
+                    goaway::add_frame(
+                                writestream,
+                                max_stream,
+                                frame::error_t::PROTOCOL_ERROR,
+                                "CONTINUATION without header block");
+                    return err_t::HTTP2_INITIATE_GOAWAY;
+                }
+                header_block.append(reinterpret_cast<const char *>(frameStream.curr()), frameStream.remaining_buffer());
+                if (pframe->contains(frame::flags_t::END_HEADERS)) {
+                    continuation_request->parse_header(make_const_stream(header_block), continuation_stream, dynamic_table);
+                    if (continuation_request == &trailers) end_trailers(continuation_stream);
+                    continuation_stream = 0x00;
+                    continuation_request = nullptr;
+                }
                 break;
             }
             default:
@@ -938,8 +1334,25 @@ template <> constexpr void request::copy_http_header_response<FIELD::Status, COD
 template <> constexpr void request::copy_http_header_response<FIELD::Status, CODE::Not_Found>(Stream &stream) { *stream++ = 0x80 + 13; }
 template <> constexpr void request::copy_http_header_response<FIELD::Status, CODE::_500>(Stream &stream) { *stream++ = 0x80 + 14; }
 
-void CreateHeaderFrame(hpack::dynamic_table_t &dynamic_table, FullStream &stream, uint32_t stream_identifier, CODE code, const std::vector<std::pair<FIELD, std::string>> &fields);
+// Date field encoded as literal without indexing, it does not change dynamic table.
+// It is encoded at most once a second for each thread.
+std::string_view GetDateHPACK();
+
+// Fixed fields are same for every response, encoder cache writes them indexed once they are in dynamic table.
+// Without encoder cache they are written as literal without indexing.
+// Response without body sets end_stream, HEADERS is then last frame of stream.
+void CreateHeaderFrame(hpack::dynamic_table_t &dynamic_table, FullStream &stream, uint32_t stream_identifier, CODE code, const std::vector<std::pair<FIELD, std::string>> &fields, const std::vector<hpack::encoded_field_t> &fixed_fields = { }, hpack::encoder_cache_t *encoder_cache = nullptr, bool end_stream = false);
 
 void CreateBodyFrame(FullStream &stream, uint32_t max_frame_size, const Stream &bodystream, uint32_t stream_identifier);
 
+// Part of body as DATA frames, last frame has END_STREAM if end_stream is set
+void CreateDataFrame(FullStream &stream, uint32_t max_frame_size, const Stream &bodystream, uint32_t stream_identifier, bool end_stream);
+
+// Empty DATA frame with END_STREAM, it ends streamed body
+void CreateEndStreamFrame(FullStream &stream, uint32_t stream_identifier);
+
+// End of last complete frame in buffer, frame split across reads is kept till rest is read.
+// Header block is kept till its last CONTINUATION is read.
+const uint8_t *GetFramesEnd(const uint8_t *begin, const uint8_t *end);
+
 } // namespace MMS::http::v2
\ No newline at end of file
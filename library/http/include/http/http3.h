@@ -15,16 +15,262 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>//
 //////////////////////////////////////////////////////////////////////////
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+//
+// This header implements
+// https://www.rfc-editor.org/rfc/rfc9114.html
+//
+// QUIC transport is abstract, session is driven by stream data and writes to stream.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////
+
 #pragma once
 #include <http/qpack.h>
+#include <mms/net/quic.h>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 
 namespace MMS::http::v3 {
 
+// https://www.rfc-editor.org/rfc/rfc9114.html#name-frame-definitions
+enum class frame_type_t : uint64_t {
+    DATA            = 0x00,
+    HEADERS         = 0x01,
+    CANCEL_PUSH     = 0x03,
+    SETTINGS        = 0x04,
+    PUSH_PROMISE    = 0x05,
+    GOAWAY          = 0x07,
+    MAX_PUSH_ID     = 0x0d,
+};
+
+// https://www.rfc-editor.org/rfc/rfc9114.html#name-unidirectional-streams
+enum class stream_type_t : uint64_t {
+    CONTROL         = 0x00,
+    PUSH            = 0x01,
+    QPACK_ENCODER   = 0x02,
+    QPACK_DECODER   = 0x03,
+};
+
+// https://www.rfc-editor.org/rfc/rfc9114.html#name-http-3-error-codes
+enum class error_t : uint64_t {
+    H3_NO_ERROR                 = 0x100,
+    H3_GENERAL_PROTOCOL_ERROR   = 0x101,
+    H3_INTERNAL_ERROR           = 0x102,
+    H3_STREAM_CREATION_ERROR    = 0x103,
+    H3_CLOSED_CRITICAL_STREAM   = 0x104,
+    H3_FRAME_UNEXPECTED         = 0x105,
+    H3_FRAME_ERROR              = 0x106,
+    H3_EXCESSIVE_LOAD           = 0x107,
+    H3_ID_ERROR                 = 0x108,
+    H3_SETTINGS_ERROR           = 0x109,
+    H3_MISSING_SETTINGS         = 0x10a,
+    H3_REQUEST_REJECTED         = 0x10b,
+    H3_REQUEST_CANCELLED        = 0x10c,
+    H3_REQUEST_INCOMPLETE       = 0x10d,
+    H3_MESSAGE_ERROR            = 0x10e,
+    H3_CONNECT_ERROR            = 0x10f,
+    H3_VERSION_FALLBACK         = 0x110,
+    QPACK_DECOMPRESSION_FAILED  = 0x200,
+    QPACK_ENCODER_STREAM_ERROR  = 0x201,
+    QPACK_DECODER_STREAM_ERROR  = 0x202,
+};
+
+error_t to_error(const err_t err);
+
+// Stream ID bits https://www.rfc-editor.org/rfc/rfc9000.html#name-stream-types-and-identifier
+constexpr bool IsClientInitiated(const uint64_t stream_id) { return (stream_id & 0x01) == 0; }
+constexpr bool IsBidirectional(const uint64_t stream_id) { return (stream_id & 0x02) == 0; }
+
+// Variable length integer is complete in stream
+inline bool HasInteger(const Stream &stream) {
+    return !stream.full() && stream.remaining_buffer() >= (1ULL << (*stream >> 6));
+}
+
+struct frame_t {
+    frame_type_t type;
+    uint64_t length;
+    const uint8_t *payload;
+};
+
+// Returns false if stream does not have complete frame, stream is not moved in that case
+bool ParseFrame(const Stream &stream, frame_t &frame);
+
+void AddFrameHeader(Stream &stream, const frame_type_t type, const uint64_t length);
+void AddDataFrame(Stream &stream, const Stream &body);
+void AddHeadersFrame(Stream &stream, const Stream &field_section);
+void AddGoawayFrame(Stream &stream, const uint64_t id);
+
+// https://www.rfc-editor.org/rfc/rfc9114.html#name-settings
+class settings_store {
+public:
+    enum class identifier_t : uint64_t {
+        SETTINGS_QPACK_MAX_TABLE_CAPACITY   = 0x01,
+        SETTINGS_MAX_FIELD_SECTION_SIZE     = 0x06,
+        SETTINGS_QPACK_BLOCKED_STREAMS      = 0x07,
+    };
+
+    uint64_t SETTINGS_QPACK_MAX_TABLE_CAPACITY { 0 };
+    uint64_t SETTINGS_MAX_FIELD_SECTION_SIZE { std::numeric_limits<uint64_t>::max() };
+    uint64_t SETTINGS_QPACK_BLOCKED_STREAMS { 0 };
+
+    // Unknown identifier is ignored, HTTP/2 identifier is an error
+    void parse(const Stream &payload);
+    void add_frame(Stream &stream) const;
+};
+
+// Transport end of one QUIC stream, implemented by QUIC connection or loopback
+class stream_t {
+public:
+    virtual ~stream_t() = default;
+
+    virtual uint64_t GetID() const = 0;
+    virtual void Write(const Stream &data) = 0;
+    // Sends FIN after written data
+    virtual void Finish() = 0;
+    virtual void Reset(const error_t error) = 0;
+};
+
+class transport_t {
+public:
+    virtual ~transport_t() = default;
+
+    // Local unidirectional stream, transport owns it
+    virtual stream_t *OpenUniStream() = 0;
+    virtual void Close(const error_t error) = 0;
+};
+
 class request : public MMS::http::request {
 public:
+    const uint64_t stream_id;
+
+    request(const uint64_t stream_id) : MMS::http::request { VERSION::VER_3 }, stream_id { stream_id } { }
+    request(const request &) = delete;
+    request &operator=(const request &) = delete;
+
+    void append_body(const uint8_t *data, const size_t size) { body.append(reinterpret_cast<const char *>(data), size); }
+};
+
+// One HTTP/3 connection for server side.
+// Transport delivers stream data to ProcessStream, complete request is given to ProcessRequest.
+class session_t {
+private:
+    struct uni_stream_t {
+        bool type_received { false };
+        stream_type_t type { };
+        bool settings_received { false };
+        std::string buffer { };
+    };
+
+    struct request_stream_t {
+        stream_t &stream;
+        request req;
+        std::string buffer { };
+        bool headers_received { false };
+        bool headers_blocked { false };
+        bool fin { false };
+        // Decoded size as per SETTINGS_MAX_FIELD_SECTION_SIZE, fields past the limit are dropped
+        uint64_t field_section_size { 0 };
+        // Request exceeded limit, stream is reset and its remaining data is discarded
+        bool rejected { false };
+
+        request_stream_t(stream_t &stream) : stream { stream }, req { stream.GetID() } { }
+    };
+
+    transport_t &transport;
+    const settings_store local_settings;
+    settings_store peer_settings { };
+    // Buffered frames and request body are kept till this size
+    const size_t max_request_size;
+
+    qpack::decoder_t decoder;
+    // Peer SETTINGS decides encoder table, static table is used till then
+    std::unique_ptr<qpack::encoder_t> encoder;
+
+    stream_t *control_stream { nullptr };
+    stream_t *encoder_stream { nullptr };
+    stream_t *decoder_stream { nullptr };
+
+    std::unordered_map<uint64_t, uni_stream_t> uni_streams { };
+    std::unordered_map<uint64_t, request_stream_t> request_streams { };
+    uint64_t next_request_id { 0 };
+    bool goaway_sent { false };
+
+    FullStreamAutoAlloc frame_buffer { 1024 };
+    FullStreamAutoAlloc qpack_buffer { 256 };
+    FullStreamAutoAlloc field_section { 256 };
+
+    void ProcessUniStream(stream_t &stream, const Stream &data, const bool fin);
+    void ProcessControlFrames(uni_stream_t &uni_stream);
+    void ProcessRequestStream(stream_t &stream, const Stream &data, const bool fin);
+    void ProcessRequestFrames(request_stream_t &request_stream);
+    void DispatchReady();
+    void RejectRequest(request_stream_t &request_stream);
+    void FlushDecoderStream();
+    void WriteHeaders(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields);
+
+protected:
+    virtual void ProcessRequest(stream_t &stream, request &request) = 0;
+
+public:
+    session_t(transport_t &transport, const settings_store &local_settings = { }, const size_t max_request_size = http_limits_t { }.MaxRequestSize);
+    session_t(const session_t &) = delete;
+    session_t &operator=(const session_t &) = delete;
+    virtual ~session_t() = default;
+
+    // Opens control and QPACK streams, must be called once connection is established
+    void Start();
+    void ProcessStream(stream_t &stream, const Stream &data, const bool fin);
+    // Peer reset request stream
+    void ResetStream(const uint64_t stream_id);
+    // Graceful shutdown, requests already received are served
+    void Shutdown();
+
+    void WriteResponse(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields, const Stream &bodystream);
+    void WriteResponse(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields);
+
+    // Streaming response, each part is one DATA frame and end sends FIN
+    void WriteResponseBegin(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields);
+    void WriteResponseData(stream_t &stream, const Stream &bodystream);
+    void WriteResponseEnd(stream_t &stream);
+
+    inline const auto &GetPeerSettings() const { return peer_settings; }
+    inline size_t GetActiveRequests() const { return request_streams.size(); }
+};
+
+// In memory transport, all writes are kept per stream.
+// This drives session without QUIC for test and benchmark.
+class loopback_transport_t : public transport_t {
+public:
+    class loopback_stream_t : public stream_t {
+    public:
+        const uint64_t id;
+        std::string data { };
+        bool finished { false };
+        bool reset { false };
+        error_t reset_error { error_t::H3_NO_ERROR };
+
+        loopback_stream_t(const uint64_t id) : id { id } { }
+
+        uint64_t GetID() const override { return id; }
+        void Write(const Stream &stream) override { data.append(reinterpret_cast<const char *>(stream.curr()), stream.remaining_buffer()); }
+        void Finish() override { finished = true; }
+        void Reset(const error_t error) override { reset = true; reset_error = error; }
+    };
 
+    std::unordered_map<uint64_t, std::unique_ptr<loopback_stream_t>> streams { };
+    uint64_t next_uni_id { 3 };
+    bool closed { false };
+    error_t close_error { error_t::H3_NO_ERROR };
 
+    stream_t *OpenUniStream() override { return GetStream(std::exchange(next_uni_id, next_uni_id + 4)); }
+    void Close(const error_t error) override { closed = true; close_error = error; }
 
+    loopback_stream_t *GetStream(const uint64_t id) {
+        auto &stream = streams[id];
+        if (!stream) stream = std::make_unique<loopback_stream_t>(id);
+        return stream.get();
+    }
 };
 
-} // namespace MMS::http::v3
\ No newline at end of file
+} // namespace MMS::http::v3
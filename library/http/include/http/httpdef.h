@@ -17,8 +17,9 @@
 
 #pragma once
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <mms/base/error.h>
+#include <mms/ds/perfecthash.h>
 
 #ifndef LIST_DEFINITION_END
 #define LIST_DEFINITION_END
@@ -29,6 +30,7 @@ namespace MMS::http {
     HTTP_VERSION_ENTRY(VER_UNKNOWN, "Unknown Version") \
     HTTP_VERSION_ENTRY(VER_1_1, "HTTP/1.1") \
     HTTP_VERSION_ENTRY(VER_2, "HTTP/2.0") \
+    HTTP_VERSION_ENTRY(VER_3, "HTTP/3") \
     LIST_DEFINITION_END
 
 #define HTTP_FIELD_LIST \
@@ -269,6 +271,7 @@ namespace MMS::http {
     HTTP_FIELD_ENTRY(Content_Security_Policy, "Content-Security-Policy") \
     HTTP_FIELD_ENTRY(Upgrade_Insecure_Requests, "Upgrade-Insecure-Requests") \
     HTTP_FIELD_ENTRY(Access_Control_Expose_Headers, "Access-Control-Expose-Headers") \
+    HTTP_FIELD_ENTRY(Priority, "Priority") \
     /* Do not use */ \
     HTTP_FIELD_ENTRY(IGNORE_THIS, "IGNORE THIS") \
     LIST_DEFINITION_END // HTTP_FIELD_LIST
@@ -291,6 +294,7 @@ namespace MMS::http {
     /* Informational 1xx */ \
     HTTP_CODE_ENTRY(100, Continue, "Continue") \
     HTTP_CODE_ENTRY(101, Switching_Protocols, "Switching Protocols") \
+    HTTP_CODE_ENTRY(103, Early_Hints, "Early Hints") \
     \
     /* Successful 2xx */ \
     HTTP_CODE_ENTRY(200, OK, "OK") \
@@ -401,43 +405,86 @@ static constexpr std::string to_string(const METHOD method) {
     }
 }
 
-typedef std::unordered_map<FIELD, std::string> fields_t;
+// View into static text, this is for writing to stream without creating string
+static constexpr std::string_view to_string_view(const VERSION version) {
+    switch(version) {
+    default:
+#define HTTP_VERSION_ENTRY(x, y) case VERSION::x: return { y, sizeof(y) - 1};
+    HTTP_VERSION_LIST
+#undef HTTP_VERSION_ENTRY
+    }
+}
 
-extern const std::unordered_map<std::string, FIELD> field_map;
-extern const std::unordered_map<std::string, METHOD> method_map;
+static constexpr std::string_view to_string_view(const FIELD field) {
+    switch(field) {
+    default:
+#define HTTP_FIELD_ENTRY(x, y) case FIELD::x: return { y, sizeof(y) - 1};
+    HTTP_FIELD_LIST
+#undef HTTP_FIELD_ENTRY
+    }
+}
+
+static constexpr std::string_view to_string_view(const CODE code) {
+    switch(code) {
+    default:
+#define HTTP_CODE_ENTRY(x, y, z) case CODE::_##x: return { z, sizeof(z) -1 };
+    HTTP_CODE_LIST
+#undef HTTP_CODE_ENTRY
+    }
+}
+
+static constexpr std::string_view to_string_view(const METHOD method) {
+    switch(method) {
+    default:
+#define HTTP_METHOD_ENTRY(x) case METHOD::x: return { #x, sizeof(#x) -1 };
+    HTTP_METHOD_LIST
+#undef HTTP_METHOD_ENTRY
+    }
+}
+
+constexpr size_t field_count = 0
+#define HTTP_FIELD_ENTRY(x, y) + 1
+    HTTP_FIELD_LIST
+#undef HTTP_FIELD_ENTRY
+;
+
+constexpr size_t method_count = 0
+#define HTTP_METHOD_ENTRY(x) + 1
+    HTTP_METHOD_LIST
+#undef HTTP_METHOD_ENTRY
+;
+
+// Field name is case insensitive https://www.rfc-editor.org/rfc/rfc9110.html#name-field-names
+extern const perfecthashmap<FIELD, field_count, true> field_map;
+// Method is case sensitive https://www.rfc-editor.org/rfc/rfc9110.html#name-methods
+extern const perfecthashmap<METHOD, method_count> method_map;
 
 // This is raw code may does not map to actual string bug atoi
 // "100" will map to CODE::_100
-extern const std::unordered_map<std::string, CODE> code_map_raw;
+extern const std::array<CODE, 1000> code_map_raw;
 
-constexpr auto to_field(const std::string &fieldname) {
-    auto fielditr = field_map.find(fieldname);;
-    if (fielditr == std::end(field_map)) {
-        return FIELD::IGNORE_THIS;
-    }
-    return fielditr->second;
+constexpr auto to_field(const std::string_view fieldname) {
+    return field_map.find(fieldname, FIELD::IGNORE_THIS);
 }
 
-constexpr auto to_method(const std::string &methodname) {
-    auto methoditr = method_map.find(methodname);;
-    if (methoditr == std::end(method_map)) {
-        return METHOD::IGNORE_THIS;
-    }
-    return methoditr->second;
+constexpr auto to_method(const std::string_view methodname) {
+    return method_map.find(methodname, METHOD::IGNORE_THIS);
 }
 
-constexpr auto to_version(const std::string &versiontext) {
+constexpr auto to_version(const std::string_view versiontext) {
     if (versiontext.compare("HTTP/1.1") == 0) return VERSION::VER_1_1;
     else if (versiontext.compare("HTTP/2.0") == 0) return VERSION::VER_2;
     else return VERSION::VER_UNKNOWN;
 }
 
-constexpr auto to_code_map(const std::string &codetext) {
-    auto codeitr = code_map_raw.find(codetext);;
-    if (codeitr == std::end(code_map_raw)) {
-        return CODE::_0;
+constexpr auto to_code_map(const std::string_view codetext) {
+    if (codetext.empty() || codetext.size() > 3) return CODE::_0;
+    size_t code { 0 };
+    for(const auto ch: codetext) {
+        if (ch < '0' || ch > '9') return CODE::_0;
+        code = code * 10 + static_cast<size_t>(ch - '0');
     }
-    return codeitr->second;
+    return code_map_raw[code];
 }
 
 } // namespace MMS::http
\ No newline at end of file
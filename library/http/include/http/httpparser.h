@@ -19,9 +19,12 @@
 #include <mms/base/stream.h>
 #include <string_view>
 #include <unordered_map>
+#include <array>
 #include <mms/base/error.h>
 #include <mms/log/log.h>
 #include <http/httpdef.h>
+#include <http/fields.h>
+#include <http/scan.h>
 
 #ifndef LIST_DEFINITION_END
 #define LIST_DEFINITION_END
@@ -30,94 +33,58 @@
 namespace MMS::http {
 class header {
 protected:
-    static const std::string empty;
     VERSION version { };
+    METHOD method { METHOD::IGNORE_THIS };
     fields_t fields { };
 
     template <bool crlf_end>
-    void parse_version(const FullStream &);
-    void parse_fields(const FullStream &);
+    void parse_version(const FullStream &, scan::delimiter_index_t &);
+    void parse_fields(const FullStream &, scan::delimiter_index_t &);
 
 public:
     constexpr header() { }
     constexpr header(VERSION version) : version { version } { }
-    header(header &&other) : version { other.version }, fields { std::move(other.fields) } { }
+    header(header &&other) : version { other.version }, method { other.method }, fields { std::move(other.fields) } { }
 
-    const auto  &GetField(FIELD field) const {
-        const auto field_itr = fields.find(field);
-        if (field_itr != fields.end()) {
-            return field_itr->second;
-        }
-        return empty;
-    }
+    constexpr std::string_view GetField(FIELD field) const { return fields.get(field); }
+    constexpr const auto &GetFields() const { return fields; }
 
-    void add_field(const FIELD field, const std::string &value) {
-        fields.emplace(field, value);
+    // Existing field is kept
+    void add_field(const FIELD field, const std::string_view value) {
+        if (fields.add(field, value) && field == FIELD::Method) method = to_method(value);
     }
 
     void add_field(const std::pair<FIELD, std::string> &entry) {
-        fields.insert(entry);
-    }
-
-    void add_field(const FIELD field, std::string &&value) {
-        fields.emplace(field, std::move(value));
+        add_field(entry.first, entry.second);
     }
 
     void add_field(const FIELD field, const size_t value) {
-        fields.emplace(field, std::to_string(value));
+        add_field(field, std::to_string(value));
     }
 
 protected:
-    void parse_request_uri(const FullStream &);
-    void parse_method(const FullStream &);
-    void parse_request_line(const FullStream &);
+    void parse_request_uri(const FullStream &, scan::delimiter_index_t &);
+    void parse_method(const FullStream &, scan::delimiter_index_t &);
+    void parse_request_line(const FullStream &, scan::delimiter_index_t &);
 
-    void SetMethod(const METHOD method) { fields.emplace(FIELD::Method, to_string(method)); }
-    void SetMethod(const std::string &method) { fields.emplace(FIELD::Method, method); }
-    void SetMethod(const std::string &&method) { fields.emplace(FIELD::Method, std::move(method)); }
-    void SetPath(const std::string &path) { fields.emplace(FIELD::Path, path); }
-    void SetPath(const std::string &&path) { fields.emplace(FIELD::Path, std::move(path)); }
+    void SetMethod(const METHOD method) { add_field(FIELD::Method, to_string(method)); }
+    void SetMethod(const std::string_view method) { add_field(FIELD::Method, method); }
+    void SetPath(const std::string_view path) { add_field(FIELD::Path, path); }
 
 public: 
-    constexpr auto GetMethod() const {
-        auto field_itr = fields.find(FIELD::Method);
-        if (field_itr != fields.end()) {
-            return to_method(field_itr->second);
-        }
-        return METHOD::IGNORE_THIS;
-    }
+    constexpr auto GetMethod() const { return method; }
+    constexpr auto GetMethodStr() const { return fields.get_method(); }
+    constexpr auto GetPath() const { return fields.get_path(); }
 
-    constexpr auto GetMethodStr() const {
-        auto field_itr = fields.find(FIELD::Method);
-        if (field_itr != fields.end()) {
-            return field_itr->second;
-        }
-        return empty;
-    }
-
-    constexpr const auto &GetPath() const { 
-        auto field_itr = fields.find(FIELD::Path);
-        if (field_itr != fields.end()) {
-            return field_itr->second;
-        }
-        return empty;
-    }
-
-    constexpr const auto GetPathBase() const { 
-        auto &path = GetPath();
+    constexpr auto GetPathBase() const { 
+        auto path = GetPath();
         auto pos = path.rfind('/');
-        if (pos == std::string::npos) return path;
+        if (pos == std::string_view::npos) return path;
         else return path.substr(pos);
     }
 
-    constexpr auto upgrade_version() {
-        auto field_itr = fields.find(FIELD::Upgrade);
-        if (field_itr != fields.end()) {
-            if (field_itr->second == "h2c") {
-                return VERSION::VER_2;
-            }
-        }
-
+    constexpr auto upgrade_version() const {
+        if (GetField(FIELD::Upgrade) == "h2c") return VERSION::VER_2;
         return VERSION::VER_1_1;
     }
 
@@ -129,11 +96,12 @@ protected:
     using header::header;
 
     friend class http_request_parser;
+    friend class request_view;
     std::string body { };
 
 public:
     request(const FullStream &);
-    request(request &&other) : header { std::move(other) }, body { std::move(body) } { }
+    request(request &&other) : header { std::move(other) }, body { std::move(other.body) } { }
 
     constexpr const auto &GetBody() const { return body; }
 
@@ -144,14 +112,125 @@ public:
     std::string to_string();
 }; // class request
 
+// Incremental HTTP/1.1 body framing https://www.rfc-editor.org/rfc/rfc9112.html#name-message-body-length
+// Input can be given in any split, body parts are views in input.
+// Chunk extensions and trailer fields are ignored.
+class body_decoder_t {
+public:
+    enum class state_t {
+        DATA,
+        CHUNK_SIZE,
+        CHUNK_END,
+        TRAILER,
+        DONE,
+    };
+
+private:
+    state_t state { state_t::DONE };
+    bool chunked { false };
+    // Remaining size of content or current chunk
+    size_t remaining { 0 };
+
+public:
+    constexpr body_decoder_t() { }
+    constexpr body_decoder_t(const bool chunked, const size_t length)
+        : state { chunked ? state_t::CHUNK_SIZE : (length ? state_t::DATA : state_t::DONE) }, chunked { chunked }, remaining { chunked ? 0 : length } { }
+
+    // Returns true with next body part, false when more input is required or body is complete.
+    // Incomplete chunk line is not consumed, curr is left at start of it.
+    bool next(const uint8_t *&curr, const uint8_t *end, std::string_view &part);
+
+    constexpr auto done() const { return state == state_t::DONE; }
+    constexpr auto is_chunked() const { return chunked; }
+    constexpr auto get_remaining() const { return remaining; }
+}; // class body_decoder_t
+
+// Request parsed in place without copy, all string views refer to parsed buffer.
+// Buffer must be kept alive while request is used, HTTP/1.1 connection keeps
+// read buffer till ProcessRead returns.
+class request_view {
+public:
+    static constexpr size_t max_fields = 64;
+
+private:
+    VERSION version { };
+    METHOD method { METHOD::IGNORE_THIS };
+    std::string_view method_str { };
+    std::string_view path { };
+    std::string_view body { };
+    std::array<std::pair<FIELD, std::string_view>, max_fields> fields { };
+    size_t field_count { 0 };
+    // Size till end of header section, this is set even when body is not complete
+    size_t head_size { 0 };
+    // Chunked body is not contiguous in buffer, hence it is decoded here
+    std::string chunked_body { };
+
+    // Returns false when there is no space for field or Content-Length differs from earlier one
+    bool add_field(const FIELD field, const std::string_view value);
+
+public:
+    request_view() { }
+    request_view(const FullStream &stream) { parse(stream); }
+    request_view(const request_view &) = delete;
+    request_view &operator=(const request_view &) = delete;
+
+    void parse(const FullStream &);
+
+    // Parses one message from start of buffer, body is framed by Transfer-Encoding or Content-Length
+    // https://www.rfc-editor.org/rfc/rfc9112.html#name-message-body-length
+    // Returns size of message including body, 0 when buffer does not have complete message.
+    size_t parse_message(const uint8_t *begin, const uint8_t *end);
+
+    // Size of request line and fields from start of buffer given to parse_message, 0 when header is not complete
+    constexpr auto GetHeadSize() const { return head_size; }
+
+    // Decoder for body following header, throws if framing fields are invalid
+    body_decoder_t body_decoder() const;
+
+    constexpr auto begin() const { return fields.begin(); }
+    constexpr auto end() const { return fields.begin() + field_count; }
+    constexpr auto size() const { return field_count; }
+
+    constexpr std::string_view GetField(const FIELD field) const {
+        for(auto &entry: *this) {
+            if (entry.first == field) return entry.second;
+        }
+        return { };
+    }
+
+    constexpr auto GetVersion() const { return version; }
+    constexpr auto GetMethod() const { return method; }
+    constexpr auto GetMethodStr() const { return method_str; }
+    constexpr auto GetPath() const { return path; }
+    constexpr auto GetPathBase() const {
+        auto pos = path.rfind('/');
+        if (pos == std::string_view::npos) return path;
+        else return path.substr(pos);
+    }
+    constexpr auto GetBody() const { return body; }
+
+    constexpr auto upgrade_version() const {
+        if (GetField(FIELD::Upgrade) == "h2c") return VERSION::VER_2;
+        return VERSION::VER_1_1;
+    }
+
+    // https://www.rfc-editor.org/rfc/rfc9112.html#name-persistence
+    bool keep_alive() const;
+
+    // Copies to owning request, this is required when request must outlive buffer
+    request to_request() const;
+
+    response CreateErrorResponse(CODE code, const std::string &errortext, const std::string &servername) const;
+}; // class request_view
+
 class response_header : public header {
 protected:
     CODE code { };
     constexpr response_header() { }
     constexpr response_header(VERSION version) : header { version } { }
 
-    void parse_code(const FullStream &);
-    void parse_response_line(const FullStream &);
+    void parse_code(const FullStream &, scan::delimiter_index_t &);
+    void parse_response_line(const FullStream &, scan::delimiter_index_t &);
 public:
     constexpr auto GetCode() const { return code; };
 };
@@ -166,7 +245,7 @@ public:
 
     constexpr void UpdateContentLength() {
         if (!body.empty()) {
-            fields[FIELD::Content_Length] = std::to_string(body.size());
+            fields.set(FIELD::Content_Length, std::to_string(body.size()));
         }
     }
 
@@ -197,8 +276,14 @@ struct http_limits_t {
         return selected;
     }
     uint32_t MaxReadBuffer { 4096 };
+    // HTTP/1.1 request including body, incomplete request is kept till this size, also HTTP/3 request body
+    uint32_t MaxRequestSize { 1048576 };
+    // Streaming response is written to connection once this is buffered
+    uint32_t StreamFlushSize { 16384 };
     uint32_t FrameSizeMin { 1024 };
     uint32_t FrameSizeMax { 65536 };
+    // HTTP/2 HEADERS with its CONTINUATION is kept till this size, advertised as HTTP/3 SETTINGS_MAX_FIELD_SECTION_SIZE
+    uint32_t HeaderBlockSizeMax { 65536 };
     uint32_t GetFrameSize(uint32_t value) const { return GetSize(FrameSizeMin, FrameSizeMax, value); }
     uint32_t HeaderTableSizeMin { 128 };
     uint32_t HeaderTableSizeMax { 4096 };
@@ -214,19 +299,46 @@ struct http_limits_t {
     uint32_t GetHeaderListSize(uint32_t value) const { return GetSize(HeaderListSizeMin, HeaderListSizeMax, value); }
 };
 
-constexpr void WriteResponseLine(Stream &stream, const CODE code) { stream.Write("HTTP/1.1 ", std::to_string(static_cast<unsigned short>(code)), ' ', to_string(code), "\r\n"); }
+constexpr void WriteResponseLine(Stream &stream, const CODE code) { stream.Write("HTTP/1.1 ", static_cast<unsigned short>(code), " ", to_string_view(code), "\r\n"); }
 constexpr void WriteRequestLine(Stream &stream, const METHOD method, const std::string &uri) { stream.Write(to_string(method), ' ', uri, " HTTP/1.1\r\n"); }
-constexpr void WriteFieldLine(Stream &stream, const FIELD field, const std::string &value) { stream.Write(to_string(field), ": ", value, "\r\n"); }
+constexpr void WriteFieldLine(Stream &stream, const FIELD field, const std::string_view value) { stream.Write(to_string_view(field), ": ", value, "\r\n"); }
+constexpr void WriteFieldLine(Stream &stream, const FIELD field, const size_t value) { stream.Write(to_string_view(field), ": ", value, "\r\n"); }
 constexpr void WriteFieldLine(Stream &stream, const std::vector<std::pair<FIELD, std::string>> &fields) { for(auto &field: fields) WriteFieldLine(stream, field.first, field.second); }
-constexpr void WriteDateLine(Stream &stream) {
-    constexpr uint64_t max_date_string_size = 92;
-    std::time_t now_time = std::time(0);   // get time now
-    std::tm* now_tm = std::gmtime(&now_time);
-    char date_str[max_date_string_size];
-    auto date_size = strftime(date_str, max_date_string_size, "%a, %d %b %Y %H:%M:%S %Z", now_tm);
-    stream.Write(to_string(FIELD::Date), ": ");
-    stream.Copy(date_str, date_size);
-    stream.Write("\r\n");
+
+// IMF-fixdate https://www.rfc-editor.org/rfc/rfc9110.html#name-date
+// It is formatted at most once a second for each thread, returned view is valid till next call in same thread.
+std::string_view GetDate();
+// Date field line with CRLF
+std::string_view GetDateLine();
+
+inline void WriteDateLine(Stream &stream) {
+    const auto dateline = GetDateLine();
+    stream.Copy(dateline.data(), dateline.size());
 }
 
+// Error body, server name is put once when it is created and code and error text are written in place.
+// Server keeps it in configuration, hence error response is written without format and allocation.
+class error_page_t {
+public:
+    enum class type_t {
+        HTML,
+        JSON,
+    };
+
+private:
+    // Text between title and code heading, this has server name
+    std::string html_server { };
+
+public:
+    error_page_t(const std::string_view servername);
+
+    // JSON only when it is accepted and HTML is not
+    static type_t GetType(const std::string_view accepttype);
+    static constexpr std::string_view GetContentType(const type_t type) { return type == type_t::JSON ? "application/json" : "text/html"; }
+
+    size_t GetSize(const type_t type, const CODE code, const std::string_view errortext) const;
+    void Write(Stream &stream, const type_t type, const CODE code, const std::string_view errortext) const;
+    std::string to_string(const type_t type, const CODE code, const std::string_view errortext) const;
+}; // class error_page_t
+
 } // namespace MMS::http
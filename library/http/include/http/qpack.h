@@ -26,6 +26,9 @@
 #include <mms/listener.h>
 #include <http/hpack.h>
 #include <http/httpdef.h>
+#include <deque>
+#include <functional>
+#include <limits>
 
 namespace MMS::http::qpack {
 
@@ -33,7 +36,6 @@ using MMS::http::FIELD;
 using MMS::http::METHOD;
 using MMS::http::CODE;
 
-using MMS::http::hpack::dynamic_table_t;
 using MMS::http::hpack::static_table_t;
 
 #ifndef LIST_DEFINITION_END
@@ -145,53 +147,228 @@ extern const static_table_t static_table;
     QPACK_STATIC_TABLE_ENTRY( 98, FIELD::X_Frame_Options, "sameorigin" ) \
     LIST_DEFINITION_END
 
-namespace header {
-
-    constexpr void parse(const Stream &stream, hpack::dynamic_table_t &dynamic_table, std::function<void(const std::pair<FIELD, std::string> &)> add_field) {
-        if ((*stream & 0x80)) { // 4.5.2. https://www.rfc-editor.org/rfc/rfc9204.html#name-indexed-field-line
-            // TODO: Check for voilation
-            const bool T = *stream & 0x40;
-            uint32_t index = hpack::decode_integer<6>(stream);
-            auto &header = T ? static_table[index] : dynamic_table[index];
-            add_field(header);
-        } else if ((*stream & 0xf0) == 0x10) { // 4.5.3.  https://www.rfc-editor.org/rfc/rfc9204.html#name-indexed-field-line-with-pos
-            uint32_t index = hpack::decode_integer<4>(stream);
-            auto &header = dynamic_table[index];
-            add_field(header);
-        } else
-        // *stream cannot have 8th bit set, hence 0x40 check is sufficient
-        if ((*stream & 0x40)) { // 4.5.4. https://www.rfc-editor.org/rfc/rfc9204.html#name-literal-field-line-with-nam
-            const bool N = *stream & 0x20;
-            const bool T = *stream & 0x10;
-            uint32_t index = hpack::decode_integer<4>(stream);
-            auto value = hpack::get_header_string<8>(stream);
-            auto &header_indexed = T ? static_table[index] : dynamic_table[index];
-            std::pair<FIELD, std::string> header { header_indexed.first, value };
-            // TODO: move header
-            if (N) dynamic_table.insert(header);
-            add_field(header);
-        } else if (!(*stream & 0xf0)) { // 4.5.5. https://www.rfc-editor.org/rfc/rfc9204.html#name-literal-field-line-with-pos
-            const bool N = *stream & 0x08;
-            uint32_t index = hpack::decode_integer<3>(stream);
-            auto value = hpack::get_header_string<8>(stream);
-            auto &header_indexed = dynamic_table[index];
-            std::pair<FIELD, std::string> header { header_indexed.first, value };
-            // TODO: move header
-            if (N) dynamic_table.insert(header);
-            add_field(header);
-        } else
-        // *stream cannot have 8th and 7th bit set, hence 0x20 check is sufficient
-        if ((*stream & 0x20)) { // 4.5.6. https://www.rfc-editor.org/rfc/rfc9204.html#name-literal-field-line-with-lit
-            const bool N = *stream & 0x10;
-            auto name = hpack::get_header_string<4>(stream);
-            auto value = hpack::get_header_string<8>(stream);
-            auto field = to_field(name);
-            std::pair<FIELD, std::string> header { field, value };
-            // TODO: move header
-            if (N) dynamic_table.insert(header);
-            add_field(header);
+// https://www.rfc-editor.org/rfc/rfc9204.html#name-dynamic-table-size
+constexpr size_t entry_overhead = 32;
+
+inline size_t entry_size(const size_t name_size, const size_t value_size) { return name_size + value_size + entry_overhead; }
+
+// Header fields this implementation never adds to dynamic table.
+// These are either changing with every message or sensitive.
+inline bool IsNeverIndexed(const FIELD field) {
+    switch(field) {
+    case FIELD::Date:
+    case FIELD::Content_Length:
+    case FIELD::Authorization:
+    case FIELD::Proxy_Authorization:
+    case FIELD::Cookie:
+    case FIELD::Set_Cookie:
+    case FIELD::IGNORE_THIS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Dynamic table is addressed by absolute index, first inserted entry is 0
+// https://www.rfc-editor.org/rfc/rfc9204.html#name-absolute-indexing
+// Encoder and decoder both use this, encoder additionally use lookup maps.
+class dynamic_table_t {
+private:
+    struct entry_t {
+        std::pair<FIELD, std::string> header;
+        size_t size;
+    };
+
+    std::deque<entry_t> entries { };
+    std::unordered_map<std::pair<FIELD, std::string>, uint64_t> entry_value_map { };
+    std::unordered_map<FIELD, uint64_t> entry_map { };
+
+    const size_t max_capacity;
+    size_t capacity { 0 };
+    size_t size { 0 };
+    uint64_t insert_count { 0 };
+
+    inline void evict() {
+        const auto &entry = entries.front();
+        const uint64_t index = GetDroppedCount();
+        auto value_itr = entry_value_map.find(entry.header);
+        if (value_itr != entry_value_map.end() && value_itr->second == index) entry_value_map.erase(value_itr);
+        auto name_itr = entry_map.find(entry.header.first);
+        if (name_itr != entry_map.end() && name_itr->second == index) entry_map.erase(name_itr);
+        size -= entry.size;
+        entries.pop_front();
+    }
+
+public:
+    dynamic_table_t(size_t max_capacity) : max_capacity { max_capacity } { }
+    dynamic_table_t(const dynamic_table_t &) = delete;
+    dynamic_table_t &operator=(const dynamic_table_t &) = delete;
+
+    inline size_t GetMaxCapacity() const { return max_capacity; }
+    inline size_t GetCapacity() const { return capacity; }
+    inline size_t GetSize() const { return size; }
+    inline uint64_t GetInsertCount() const { return insert_count; }
+    inline uint64_t GetDroppedCount() const { return insert_count - entries.size(); }
+    // https://www.rfc-editor.org/rfc/rfc9204.html#name-required-insert-count
+    inline uint64_t GetMaxEntries() const { return max_capacity / entry_overhead; }
+
+    inline bool contains(const uint64_t index) const { return index >= GetDroppedCount() && index < insert_count; }
+
+    inline const auto &operator[](const uint64_t index) const {
+        if (!contains(index)) throw QPACKException { err_t::QPACK_DECOMPRESSION_FAILED };
+        return entries[index - GetDroppedCount()].header;
+    }
+
+    // Size of name as it was on wire
+    inline size_t GetNameSize(const uint64_t index) const {
+        const auto &entry = entries[index - GetDroppedCount()];
+        return entry.size - entry.header.second.size() - entry_overhead;
+    }
+
+    // Returns latest absolute index or -1
+    inline uint64_t find(const std::pair<FIELD, std::string> &header_line) const {
+        auto entry_itr = entry_value_map.find(header_line);
+        if (entry_itr == entry_value_map.end()) return -1;
+        return entry_itr->second;
+    }
+
+    inline uint64_t find(const FIELD field) const {
+        auto entry_itr = entry_map.find(field);
+        if (entry_itr == entry_map.end()) return -1;
+        return entry_itr->second;
+    }
+
+    // Entry of given size can be inserted without evicting entry at or after evict_limit
+    inline bool CanInsert(const size_t new_size, const uint64_t evict_limit) const {
+        if (new_size > capacity) return false;
+        size_t available = capacity - size;
+        for(uint64_t index = GetDroppedCount(); available < new_size; ++index) {
+            if (index >= evict_limit) return false;
+            available += entries[index - GetDroppedCount()].size;
+        }
+        return true;
+    }
+
+    inline void SetCapacity(const size_t new_capacity) {
+        if (new_capacity > max_capacity) throw QPACKException { err_t::QPACK_ENCODER_STREAM_ERROR };
+        capacity = new_capacity;
+        while(size > capacity) evict();
+    }
+
+    // name_size is size of name on wire, FIELD::IGNORE_THIS does not carry it
+    inline uint64_t insert(const std::pair<FIELD, std::string> &header_line, const size_t name_size) {
+        const size_t new_size = entry_size(name_size, header_line.second.size());
+        if (new_size > capacity) throw QPACKException { err_t::QPACK_ENCODER_STREAM_ERROR };
+        while(size + new_size > capacity) evict();
+        entries.push_back({header_line, new_size});
+        size += new_size;
+        const uint64_t index = insert_count++;
+        if (header_line.first != FIELD::IGNORE_THIS) {
+            entry_value_map[header_line] = index;
+            entry_map[header_line.first] = index;
         }
+        return index;
+    }
+};
+
+// https://www.rfc-editor.org/rfc/rfc9204.html#name-required-insert-count
+inline uint64_t EncodeRequiredInsertCount(const uint64_t required_insert_count, const uint64_t max_entries) {
+    if (required_insert_count == 0) return 0;
+    return (required_insert_count % (2 * max_entries)) + 1;
+}
+
+uint64_t DecodeRequiredInsertCount(const uint64_t encoded_insert_count, const uint64_t max_entries, const uint64_t total_inserts);
+
+// Encoder owns dynamic table on encoder stream of a connection.
+// Field sections are written to request stream and table update to encoder stream.
+class encoder_t {
+private:
+    // Section which reference dynamic table and is not acknowledged yet
+    struct section_t {
+        uint64_t required_insert_count;
+        uint64_t min_reference;
+    };
+
+    dynamic_table_t dynamic_table;
+    const size_t preferred_capacity;
+    const size_t max_blocked_streams;
+    uint64_t known_received_count { 0 };
+    std::string pending_instructions { };
+    std::unordered_map<uint64_t, std::deque<section_t>> outstanding { };
+    // Literal values in field section are Huffman encoded once per connection
+    hpack::huffman_cache_t huffman_cache { };
+
+    size_t GetBlockedStreams() const;
+    bool IsStreamBlocked(const uint64_t stream_id) const;
+    uint64_t GetMinReference() const;
+
+public:
+    // max_capacity and max_blocked_streams are peer SETTINGS_QPACK_MAX_TABLE_CAPACITY and SETTINGS_QPACK_BLOCKED_STREAMS
+    encoder_t(size_t max_capacity, size_t max_blocked_streams, size_t preferred_capacity = 4096)
+        : dynamic_table { max_capacity }, preferred_capacity { std::min(preferred_capacity, max_capacity) }, max_blocked_streams { max_blocked_streams } { }
+
+    void Encode(const uint64_t stream_id, const std::vector<std::pair<FIELD, std::string>> &fields, Stream &field_section, Stream &encoder_stream);
+
+    // https://www.rfc-editor.org/rfc/rfc9204.html#name-decoder-instructions
+    void ProcessDecoderInstructions(const Stream &input);
+
+    inline const auto &GetDynamicTable() const { return dynamic_table; }
+    inline uint64_t GetKnownReceivedCount() const { return known_received_count; }
+    inline size_t GetOutstandingSections(const uint64_t stream_id) const {
+        auto itr = outstanding.find(stream_id);
+        return itr == outstanding.end() ? 0 : itr->second.size();
+    }
+};
+
+// Decoder owns dynamic table built from peer encoder stream.
+// Section which cannot be decoded yet is kept till required inserts arrive.
+class decoder_t {
+public:
+    using add_field_t = std::function<void(const std::pair<FIELD, std::string> &)>;
+
+    enum class status_t {
+        Decoded,
+        Blocked
+    };
+
+private:
+    struct blocked_section_t {
+        uint64_t stream_id;
+        uint64_t required_insert_count;
+        uint64_t base;
+        std::string section;
+        add_field_t add_field;
+    };
+
+    dynamic_table_t dynamic_table;
+    const size_t max_blocked_streams;
+    // Insert count known to encoder by section acknowledgment or insert count increment
+    uint64_t acknowledged_count { 0 };
+    std::string pending_instructions { };
+    std::deque<blocked_section_t> blocked_sections { };
+
+    void Decode(const Stream &section, const uint64_t required_insert_count, const uint64_t base, const add_field_t &add_field) const;
+    void Acknowledge(const uint64_t stream_id, const uint64_t required_insert_count, Stream &decoder_stream);
+    void UnblockSections(Stream &decoder_stream);
+
+public:
+    // max_capacity and max_blocked_streams are local SETTINGS_QPACK_MAX_TABLE_CAPACITY and SETTINGS_QPACK_BLOCKED_STREAMS
+    decoder_t(size_t max_capacity, size_t max_blocked_streams) : dynamic_table { max_capacity }, max_blocked_streams { max_blocked_streams } { }
+
+    // input may contain partial instruction, that is kept till rest of it arrive
+    void ProcessEncoderInstructions(const Stream &input, Stream &decoder_stream);
+
+    // add_field is called for every field line once section is decoded, this may be later for Blocked
+    status_t DecodeFieldSection(const uint64_t stream_id, const Stream &section, Stream &decoder_stream, const add_field_t &add_field);
+
+    // https://www.rfc-editor.org/rfc/rfc9204.html#name-stream-cancellation
+    void CancelStream(const uint64_t stream_id, Stream &decoder_stream);
+
+    inline const auto &GetDynamicTable() const { return dynamic_table; }
+    inline size_t GetBlockedStreams() const { return blocked_sections.size(); }
+    inline bool IsBlocked(const uint64_t stream_id) const {
+        return std::ranges::any_of(blocked_sections, [&](const auto &blocked_section) { return blocked_section.stream_id == stream_id; });
     }
-} // namespace header
+};
 
-} // namespace rohit::http::v2
\ No newline at end of file
+} // namespace MMS::http::qpack
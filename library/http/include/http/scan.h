@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////
+//
+// HTTP/1.1 delimiter scanning.
+// Space, colon, CR and LF are located in blocks with SIMD, kernel is selected at runtime.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace MMS::http::scan {
+
+// Offsets of ' ', ':', '\r' and '\n' in data are written to positions after adding base_offset.
+// positions must have space for size entries. Returns number of positions written.
+using find_delimiters_t = size_t (*)(const uint8_t *data, const size_t size, const uint32_t base_offset, uint32_t *positions);
+
+size_t find_delimiters_scalar(const uint8_t *data, const size_t size, const uint32_t base_offset, uint32_t *positions);
+#if defined(__x86_64__)
+size_t find_delimiters_sse42(const uint8_t *data, const size_t size, const uint32_t base_offset, uint32_t *positions);
+size_t find_delimiters_avx2(const uint8_t *data, const size_t size, const uint32_t base_offset, uint32_t *positions);
+#endif
+
+// Best kernel supported by CPU
+extern const find_delimiters_t find_delimiters;
+const char *find_delimiters_name();
+
+// Delimiter positions of a buffer, buffer is indexed one block at a time as parser moves forward.
+class delimiter_index_t {
+    static constexpr size_t block_size = 256;
+
+    const uint8_t *const base;
+    const size_t size;
+    size_t scanned { 0 };
+    size_t count { 0 };
+    size_t current { 0 };
+    uint32_t positions[block_size];
+
+public:
+    delimiter_index_t(const uint8_t *begin, const uint8_t *end) : base { begin }, size { static_cast<size_t>(end - begin) }, positions { } { }
+    delimiter_index_t(const delimiter_index_t &) = delete;
+    delimiter_index_t &operator=(const delimiter_index_t &) = delete;
+
+    // Next delimiter at or after from, end of buffer if there is none.
+    // from must not move backward between calls.
+    const uint8_t *next(const uint8_t *from) {
+        const size_t offset = static_cast<size_t>(from - base);
+        for(;;) {
+            while(current < count) {
+                if (positions[current] >= offset) return base + positions[current];
+                ++current;
+            }
+            if (offset >= size) return base + size;
+            if (scanned < offset) scanned = offset;
+            if (scanned >= size) return base + size;
+            const size_t length = size - scanned < block_size ? size - scanned : block_size;
+            count = find_delimiters(base + scanned, length, static_cast<uint32_t>(scanned), positions);
+            current = 0;
+            scanned += length;
+        }
+    }
+
+    // Next delimiter matching any of given characters
+    template <uint8_t... delimiters>
+    const uint8_t *next_of(const uint8_t *from) {
+        const uint8_t *const end = base + size;
+        auto pos = next(from);
+        while(pos != end && ((*pos != delimiters) && ...)) pos = next(pos + 1);
+        return pos;
+    }
+};
+
+} // namespace MMS::http::scan
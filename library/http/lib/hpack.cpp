@@ -16,93 +16,287 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <http/hpack.h>
+#include <algorithm>
+#include <cctype>
 
 namespace MMS::http::hpack {
 
-const node *huffman_root = created_huffman_tree();
-
-node *created_huffman_tree() {
-    node *root = new node();
-    constexpr uint16_t symbol_count = sizeof(static_huffman)/sizeof(static_huffman[0]);
-    for(uint16_t symbol = 0; symbol < symbol_count; ++symbol) {
-        auto symbol_entry = static_huffman[symbol];
-        uint32_t code = symbol_entry.code;
-        node *curr = root;
-        for(uint32_t bit = 1 << (symbol_entry.code_len - 1); bit; bit >>= 1) {
-            if ((code & bit) == 0) {
-                if (curr->left == nullptr) {
-                    curr->left = new node();
+namespace {
+consteval huffman_decode_table_t create_huffman_decode_table() {
+    constexpr size_t symbol_count = sizeof(static_huffman)/sizeof(static_huffman[0]);
+    constexpr size_t node_count = symbol_count * 2 - 1;
+    constexpr int16_t none = -1;
+
+    // Tree is kept in arrays, node 0 is root
+    std::array<std::array<int16_t, 2>, node_count> child { };
+    std::array<int16_t, node_count> symbol { };
+    std::array<uint8_t, node_count> state { };
+    // Path from root is at most 7 one bits, that is valid padding
+    std::array<bool, node_count> accept { };
+    for(auto &entry: child) entry = { none, none };
+    symbol.fill(none);
+    accept[0] = true;
+
+    size_t next_node { 1 };
+    size_t next_state { 1 };
+    for(size_t index { 0 }; index < symbol_count; ++index) {
+        const auto &entry = static_huffman[index];
+        size_t curr { 0 };
+        bool ones { true };
+        for(uint32_t depth { 1 }; depth <= entry.code_len; ++depth) {
+            const auto bit = (entry.code >> (entry.code_len - depth)) & 1;
+            ones = ones && bit;
+            if (child[curr][bit] == none) {
+                child[curr][bit] = static_cast<int16_t>(next_node++);
+                if (depth < entry.code_len) {
+                    state[child[curr][bit]] = static_cast<uint8_t>(next_state++);
+                    accept[child[curr][bit]] = ones && depth < 8;
                 }
-                curr = curr->left;
-            } else {
-                if (curr->right == nullptr) {
-                    curr->right = new node();
+            }
+            curr = child[curr][bit];
+        }
+        symbol[curr] = static_cast<int16_t>(index);
+    }
+
+    huffman_decode_table_t table { };
+    for(size_t node { 0 }; node < node_count; ++node) {
+        if (symbol[node] != none) continue;
+        for(uint8_t nibble { 0 }; nibble < 16; ++nibble) {
+            huffman_decode_entry entry { 0, 0, 0 };
+            size_t curr { node };
+            for(int bit { 3 }; bit >= 0; --bit) {
+                curr = child[curr][(nibble >> bit) & 1];
+                if (symbol[curr] == none) continue;
+                if (symbol[curr] == 256) {
+                    entry.flags = huffman_decode_entry::FAIL;
+                    break;
                 }
-                curr = curr->right;
+                entry.flags = huffman_decode_entry::SYMBOL;
+                entry.symbol = static_cast<uint8_t>(symbol[curr]);
+                curr = 0;
             }
+            if (entry.flags != huffman_decode_entry::FAIL) {
+                entry.state = state[curr];
+                if (accept[curr]) entry.flags |= huffman_decode_entry::ACCEPT;
+            }
+            table[state[node]][nibble] = entry;
         }
-        curr->set_leaf(symbol);
     }
+    return table;
+}
+} // namespace
 
-    return root;
+constinit const huffman_decode_table_t huffman_decode_table = create_huffman_decode_table();
+
+char *decode_huffman(const uint8_t *begin, const uint8_t *end, char *output) {
+    uint8_t state { 0 };
+    uint8_t flags { huffman_decode_entry::ACCEPT };
+    for(; begin != end; ++begin) {
+        const auto &high = huffman_decode_table[state][*begin >> 4];
+        const auto &low = huffman_decode_table[high.state][*begin & 0x0f];
+        if ((high.flags | low.flags) & huffman_decode_entry::FAIL) return nullptr;
+        *output = static_cast<char>(high.symbol);
+        output += high.flags & huffman_decode_entry::SYMBOL;
+        *output = static_cast<char>(low.symbol);
+        output += low.flags & huffman_decode_entry::SYMBOL;
+        state = low.state;
+        flags = low.flags;
+    }
+    return (flags & huffman_decode_entry::ACCEPT) ? output : nullptr;
 }
 
 std::string get_huffman_string(const Stream &stream) {
-    std::string value;
-    const node *curr = huffman_root;
-    while(!stream.full()) {
-        for(uint8_t bit = 128; bit; bit >>= 1) {
-            if ((*stream & bit) == 0) {
-                curr = curr-> left;
-            } else {
-                curr = curr->right;
-            }
+    std::string value { };
+    bool valid { false };
+    value.resize_and_overwrite(huffman_decoded_max_size(stream.remaining_buffer()), [&](char *buffer, size_t) {
+        const auto output = decode_huffman(stream.curr(), stream.end(), buffer);
+        valid = output != nullptr;
+        return valid ? static_cast<size_t>(output - buffer) : 0;
+    });
+    if (!valid) throw HPACKException { err_t::HPACK_HUFFMAN_DECODE_FAILED };
+    return value;
+}
 
-            if (curr->is_leaf()) {
-                if (curr->is_eos()) return value;
-                value.push_back(curr->get_symbol());
+size_t encode_huffman(const uint8_t *begin, const uint8_t *end, uint8_t *output, const size_t limit) {
+    const auto output_begin = output;
+    const auto output_limit = output + limit;
+    // At most 31 bits are pending before a code is added, longest code is 30 bits
+    uint64_t bits { 0 };
+    uint32_t bit_count { 0 };
+    for(; begin != end; ++begin) {
+        if (output >= output_limit) return limit;
+        const auto &entry = static_huffman[*begin];
+        bits = (bits << entry.code_len) | entry.code;
+        bit_count += entry.code_len;
+        if (bit_count >= 32) {
+            bit_count -= 32;
+            const auto word = static_cast<uint32_t>(bits >> bit_count);
+            output[0] = static_cast<uint8_t>(word >> 24);
+            output[1] = static_cast<uint8_t>(word >> 16);
+            output[2] = static_cast<uint8_t>(word >> 8);
+            output[3] = static_cast<uint8_t>(word);
+            output += 4;
+        }
+    }
+    while(bit_count >= 8) {
+        bit_count -= 8;
+        *output++ = static_cast<uint8_t>(bits >> bit_count);
+    }
+    if (bit_count) {
+        // Padding is most significant bits of EOS
+        *output++ = static_cast<uint8_t>((bits << (8 - bit_count)) | (0xff >> bit_count));
+    }
+    return std::min(static_cast<size_t>(output - output_begin), limit);
+}
 
-                curr = huffman_root;
-            }
+std::string_view encode_huffman(const std::string_view value) {
+    thread_local std::vector<uint8_t> scratch { };
+    if (scratch.size() < value.size() + huffman_encode_slack) scratch.resize(value.size() + huffman_encode_slack);
+    const auto begin = reinterpret_cast<const uint8_t *>(value.data());
+    const auto size = encode_huffman(begin, begin + value.size(), scratch.data(), value.size());
+    if (size >= value.size()) return { };
+    return { reinterpret_cast<const char *>(scratch.data()), size };
+}
+
+void add_huffman_string(Stream &stream, const Stream &valstream) {
+    const auto limit = huffman_encoded_max_size(valstream.remaining_buffer());
+    stream.Reserve(limit + huffman_encode_slack);
+    stream += encode_huffman(valstream.curr(), valstream.end(), stream.curr(), limit);
+    valstream += valstream.remaining_buffer();
+}
+
+const huffman_cache_t::entry_t &huffman_cache_t::get(const std::string_view value) {
+    const auto hash = std::hash<std::string_view> { }(value);
+    const auto set = hash % set_count;
+    auto &ways = entries[set];
+    for(uint8_t way { 0 }; way < ways.size(); ++way) {
+        if (ways[way].hash == hash && ways[way].value == value) {
+            recent[set] = way;
+            return ways[way];
         }
+    }
+    recent[set] ^= 1;
+    auto &entry = ways[recent[set]];
+    entry.hash = hash;
+    entry.value = value;
+    entry.encoded = encode_huffman(value);
+    return entry;
+}
 
-        ++stream;
+encoded_field_t::encoded_field_t(const std::pair<FIELD, std::string> &header) : header { header } {
+    if (static_table.contains(header)) {
+        static_index = static_table[header];
+        return;
     }
+    FullStreamAutoAlloc stream { 64 };
+    if (static_table.contains(header.first)) {
+        encode_integer<6>(stream, 0x40, static_table[header.first]);
+    } else {
+        *stream++ = 0x40;
+        add_header_string(stream, to_wire_name(header.first));
+    }
+    add_header_string(stream, header.second);
+    literal.assign(reinterpret_cast<const char *>(stream.begin()), stream.index());
+}
 
-    return value;
+void encoder_cache_t::encode(dynamic_table_t &dynamic_table, Stream &stream, const encoded_field_t &field, uint64_t &absolute_index) {
+    if (field.static_index) {
+        encode_integer<7>(stream, 0x80, field.static_index);
+        return;
+    }
+    const auto index = dynamic_table.find_absolute(absolute_index);
+    if (index != dynamic_table_t::npos) {
+        encode_integer<7>(stream, 0x80, index + dynamic_table_first_index);
+        return;
+    }
+    stream.Copy(field.literal.data(), field.literal.size());
+    absolute_index = dynamic_table.insert(field.header, wire_name_size(field.header.first));
 }
 
-void add_huffman_string(Stream &stream, const Stream &valstream) {
-    constexpr uint8_t mask[] = {0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01};
-    uint8_t bit_index = 0;
-    *stream = 0; // Clean all existing value
-    for(;!valstream.full(); ++valstream) {
-        const auto &entry = static_huffman[*valstream];
-        auto len_left = entry.code_len;
-        auto code = entry.code;
-        while (true) {
-            if (bit_index + len_left <= 8) {
-                *stream += (code << (8 - bit_index - len_left)) & mask[bit_index];
-                bit_index += len_left;
-                if (bit_index == 8) {
-                    bit_index = 0;
-                    ++stream;
-                    *stream = 0;
-                }
-                break;
-            } else {
-                // This will copy atleast one bit
-                *stream++ += (code >> (len_left + bit_index - 8)) & mask[bit_index];
-                len_left -= 8 - bit_index;
-                bit_index = 0;
-                *stream = 0;
-            }
+void encoder_cache_t::encode(dynamic_table_t &dynamic_table, Stream &stream, const std::vector<encoded_field_t> &fixed_fields) {
+    // Configuration does not change for connection, size changes only once
+    if (fixed_indexes.size() != fixed_fields.size()) fixed_indexes.assign(fixed_fields.size(), dynamic_table_t::npos);
+    for(size_t index { 0 }; index < fixed_fields.size(); ++index) {
+        encode(dynamic_table, stream, fixed_fields[index], fixed_indexes[index]);
+    }
+}
+
+void encoder_cache_t::encode(dynamic_table_t &dynamic_table, Stream &stream, const std::pair<FIELD, std::string> &header_line) {
+    const auto hash = std::hash<std::pair<FIELD, std::string>> { }(header_line);
+    const auto set = hash % set_count;
+    auto &ways = entries[set];
+    for(uint8_t way { 0 }; way < ways.size(); ++way) {
+        if (ways[way].hash == hash && ways[way].field.header == header_line) {
+            recent[set] = way;
+            encode(dynamic_table, stream, ways[way].field, ways[way].absolute_index);
+            return;
         }
     }
-    
-    if (bit_index) {
-        *stream++ += mask[bit_index];
+    recent[set] ^= 1;
+    auto &entry = ways[recent[set]];
+    entry.hash = hash;
+    entry.field = encoded_field_t { header_line };
+    // Entry may be in table already
+    const auto index = dynamic_table.find(header_line);
+    entry.absolute_index = index == dynamic_table_t::npos ? dynamic_table_t::npos : dynamic_table.get_insert_count() - 1 - index;
+    encode(dynamic_table, stream, entry.field, entry.absolute_index);
+}
+
+void dynamic_table_t::evict() {
+    const uint64_t index = dropped_count++;
+    const auto &oldest = entry(index);
+    if (lookup) {
+        auto value_itr = entry_value_map.find(oldest.header);
+        if (value_itr != entry_value_map.end() && value_itr->second == index) entry_value_map.erase(value_itr);
+        auto name_itr = entry_map.find(oldest.header.first);
+        if (name_itr != entry_map.end() && name_itr->second == index) entry_map.erase(name_itr);
+    }
+    // String is kept, its buffer is reused by later insert at this position
+    table_size -= oldest.size;
+}
+
+void dynamic_table_t::grow() {
+    std::vector<entry_t> new_entries(entries.size() * 2);
+    const auto mask = new_entries.size() - 1;
+    for(auto index = dropped_count; index < insert_count; ++index) {
+        new_entries[index & mask] = std::move(entry(index));
+    }
+    entries = std::move(new_entries);
+}
+
+uint64_t dynamic_table_t::insert(const std::pair<FIELD, std::string> &header_line, const size_t name_size) {
+    const size_t new_size = entry_size(name_size, header_line.second.size());
+    // rfc7541 - 4.4.  Entry Eviction When Adding New Entries
+    while(count() && table_size + new_size > max_size) evict();
+    if (new_size > max_size) return npos;
+    if (count() == entries.size()) grow();
+
+    const uint64_t index = insert_count++;
+    auto &newest = entry(index);
+    newest.header.first = header_line.first;
+    newest.header.second.assign(header_line.second);
+    newest.size = new_size;
+    table_size += new_size;
+    if (lookup && header_line.first != FIELD::IGNORE_THIS) {
+        entry_value_map.insert_or_assign(header_line, index);
+        entry_map.insert_or_assign(header_line.first, index);
     }
+    return index;
+}
+
+void dynamic_table_t::update_size(const size_t new_size) {
+    if (new_size > size_limit) throw HPACKException { err_t::HPACK_TABLE_SIZE_UPDATE_FAILED };
+    max_size = new_size;
+    // rfc7541 - 4.3.  Entry Eviction When Dynamic Table Size Changes
+    while(table_size > max_size) evict();
+}
+
+void dynamic_table_t::set_size_limit(const size_t new_limit) {
+    size_limit = new_limit;
+    if (max_size == new_limit) return;
+    max_size = new_limit;
+    while(table_size > max_size) evict();
+    size_update_pending = true;
 }
 
 const static_table_t static_table = {
@@ -111,6 +305,39 @@ const static_table_t static_table = {
 #undef HTTP2_STATIC_TABLE_ENTRY
 };
 
+std::string to_wire_name(const FIELD field) {
+    std::string name { };
+    switch(field) {
+    case FIELD::Authority:
+    case FIELD::Method:
+    case FIELD::Path:
+    case FIELD::Scheme:
+    case FIELD::Status:
+        name.push_back(':');
+        break;
+    default:
+        break;
+    }
+    for(auto ch: to_string(field)) name.push_back(static_cast<char>(std::tolower(ch)));
+    return name;
+}
+
+static const std::unordered_map<std::string, FIELD> wire_field_map = [] {
+    std::unordered_map<std::string, FIELD> field_map { };
+#define HTTP_FIELD_ENTRY(x, y) field_map.insert(std::make_pair(to_wire_name(FIELD::x), FIELD::x));
+    HTTP_FIELD_LIST
+#undef HTTP_FIELD_ENTRY
+    return field_map;
+}();
+
+FIELD wire_to_field(const std::string &name) {
+    auto fielditr = wire_field_map.find(name);
+    if (fielditr == std::end(wire_field_map)) {
+        return FIELD::IGNORE_THIS;
+    }
+    return fielditr->second;
+}
+
 const std::pair<FIELD, std::string> map_table_t::empty { FIELD::IGNORE_THIS, {}};
 
 } // namespace MMS::http::hpack
\ No newline at end of file
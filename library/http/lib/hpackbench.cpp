@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <http/hpack.h>
+#include <http/http2.h>
+#include <benchmark/benchmark.h>
+
+namespace hpack = MMS::http::hpack;
+namespace v2 = MMS::http::v2;
+using MMS::http::FIELD;
+
+// Field values of browser request and server response, these are Huffman coded by peers
+const std::vector<std::string> field_values {
+    "www.example.com",
+    "/static/js/application.bundle.js?v=20241021",
+    "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36",
+    "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8",
+    "gzip, deflate, br",
+    "en-US,en;q=0.9",
+    "https://www.example.com/index.html",
+    "session=4f2a9c1e7b3d; theme=dark; _ga=GA1.2.1234567890.1697812345",
+    "Mon, 21 Oct 2024 07:28:00 GMT",
+    "application/javascript; charset=utf-8",
+    "public, max-age=604800, immutable",
+    "\"5e1f-63b2a1c4\"",
+};
+
+static const std::vector<std::vector<uint8_t>> &GetEncodedValues() {
+    static const auto encoded = [] {
+        std::vector<std::vector<uint8_t>> encoded { };
+        for(auto &value: field_values) {
+            MMS::FullStreamAutoAlloc stream { 256 };
+            stream.Reserve(hpack::huffman_string_size(MMS::make_const_stream(value.data(), value.size())) + 1);
+            hpack::add_huffman_string(stream, MMS::make_const_stream(value.data(), value.size()));
+            encoded.emplace_back(stream.begin(), stream.begin() + stream.index());
+        }
+        return encoded;
+    }();
+    return encoded;
+}
+
+static size_t GetEncodedSize() {
+    size_t size { 0 };
+    for(auto &value: GetEncodedValues()) size += value.size();
+    return size;
+}
+
+// Decoded to new string as done by header parsing
+static void BM_HuffmanDecodeString(benchmark::State &state) {
+    const auto &encoded = GetEncodedValues();
+    for (auto _ : state) {
+        for(auto &value: encoded) {
+            auto decoded = hpack::get_huffman_string(MMS::make_const_stream(value.data(), value.size()));
+            benchmark::DoNotOptimize(decoded);
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * GetEncodedSize()));
+}
+BENCHMARK(BM_HuffmanDecodeString);
+
+// Decoded to preallocated buffer
+static void BM_HuffmanDecodeBuffer(benchmark::State &state) {
+    const auto &encoded = GetEncodedValues();
+    std::vector<char> output(hpack::huffman_decoded_max_size(256));
+    for (auto _ : state) {
+        for(auto &value: encoded) {
+            auto end = hpack::decode_huffman(value.data(), value.data() + value.size(), output.data());
+            benchmark::DoNotOptimize(end);
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * GetEncodedSize()));
+}
+BENCHMARK(BM_HuffmanDecodeBuffer);
+
+static size_t GetValueSize() {
+    size_t size { 0 };
+    for(auto &value: field_values) size += value.size();
+    return size;
+}
+
+// Length prefix and Huffman or literal string as written in field line
+static void BM_HeaderStringEncode(benchmark::State &state) {
+    MMS::FullStreamAutoAlloc stream { 1024 };
+    for (auto _ : state) {
+        stream.Reset();
+        for(auto &value: field_values) hpack::add_header_string<8>(stream, 0x00, value);
+        benchmark::DoNotOptimize(stream.curr());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * GetValueSize()));
+}
+BENCHMARK(BM_HeaderStringEncode);
+
+// Connection writes same values for every response
+static void BM_HeaderStringEncodeCached(benchmark::State &state) {
+    MMS::FullStreamAutoAlloc stream { 1024 };
+    hpack::huffman_cache_t cache { };
+    for (auto _ : state) {
+        stream.Reset();
+        for(auto &value: field_values) hpack::add_header_string<8>(stream, 0x00, value, &cache);
+        benchmark::DoNotOptimize(stream.curr());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * GetValueSize()));
+}
+BENCHMARK(BM_HeaderStringEncodeCached);
+
+using fields_t = std::vector<std::pair<FIELD, std::string>>;
+
+// Browser loading resources of a page over one connection, only path changes
+static const std::vector<fields_t> &GetPageRequests() {
+    static const auto requests = [] {
+        std::vector<fields_t> requests { };
+        for(size_t index { 0 }; index < 20; ++index) {
+            requests.push_back({
+                {FIELD::Method, "GET"},
+                {FIELD::Scheme, "https"},
+                {FIELD::Authority, "www.example.com"},
+                {FIELD::Path, "/static/img/icon-" + std::to_string(index) + ".png"},
+                {FIELD::User_Agent, "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36"},
+                {FIELD::Accept, "image/avif,image/webp,*/*;q=0.8"},
+                {FIELD::Accept_Encoding, "gzip, deflate, br"},
+                {FIELD::Accept_Language, "en-US,en;q=0.9"},
+                {FIELD::Referer, "https://www.example.com/index.html"},
+                {FIELD::Cookie, "session=4f2a9c1e7b3d; theme=dark"},
+            });
+        }
+        return requests;
+    }();
+    return requests;
+}
+
+static std::vector<std::string> EncodePage(hpack::dynamic_table_t &table) {
+    std::vector<std::string> blocks { };
+    MMS::FullStreamAutoAlloc stream { 1024 };
+    for(auto &fields: GetPageRequests()) {
+        stream.Reset();
+        for(auto &field: fields) v2::copy_http_header_response(table, stream, field, true);
+        blocks.emplace_back(reinterpret_cast<const char *>(stream.begin()), stream.index());
+    }
+    return blocks;
+}
+
+// Connection table is kept across pages, block_bytes is average header block size
+static void BM_HPACKEncodePage(benchmark::State &state) {
+    hpack::dynamic_table_t table { };
+    MMS::FullStreamAutoAlloc stream { 1024 };
+    size_t bytes { 0 };
+    size_t headers { 0 };
+    for (auto _ : state) {
+        for(auto &fields: GetPageRequests()) {
+            stream.Reset();
+            for(auto &field: fields) v2::copy_http_header_response(table, stream, field, true);
+            bytes += stream.index();
+            headers += fields.size();
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(headers));
+    state.counters["block_bytes"] = benchmark::Counter(static_cast<double>(bytes) / static_cast<double>(state.iterations() * GetPageRequests().size()));
+}
+BENCHMARK(BM_HPACKEncodePage);
+
+// Response header frame of static file, argument 1 uses encoder cache of connection
+static void BM_HPACKEncodeResponse(benchmark::State &state) {
+    const std::vector<hpack::encoded_field_t> fixed_fields {
+        std::make_pair(FIELD::Server, std::string { "MicroMonolithServer" }),
+    };
+    const fields_t fields {
+        {FIELD::Content_Type, "application/javascript"},
+        {FIELD::Cache_Control, "max-age=604800"},
+        {FIELD::Vary, "accept-encoding"},
+        {FIELD::ETag, "\"5e1f-63b2a1c4\""},
+        {FIELD::Content_Length, "48213"},
+    };
+    hpack::dynamic_table_t table { };
+    hpack::encoder_cache_t cache { };
+    MMS::FullStreamAutoAlloc stream { 1024 };
+    const auto encoder_cache = state.range(0) ? &cache : nullptr;
+    size_t bytes { 0 };
+    for (auto _ : state) {
+        stream.Reset();
+        v2::CreateHeaderFrame(table, stream, 1, MMS::http::CODE::OK, fields, fixed_fields, encoder_cache);
+        bytes += stream.index();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["frame_bytes"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HPACKEncodeResponse)->Arg(0)->Arg(1);
+
+// Page encoded by new connection is decoded by new connection
+static void BM_HPACKDecodePage(benchmark::State &state) {
+    hpack::dynamic_table_t encoder_table { };
+    const auto blocks = EncodePage(encoder_table);
+    size_t headers { 0 };
+    for (auto _ : state) {
+        hpack::dynamic_table_t table { v2::constant::SETTINGS_HEADER_TABLE_SIZE, false };
+        for(auto &block: blocks) {
+            v2::header_request request { };
+            request.parse_header(MMS::make_const_stream(block.data(), block.size()), 1, table);
+            benchmark::DoNotOptimize(request.GetPath());
+        }
+        for(auto &fields: GetPageRequests()) headers += fields.size();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(headers));
+}
+BENCHMARK(BM_HPACKDecodePage);
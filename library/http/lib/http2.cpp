@@ -20,51 +20,164 @@
 
 namespace MMS::http::v2 {
 
-void CreateHeaderFrame(hpack::dynamic_table_t &dynamic_table, FullStream &stream, uint32_t stream_identifier, CODE code, const std::vector<std::pair<FIELD, std::string>> &fields) {
-    constexpr uint64_t max_date_string_size = 92;
-    std::time_t now_time = std::time(0);   // get time now
-    std::tm* now_tm = std::gmtime(&now_time);
-    char date_str[max_date_string_size];
-    size_t date_str_size = strftime(date_str, max_date_string_size, "%a, %d %b %Y %H:%M:%S %Z", now_tm);
-
-    auto frame_buffer = stream.GetCurrAndIncrease(sizeof(MMS::http::v2::frame));
-    auto start_frame_body = stream.curr();
-    copy_http_header_response(dynamic_table, stream, std::make_pair(FIELD::Status, std::to_string(static_cast<uint16_t>(code)) ), true);
-    copy_http_header_response(dynamic_table, stream, std::make_pair(FIELD::Date, std::string { date_str, date_str_size } ), false);
-    std::ranges::for_each(fields, [&](auto field) {copy_http_header_response(dynamic_table, stream, field, true);});
-    new (frame_buffer) frame{ static_cast<uint32_t>(stream.GetSizeFrom(start_frame_body)), frame::type_t::HEADERS, frame::flags_t::END_HEADERS, stream_identifier };
+std::string_view GetDateHPACK() {
+    // Date text changes once a second, encoding is repeated only then
+    thread_local std::string date { };
+    thread_local FullStreamAutoAlloc encoded { 64 };
+    const auto current = GetDate();
+    if (current != date) {
+        date = current;
+        encoded.Reset();
+        hpack::dynamic_table_t empty_table { };
+        copy_http_header_response(empty_table, encoded, std::make_pair(FIELD::Date, date), false);
+    }
+    return { reinterpret_cast<const char *>(encoded.begin()), encoded.index() };
+}
+
+void CreateHeaderFrame(hpack::dynamic_table_t &dynamic_table, FullStream &stream, uint32_t stream_identifier, CODE code, const std::vector<std::pair<FIELD, std::string>> &fields, const std::vector<hpack::encoded_field_t> &fixed_fields, hpack::encoder_cache_t *encoder_cache, bool end_stream) {
+    // Stream may be reallocated while header block is written, frame is addressed by offset
+    const auto frame_offset = stream.index();
+    stream += sizeof(MMS::http::v2::frame);
+    // rfc7541 - 6.3.  Dynamic Table Size Update must be at start of header block
+    if (dynamic_table.take_size_update()) hpack::encode_integer<5>(stream, 0x20, dynamic_table.get_max_size());
+    const auto status_index = status_static_index(code);
+    if (status_index) *stream++ = static_cast<uint8_t>(0x80 + status_index);
+    else copy_http_header_response(dynamic_table, stream, std::make_pair(FIELD::Status, std::to_string(static_cast<uint16_t>(code))), true);
+    const auto date = GetDateHPACK();
+    stream.Copy(date.data(), date.size());
+    if (encoder_cache) {
+        encoder_cache->encode(dynamic_table, stream, fixed_fields);
+        for(const auto &field: fields) {
+            if (hpack::encoder_cache_t::is_cacheable(field.first) && field.second.size() <= hpack::encoder_cache_t::max_value_size) {
+                encoder_cache->encode(dynamic_table, stream, field);
+            } else {
+                copy_http_header_response(dynamic_table, stream, field, false, &encoder_cache->huffman_cache);
+            }
+        }
+    } else {
+        for(const auto &field: fixed_fields) copy_http_header_response(dynamic_table, stream, field.header, false);
+        for(const auto &field: fields) copy_http_header_response(dynamic_table, stream, field, true);
+    }
+    const auto frame_size = static_cast<uint32_t>(stream.index() - frame_offset - sizeof(frame));
+    auto pframe = new (stream.begin() + frame_offset) frame{ frame_size, frame::type_t::HEADERS, frame::flags_t::END_HEADERS, stream_identifier };
+    if (end_stream) pframe->set_flag(frame::flags_t::END_STREAM);
 }
 
 void CreateBodyFrame(FullStream &stream, uint32_t max_frame_size, const Stream &bodystream, uint32_t stream_identifier) {
+    CreateDataFrame(stream, max_frame_size, bodystream, stream_identifier, true);
+}
+
+void CreateDataFrame(FullStream &stream, uint32_t max_frame_size, const Stream &bodystream, uint32_t stream_identifier, bool end_stream) {
     const uint32_t max_body_size = max_frame_size - sizeof(frame);
-    const uint32_t first_body_size = std::min(max_body_size, static_cast<uint32_t>(bodystream.remaining_buffer()));
-    {
+    const auto bodysize = bodystream.remaining_buffer();
+    // Frame pointer must remain valid, hence buffer is reserved once
+    stream.Reserve(bodysize + (bodysize / max_body_size + 1) * sizeof(frame));
+    do {
+        const auto frame_body_size = static_cast<uint32_t>(std::min<size_t>(max_body_size, bodystream.remaining_buffer()));
         auto frame_buffer = stream.GetCurrAndIncrease(sizeof(frame));
-        auto start_frame_body = stream.GetCurrAndIncrease(first_body_size);
-        auto bodystreamstart = bodystream.GetCurrAndIncrease(first_body_size);
-        std::copy(bodystreamstart, bodystream.curr(), start_frame_body);
-        if (bodystream.remaining_buffer()) {
-            new (frame_buffer) frame{ first_body_size, frame::type_t::DATA, frame::flags_t::NONE, stream_identifier };
-        } else {
-            new (frame_buffer) frame{ first_body_size, frame::type_t::DATA, frame::flags_t::END_STREAM, stream_identifier };
-            return;
+        stream.Copy(bodystream.GetCurrAndIncrease(frame_body_size), frame_body_size);
+        const auto flags = end_stream && bodystream.full() ? frame::flags_t::END_STREAM : frame::flags_t::NONE;
+        new (frame_buffer) frame{ frame_body_size, frame::type_t::DATA, flags, stream_identifier };
+    } while(!bodystream.full());
+}
+
+void CreateEndStreamFrame(FullStream &stream, uint32_t stream_identifier) {
+    auto frame_buffer = stream.GetCurrAndIncrease(sizeof(frame));
+    new (frame_buffer) frame{ 0, frame::type_t::DATA, frame::flags_t::END_STREAM, stream_identifier };
+}
+
+void CreateWindowUpdateFrame(Stream &stream, uint32_t stream_identifier, uint32_t increment) {
+    auto frame_buffer = stream.GetCurrAndIncrease(sizeof(frame));
+    new (frame_buffer) frame{ sizeof(window_update), frame::type_t::WINDOW_UPDATE, frame::flags_t::NONE, stream_identifier };
+    new (stream.GetCurrAndIncrease(sizeof(window_update))) window_update { increment };
+}
+
+void CreateResetFrame(Stream &stream, uint32_t stream_identifier, frame::error_t error) {
+    auto frame_buffer = stream.GetCurrAndIncrease(sizeof(frame));
+    new (frame_buffer) frame{ sizeof(uint32_t), frame::type_t::RST_STREAM, frame::flags_t::NONE, stream_identifier };
+    const auto error_code = changeEndian<std::endian::native, std::endian::big>(static_cast<uint32_t>(error));
+    std::copy_n(reinterpret_cast<const uint8_t *>(&error_code), sizeof(error_code), stream.GetCurrAndIncrease(sizeof(error_code)));
+}
+
+void CreatePingFrame(Stream &stream, uint64_t opaque_data, bool ack) {
+    auto frame_buffer = stream.GetCurrAndIncrease(sizeof(frame));
+    new (frame_buffer) frame{ ping_payload_size, frame::type_t::PING, ack ? frame::flags_t::ACK : frame::flags_t::NONE, 0x00 };
+    opaque_data = changeEndian<std::endian::native, std::endian::big>(opaque_data);
+    std::copy_n(reinterpret_cast<const uint8_t *>(&opaque_data), sizeof(opaque_data), stream.GetCurrAndIncrease(sizeof(opaque_data)));
+}
+
+// One PING is in flight, DATA read after it is sample of its round trip
+bool window_estimator_t::Received(const uint32_t length) {
+    if (window_min == window_max) return false;
+    sample += length;
+    return !ping_pending;
+}
+
+bool window_estimator_t::PingAck(const uint64_t opaque_data, const clock::time_point now) {
+    if (opaque_data != ping_data || !ping_pending) return false;
+    ping_pending = false;
+    const auto sample_rtt = now - ping_sent;
+    rtt = rtt == clock::duration::zero() ? sample_rtt : (7 * rtt + sample_rtt) / 8;
+    min_rtt = min_rtt == clock::duration::zero() ? sample_rtt : std::min(min_rtt, sample_rtt);
+    bdp = sample;
+
+    const auto previous = window;
+    if (sample * 3 >= uint64_t { window } * 2) {
+        // Peer is limited by window
+        window = static_cast<uint32_t>(std::clamp<uint64_t>(2 * sample, window_min, window_max));
+        low_samples = 0;
+    } else if (sample * 4 < window) {
+        if (++low_samples >= shrink_samples) {
+            window = std::max(window / 2, window_min);
+            low_samples = 0;
         }
+    } else {
+        low_samples = 0;
     }
+    return window != previous;
+}
 
-    while(bodystream.remaining_buffer() > max_body_size) {
-        auto frame_buffer = stream.GetCurrAndIncrease(sizeof(frame));
-        auto start_frame_body = stream.GetCurrAndIncrease(max_body_size);
-        auto bodystreamstart = bodystream.GetCurrAndIncrease(first_body_size);
-        std::copy(bodystreamstart, bodystream.curr(), start_frame_body);
-        new (frame_buffer) frame{ max_body_size, frame::type_t::CONTINUATION, frame::flags_t::NONE, stream_identifier };
+// Dictionary members are split on comma, only "u" and "i" are read
+priority_t parse_priority(const std::string_view value) {
+    priority_t priority { };
+    size_t index { 0 };
+    while(index < value.size()) {
+        const auto member_end = std::min(value.find(',', index), value.size());
+        auto member = value.substr(index, member_end - index);
+        member = member.substr(0, member.find(';'));
+        const auto member_begin = member.find_first_not_of(" \t");
+        member = member_begin == std::string_view::npos ? std::string_view { } : member.substr(member_begin, member.find_last_not_of(" \t") + 1 - member_begin);
+        const auto equal = member.find('=');
+        const auto key = member.substr(0, equal);
+        // Key without value is boolean true
+        const auto item = equal == std::string_view::npos ? std::string_view { "?1" } : member.substr(equal + 1);
+        if (key == "u") {
+            if (item.size() == 1 && item[0] >= '0' && item[0] <= '0' + priority_t::lowest_urgency) priority.urgency = static_cast<uint8_t>(item[0] - '0');
+        } else if (key == "i") {
+            if (item == "?1") priority.incremental = true;
+            else if (item == "?0") priority.incremental = false;
+        }
+        index = member_end + 1;
     }
+    return priority;
+}
 
-    const uint32_t last_body_size = bodystream.remaining_buffer();
-    auto frame_buffer = stream.GetCurrAndIncrease(sizeof(MMS::http::v2::frame));
-    auto start_frame_body = stream.GetCurrAndIncrease(last_body_size);
-    auto bodystreamstart = bodystream.GetCurrAndIncrease(first_body_size);
-    std::copy(bodystreamstart, bodystream.end(), start_frame_body);
-    new (frame_buffer) frame{ last_body_size, frame::type_t::CONTINUATION, frame::flags_t::END_STREAM, stream_identifier };
+// HEADERS with its CONTINUATION is returned only when END_HEADERS is read, header block is decoded at once.
+// Other frame inside header block ends it here so that parse reports the error.
+const uint8_t *GetFramesEnd(const uint8_t *begin, const uint8_t *end) {
+    auto complete = begin;
+    bool header_block { false };
+    while(static_cast<size_t>(end - begin) >= sizeof(frame)) {
+        const auto pframe = reinterpret_cast<const frame *>(begin);
+        const auto frame_end = begin + sizeof(frame) + pframe->get_length();
+        if (frame_end > end) break;
+        const auto type = pframe->get_type();
+        header_block = (type == frame::type_t::HEADERS || (header_block && type == frame::type_t::CONTINUATION))
+            && !pframe->contains(frame::flags_t::END_HEADERS);
+        begin = frame_end;
+        if (!header_block) complete = begin;
+    }
+    return complete;
 }
 
 } // namespace MMS::http::v2
\ No newline at end of file
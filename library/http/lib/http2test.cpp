@@ -0,0 +1,573 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <http/http2.h>
+#include <gtest/gtest.h>
+#include <mms/base/stream.h>
+
+namespace v2 = MMS::http::v2;
+
+// Walks frames in buffer, payload of all DATA frames is appended to body
+static size_t ReadDataFrames(const MMS::FullStream &stream, const uint32_t stream_identifier, std::string &body, bool &end_stream) {
+    size_t count { 0 };
+    auto curr = stream.begin();
+    while(curr < stream.curr()) {
+        auto pframe = reinterpret_cast<const v2::frame *>(curr);
+        EXPECT_EQ(pframe->get_type(), v2::frame::type_t::DATA);
+        EXPECT_EQ(pframe->get_stream_identifier(), stream_identifier);
+        EXPECT_FALSE(end_stream);
+        end_stream = (static_cast<uint8_t>(pframe->get_flags()) & static_cast<uint8_t>(v2::frame::flags_t::END_STREAM)) != 0;
+        body.append(reinterpret_cast<const char *>(curr + sizeof(v2::frame)), pframe->get_length());
+        curr += sizeof(v2::frame) + pframe->get_length();
+        ++count;
+    }
+    EXPECT_EQ(curr, stream.curr());
+    return count;
+}
+
+TEST(HTTP2Test, FrameHeader) {
+    // Reserved bit is first bit on wire
+    for(const uint32_t stream_identifier: { 1u, 129u, 0x12345u, 0x7fffffffu }) {
+        const v2::frame header { 100, v2::frame::type_t::DATA, v2::frame::flags_t::END_STREAM, stream_identifier | 0x80000000 };
+        EXPECT_EQ(header.get_stream_identifier(), stream_identifier);
+        EXPECT_EQ(header.get_length(), 100);
+        const auto bytes = reinterpret_cast<const uint8_t *>(&header);
+        EXPECT_EQ(bytes[5], stream_identifier >> 24);
+        EXPECT_EQ(bytes[8], stream_identifier & 0xff);
+        const v2::goaway goaway { stream_identifier, v2::frame::error_t::NO_ERROR };
+        EXPECT_EQ(goaway.get_last_stream_id(), stream_identifier);
+    }
+}
+
+TEST(HTTP2Test, DataFrame) {
+    constexpr uint32_t max_frame_size { 64 };
+    std::string body { };
+    for(size_t index { 0 }; index < 200; ++index) body += static_cast<char>('a' + index % 26);
+
+    // Body is split in frames, only last has END_STREAM
+    MMS::FullStreamAutoAlloc buffer { 16 };
+    v2::CreateBodyFrame(buffer, max_frame_size, MMS::make_const_stream(body), 3);
+    std::string received { };
+    bool end_stream { false };
+    EXPECT_EQ(ReadDataFrames(buffer, 3, received, end_stream), 4);
+    EXPECT_TRUE(end_stream);
+    EXPECT_EQ(received, body);
+
+    // Streamed body ends with empty frame
+    buffer.Reset();
+    v2::CreateDataFrame(buffer, max_frame_size, MMS::make_const_stream(body.data(), 100), 5, false);
+    v2::CreateDataFrame(buffer, max_frame_size, MMS::make_const_stream(body.data() + 100, 100), 5, false);
+    v2::CreateEndStreamFrame(buffer, 5);
+    received.clear();
+    end_stream = false;
+    EXPECT_EQ(ReadDataFrames(buffer, 5, received, end_stream), 5);
+    EXPECT_TRUE(end_stream);
+    EXPECT_EQ(received, body);
+}
+
+TEST(HTTP2Test, DateHPACK) {
+    // Literal without indexing, name is static table index 33
+    const auto date = v2::GetDateHPACK();
+    ASSERT_GE(date.size(), 3);
+    EXPECT_EQ(static_cast<uint8_t>(date[0]), 0x0f);
+    EXPECT_EQ(static_cast<uint8_t>(date[1]), 33 - 15);
+    EXPECT_EQ(date.data(), v2::GetDateHPACK().data());
+}
+
+TEST(HTTP2Test, HPACKDecodeRequests) {
+    // https://www.rfc-editor.org/rfc/rfc7541.html#appendix-C.3
+    const std::vector<std::vector<uint8_t>> blocks {
+        { 0x82, 0x86, 0x84, 0x41, 0x0f, 0x77, 0x77, 0x77, 0x2e, 0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d },
+        { 0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 0x6e, 0x6f, 0x2d, 0x63, 0x61, 0x63, 0x68, 0x65 },
+        { 0x82, 0x87, 0x85, 0xbf, 0x40, 0x0a, 0x63, 0x75, 0x73, 0x74, 0x6f, 0x6d, 0x2d, 0x6b, 0x65, 0x79,
+          0x0c, 0x63, 0x75, 0x73, 0x74, 0x6f, 0x6d, 0x2d, 0x76, 0x61, 0x6c, 0x75, 0x65 },
+    };
+    const std::vector<size_t> table_sizes { 57, 110, 164 };
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    for(size_t index { 0 }; index < blocks.size(); ++index) {
+        v2::header_request request { };
+        request.parse_header(MMS::make_const_stream(blocks[index].data(), blocks[index].size()), 1, table);
+        EXPECT_EQ(request.GetField(MMS::http::FIELD::Authority), "www.example.com");
+        EXPECT_EQ(table.size(), table_sizes[index]);
+    }
+
+    // Newest entry is first
+    EXPECT_EQ(table.count(), 3);
+    EXPECT_EQ(table[0].second, "custom-value");
+    EXPECT_EQ(table.get_name_size(0), 10);
+    EXPECT_EQ(table[1], std::make_pair(MMS::http::FIELD::Cache_Control, std::string { "no-cache" }));
+    EXPECT_EQ(table[2], std::make_pair(MMS::http::FIELD::Authority, std::string { "www.example.com" }));
+    EXPECT_THROW(table[3], MMS::HPACKException);
+
+    // Size update evicts oldest and can not exceed the limit
+    const std::vector<uint8_t> size_update { 0x3f, 0x51 };
+    v2::header_request request { };
+    request.parse_header(MMS::make_const_stream(size_update.data(), size_update.size()), 1, table);
+    EXPECT_EQ(table.count(), 2);
+    EXPECT_EQ(table.size(), 107);
+    const std::vector<uint8_t> over_limit { 0x3f, 0xe2, 0x1f };
+    EXPECT_THROW(request.parse_header(MMS::make_const_stream(over_limit.data(), over_limit.size()), 1, table), MMS::HPACKException);
+}
+
+TEST(HTTP2Test, HPACKEncodeResponses) {
+    const std::vector<std::pair<MMS::http::FIELD, std::string>> fields {
+        {MMS::http::FIELD::Content_Type, "text/html; charset=utf-8"},
+        {MMS::http::FIELD::Cache_Control, "private"},
+        {MMS::http::FIELD::X_Frame_Options, "DENY"},
+    };
+    MMS::http::hpack::dynamic_table_t encoder_table { 256 };
+    MMS::http::hpack::dynamic_table_t decoder_table { 256, false };
+    MMS::FullStreamAutoAlloc buffer { 64 };
+    for(size_t count { 0 }; count < 3; ++count) {
+        buffer.Reset();
+        for(auto &field: fields) v2::copy_http_header_response(encoder_table, buffer, field, true);
+        v2::header_request request { };
+        request.parse_header(MMS::make_const_stream(buffer.begin(), buffer.index()), 1, decoder_table);
+        EXPECT_EQ(request.GetField(MMS::http::FIELD::Content_Type), "text/html; charset=utf-8");
+        EXPECT_EQ(decoder_table.size(), encoder_table.size());
+        // Repeated fields are one octet each
+        if (count) {
+            EXPECT_EQ(buffer.index(), fields.size());
+        }
+    }
+
+    // Peer smaller table is signalled and oldest entries are evicted
+    encoder_table.set_size_limit(64);
+    EXPECT_TRUE(encoder_table.take_size_update());
+    EXPECT_FALSE(encoder_table.take_size_update());
+    EXPECT_EQ(encoder_table.count(), 1);
+    EXPECT_EQ(encoder_table.find(fields[2]), 0);
+    EXPECT_EQ(encoder_table.find(fields[0]), MMS::http::hpack::dynamic_table_t::npos);
+
+    // Entry larger than table empties it
+    encoder_table.insert({MMS::http::FIELD::Cache_Control, std::string(64, 'a')}, 13);
+    EXPECT_EQ(encoder_table.count(), 0);
+    EXPECT_EQ(encoder_table.size(), 0);
+}
+
+TEST(HTTP2Test, HeaderFrameEncoderCache) {
+    const std::vector<MMS::http::hpack::encoded_field_t> fixed_fields {
+        std::make_pair(MMS::http::FIELD::Server, std::string { "MicroMonolithServer" }),
+        std::make_pair(MMS::http::FIELD::X_Frame_Options, std::string { "DENY" }),
+    };
+    const std::vector<std::pair<MMS::http::FIELD, std::string>> fields {
+        {MMS::http::FIELD::Content_Type, "text/html; charset=utf-8"},
+        {MMS::http::FIELD::Cache_Control, "max-age=604800"},
+        {MMS::http::FIELD::Content_Length, "1234"},
+    };
+    MMS::http::hpack::dynamic_table_t encoder_table { };
+    MMS::http::hpack::dynamic_table_t decoder_table { 4096, false };
+    MMS::http::hpack::encoder_cache_t encoder_cache { };
+    // Small buffer is reallocated while header block is written
+    MMS::FullStreamAutoAlloc buffer { 16 };
+    std::vector<size_t> sizes { };
+    for(uint32_t count { 0 }; count < 6; ++count) {
+        // Table with room for one entry evicts fixed fields, they are written as literal again
+        if (count == 3) encoder_table.set_size_limit(80);
+        buffer.Reset();
+        v2::CreateHeaderFrame(encoder_table, buffer, 1 + 2 * count, MMS::http::CODE::OK, fields, fixed_fields, &encoder_cache);
+        const auto pframe = reinterpret_cast<const v2::frame *>(buffer.begin());
+        ASSERT_EQ(pframe->get_type(), v2::frame::type_t::HEADERS);
+        ASSERT_EQ(pframe->get_length(), buffer.index() - sizeof(v2::frame));
+        sizes.push_back(pframe->get_length());
+        v2::header_request request { };
+        request.parse_header(MMS::make_const_stream(buffer.begin() + sizeof(v2::frame), pframe->get_length()), 1 + 2 * count, decoder_table);
+        EXPECT_EQ(request.GetField(MMS::http::FIELD::Server), "MicroMonolithServer");
+        EXPECT_EQ(request.GetField(MMS::http::FIELD::X_Frame_Options), "DENY");
+        EXPECT_EQ(request.GetField(MMS::http::FIELD::Content_Type), "text/html; charset=utf-8");
+        EXPECT_EQ(request.GetField(MMS::http::FIELD::Cache_Control), "max-age=604800");
+        EXPECT_EQ(request.GetField(MMS::http::FIELD::Content_Length), "1234");
+        EXPECT_EQ(decoder_table.size(), encoder_table.size());
+    }
+    // Status is static index, cached fields are one octet each once indexed
+    EXPECT_LT(sizes[1], sizes[0]);
+    EXPECT_EQ(sizes[1], sizes[2]);
+    EXPECT_GT(sizes[4], sizes[1]);
+    // Per response field is not indexed
+    EXPECT_EQ(encoder_table.find(fields[2]), MMS::http::hpack::dynamic_table_t::npos);
+}
+
+TEST(HTTP2Test, HeaderFrameEndStream) {
+    const std::vector<std::pair<MMS::http::FIELD, std::string>> fields { {MMS::http::FIELD::Allow, "GET, HEAD"} };
+    MMS::http::hpack::dynamic_table_t encoder_table { };
+    MMS::FullStreamAutoAlloc buffer { 64 };
+    // Response without body ends stream with its HEADERS
+    v2::CreateHeaderFrame(encoder_table, buffer, 1, MMS::http::CODE::No_Content, fields, { }, nullptr, true);
+    auto pframe = reinterpret_cast<const v2::frame *>(buffer.begin());
+    EXPECT_EQ(pframe->get_type(), v2::frame::type_t::HEADERS);
+    EXPECT_EQ(static_cast<uint8_t>(pframe->get_flags()), static_cast<uint8_t>(v2::frame::flags_t::END_HEADERS) | static_cast<uint8_t>(v2::frame::flags_t::END_STREAM));
+
+    // Body follows in DATA
+    buffer.Reset();
+    v2::CreateHeaderFrame(encoder_table, buffer, 3, MMS::http::CODE::OK, fields);
+    pframe = reinterpret_cast<const v2::frame *>(buffer.begin());
+    EXPECT_EQ(pframe->get_flags(), v2::frame::flags_t::END_HEADERS);
+}
+
+TEST(HTTP2Test, WindowUpdate) {
+    MMS::FullStreamAutoAlloc input { 128 };
+    // Streams are opened by HEADERS before their WINDOW_UPDATE
+    const std::string block { "\x82\x86\x84\x41\x0fwww.example.com" };
+    for (const uint32_t stream_identifier: { 3u, 5u }) {
+        v2::frame header { static_cast<uint32_t>(block.size()), v2::frame::type_t::HEADERS, v2::frame::flags_t::END_HEADERS, stream_identifier };
+        header.set_flag(v2::frame::flags_t::END_STREAM);
+        input.Copy(reinterpret_cast<const uint8_t *>(&header), sizeof(header));
+        input.Copy(reinterpret_cast<const uint8_t *>(block.data()), block.size());
+    }
+    v2::CreateWindowUpdateFrame(input, 0, 1000);
+    v2::CreateWindowUpdateFrame(input, 3, v2::constant::MAX_WINDOW_SIZE);
+    // Zero increment on stream is stream error
+    v2::CreateWindowUpdateFrame(input, 5, 0);
+
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    v2::request request { table, settings };
+    std::vector<std::pair<uint32_t, uint32_t>> updates { };
+    request.window_update_handler = [&updates](const uint32_t stream_id, const uint32_t increment) { updates.emplace_back(stream_id, increment); };
+    MMS::FullStreamAutoAlloc output { 64 };
+    EXPECT_EQ(request.parse(MMS::make_const_stream(input.begin(), input.index()), output), MMS::err_t::SUCCESS);
+    const std::vector<std::pair<uint32_t, uint32_t>> expected { {0, 1000}, {3, v2::constant::MAX_WINDOW_SIZE} };
+    EXPECT_EQ(updates, expected);
+
+    MMS::FullStreamAutoAlloc reset { 16 };
+    v2::CreateResetFrame(reset, 5, v2::frame::error_t::PROTOCOL_ERROR);
+    ASSERT_EQ(output.index(), reset.index());
+    EXPECT_TRUE(std::equal(output.begin(), output.curr(), reset.begin()));
+
+    // Zero increment on connection is connection error
+    input.Reset();
+    v2::CreateWindowUpdateFrame(input, 0, 0);
+    output.Reset();
+    EXPECT_EQ(request.parse(MMS::make_const_stream(input.begin(), input.index()), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+    EXPECT_EQ(reinterpret_cast<const v2::frame *>(output.begin())->get_type(), v2::frame::type_t::GOAWAY);
+
+    // WINDOW_UPDATE and DATA on idle stream are connection error
+    input.Reset();
+    v2::CreateWindowUpdateFrame(input, 7, 1000);
+    output.Reset();
+    EXPECT_EQ(request.parse(MMS::make_const_stream(input.begin(), input.index()), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+    EXPECT_EQ(reinterpret_cast<const v2::frame *>(output.begin())->get_type(), v2::frame::type_t::GOAWAY);
+    input.Reset();
+    v2::CreateDataFrame(input, 16384, MMS::make_const_stream(std::string_view { "body" }), 7, true);
+    output.Reset();
+    EXPECT_EQ(request.parse(MMS::make_const_stream(input.begin(), input.index()), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+    EXPECT_EQ(updates, expected);
+}
+
+TEST(HTTP2Test, ResetStreamLength) {
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    v2::request request { table, settings };
+
+    // RST_STREAM payload other than 4 bytes is connection error
+    for (const uint32_t length: { 3u, 5u }) {
+        MMS::FullStreamAutoAlloc input { 64 };
+        const v2::frame header { length, v2::frame::type_t::RST_STREAM, v2::frame::flags_t::NONE, 1 };
+        input.Copy(reinterpret_cast<const uint8_t *>(&header), sizeof(header));
+        const uint8_t payload[5] { };
+        input.Copy(payload, length);
+
+        MMS::FullStreamAutoAlloc output { 64 };
+        EXPECT_EQ(request.parse(MMS::make_const_stream(input.begin(), input.index()), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+        EXPECT_EQ(reinterpret_cast<const v2::frame *>(output.begin())->get_type(), v2::frame::type_t::GOAWAY);
+        const auto goaway = reinterpret_cast<const v2::goaway *>(output.begin() + sizeof(v2::frame));
+        EXPECT_EQ(goaway->get_error_code(), v2::frame::error_t::FRAME_SIZE_ERROR);
+    }
+}
+
+TEST(HTTP2Test, Ping) {
+    MMS::FullStreamAutoAlloc input { 64 };
+    v2::CreatePingFrame(input, 0x0102030405060708ULL);
+    v2::CreatePingFrame(input, v2::window_estimator_t::ping_data, true);
+
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    v2::request request { table, settings };
+    std::vector<uint64_t> acks { };
+    request.ping_ack_handler = [&acks](const uint64_t opaque_data) { acks.push_back(opaque_data); };
+    MMS::FullStreamAutoAlloc output { 64 };
+    EXPECT_EQ(request.parse(MMS::make_const_stream(input.begin(), input.index()), output), MMS::err_t::SUCCESS);
+    EXPECT_EQ(acks, std::vector<uint64_t> { v2::window_estimator_t::ping_data });
+
+    // Only PING without ACK is answered
+    MMS::FullStreamAutoAlloc expected { 32 };
+    v2::CreatePingFrame(expected, 0x0102030405060708ULL, true);
+    ASSERT_EQ(output.index(), expected.index());
+    EXPECT_TRUE(std::equal(output.begin(), output.curr(), expected.begin()));
+}
+
+TEST(HTTP2Test, WindowEstimator) {
+    using namespace std::chrono_literals;
+    v2::window_estimator_t estimator { 65535, 16384, 1048576 };
+    const auto start = v2::window_estimator_t::clock::now();
+
+    // Peer sends whole window in a round trip
+    EXPECT_TRUE(estimator.Received(16384));
+    estimator.PingSent(start);
+    EXPECT_FALSE(estimator.Received(60000));
+    EXPECT_FALSE(estimator.PingAck(v2::window_estimator_t::ping_data + 1, start + 10ms));
+    EXPECT_TRUE(estimator.PingAck(v2::window_estimator_t::ping_data, start + 10ms));
+    EXPECT_EQ(estimator.GetWindow(), 120000);
+    EXPECT_EQ(estimator.GetBDP(), 60000);
+    EXPECT_EQ(estimator.GetRTT(), 10ms);
+
+    // Growth is limited to maximum
+    for(int index { 0 }; index < 8; ++index) {
+        EXPECT_TRUE(estimator.Received(16384));
+        estimator.PingSent(start);
+        estimator.Received(estimator.GetWindow());
+        estimator.PingAck(v2::window_estimator_t::ping_data, start + 2ms);
+    }
+    EXPECT_EQ(estimator.GetWindow(), 1048576);
+    EXPECT_EQ(estimator.GetMinRTT(), 2ms);
+
+    // Window is halved once peer used less than quarter of it for some round trips
+    for(uint32_t index { 0 }; index < v2::window_estimator_t::shrink_samples; ++index) {
+        EXPECT_TRUE(estimator.Received(1000));
+        estimator.PingSent(start);
+        estimator.Received(1000);
+        EXPECT_EQ(estimator.PingAck(v2::window_estimator_t::ping_data, start + 2ms), index + 1 == v2::window_estimator_t::shrink_samples);
+    }
+    EXPECT_EQ(estimator.GetWindow(), 524288);
+
+    // Fixed window is not tuned
+    v2::window_estimator_t fixed { 65535, 65535, 65535 };
+    EXPECT_FALSE(fixed.Received(16384));
+}
+
+TEST(HTTP2Test, Priority) {
+    EXPECT_EQ(v2::parse_priority(""), v2::priority_t { });
+    EXPECT_EQ(v2::parse_priority("u=0"), (v2::priority_t { 0, false }));
+    EXPECT_EQ(v2::parse_priority("u=5, i"), (v2::priority_t { 5, true }));
+    EXPECT_EQ(v2::parse_priority("i=?1,u=1;x=2"), (v2::priority_t { 1, true }));
+    EXPECT_EQ(v2::parse_priority("i, i=?0"), (v2::priority_t { 3, false }));
+    // Invalid values are ignored
+    EXPECT_EQ(v2::parse_priority("u=8, i=1, x=\"u\""), v2::priority_t { });
+
+    // PRIORITY_UPDATE for stream 5, it is allowed only on stream 0
+    const std::string value { "u=1, i" };
+    std::string update(sizeof(v2::frame), '\0');
+    reinterpret_cast<v2::frame *>(update.data())->init_frame(static_cast<uint32_t>(sizeof(uint32_t) + value.size()), v2::frame::type_t::PRIORITY_UPDATE, v2::frame::flags_t::NONE, 0);
+    update += std::string { "\x00\x00\x00\x05", 4 } + value;
+
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    v2::request request { table, settings };
+    uint32_t prioritized_stream { 0 };
+    v2::priority_t priority { };
+    request.priority_update_handler = [&](const uint32_t stream_id, const std::string_view field) {
+        prioritized_stream = stream_id;
+        priority = v2::parse_priority(field);
+    };
+    MMS::FullStreamAutoAlloc output { 64 };
+    EXPECT_EQ(request.parse(MMS::make_const_stream(update), output), MMS::err_t::SUCCESS);
+    EXPECT_EQ(prioritized_stream, 5);
+    EXPECT_EQ(priority, (v2::priority_t { 1, true }));
+
+    reinterpret_cast<v2::frame *>(update.data())->init_frame(static_cast<uint32_t>(sizeof(uint32_t) + value.size()), v2::frame::type_t::PRIORITY_UPDATE, v2::frame::flags_t::NONE, 3);
+    EXPECT_EQ(request.parse(MMS::make_const_stream(update), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+}
+
+// Frame header followed by payload
+static std::string MakeFrame(const v2::frame::type_t type, const v2::frame::flags_t flags, const uint32_t stream_identifier, const std::string_view payload) {
+    std::string frame_str(sizeof(v2::frame), '\0');
+    reinterpret_cast<v2::frame *>(frame_str.data())->init_frame(static_cast<uint32_t>(payload.size()), type, flags, stream_identifier);
+    return frame_str + std::string { payload };
+}
+
+TEST(HTTP2Test, Continuation) {
+    // https://www.rfc-editor.org/rfc/rfc7541.html#appendix-C.3.1 block is split inside authority literal
+    const std::string block { "\x82\x86\x84\x41\x0fwww.example.com" };
+    std::string frames { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_STREAM, 1, block.substr(0, 6)) };
+    frames += MakeFrame(v2::frame::type_t::CONTINUATION, v2::frame::flags_t::NONE, 1, block.substr(6, 5));
+    const auto last = MakeFrame(v2::frame::type_t::CONTINUATION, v2::frame::flags_t::END_HEADERS, 1, block.substr(11));
+
+    // Header block is not returned till it is complete
+    const auto begin = reinterpret_cast<const uint8_t *>(frames.data());
+    EXPECT_EQ(v2::GetFramesEnd(begin, begin + frames.size()), begin);
+    frames += last;
+    const auto complete_begin = reinterpret_cast<const uint8_t *>(frames.data());
+    EXPECT_EQ(v2::GetFramesEnd(complete_begin, complete_begin + frames.size()), complete_begin + frames.size());
+
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    MMS::FullStreamAutoAlloc output { 64 };
+    {
+        v2::request request { table, settings };
+        EXPECT_EQ(request.parse(MMS::make_const_stream(frames), output), MMS::err_t::SUCCESS);
+        auto header = request.get_first_header();
+        ASSERT_NE(header, nullptr);
+        EXPECT_EQ(header->GetField(MMS::http::FIELD::Authority), "www.example.com");
+        EXPECT_EQ(header->GetPath(), "/");
+        EXPECT_TRUE(header->end_stream);
+    }
+
+    // Other frame inside header block is connection error
+    std::string interleaved { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::NONE, 3, block.substr(0, 6)) };
+    interleaved += MakeFrame(v2::frame::type_t::DATA, v2::frame::flags_t::NONE, 3, "x");
+    const auto interleaved_begin = reinterpret_cast<const uint8_t *>(interleaved.data());
+    EXPECT_EQ(v2::GetFramesEnd(interleaved_begin, interleaved_begin + interleaved.size()), interleaved_begin + interleaved.size());
+    v2::request request { table, settings };
+    EXPECT_EQ(request.parse(MMS::make_const_stream(interleaved), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+}
+
+TEST(HTTP2Test, PaddedFrames) {
+    // Pad length octet, payload and padding
+    const std::string block { "\x82\x86\x84\x41\x0fwww.example.com" };
+    std::string frames { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_HEADERS, 1, std::string { "\x03" } + block + std::string(3, '\0')) };
+    std::string data_frame { MakeFrame(v2::frame::type_t::DATA, v2::frame::flags_t::END_STREAM, 1, std::string { "\x02" } + "body" + std::string(2, '\0')) };
+    reinterpret_cast<v2::frame *>(frames.data())->set_flag(v2::frame::flags_t::PADDED);
+    reinterpret_cast<v2::frame *>(data_frame.data())->set_flag(v2::frame::flags_t::PADDED);
+    frames += data_frame;
+
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    v2::request request { table, settings };
+    MMS::FullStreamAutoAlloc output { 64 };
+    EXPECT_EQ(request.parse(MMS::make_const_stream(frames), output), MMS::err_t::SUCCESS);
+    auto header = request.get_first_header();
+    ASSERT_NE(header, nullptr);
+    EXPECT_EQ(header->GetField(MMS::http::FIELD::Authority), "www.example.com");
+    EXPECT_EQ(header->GetBody(), "body");
+    EXPECT_TRUE(header->end_stream);
+
+    // Padding larger than frame
+    const auto bad = MakeFrame(v2::frame::type_t::DATA, v2::frame::flags_t::PADDED, 3, "\x05" "ab");
+    EXPECT_EQ(request.parse(MMS::make_const_stream(bad), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+}
+
+TEST(HTTP2Test, SplitFrame) {
+    const std::string block { "\x82\x86\x84\x41\x0fwww.example.com" };
+    std::string frames { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_HEADERS, 1, block) };
+    // Authority is indexed from dynamic table
+    frames += MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_HEADERS, 3, "\x82\x86\x84\xbe");
+    const auto first_size = sizeof(v2::frame) + block.size();
+    reinterpret_cast<v2::frame *>(frames.data() + first_size)->set_flag(v2::frame::flags_t::END_STREAM);
+    // Second frame is cut in payload
+    const std::string_view partial { frames.data(), first_size + sizeof(v2::frame) + 2 };
+
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    v2::request request { table, settings };
+    MMS::FullStreamAutoAlloc output { 64 };
+    const auto stream = MMS::make_const_stream(partial);
+    EXPECT_EQ(request.parse(stream, output), MMS::err_t::SUCCESS);
+    EXPECT_EQ(stream.curr(), reinterpret_cast<const uint8_t *>(frames.data()) + first_size);
+    auto header = request.get_first_header();
+    ASSERT_NE(header, nullptr);
+    EXPECT_EQ(header->stream_identifier, 1);
+    EXPECT_EQ(header->get_next(), nullptr);
+
+    // Rest is parsed once read, pooled request is reused for new stream
+    const auto rest = MMS::make_const_stream(std::string_view { frames.data() + first_size, frames.size() - first_size });
+    EXPECT_EQ(request.parse(rest, output), MMS::err_t::SUCCESS);
+    EXPECT_TRUE(rest.full());
+    ASSERT_EQ(request.get_first_header(), header);
+    EXPECT_EQ(header->stream_identifier, 3);
+    EXPECT_EQ(header->GetField(MMS::http::FIELD::Authority), "www.example.com");
+    EXPECT_TRUE(header->end_stream);
+    EXPECT_EQ(header->get_next(), nullptr);
+}
+
+TEST(HTTP2Test, StreamTable) {
+    v2::stream_table_t<v2::header_request> streams { };
+    const auto initial_capacity = streams.capacity();
+    for(uint32_t stream_identifier { 1 }; stream_identifier < 200; stream_identifier += 2) {
+        EXPECT_EQ(streams.insert(stream_identifier)->stream_identifier, stream_identifier);
+    }
+    EXPECT_EQ(streams.size(), 100);
+    EXPECT_GE(streams.capacity(), 200);
+    for(uint32_t stream_identifier { 1 }; stream_identifier < 200; stream_identifier += 2) {
+        auto request = streams.find(stream_identifier);
+        ASSERT_NE(request, nullptr);
+        EXPECT_EQ(request->stream_identifier, stream_identifier);
+        EXPECT_EQ(streams.find(stream_identifier + 1), nullptr);
+    }
+    EXPECT_EQ(streams.find(0), nullptr);
+
+    streams.clear();
+    EXPECT_EQ(streams.size(), 0);
+    EXPECT_EQ(streams.capacity(), initial_capacity);
+    EXPECT_EQ(streams.find(1), nullptr);
+    // Colliding identifiers are probed
+    const auto request = streams.insert(1);
+    EXPECT_EQ(streams.insert(1 + 2 * static_cast<uint32_t>(initial_capacity))->stream_identifier, 1 + 2 * initial_capacity);
+    EXPECT_EQ(streams.find(1), request);
+
+    // Erase shifts colliding record back, erased record is reused
+    const auto colliding = streams.insert(1 + 4 * static_cast<uint32_t>(initial_capacity));
+    streams.erase(1);
+    EXPECT_EQ(streams.size(), 2);
+    EXPECT_EQ(streams.find(1), nullptr);
+    EXPECT_EQ(streams.find(1 + 4 * static_cast<uint32_t>(initial_capacity)), colliding);
+    EXPECT_EQ(streams.find(1 + 2 * static_cast<uint32_t>(initial_capacity))->stream_identifier, 1 + 2 * initial_capacity);
+    EXPECT_EQ(streams.insert(3), request);
+    EXPECT_EQ(request->stream_identifier, 3);
+    size_t visited { 0 };
+    streams.for_each([&visited](v2::header_request &) { ++visited; });
+    EXPECT_EQ(visited, 3);
+}
+
+TEST(HTTP2Test, Trailers) {
+    const std::string block { "\x82\x86\x84\x41\x0fwww.example.com" };
+    // Trailer field is added to decoder table
+    const std::string trailer_block { "\x40\x07x-check\x02ok" };
+    std::string frames { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_HEADERS, 1, block) };
+    frames += MakeFrame(v2::frame::type_t::DATA, v2::frame::flags_t::NONE, 1, "body");
+    std::string trailer { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_STREAM, 1, trailer_block) };
+    reinterpret_cast<v2::frame *>(trailer.data())->set_flag(v2::frame::flags_t::END_HEADERS);
+    frames += trailer;
+    // Authority is second entry of decoder table once trailer is decoded
+    std::string next { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_STREAM, 3, "\x82\x86\x84\xbf") };
+    reinterpret_cast<v2::frame *>(next.data())->set_flag(v2::frame::flags_t::END_HEADERS);
+    frames += next;
+
+    MMS::http::hpack::dynamic_table_t table { 4096, false };
+    v2::settings_store settings { };
+    v2::request request { table, settings };
+    MMS::FullStreamAutoAlloc output { 64 };
+    EXPECT_EQ(request.parse(MMS::make_const_stream(frames), output), MMS::err_t::SUCCESS);
+    auto header = request.get_first_header();
+    ASSERT_NE(header, nullptr);
+    EXPECT_EQ(header->stream_identifier, 1);
+    EXPECT_EQ(header->GetPath(), "/");
+    EXPECT_EQ(header->GetBody(), "body");
+    EXPECT_TRUE(header->end_stream);
+    header = header->get_next();
+    ASSERT_NE(header, nullptr);
+    EXPECT_EQ(header->stream_identifier, 3);
+    EXPECT_EQ(header->GetField(MMS::http::FIELD::Authority), "www.example.com");
+    EXPECT_EQ(header->get_next(), nullptr);
+
+    // Trailers of stream opened in earlier read end its body through data handler
+    uint32_t ended { 0 };
+    request.stream_open_handler = [](uint32_t stream_identifier) { return stream_identifier == 5; };
+    request.data_handler = [&ended](uint32_t stream_identifier, const MMS::Stream &payload, bool end_stream) {
+        EXPECT_EQ(payload.remaining_buffer(), 0);
+        EXPECT_TRUE(end_stream);
+        ended = stream_identifier;
+    };
+    std::string later { MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_STREAM, 5, trailer_block) };
+    reinterpret_cast<v2::frame *>(later.data())->set_flag(v2::frame::flags_t::END_HEADERS);
+    EXPECT_EQ(request.parse(MMS::make_const_stream(later), output), MMS::err_t::SUCCESS);
+    EXPECT_EQ(ended, 5);
+    EXPECT_EQ(request.get_first_header(), nullptr);
+
+    // Trailers must end stream
+    const auto open_ended = MakeFrame(v2::frame::type_t::HEADERS, v2::frame::flags_t::END_HEADERS, 5, trailer_block);
+    EXPECT_EQ(request.parse(MMS::make_const_stream(open_ended), output), MMS::err_t::HTTP2_INITIATE_GOAWAY);
+}
@@ -0,0 +1,438 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <http/http3.h>
+#include <ctime>
+
+namespace MMS::http::v3 {
+
+using MMS::net::quic::DecodeUnsignedInteger;
+using MMS::net::quic::EncodeUnsignedInteger;
+
+error_t to_error(const err_t err) {
+    switch(err) {
+    case err_t::HTTP3_FRAME_ERROR: return error_t::H3_FRAME_ERROR;
+    case err_t::HTTP3_FRAME_UNEXPECTED: return error_t::H3_FRAME_UNEXPECTED;
+    case err_t::HTTP3_MISSING_SETTINGS: return error_t::H3_MISSING_SETTINGS;
+    case err_t::HTTP3_SETTINGS_ERROR: return error_t::H3_SETTINGS_ERROR;
+    case err_t::HTTP3_STREAM_CREATION_ERROR: return error_t::H3_STREAM_CREATION_ERROR;
+    case err_t::HTTP3_CLOSED_CRITICAL_STREAM: return error_t::H3_CLOSED_CRITICAL_STREAM;
+    case err_t::QPACK_DECOMPRESSION_FAILED: return error_t::QPACK_DECOMPRESSION_FAILED;
+    case err_t::QPACK_ENCODER_STREAM_ERROR: return error_t::QPACK_ENCODER_STREAM_ERROR;
+    case err_t::QPACK_DECODER_STREAM_ERROR: return error_t::QPACK_DECODER_STREAM_ERROR;
+    default: return error_t::H3_GENERAL_PROTOCOL_ERROR;
+    }
+}
+
+bool ParseFrame(const Stream &stream, frame_t &frame) {
+    auto peek = make_const_stream(stream.curr(), stream.remaining_buffer());
+    if (!HasInteger(peek)) return false;
+    const uint64_t type = DecodeUnsignedInteger(peek);
+    if (!HasInteger(peek)) return false;
+    const uint64_t length = DecodeUnsignedInteger(peek);
+    if (peek.remaining_buffer() < length) return false;
+
+    frame = { static_cast<frame_type_t>(type), length, peek.curr() };
+    stream += peek.GetSizeFrom(stream.curr()) + length;
+    return true;
+}
+
+void AddFrameHeader(Stream &stream, const frame_type_t type, const uint64_t length) {
+    EncodeUnsignedInteger(static_cast<uint64_t>(type), stream);
+    EncodeUnsignedInteger(length, stream);
+}
+
+void AddDataFrame(Stream &stream, const Stream &body) {
+    AddFrameHeader(stream, frame_type_t::DATA, body.remaining_buffer());
+    stream.Copy(body);
+}
+
+void AddHeadersFrame(Stream &stream, const Stream &field_section) {
+    AddFrameHeader(stream, frame_type_t::HEADERS, field_section.remaining_buffer());
+    stream.Copy(field_section);
+}
+
+void AddGoawayFrame(Stream &stream, const uint64_t id) {
+    uint8_t payload[8];
+    Stream payloadstream { payload, sizeof(payload) };
+    EncodeUnsignedInteger(id, payloadstream);
+    AddFrameHeader(stream, frame_type_t::GOAWAY, payloadstream.GetSizeFrom(payload));
+    stream.Copy(payload, payloadstream.GetSizeFrom(payload));
+}
+
+void settings_store::parse(const Stream &payload) {
+    while(!payload.full()) {
+        if (!HasInteger(payload)) throw HTTP3Exception { err_t::HTTP3_FRAME_ERROR };
+        const uint64_t identifier = DecodeUnsignedInteger(payload);
+        if (!HasInteger(payload)) throw HTTP3Exception { err_t::HTTP3_FRAME_ERROR };
+        const uint64_t value = DecodeUnsignedInteger(payload);
+
+        switch(static_cast<identifier_t>(identifier)) {
+        case identifier_t::SETTINGS_QPACK_MAX_TABLE_CAPACITY:
+            SETTINGS_QPACK_MAX_TABLE_CAPACITY = value;
+            break;
+        case identifier_t::SETTINGS_MAX_FIELD_SECTION_SIZE:
+            SETTINGS_MAX_FIELD_SECTION_SIZE = value;
+            break;
+        case identifier_t::SETTINGS_QPACK_BLOCKED_STREAMS:
+            SETTINGS_QPACK_BLOCKED_STREAMS = value;
+            break;
+        default:
+            // https://www.rfc-editor.org/rfc/rfc9114.html#name-http-2-settings-parameters
+            if (identifier >= 0x02 && identifier <= 0x05) throw HTTP3Exception { err_t::HTTP3_SETTINGS_ERROR };
+            break;
+        }
+    }
+}
+
+void settings_store::add_frame(Stream &stream) const {
+    // Three settings with 8 byte identifier and value
+    uint8_t payload[48];
+    Stream payloadstream { payload, sizeof(payload) };
+    EncodeUnsignedInteger(static_cast<uint64_t>(identifier_t::SETTINGS_QPACK_MAX_TABLE_CAPACITY), payloadstream);
+    EncodeUnsignedInteger(SETTINGS_QPACK_MAX_TABLE_CAPACITY, payloadstream);
+    EncodeUnsignedInteger(static_cast<uint64_t>(identifier_t::SETTINGS_QPACK_BLOCKED_STREAMS), payloadstream);
+    EncodeUnsignedInteger(SETTINGS_QPACK_BLOCKED_STREAMS, payloadstream);
+    if (SETTINGS_MAX_FIELD_SECTION_SIZE < (1ULL << 62)) {
+        EncodeUnsignedInteger(static_cast<uint64_t>(identifier_t::SETTINGS_MAX_FIELD_SECTION_SIZE), payloadstream);
+        EncodeUnsignedInteger(SETTINGS_MAX_FIELD_SECTION_SIZE, payloadstream);
+    }
+    AddFrameHeader(stream, frame_type_t::SETTINGS, payloadstream.GetSizeFrom(payload));
+    stream.Copy(payload, payloadstream.GetSizeFrom(payload));
+}
+
+session_t::session_t(transport_t &transport, const settings_store &local_settings, const size_t max_request_size)
+    : transport { transport }, local_settings { local_settings }, max_request_size { max_request_size },
+      decoder { local_settings.SETTINGS_QPACK_MAX_TABLE_CAPACITY, local_settings.SETTINGS_QPACK_BLOCKED_STREAMS },
+      encoder { std::make_unique<qpack::encoder_t>(0, 0) } { }
+
+void session_t::Start() {
+    auto open_stream = [&](const stream_type_t type) {
+        auto stream = transport.OpenUniStream();
+        frame_buffer.Reset();
+        EncodeUnsignedInteger(static_cast<uint64_t>(type), frame_buffer);
+        if (type == stream_type_t::CONTROL) local_settings.add_frame(frame_buffer);
+        stream->Write(make_const_stream(frame_buffer.begin(), frame_buffer.index()));
+        return stream;
+    };
+
+    control_stream = open_stream(stream_type_t::CONTROL);
+    encoder_stream = open_stream(stream_type_t::QPACK_ENCODER);
+    decoder_stream = open_stream(stream_type_t::QPACK_DECODER);
+}
+
+void session_t::ProcessStream(stream_t &stream, const Stream &data, const bool fin) {
+    try {
+        if (IsBidirectional(stream.GetID())) {
+            ProcessRequestStream(stream, data, fin);
+        } else {
+            ProcessUniStream(stream, data, fin);
+        }
+    } catch(const HTTPException &error) {
+        transport.Close(to_error(error));
+    }
+}
+
+void session_t::ProcessUniStream(stream_t &stream, const Stream &data, const bool fin) {
+    auto &uni_stream = uni_streams[stream.GetID()];
+    uni_stream.buffer.append(reinterpret_cast<const char *>(data.curr()), data.remaining_buffer());
+    data += data.remaining_buffer();
+
+    if (!uni_stream.type_received) {
+        auto input = make_const_stream(uni_stream.buffer);
+        if (!HasInteger(input)) return;
+        uni_stream.type = static_cast<stream_type_t>(DecodeUnsignedInteger(input));
+        uni_stream.type_received = true;
+        uni_stream.buffer.erase(0, input.GetSizeFrom(uni_stream.buffer.data()));
+
+        switch(uni_stream.type) {
+        case stream_type_t::CONTROL:
+        case stream_type_t::QPACK_ENCODER:
+        case stream_type_t::QPACK_DECODER: {
+            // https://www.rfc-editor.org/rfc/rfc9114.html#name-unidirectional-streams
+            // Only one of each critical stream is allowed
+            const auto type = uni_stream.type;
+            const auto count = std::ranges::count_if(uni_streams, [type](const auto &entry) { return entry.second.type_received && entry.second.type == type; });
+            if (count > 1) throw HTTP3Exception { err_t::HTTP3_STREAM_CREATION_ERROR };
+            break;
+        }
+
+        case stream_type_t::PUSH:
+            // Only server can push
+            throw HTTP3Exception { err_t::HTTP3_STREAM_CREATION_ERROR };
+
+        default:
+            break;
+        }
+    }
+
+    switch(uni_stream.type) {
+    case stream_type_t::CONTROL:
+        ProcessControlFrames(uni_stream);
+        if (fin) throw HTTP3Exception { err_t::HTTP3_CLOSED_CRITICAL_STREAM };
+        break;
+
+    case stream_type_t::QPACK_ENCODER:
+        qpack_buffer.Reset();
+        decoder.ProcessEncoderInstructions(make_const_stream(uni_stream.buffer), qpack_buffer);
+        uni_stream.buffer.clear();
+        FlushDecoderStream();
+        if (fin) throw HTTP3Exception { err_t::HTTP3_CLOSED_CRITICAL_STREAM };
+        DispatchReady();
+        break;
+
+    case stream_type_t::QPACK_DECODER:
+        encoder->ProcessDecoderInstructions(make_const_stream(uni_stream.buffer));
+        uni_stream.buffer.clear();
+        if (fin) throw HTTP3Exception { err_t::HTTP3_CLOSED_CRITICAL_STREAM };
+        break;
+
+    default:
+        // Unknown stream type must be ignored
+        uni_stream.buffer.clear();
+        break;
+    }
+}
+
+void session_t::ProcessControlFrames(uni_stream_t &uni_stream) {
+    auto input = make_const_stream(uni_stream.buffer);
+    frame_t frame;
+    while(ParseFrame(input, frame)) {
+        auto payload = make_const_stream(frame.payload, frame.length);
+        if (!uni_stream.settings_received) {
+            // https://www.rfc-editor.org/rfc/rfc9114.html#name-control-streams
+            if (frame.type != frame_type_t::SETTINGS) throw HTTP3Exception { err_t::HTTP3_MISSING_SETTINGS };
+            peer_settings.parse(payload);
+            uni_stream.settings_received = true;
+            // No field section has used dynamic table yet, hence encoder can be replaced
+            encoder = std::make_unique<qpack::encoder_t>(peer_settings.SETTINGS_QPACK_MAX_TABLE_CAPACITY, peer_settings.SETTINGS_QPACK_BLOCKED_STREAMS);
+            continue;
+        }
+
+        switch(frame.type) {
+        case frame_type_t::SETTINGS:
+        case frame_type_t::DATA:
+        case frame_type_t::HEADERS:
+        case frame_type_t::PUSH_PROMISE:
+            throw HTTP3Exception { err_t::HTTP3_FRAME_UNEXPECTED };
+
+        default:
+            // GOAWAY from client refers push ID, server does not push
+            break;
+        }
+    }
+    uni_stream.buffer.erase(0, input.GetSizeFrom(uni_stream.buffer.data()));
+}
+
+void session_t::ProcessRequestStream(stream_t &stream, const Stream &data, const bool fin) {
+    const uint64_t stream_id = stream.GetID();
+    if (!IsClientInitiated(stream_id)) throw HTTP3Exception { err_t::HTTP3_STREAM_CREATION_ERROR };
+
+    auto itr = request_streams.find(stream_id);
+    if (itr == request_streams.end()) {
+        if (goaway_sent && stream_id >= next_request_id) {
+            // https://www.rfc-editor.org/rfc/rfc9114.html#name-connection-shutdown
+            stream.Reset(error_t::H3_REQUEST_REJECTED);
+            return;
+        }
+        itr = request_streams.try_emplace(stream_id, stream).first;
+        next_request_id = std::max(next_request_id, stream_id + 4);
+    }
+
+    auto &request_stream = itr->second;
+    request_stream.fin |= fin;
+    if (request_stream.rejected) {
+        // Stream is already reset, remaining data is discarded
+        data += data.remaining_buffer();
+        if (request_stream.fin) request_streams.erase(itr);
+        return;
+    }
+    request_stream.buffer.append(reinterpret_cast<const char *>(data.curr()), data.remaining_buffer());
+    data += data.remaining_buffer();
+
+    ProcessRequestFrames(request_stream);
+    // Incomplete frame left in buffer
+    if (request_stream.buffer.size() > max_request_size) RejectRequest(request_stream);
+    DispatchReady();
+}
+
+void session_t::ProcessRequestFrames(request_stream_t &request_stream) {
+    const uint64_t stream_id = request_stream.stream.GetID();
+    auto input = make_const_stream(request_stream.buffer);
+    frame_t frame;
+    while(ParseFrame(input, frame)) {
+        auto payload = make_const_stream(frame.payload, frame.length);
+        switch(frame.type) {
+        case frame_type_t::HEADERS: {
+            qpack_buffer.Reset();
+            if (!request_stream.headers_received) {
+                request_stream.headers_received = true;
+                const auto max_size = local_settings.SETTINGS_MAX_FIELD_SECTION_SIZE;
+                auto status = decoder.DecodeFieldSection(stream_id, payload, qpack_buffer, [&request_stream, max_size](const auto &field) {
+                    // https://www.rfc-editor.org/rfc/rfc9114.html#name-header-size-constraints
+                    request_stream.field_section_size += to_string_view(field.first).size() + field.second.size() + 32;
+                    if (request_stream.field_section_size <= max_size) request_stream.req.add_field(field);
+                });
+                request_stream.headers_blocked = status == qpack::decoder_t::status_t::Blocked;
+            } else {
+                // Trailer section is decoded only to keep QPACK state
+                decoder.DecodeFieldSection(stream_id, payload, qpack_buffer, [](const auto &) { });
+            }
+            FlushDecoderStream();
+            if (request_stream.field_section_size > local_settings.SETTINGS_MAX_FIELD_SECTION_SIZE) {
+                RejectRequest(request_stream);
+                return;
+            }
+            break;
+        }
+
+        case frame_type_t::DATA:
+            if (!request_stream.headers_received) throw HTTP3Exception { err_t::HTTP3_FRAME_UNEXPECTED };
+            if (request_stream.req.GetBody().size() + frame.length > max_request_size) {
+                RejectRequest(request_stream);
+                return;
+            }
+            request_stream.req.append_body(frame.payload, frame.length);
+            break;
+
+        case frame_type_t::SETTINGS:
+        case frame_type_t::GOAWAY:
+        case frame_type_t::CANCEL_PUSH:
+        case frame_type_t::MAX_PUSH_ID:
+        case frame_type_t::PUSH_PROMISE:
+            throw HTTP3Exception { err_t::HTTP3_FRAME_UNEXPECTED };
+
+        default:
+            // Unknown frame type must be ignored
+            break;
+        }
+    }
+    request_stream.buffer.erase(0, input.GetSizeFrom(request_stream.buffer.data()));
+}
+
+void session_t::DispatchReady() {
+    for(auto itr = request_streams.begin(); itr != request_streams.end(); ) {
+        auto &request_stream = itr->second;
+        if (request_stream.headers_blocked) {
+            request_stream.headers_blocked = decoder.IsBlocked(itr->first);
+            // Blocked section is decoded by encoder instructions
+            if (!request_stream.headers_blocked && request_stream.field_section_size > local_settings.SETTINGS_MAX_FIELD_SECTION_SIZE) {
+                RejectRequest(request_stream);
+            }
+        }
+
+        if (!request_stream.fin || request_stream.headers_blocked) {
+            ++itr;
+            continue;
+        }
+
+        if (request_stream.rejected) {
+            // Stream is already reset
+        } else if (!request_stream.headers_received || !request_stream.buffer.empty()) {
+            // https://www.rfc-editor.org/rfc/rfc9114.html#name-malformed-requests-and-resp
+            request_stream.stream.Reset(error_t::H3_REQUEST_INCOMPLETE);
+        } else {
+            ProcessRequest(request_stream.stream, request_stream.req);
+        }
+        itr = request_streams.erase(itr);
+    }
+}
+
+// https://www.rfc-editor.org/rfc/rfc9114.html#name-request-cancellation-and-re
+void session_t::RejectRequest(request_stream_t &request_stream) {
+    const uint64_t stream_id = request_stream.stream.GetID();
+    request_stream.stream.Reset(error_t::H3_EXCESSIVE_LOAD);
+    request_stream.rejected = true;
+    request_stream.headers_blocked = false;
+    request_stream.buffer = std::string { };
+    qpack_buffer.Reset();
+    decoder.CancelStream(stream_id, qpack_buffer);
+    FlushDecoderStream();
+}
+
+void session_t::FlushDecoderStream() {
+    if (!qpack_buffer.empty() && decoder_stream) {
+        decoder_stream->Write(make_const_stream(qpack_buffer.begin(), qpack_buffer.index()));
+    }
+    qpack_buffer.Reset();
+}
+
+void session_t::ResetStream(const uint64_t stream_id) {
+    if (request_streams.erase(stream_id)) {
+        qpack_buffer.Reset();
+        decoder.CancelStream(stream_id, qpack_buffer);
+        FlushDecoderStream();
+    }
+}
+
+void session_t::Shutdown() {
+    if (goaway_sent) return;
+    frame_buffer.Reset();
+    AddGoawayFrame(frame_buffer, next_request_id);
+    control_stream->Write(make_const_stream(frame_buffer.begin(), frame_buffer.index()));
+    goaway_sent = true;
+}
+
+void session_t::WriteHeaders(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields) {
+    std::vector<std::pair<FIELD, std::string>> header_fields { };
+    header_fields.reserve(fields.size() + 2);
+    header_fields.emplace_back(FIELD::Status, std::to_string(static_cast<uint16_t>(code)));
+    header_fields.emplace_back(FIELD::Date, std::string { GetDate() });
+    header_fields.insert(header_fields.end(), fields.begin(), fields.end());
+
+    field_section.Reset();
+    qpack_buffer.Reset();
+    encoder->Encode(stream.GetID(), header_fields, field_section, qpack_buffer);
+    if (!qpack_buffer.empty()) {
+        encoder_stream->Write(make_const_stream(qpack_buffer.begin(), qpack_buffer.index()));
+        qpack_buffer.Reset();
+    }
+
+    frame_buffer.Reset();
+    AddHeadersFrame(frame_buffer, make_const_stream(field_section.begin(), field_section.index()));
+}
+
+void session_t::WriteResponse(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields, const Stream &bodystream) {
+    WriteHeaders(stream, code, fields);
+    if (!bodystream.full()) AddDataFrame(frame_buffer, bodystream);
+    stream.Write(make_const_stream(frame_buffer.begin(), frame_buffer.index()));
+    stream.Finish();
+}
+
+void session_t::WriteResponse(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields) {
+    WriteHeaders(stream, code, fields);
+    stream.Write(make_const_stream(frame_buffer.begin(), frame_buffer.index()));
+    stream.Finish();
+}
+
+void session_t::WriteResponseBegin(stream_t &stream, const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields) {
+    WriteHeaders(stream, code, fields);
+    stream.Write(make_const_stream(frame_buffer.begin(), frame_buffer.index()));
+}
+
+void session_t::WriteResponseData(stream_t &stream, const Stream &bodystream) {
+    if (bodystream.full()) return;
+    frame_buffer.Reset();
+    AddDataFrame(frame_buffer, bodystream);
+    stream.Write(make_const_stream(frame_buffer.begin(), frame_buffer.index()));
+}
+
+void session_t::WriteResponseEnd(stream_t &stream) {
+    stream.Finish();
+}
+
+} // namespace MMS::http::v3
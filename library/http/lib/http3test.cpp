@@ -0,0 +1,356 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+#include <http/http3.h>
+#include <gtest/gtest.h>
+#include <mms/base/stream.h>
+
+namespace v3 = MMS::http::v3;
+namespace qpack = MMS::http::qpack;
+using MMS::http::CODE;
+using MMS::http::FIELD;
+using MMS::http::METHOD;
+
+using fields_t = std::vector<std::pair<FIELD, std::string>>;
+
+// Server session answering every request with its path as body
+class echo_session_t : public v3::session_t {
+protected:
+    void ProcessRequest(v3::stream_t &stream, v3::request &request) override {
+        ++request_count;
+        last_method = request.GetMethod();
+        last_body = request.GetBody();
+        const fields_t fields { {FIELD::Content_Type, "text/plain"} };
+        if (streaming) {
+            // Path is written in two parts
+            const auto &path = request.GetPath();
+            WriteResponseBegin(stream, CODE::OK, fields);
+            WriteResponseData(stream, MMS::make_const_stream(path.data(), path.size() / 2));
+            WriteResponseData(stream, MMS::make_const_stream(path.data() + path.size() / 2, path.size() - path.size() / 2));
+            WriteResponseEnd(stream);
+        } else {
+            WriteResponse(stream, CODE::OK, fields, MMS::make_const_stream(request.GetPath()));
+        }
+    }
+
+public:
+    bool streaming { false };
+    size_t request_count { 0 };
+    METHOD last_method { };
+    std::string last_body { };
+
+    using v3::session_t::session_t;
+};
+
+// Client end of loopback connection
+struct client_t {
+    v3::loopback_transport_t transport { };
+    echo_session_t session;
+    qpack::encoder_t encoder;
+    qpack::decoder_t decoder { 4096, 16 };
+    MMS::FullStreamAutoAlloc buffer { 256 };
+    MMS::FullStreamAutoAlloc section { 256 };
+    MMS::FullStreamAutoAlloc encoder_stream { 256 };
+
+    client_t(const size_t capacity = 0, const size_t max_request_size = 4096) : session { transport, { 4096, 1024, 16 }, max_request_size }, encoder { capacity, 16 } {
+        session.Start();
+    }
+
+    void Send(const uint64_t stream_id, const std::string &data, const bool fin = false) {
+        session.ProcessStream(*transport.GetStream(stream_id), MMS::make_const_stream(data), fin);
+    }
+
+    // Control stream with SETTINGS, client unidirectional stream ID starts from 2
+    void SendSettings() {
+        buffer.Reset();
+        MMS::net::quic::EncodeUnsignedInteger(static_cast<uint64_t>(v3::stream_type_t::CONTROL), buffer);
+        v3::settings_store { 4096, 1024, 16 }.add_frame(buffer);
+        Send(2, std::string { reinterpret_cast<const char *>(buffer.begin()), buffer.index() });
+    }
+
+    // Returns HEADERS frame, QPACK inserts are left in encoder_stream
+    std::string EncodeRequest(const uint64_t stream_id, const fields_t &fields) {
+        section.Reset();
+        encoder_stream.Reset();
+        encoder.Encode(stream_id, fields, section, encoder_stream);
+        buffer.Reset();
+        v3::AddHeadersFrame(buffer, MMS::make_const_stream(section.begin(), section.index()));
+        return std::string { reinterpret_cast<const char *>(buffer.begin()), buffer.index() };
+    }
+
+    std::string DataFrame(const std::string &body) {
+        buffer.Reset();
+        v3::AddDataFrame(buffer, MMS::make_const_stream(body));
+        return std::string { reinterpret_cast<const char *>(buffer.begin()), buffer.index() };
+    }
+
+    // Decodes response on request stream, server encoder stream is 7
+    fields_t ReadResponse(const uint64_t stream_id, std::string &body) {
+        const auto &server_encoder = transport.GetStream(7)->data;
+        MMS::FullStreamAutoAlloc decoder_stream { 64 };
+        // First byte is stream type
+        decoder.ProcessEncoderInstructions(MMS::make_const_stream(server_encoder.data() + 1, server_encoder.size() - 1), decoder_stream);
+
+        fields_t fields { };
+        auto input = MMS::make_const_stream(transport.GetStream(stream_id)->data);
+        v3::frame_t frame;
+        while(v3::ParseFrame(input, frame)) {
+            auto payload = MMS::make_const_stream(frame.payload, frame.length);
+            if (frame.type == v3::frame_type_t::HEADERS) {
+                decoder.DecodeFieldSection(stream_id, payload, decoder_stream, [&fields](const auto &field) { fields.push_back(field); });
+            } else if (frame.type == v3::frame_type_t::DATA) {
+                body.append(reinterpret_cast<const char *>(frame.payload), frame.length);
+            }
+        }
+        EXPECT_TRUE(input.full());
+        return fields;
+    }
+};
+
+const fields_t request_fields {
+    {FIELD::Method, "POST"},
+    {FIELD::Scheme, "https"},
+    {FIELD::Authority, "www.example.com"},
+    {FIELD::Path, "/sample/path"},
+    {FIELD::User_Agent, "Mozilla/5.0 (X11; Linux x86_64)"},
+};
+
+TEST(HTTP3Test, FrameRoundTrip) {
+    MMS::FullStreamAutoAlloc stream { 64 };
+    const std::string body { "hello world" };
+    v3::AddDataFrame(stream, MMS::make_const_stream(body));
+    v3::AddGoawayFrame(stream, 16);
+
+    auto input = MMS::make_const_stream(stream.begin(), stream.index());
+    v3::frame_t frame;
+    ASSERT_TRUE(v3::ParseFrame(input, frame));
+    EXPECT_EQ(frame.type, v3::frame_type_t::DATA);
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(frame.payload), frame.length), body);
+
+    ASSERT_TRUE(v3::ParseFrame(input, frame));
+    EXPECT_EQ(frame.type, v3::frame_type_t::GOAWAY);
+    auto payload = MMS::make_const_stream(frame.payload, frame.length);
+    EXPECT_EQ(MMS::net::quic::DecodeUnsignedInteger(payload), 16);
+    EXPECT_TRUE(input.full());
+
+    // Incomplete frame must not move stream
+    auto partial = MMS::make_const_stream(stream.begin(), 5);
+    EXPECT_FALSE(v3::ParseFrame(partial, frame));
+    EXPECT_EQ(partial.curr(), stream.begin());
+}
+
+TEST(HTTP3Test, SettingsRoundTrip) {
+    MMS::FullStreamAutoAlloc stream { 64 };
+    const v3::settings_store settings { 4096, 1024, 16 };
+    settings.add_frame(stream);
+
+    auto input = MMS::make_const_stream(stream.begin(), stream.index());
+    v3::frame_t frame;
+    ASSERT_TRUE(v3::ParseFrame(input, frame));
+    EXPECT_EQ(frame.type, v3::frame_type_t::SETTINGS);
+
+    v3::settings_store parsed { };
+    parsed.parse(MMS::make_const_stream(frame.payload, frame.length));
+    EXPECT_EQ(parsed.SETTINGS_QPACK_MAX_TABLE_CAPACITY, 4096);
+    EXPECT_EQ(parsed.SETTINGS_MAX_FIELD_SECTION_SIZE, 1024);
+    EXPECT_EQ(parsed.SETTINGS_QPACK_BLOCKED_STREAMS, 16);
+
+    // SETTINGS_MAX_CONCURRENT_STREAMS from HTTP/2 is not allowed
+    const std::vector<uint8_t> http2_setting { 0x03, 0x64 };
+    EXPECT_THROW(parsed.parse(MMS::make_const_stream(http2_setting.data(), http2_setting.size())), MMS::HTTP3Exception);
+}
+
+TEST(HTTP3Test, RequestDispatch) {
+    client_t client { };
+    client.SendSettings();
+    EXPECT_EQ(client.session.GetPeerSettings().SETTINGS_QPACK_MAX_TABLE_CAPACITY, 4096);
+
+    // Headers and body arrive in separate stream reads
+    client.Send(0, client.EncodeRequest(0, request_fields));
+    EXPECT_EQ(client.session.request_count, 0);
+    client.Send(0, client.DataFrame("request body"), true);
+    ASSERT_EQ(client.session.request_count, 1);
+    EXPECT_EQ(client.session.last_method, METHOD::POST);
+    EXPECT_EQ(client.session.last_body, "request body");
+    EXPECT_EQ(client.session.GetActiveRequests(), 0);
+
+    std::string body { };
+    auto fields = client.ReadResponse(0, body);
+    ASSERT_GE(fields.size(), 3);
+    EXPECT_EQ(fields[0], (std::pair<FIELD, std::string> { FIELD::Status, "200" }));
+    EXPECT_EQ(fields[1].first, FIELD::Date);
+    EXPECT_EQ(fields[2], (std::pair<FIELD, std::string> { FIELD::Content_Type, "text/plain" }));
+    EXPECT_EQ(body, "/sample/path");
+    EXPECT_TRUE(client.transport.GetStream(0)->finished);
+    EXPECT_FALSE(client.transport.closed);
+}
+
+TEST(HTTP3Test, StreamingResponse) {
+    client_t client { };
+    client.session.streaming = true;
+    client.SendSettings();
+    client.Send(0, client.EncodeRequest(0, request_fields), true);
+    ASSERT_EQ(client.session.request_count, 1);
+
+    std::string body { };
+    auto fields = client.ReadResponse(0, body);
+    ASSERT_GE(fields.size(), 3);
+    EXPECT_EQ(fields[0], (std::pair<FIELD, std::string> { FIELD::Status, "200" }));
+    EXPECT_EQ(body, "/sample/path");
+    EXPECT_TRUE(client.transport.GetStream(0)->finished);
+}
+
+TEST(HTTP3Test, BlockedRequestDispatch) {
+    client_t client { 4096 };
+    client.SendSettings();
+
+    // Field section refers dynamic table entries not yet received by server
+    client.Send(0, client.EncodeRequest(0, request_fields), true);
+    ASSERT_FALSE(client.encoder_stream.empty());
+    EXPECT_EQ(client.session.request_count, 0);
+    EXPECT_EQ(client.session.GetActiveRequests(), 1);
+
+    std::string encoder_data { static_cast<char>(v3::stream_type_t::QPACK_ENCODER) };
+    encoder_data.append(reinterpret_cast<const char *>(client.encoder_stream.begin()), client.encoder_stream.index());
+    client.Send(6, encoder_data);
+    EXPECT_EQ(client.session.request_count, 1);
+    EXPECT_EQ(client.session.GetActiveRequests(), 0);
+
+    std::string body { };
+    client.ReadResponse(0, body);
+    EXPECT_EQ(body, "/sample/path");
+    // Server decoder acknowledges section on its decoder stream
+    EXPECT_GT(client.transport.GetStream(11)->data.size(), 1);
+}
+
+TEST(HTTP3Test, IncompleteRequest) {
+    client_t client { };
+    client.SendSettings();
+
+    // Partial frame at end of stream
+    auto headers = client.EncodeRequest(0, request_fields);
+    client.Send(0, headers.substr(0, headers.size() - 1), true);
+    EXPECT_EQ(client.session.request_count, 0);
+    EXPECT_TRUE(client.transport.GetStream(0)->reset);
+    EXPECT_FALSE(client.transport.closed);
+}
+
+TEST(HTTP3Test, RequestLimits) {
+    {
+        // Body over limit resets stream, its remaining data is discarded
+        client_t client { };
+        client.SendSettings();
+        client.Send(0, client.EncodeRequest(0, request_fields));
+        client.Send(0, client.DataFrame(std::string(4000, 'a')));
+        EXPECT_FALSE(client.transport.GetStream(0)->reset);
+        client.Send(0, client.DataFrame(std::string(100, 'a')));
+        EXPECT_TRUE(client.transport.GetStream(0)->reset);
+        EXPECT_EQ(client.transport.GetStream(0)->reset_error, v3::error_t::H3_EXCESSIVE_LOAD);
+        client.Send(0, client.DataFrame("a"), true);
+        EXPECT_EQ(client.session.request_count, 0);
+        EXPECT_EQ(client.session.GetActiveRequests(), 0);
+        EXPECT_FALSE(client.transport.closed);
+    }
+    {
+        // Incomplete frame is not buffered past limit
+        client_t client { };
+        client.SendSettings();
+        client.Send(0, client.EncodeRequest(0, request_fields));
+        const auto data = client.DataFrame(std::string(8192, 'a'));
+        client.Send(0, data.substr(0, 4000));
+        EXPECT_FALSE(client.transport.GetStream(0)->reset);
+        client.Send(0, data.substr(4000, 200));
+        EXPECT_EQ(client.transport.GetStream(0)->reset_error, v3::error_t::H3_EXCESSIVE_LOAD);
+    }
+    // Field section over advertised SETTINGS_MAX_FIELD_SECTION_SIZE
+    auto fields = request_fields;
+    fields.emplace_back(FIELD::Cookie, std::string(1024, 'c'));
+    {
+        client_t client { };
+        client.SendSettings();
+        client.Send(0, client.EncodeRequest(0, fields), true);
+        EXPECT_EQ(client.session.request_count, 0);
+        EXPECT_EQ(client.transport.GetStream(0)->reset_error, v3::error_t::H3_EXCESSIVE_LOAD);
+        EXPECT_EQ(client.session.GetActiveRequests(), 0);
+
+        client.Send(4, client.EncodeRequest(4, request_fields), true);
+        EXPECT_EQ(client.session.request_count, 1);
+    }
+    {
+        // Blocked section is checked once decoded
+        client_t client { 4096 };
+        client.SendSettings();
+        client.Send(0, client.EncodeRequest(0, fields), true);
+        ASSERT_FALSE(client.encoder_stream.empty());
+        EXPECT_EQ(client.session.GetActiveRequests(), 1);
+
+        std::string encoder_data { static_cast<char>(v3::stream_type_t::QPACK_ENCODER) };
+        encoder_data.append(reinterpret_cast<const char *>(client.encoder_stream.begin()), client.encoder_stream.index());
+        client.Send(6, encoder_data);
+        EXPECT_EQ(client.session.request_count, 0);
+        EXPECT_EQ(client.transport.GetStream(0)->reset_error, v3::error_t::H3_EXCESSIVE_LOAD);
+        EXPECT_EQ(client.session.GetActiveRequests(), 0);
+        EXPECT_FALSE(client.transport.closed);
+    }
+}
+
+TEST(HTTP3Test, ConnectionErrors) {
+    {
+        // First frame on control stream must be SETTINGS
+        client_t client { };
+        std::string control { static_cast<char>(v3::stream_type_t::CONTROL) };
+        control += client.DataFrame("x");
+        client.Send(2, control);
+        EXPECT_TRUE(client.transport.closed);
+        EXPECT_EQ(client.transport.close_error, v3::error_t::H3_MISSING_SETTINGS);
+    }
+    {
+        // DATA is not allowed on control stream
+        client_t client { };
+        client.SendSettings();
+        client.Send(2, client.DataFrame("x"));
+        EXPECT_TRUE(client.transport.closed);
+        EXPECT_EQ(client.transport.close_error, v3::error_t::H3_FRAME_UNEXPECTED);
+    }
+    {
+        // Only one control stream is allowed
+        client_t client { };
+        client.SendSettings();
+        client.Send(6, std::string { static_cast<char>(v3::stream_type_t::CONTROL) });
+        EXPECT_TRUE(client.transport.closed);
+        EXPECT_EQ(client.transport.close_error, v3::error_t::H3_STREAM_CREATION_ERROR);
+    }
+    {
+        // Control stream must not be closed
+        client_t client { };
+        client.SendSettings();
+        client.Send(2, std::string { }, true);
+        EXPECT_TRUE(client.transport.closed);
+        EXPECT_EQ(client.transport.close_error, v3::error_t::H3_CLOSED_CRITICAL_STREAM);
+    }
+}
+
+TEST(HTTP3Test, GoawayRejectsNewRequest) {
+    client_t client { };
+    client.SendSettings();
+    client.Send(0, client.EncodeRequest(0, request_fields), true);
+    EXPECT_EQ(client.session.request_count, 1);
+
+    client.session.Shutdown();
+    client.Send(4, client.EncodeRequest(4, request_fields), true);
+    EXPECT_EQ(client.session.request_count, 1);
+    EXPECT_TRUE(client.transport.GetStream(4)->reset);
+}
@@ -0,0 +1,207 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+#include <http/httpparser.h>
+#include <benchmark/benchmark.h>
+#include <ctime>
+#include <unordered_map>
+
+// Chrome like page request
+const std::string browser_request {
+    "GET /static/js/application.bundle.js?v=20241021 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"120\", \"Google Chrome\";v=\"120\", \"Not?A_Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Accept: */*\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Dest: script\r\n"
+    "Referer: https://www.example.com/products/index.html?category=books&sort=price\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9,hi;q=0.8\r\n"
+    "Cookie: session=4f2a9c1e7b3d5a6f8e0c; theme=dark; _ga=GA1.1.1234567890.1700000000; consent=yes\r\n"
+    "If-None-Match: \"5e1f-63b2a1c4\"\r\n"
+    "If-Modified-Since: Sun, 20 Oct 2024 11:02:51 GMT\r\n"
+    "\r\n"
+};
+
+static void BM_FindDelimiters(benchmark::State &state, MMS::http::scan::find_delimiters_t kernel) {
+    std::vector<uint32_t> positions(browser_request.size());
+    auto data = reinterpret_cast<const uint8_t *>(browser_request.data());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernel(data, browser_request.size(), 0, positions.data()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * browser_request.size()));
+}
+BENCHMARK_CAPTURE(BM_FindDelimiters, scalar, MMS::http::scan::find_delimiters_scalar);
+#if defined(__x86_64__)
+BENCHMARK_CAPTURE(BM_FindDelimiters, sse42, MMS::http::scan::find_delimiters_sse42);
+BENCHMARK_CAPTURE(BM_FindDelimiters, avx2, MMS::http::scan::find_delimiters_avx2);
+#endif
+
+static void BM_ParseRequest(benchmark::State &state) {
+    state.SetLabel(MMS::http::scan::find_delimiters_name());
+    for (auto _ : state) {
+        MMS::http::request request { MMS::make_const_fullstream(browser_request) };
+        benchmark::DoNotOptimize(request.GetPath());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * browser_request.size()));
+}
+BENCHMARK(BM_ParseRequest);
+
+static void BM_ParseRequestView(benchmark::State &state) {
+    state.SetLabel(MMS::http::scan::find_delimiters_name());
+    for (auto _ : state) {
+        MMS::http::request_view request { MMS::make_const_fullstream(browser_request) };
+        benchmark::DoNotOptimize(request.GetPath());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * browser_request.size()));
+}
+BENCHMARK(BM_ParseRequestView);
+
+// Field names of browser request, lookup is done for each name
+const std::vector<std::string_view> browser_field_names {
+    "Host", "Connection", "sec-ch-ua", "sec-ch-ua-mobile", "User-Agent", "sec-ch-ua-platform", "Accept", "Sec-Fetch-Site",
+    "Sec-Fetch-Mode", "Sec-Fetch-Dest", "Referer", "Accept-Encoding", "Accept-Language", "Cookie", "If-None-Match", "If-Modified-Since"
+};
+
+// Earlier lookup, string is created for each name
+const std::unordered_map<std::string, MMS::http::FIELD> string_field_map {
+#define HTTP_FIELD_ENTRY(x, y) {y, MMS::http::FIELD::x},
+    HTTP_FIELD_LIST
+#undef HTTP_FIELD_ENTRY
+};
+
+static void BM_FieldLookupMap(benchmark::State &state) {
+    for (auto _ : state) {
+        for(const auto name: browser_field_names) {
+            auto itr = string_field_map.find(std::string { name });
+            benchmark::DoNotOptimize(itr == string_field_map.end() ? MMS::http::FIELD::IGNORE_THIS : itr->second);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * browser_field_names.size()));
+}
+BENCHMARK(BM_FieldLookupMap);
+
+static void BM_FieldLookupPerfectHash(benchmark::State &state) {
+    for (auto _ : state) {
+        for(const auto name: browser_field_names) {
+            benchmark::DoNotOptimize(MMS::http::to_field(name));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * browser_field_names.size()));
+}
+BENCHMARK(BM_FieldLookupPerfectHash);
+
+static void BM_MethodLookupMap(benchmark::State &state) {
+    static const std::unordered_map<std::string, MMS::http::METHOD> string_method_map {
+#define HTTP_METHOD_ENTRY(x) {#x, MMS::http::METHOD::x},
+        HTTP_METHOD_LIST
+#undef HTTP_METHOD_ENTRY
+    };
+    const std::string_view method { "GET" };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(string_method_map.find(std::string { method }));
+    }
+}
+BENCHMARK(BM_MethodLookupMap);
+
+static void BM_MethodLookupPerfectHash(benchmark::State &state) {
+    const std::string_view method { "GET" };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MMS::http::to_method(method));
+    }
+}
+BENCHMARK(BM_MethodLookupPerfectHash);
+
+// Fields as parsed from browser request, parser must not run in static initialization
+static const auto &GetBrowserFields() {
+    static const auto fields = [] {
+        std::vector<std::pair<MMS::http::FIELD, std::string>> fields { };
+        MMS::http::request_view view { MMS::make_const_fullstream(browser_request) };
+        for(auto &entry: view) fields.emplace_back(entry.first, entry.second);
+        return fields;
+    }();
+    return fields;
+}
+
+// Fields read by handler for each request
+const std::array<MMS::http::FIELD, 4> handler_fields {
+    MMS::http::FIELD::Host, MMS::http::FIELD::Accept_Encoding, MMS::http::FIELD::If_None_Match, MMS::http::FIELD::Cookie
+};
+
+// Earlier header storage, every value is separate node and allocation
+static void BM_HeaderStorageMap(benchmark::State &state) {
+    auto &browser_fields = GetBrowserFields();
+    for (auto _ : state) {
+        std::unordered_map<MMS::http::FIELD, std::string> fields { };
+        fields.emplace(MMS::http::FIELD::Method, "GET");
+        fields.emplace(MMS::http::FIELD::Path, "/static/js/application.bundle.js?v=20241021");
+        for(auto &entry: browser_fields) fields.insert(entry);
+        benchmark::DoNotOptimize(fields.find(MMS::http::FIELD::Method)->second);
+        benchmark::DoNotOptimize(fields.find(MMS::http::FIELD::Path)->second);
+        for(auto field: handler_fields) benchmark::DoNotOptimize(fields.find(field)->second);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * browser_fields.size()));
+}
+BENCHMARK(BM_HeaderStorageMap);
+
+static void BM_HeaderStorageFlat(benchmark::State &state) {
+    auto &browser_fields = GetBrowserFields();
+    for (auto _ : state) {
+        MMS::http::fields_t fields { };
+        fields.add(MMS::http::FIELD::Method, "GET");
+        fields.add(MMS::http::FIELD::Path, "/static/js/application.bundle.js?v=20241021");
+        for(auto &entry: browser_fields) fields.add(entry.first, entry.second);
+        benchmark::DoNotOptimize(fields.get_method());
+        benchmark::DoNotOptimize(fields.get_path());
+        for(auto field: handler_fields) benchmark::DoNotOptimize(fields.get(field));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * browser_fields.size()));
+}
+BENCHMARK(BM_HeaderStorageFlat);
+
+// Date line as it was written for every response
+static void BM_DateLineStrftime(benchmark::State &state) {
+    MMS::FullStreamAutoAlloc stream { 64 };
+    for (auto _ : state) {
+        stream.Reset();
+        constexpr uint64_t max_date_string_size = 92;
+        std::time_t now_time = std::time(0);
+        std::tm now_tm { };
+        gmtime_r(&now_time, &now_tm);
+        char date_str[max_date_string_size];
+        auto date_size = strftime(date_str, max_date_string_size, "%a, %d %b %Y %H:%M:%S %Z", &now_tm);
+        stream.Write(MMS::http::to_string(MMS::http::FIELD::Date), ": ");
+        stream.Copy(date_str, date_size);
+        stream.Write("\r\n");
+        benchmark::DoNotOptimize(stream.index());
+    }
+}
+BENCHMARK(BM_DateLineStrftime);
+
+static void BM_DateLineCached(benchmark::State &state) {
+    MMS::FullStreamAutoAlloc stream { 64 };
+    for (auto _ : state) {
+        stream.Reset();
+        MMS::http::WriteDateLine(stream);
+        benchmark::DoNotOptimize(stream.index());
+    }
+}
+BENCHMARK(BM_DateLineCached);
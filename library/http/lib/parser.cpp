@@ -16,29 +16,44 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <http/httpparser.h>
-#include <format>
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <cstring>
 
 namespace MMS::http {
 
-const std::unordered_map<std::string, FIELD> field_map = {
-#define HTTP_FIELD_ENTRY(x, y) {y, FIELD::x},
+constinit const perfecthashmap<FIELD, field_count, true> field_map { std::array {
+#define HTTP_FIELD_ENTRY(x, y) std::pair<std::string_view, FIELD> {y, FIELD::x},
     HTTP_FIELD_LIST
 #undef HTTP_FIELD_ENTRY
-};
+} };
 
-const std::unordered_map<std::string, METHOD> method_map = {
-#define HTTP_METHOD_ENTRY(x) {#x, METHOD::x},
+constinit const perfecthashmap<METHOD, method_count> method_map { std::array {
+#define HTTP_METHOD_ENTRY(x) std::pair<std::string_view, METHOD> {#x, METHOD::x},
     HTTP_METHOD_LIST
 #undef HTTP_METHOD_ENTRY
-};
+} };
 
-const std::unordered_map<std::string, CODE> code_map_raw = {
-#define HTTP_CODE_ENTRY(x, y, z) {#x, CODE::_##x},
+constinit const std::array<CODE, 1000> code_map_raw = [] {
+    std::array<CODE, 1000> code_map { };
+#define HTTP_CODE_ENTRY(x, y, z) code_map[x] = CODE::_##x;
     HTTP_CODE_LIST
 #undef HTTP_CODE_ENTRY
-};
+    return code_map;
+}();
 
-const std::string header::empty { };
+// Field lines and body after start line
+static void append_message(std::string &ret, const fields_t &fields, const std::string &body) {
+    for(auto [field, value]: fields) {
+        ret += to_string_view(field);
+        ret += ": ";
+        ret += value;
+        ret += "\r\n";
+    }
+    ret += "\r\n";
+    ret += body;
+}
 
 std::string request::to_string() {
     std::string ret {};
@@ -46,75 +61,56 @@ std::string request::to_string() {
     ret += " ";
     ret += GetPath();
     ret += " ";
-    ret += MMS::http::to_string(version);
-    ret += "\r\n";
-    for(auto fieldentry: fields) {
-        auto field = fieldentry.first;
-        auto value = fieldentry.second;
-        ret += MMS::http::to_string(field);
-        ret += ": ";
-        ret += value;
-        ret += "\r\n";
-    }
+    ret += to_string_view(version);
     ret += "\r\n";
-    if ( !body.empty() ) {
-        ret += body;
-    }
+    append_message(ret, fields, body);
     return ret;
 }
 
 std::string response::to_string() const {
-    std::string ret = std::format(
-        "{} {} {}\r\n",
-        MMS::http::to_string(version),
-        static_cast<int>(code),
-        MMS::http::to_string(code)
-    );
-
-    for(auto fieldentry: fields) {
-        auto field = fieldentry.first;
-        auto value = fieldentry.second;
-        ret += MMS::http::to_string(field);
-        ret += ": ";
-        ret += value;
-        ret += "\r\n";
-    }
+    std::string ret {};
+    ret.reserve(256 + body.size());
+    ret += to_string_view(version);
+    ret += " ";
+    char code_str[8];
+    ret.append(code_str, std::to_chars(std::begin(code_str), std::end(code_str), static_cast<int>(code)).ptr);
+    ret += " ";
+    ret += to_string_view(code);
     ret += "\r\n";
-    if ( !body.empty() ) {
-        ret += body;
-    }
+    append_message(ret, fields, body);
     return ret;
 }
 
-std::string parse_till_space(const FullStream &stream) {
-    auto start = stream.curr();
-    while(*stream != ' ' && stream.remaining_buffer()) {
+// Parse helpers return view into stream, caller copies when required.
+// Delimiters are taken from index instead of checking one byte at a time.
+void parse_skip_space(const FullStream &stream) {
+    while(stream.remaining_buffer() && *stream == ' ') {
         ++stream;
     }
+}
 
-    if (start == stream.curr()) {
+std::string_view parse_till_space(const FullStream &stream, scan::delimiter_index_t &index) {
+    auto start = stream.curr();
+    auto pos = index.next_of<' '>(start);
+    if (start == pos) {
         throw MMS::http_parser_failed_t(stream);
     }
+    stream += static_cast<size_t>(pos - start);
 
-    return { reinterpret_cast<const char *>(start), static_cast<size_t>(stream.curr() - start)};
+    return { reinterpret_cast<const char *>(start), static_cast<size_t>(pos - start)};
 }
 
-std::string parse_till_colon(const FullStream &stream) {
-    while(*stream == ' ' && stream.remaining_buffer()) {
-        ++stream;
-    }
+std::string_view parse_till_colon(const FullStream &stream, scan::delimiter_index_t &index) {
+    parse_skip_space(stream);
     auto start = stream.curr();
-    while(*stream != ':' && *stream != ' ' && stream.remaining_buffer()) {
-        ++stream;
-    }
-    if (start == stream.curr()) {
+    auto pos = index.next_of<':', ' '>(start);
+    if (start == pos) {
         throw MMS::http_parser_failed_t(stream);
     }
-    std::string ret = { reinterpret_cast<const char *>(start), static_cast<size_t>(stream.curr() - start) };
+    std::string_view ret = { reinterpret_cast<const char *>(start), static_cast<size_t>(pos - start) };
 
-    while(*stream != ':' && stream.remaining_buffer()) {
-        ++stream;
-    }
+    pos = index.next_of<':'>(pos);
+    stream += static_cast<size_t>(pos - start);
 
     if (stream.remaining_buffer()) {
         // Skip colon
@@ -124,20 +120,15 @@ std::string parse_till_colon(const FullStream &stream) {
     return ret;
 }
 
-std::string parse_till_CRLF(const FullStream &stream) {
-    while(*stream == ' ' && stream.remaining_buffer()) {
-        ++stream;
-    }
+std::string_view parse_till_CRLF(const FullStream &stream, scan::delimiter_index_t &index) {
+    parse_skip_space(stream);
     auto start = stream.curr();
-    auto end = stream.curr();
-    while(stream.remaining_buffer()) {
-        if (*stream == '\r' || *stream == '\n') break;
-        if (*(stream.curr() - 1) != ' ') end = stream.curr();
-        ++stream;
-    }
-    if (*(stream.curr() - 1) != ' ') end = stream.curr();
+    auto pos = index.next_of<'\r', '\n'>(start);
+    auto end = pos;
+    while(end > start && *(end - 1) == ' ') --end;
+    stream += static_cast<size_t>(pos - start);
 
-    std::string ret = { reinterpret_cast<const char *>(start), static_cast<size_t>(end - start) };
+    std::string_view ret = { reinterpret_cast<const char *>(start), static_cast<size_t>(end - start) };
     
     if (stream.remaining_buffer()) {
         if (*stream == '\r') {
@@ -172,48 +163,54 @@ bool parse_check_CRLF(const FullStream &stream) {
 }
 
 template <bool crlf_end>
-void header::parse_version(const FullStream &stream) {
-    const auto versiontext = crlf_end ? parse_till_CRLF(stream) : parse_till_space(stream);
+void header::parse_version(const FullStream &stream, scan::delimiter_index_t &index) {
+    const auto versiontext = crlf_end ? parse_till_CRLF(stream, index) : parse_till_space(stream, index);
     version = to_version(versiontext);
     if (version == VERSION::VER_UNKNOWN) throw MMS::http_parser_failed_t(stream);
 }
 
-void header::parse_fields(const FullStream &stream) {
+template <typename add_field_t>
+void parse_field_lines(const FullStream &stream, scan::delimiter_index_t &index, add_field_t add_field) {
     while(true) {
-        auto fieldtext = parse_till_colon(stream);
-        auto value = parse_till_CRLF(stream);
+        auto fieldtext = parse_till_colon(stream, index);
+        auto value = parse_till_CRLF(stream, index);
         auto field = to_field(fieldtext);
         // When field is not present in enumeration it will be ignored.
-        if (field != FIELD::IGNORE_THIS) fields[field] = std::move(value);
+        if (field != FIELD::IGNORE_THIS) add_field(field, value);
         if (stream.full() || parse_check_CRLF(stream)) break;
     }
 }
 
-void header::parse_method(const FullStream &stream) {
-    auto methodtext = parse_till_space(stream);
-    SetMethod(std::move(methodtext));
+void header::parse_fields(const FullStream &stream, scan::delimiter_index_t &index) {
+    parse_field_lines(stream, index, [this](const FIELD field, const std::string_view value) { fields.set(field, value); });
+}
+
+void header::parse_method(const FullStream &stream, scan::delimiter_index_t &index) {
+    auto methodtext = parse_till_space(stream, index);
+    SetMethod(methodtext);
     if (GetMethod() == METHOD::IGNORE_THIS) throw MMS::http_parser_failed_t(stream);
 }
 
-void header::parse_request_uri(const FullStream &stream) {
-    auto requesturi = parse_till_space(stream);
-    SetPath(std::move(requesturi));
+void header::parse_request_uri(const FullStream &stream, scan::delimiter_index_t &index) {
+    auto requesturi = parse_till_space(stream, index);
+    SetPath(requesturi);
 }
 
 // Request-Line   = Method SP Request-URI SP HTTP-Version CRLF
 // We will allow CR
-void header::parse_request_line(const FullStream &stream) {
-    parse_method(stream);
+void header::parse_request_line(const FullStream &stream, scan::delimiter_index_t &index) {
+    parse_method(stream, index);
     parse_skip_one(stream);
-    parse_request_uri(stream);
+    parse_request_uri(stream, index);
     parse_skip_one(stream);
-    parse_version<true>(stream);
+    parse_version<true>(stream, index);
 }
 
 void request::parse(const FullStream &stream) {
-    parse_request_line(stream);
+    scan::delimiter_index_t index { stream.curr(), stream.end() };
+    parse_request_line(stream, index);
     if (stream.remaining_buffer()) {
-        parse_fields(stream);
+        parse_fields(stream, index);
         if (stream.remaining_buffer()) body = std::string { reinterpret_cast<const char *>(stream.curr()), stream.remaining_buffer() };
     }
 }
@@ -222,75 +219,296 @@ request::request(const FullStream &stream) {
     parse(stream);
 }
 
-response request::CreateErrorResponse(CODE code, const std::string &errortext, const std::string &servername) const {
+error_page_t::error_page_t(const std::string_view servername) {
+    html_server += "</title></head><h1>";
+    html_server += servername;
+    html_server += "</h1><h2>";
+}
+
+error_page_t::type_t error_page_t::GetType(const std::string_view accepttype) {
+    if (accepttype.find("text/html") == std::string_view::npos && accepttype.find("application/json") != std::string_view::npos) {
+        return type_t::JSON;
+    }
+    return type_t::HTML;
+}
+
+namespace {
+// Text around code and error text, code text is written twice in HTML
+constexpr std::string_view html_begin { "<html><head><title>" };
+constexpr std::string_view html_text { "</h2><pre>" };
+constexpr std::string_view html_end { "</pre></html>" };
+constexpr std::string_view json_begin { "{\"error\": \"" };
+constexpr std::string_view json_text { "\", \"details\": \"" };
+constexpr std::string_view json_end { "\"}" };
+} // namespace
+
+size_t error_page_t::GetSize(const type_t type, const CODE code, const std::string_view errortext) const {
+    const auto codetext = to_string_view(code);
+    if (type == type_t::JSON) return json_begin.size() + codetext.size() + json_text.size() + errortext.size() + json_end.size();
+    return html_begin.size() + codetext.size() + html_server.size() + codetext.size() + html_text.size() + errortext.size() + html_end.size();
+}
+
+void error_page_t::Write(Stream &stream, const type_t type, const CODE code, const std::string_view errortext) const {
+    const auto codetext = to_string_view(code);
+    if (type == type_t::JSON) stream.Write(json_begin, codetext, json_text, errortext, json_end);
+    else stream.Write(html_begin, codetext, std::string_view { html_server }, codetext, html_text, errortext, html_end);
+}
+
+std::string error_page_t::to_string(const type_t type, const CODE code, const std::string_view errortext) const {
+    std::string body(GetSize(type, code, errortext), '\0');
+    Stream stream { body };
+    Write(stream, type, code, errortext);
+    return body;
+}
+
+// Error body is created based on Accept field of request
+static response CreateErrorResponse(CODE code, const std::string &errortext, const std::string &servername, const std::string_view accepttype, const bool close = true) {
     response res = response::CreateBasicResponse(code);
-    res.fields.emplace(FIELD::Connection, std::string { "close" });
+    if (close) res.add_field(FIELD::Connection, "close");
     res.add_field(FIELD::Server, servername);
-    
-    auto accepttype = GetField(FIELD::Accept);
-    bool accepthtml = accepttype.find("text/html") != std::string::npos;
-    if (!accepthtml) {
-        if (accepttype.find("application/json") != std::string::npos) {
-            res.body = std::format(
-                "{{\"error\": \"{}\", \"details\": \"{}\"}}",
-                MMS::http::to_string(code), errortext
-            );
-            res.add_field(FIELD::Content_Type, std::string { "application/json" });
-        } else accepthtml = true;
-    }
 
-    if (accepthtml) {
-        res.body = std::format(
-            "<html>"
-            "<head><title>{0}</title></head>"
-            "<h1>{2}</h1>"
-            "<h2>{0}</h2>"
-            "<pre>{1}</pre>"
-            "</html>", 
-            MMS::http::to_string(code), errortext, servername
-        );
-        res.add_field(FIELD::Content_Type, std::string { "text/html" });
-    }
+    const auto type = error_page_t::GetType(accepttype);
+    res.add_field(FIELD::Content_Type, error_page_t::GetContentType(type));
+    res.SetBody(error_page_t { servername }.to_string(type, code, errortext));
     res.UpdateContentLength();
     return res;
 }
 
+response request::CreateErrorResponse(CODE code, const std::string &errortext, const std::string &servername) const {
+    return MMS::http::CreateErrorResponse(code, errortext, servername, GetField(FIELD::Accept));
+}
+
+bool request_view::add_field(const FIELD field, const std::string_view value) {
+    // Last field is used same as request
+    for(auto itr = fields.begin(); itr != end(); ++itr) {
+        if (itr->first == field) {
+            // Differing Content-Length is not recoverable https://www.rfc-editor.org/rfc/rfc9112.html#section-6.3-2.5
+            if (field == FIELD::Content_Length && itr->second != value) return false;
+            itr->second = value;
+            return true;
+        }
+    }
+    if (field_count == max_fields) return false;
+    fields[field_count++] = { field, value };
+    return true;
+}
+
+void request_view::parse(const FullStream &stream) {
+    scan::delimiter_index_t index { stream.curr(), stream.end() };
+    method_str = parse_till_space(stream, index);
+    method = to_method(method_str);
+    if (method == METHOD::IGNORE_THIS) throw MMS::http_parser_failed_t(stream);
+    parse_skip_one(stream);
+    path = parse_till_space(stream, index);
+    parse_skip_one(stream);
+    version = to_version(parse_till_CRLF(stream, index));
+    if (version == VERSION::VER_UNKNOWN) throw MMS::http_parser_failed_t(stream);
+    if (stream.remaining_buffer() && !parse_check_CRLF(stream)) {
+        parse_field_lines(stream, index, [this, &stream](const FIELD field, const std::string_view value) {
+            if (!add_field(field, value)) throw MMS::http_parser_failed_t(stream);
+        });
+    }
+    if (stream.remaining_buffer()) body = { reinterpret_cast<const char *>(stream.curr()), stream.remaining_buffer() };
+}
+
+// Field section ends with empty line, LF without CR is allowed same as parser
+static const uint8_t *find_header_end(const uint8_t *begin, const uint8_t *end) {
+    auto curr = begin;
+    while(true) {
+        curr = static_cast<const uint8_t *>(std::memchr(curr, '\n', static_cast<size_t>(end - curr)));
+        if (curr == nullptr || ++curr == end) return nullptr;
+        if (*curr == '\n') return curr + 1;
+        if (*curr == '\r') {
+            if (curr + 1 == end) return nullptr;
+            if (curr[1] == '\n') return curr + 2;
+        }
+    }
+}
+
+static constexpr std::string_view trim_space(std::string_view text) {
+    while(!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while(!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+// Tokens are case insensitive https://www.rfc-editor.org/rfc/rfc9110.html#name-tokens
+static constexpr bool equal_token(const std::string_view lhs, const std::string_view rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    for(size_t index { 0 }; index < lhs.size(); ++index) {
+        auto lch = lhs[index];
+        auto rch = rhs[index];
+        if (lch >= 'A' && lch <= 'Z') lch |= 0x20;
+        if (rch >= 'A' && rch <= 'Z') rch |= 0x20;
+        if (lch != rch) return false;
+    }
+    return true;
+}
+
+// Comma separated list https://www.rfc-editor.org/rfc/rfc9110.html#name-lists-rule-abnf-extension
+static constexpr bool has_token(std::string_view list, const std::string_view token) {
+    while(true) {
+        const auto pos = list.find(',');
+        if (equal_token(trim_space(list.substr(0, pos)), token)) return true;
+        if (pos == std::string_view::npos) return false;
+        list.remove_prefix(pos + 1);
+    }
+}
+
+// Line ends with LF, returns next line or nullptr if line is not complete
+static const uint8_t *next_line(const uint8_t *begin, const uint8_t *end) {
+    auto pos = static_cast<const uint8_t *>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+    return pos == nullptr ? nullptr : pos + 1;
+}
+
+// https://www.rfc-editor.org/rfc/rfc9112.html#name-chunked-transfer-coding
+bool body_decoder_t::next(const uint8_t *&curr, const uint8_t *end, std::string_view &part) {
+    while(curr != end) {
+        switch(state) {
+        case state_t::DATA: {
+            const auto size = std::min(remaining, static_cast<size_t>(end - curr));
+            part = { reinterpret_cast<const char *>(curr), size };
+            curr += size;
+            remaining -= size;
+            if (remaining == 0) state = chunked ? state_t::CHUNK_END : state_t::DONE;
+            return true;
+        }
+
+        case state_t::CHUNK_END:
+            if (*curr == '\r') {
+                if (curr + 1 == end) return false;
+                ++curr;
+            }
+            if (*curr != '\n') throw MMS::http_parser_failed_t(make_const_fullstream(curr, end));
+            ++curr;
+            state = state_t::CHUNK_SIZE;
+            break;
+
+        case state_t::CHUNK_SIZE: {
+            const auto line_end = next_line(curr, end);
+            if (line_end == nullptr) return false;
+
+            size_t size { 0 };
+            const auto [size_end, err] = std::from_chars(reinterpret_cast<const char *>(curr), reinterpret_cast<const char *>(line_end), size, 16);
+            if (err != std::errc { }) throw MMS::http_parser_failed_t(make_const_fullstream(curr, end));
+            const auto delimiter = *size_end;
+            if (delimiter != ';' && delimiter != ' ' && delimiter != '\t' && delimiter != '\r' && delimiter != '\n') throw MMS::http_parser_failed_t(make_const_fullstream(curr, end));
+            curr = line_end;
+            remaining = size;
+            state = size ? state_t::DATA : state_t::TRAILER;
+            break;
+        }
+
+        case state_t::TRAILER: {
+            // Trailer section ends with empty line
+            const auto line_end = next_line(curr, end);
+            if (line_end == nullptr) return false;
+            const auto empty = line_end == curr + 1 || (line_end == curr + 2 && *curr == '\r');
+            curr = line_end;
+            if (empty) state = state_t::DONE;
+            break;
+        }
+
+        case state_t::DONE:
+            return false;
+        }
+    }
+    return false;
+}
+
+body_decoder_t request_view::body_decoder() const {
+    const auto transfer_encoding = GetField(FIELD::Transfer_Encoding);
+    if (!transfer_encoding.empty()) {
+        // Transfer-Encoding overrides Content-Length, chunked must be final coding
+        const auto last = transfer_encoding.rfind(',');
+        const auto final_coding = last == std::string_view::npos ? transfer_encoding : transfer_encoding.substr(last + 1);
+        if (!equal_token(trim_space(final_coding), "chunked")) throw MMS::http_parser_failed_t(make_const_fullstream(transfer_encoding));
+        return { true, 0 };
+    }
+
+    const auto content_length = GetField(FIELD::Content_Length);
+    if (content_length.empty()) return { };
+    size_t length { 0 };
+    const auto [length_end, err] = std::from_chars(content_length.data(), content_length.data() + content_length.size(), length);
+    if (err != std::errc { } || length_end != content_length.data() + content_length.size()) throw MMS::http_parser_failed_t(make_const_fullstream(content_length));
+    return { false, length };
+}
+
+size_t request_view::parse_message(const uint8_t *begin, const uint8_t *end) {
+    head_size = 0;
+    // Empty line before request line is ignored https://www.rfc-editor.org/rfc/rfc9112.html#section-2.2-6
+    auto start = begin;
+    while(start != end && (*start == '\r' || *start == '\n')) ++start;
+    const auto header_end = find_header_end(start, end);
+    if (header_end == nullptr) return 0;
+
+    field_count = 0;
+    body = { };
+    chunked_body.clear();
+    parse(make_const_fullstream(start, header_end));
+    head_size = static_cast<size_t>(header_end - begin);
+
+    auto decoder = body_decoder();
+    auto message_end = header_end;
+    if (decoder.is_chunked()) {
+        std::string_view part { };
+        while(decoder.next(message_end, end, part)) chunked_body.append(part);
+        if (!decoder.done()) return 0;
+        body = chunked_body;
+    } else {
+        const auto length = decoder.get_remaining();
+        if (static_cast<size_t>(end - header_end) < length) return 0;
+        message_end = header_end + length;
+        body = { reinterpret_cast<const char *>(header_end), length };
+    }
+    return static_cast<size_t>(message_end - begin);
+}
+
+bool request_view::keep_alive() const {
+    // Transfer-Encoding with Content-Length may be smuggling, connection is closed after response
+    // https://www.rfc-editor.org/rfc/rfc9112.html#section-6.1-15
+    if (!GetField(FIELD::Transfer_Encoding).empty() && !GetField(FIELD::Content_Length).empty()) return false;
+    // HTTP/1.1 connection is persistent unless close option is present
+    return !has_token(GetField(FIELD::Connection), "close");
+}
+
+request request_view::to_request() const {
+    request req { version };
+    req.SetMethod(method_str);
+    req.SetPath(path);
+    for(auto &entry: *this) {
+        req.add_field(entry.first, entry.second);
+    }
+    req.body = body;
+    return req;
+}
+
+response request_view::CreateErrorResponse(CODE code, const std::string &errortext, const std::string &servername) const {
+    return MMS::http::CreateErrorResponse(code, errortext, servername, GetField(FIELD::Accept), !keep_alive());
+}
+
 response response::CreateErrorResponse(CODE code, const std::string &errortext, const std::string &servername) {
-    auto res = CreateBasicResponse(code);
-    res.add_field(FIELD::Connection, std::string { "Close" });
-    res.add_field(FIELD::Server, servername);
-    res.add_field(FIELD::Content_Type, std::string { "text/html" });
-    res.body = std::format(
-        "<html>"
-        "<head><title>{0}</title></head>"
-        "<h1>Micro Monolith Server</h1>"
-        "<h2>{0}</h2>"
-        "<pre>{1}</pre>"
-        "</html>", 
-        MMS::http::to_string(code), errortext
-    );
-    res.UpdateContentLength();
-    return res;
+    return MMS::http::CreateErrorResponse(code, errortext, servername, { });
 }
 
-void response_header::parse_code(const FullStream &stream) {
-    auto codetext = parse_till_space(stream);
+void response_header::parse_code(const FullStream &stream, scan::delimiter_index_t &index) {
+    auto codetext = parse_till_space(stream, index);
     code = to_code_map(codetext);
     if (code == CODE::_0) throw MMS::http_parser_failed_t(stream);
 }
 
-void response_header::parse_response_line(const FullStream &stream) {
-    parse_version<false>(stream);
+void response_header::parse_response_line(const FullStream &stream, scan::delimiter_index_t &index) {
+    parse_version<false>(stream, index);
     parse_skip_one(stream);
-    parse_code(stream);
+    parse_code(stream, index);
     parse_skip_one(stream);
-    parse_till_CRLF(stream);
+    parse_till_CRLF(stream, index);
 }
 
 void response::parse(const FullStream &stream) {
-    parse_response_line(stream);
+    scan::delimiter_index_t index { stream.curr(), stream.end() };
+    parse_response_line(stream, index);
     if (stream.remaining_buffer()) {
-        parse_fields(stream);
+        parse_fields(stream, index);
         if (stream.remaining_buffer()) body = std::string { reinterpret_cast<const char *>(stream.curr()), stream.remaining_buffer() };
     }
 }
@@ -300,18 +518,73 @@ response::response(const FullStream &stream) {
 }
 
 response response::CreateBasicResponse(CODE code) {
-    constexpr uint64_t max_date_string_size = 92;
-    std::time_t now_time = std::time(0);   // get time now
-    std::tm* now_tm = std::gmtime(&now_time);
-    char date_str[max_date_string_size];
-    strftime(date_str, max_date_string_size, "%a, %d %b %Y %H:%M:%S %Z", now_tm);
-    
     response res { };
     res.version = VERSION::VER_1_1;
     res.code = code;
-    res.fields.emplace(FIELD::Date, std::string { date_str });
+    res.fields.add(FIELD::Date, GetDate());
 
     return res;
 }
 
+namespace {
+// "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n", date is at offset 6
+struct date_cache_t {
+    static constexpr size_t date_offset = 6;
+    static constexpr size_t date_size = 29;
+    std::time_t second { -1 };
+    std::array<char, date_offset + date_size + 2> line { 'D', 'a', 't', 'e', ':', ' ' };
+
+    void write_number(size_t offset, int value, size_t digits) {
+        for(; digits; --digits, value /= 10) line[offset + digits - 1] = static_cast<char>('0' + value % 10);
+    }
+
+    // Formatted without strftime, it does not depend on locale
+    void update(const std::time_t now) {
+        static constexpr std::string_view days { "SunMonTueWedThuFriSat" };
+        static constexpr std::string_view months { "JanFebMarAprMayJunJulAugSepOctNovDec" };
+        std::tm now_tm { };
+        gmtime_r(&now, &now_tm);
+        auto curr = line.begin() + date_offset;
+        curr = std::ranges::copy(days.substr(static_cast<size_t>(now_tm.tm_wday) * 3, 3), curr).out;
+        *curr++ = ','; *curr++ = ' ';
+        write_number(static_cast<size_t>(curr - line.begin()), now_tm.tm_mday, 2);
+        curr += 2;
+        *curr++ = ' ';
+        curr = std::ranges::copy(months.substr(static_cast<size_t>(now_tm.tm_mon) * 3, 3), curr).out;
+        *curr++ = ' ';
+        write_number(static_cast<size_t>(curr - line.begin()), now_tm.tm_year + 1900, 4);
+        curr += 4;
+        *curr++ = ' ';
+        write_number(static_cast<size_t>(curr - line.begin()), now_tm.tm_hour, 2);
+        curr += 2;
+        *curr++ = ':';
+        write_number(static_cast<size_t>(curr - line.begin()), now_tm.tm_min, 2);
+        curr += 2;
+        *curr++ = ':';
+        write_number(static_cast<size_t>(curr - line.begin()), now_tm.tm_sec, 2);
+        curr += 2;
+        std::ranges::copy(std::string_view { " GMT\r\n" }, curr);
+        second = now;
+    }
+
+    void refresh() {
+        const auto now = std::time(nullptr);
+        if (now != second) update(now);
+    }
+};
+
+// Listener threads do not share cache, hence no synchronization
+thread_local date_cache_t date_cache { };
+} // namespace
+
+std::string_view GetDate() {
+    date_cache.refresh();
+    return { date_cache.line.data() + date_cache_t::date_offset, date_cache_t::date_size };
+}
+
+std::string_view GetDateLine() {
+    date_cache.refresh();
+    return { date_cache.line.data(), date_cache.line.size() };
+}
+
 } // namespace MMS::http
\ No newline at end of file
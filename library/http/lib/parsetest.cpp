@@ -18,6 +18,9 @@
 #include <http/httpparser.h>
 #include <gtest/gtest.h>
 #include <mms/base/stream.h>
+#include <algorithm>
+#include <cctype>
+#include <ctime>
 
 bool http_request_parse(const MMS::FullStream &stream) {
     try {
@@ -64,6 +67,331 @@ TEST(HttpRequestParserTest, RequestTest) {
     ));
 }
 
+TEST(HttpRequestParserTest, RequestViewTest) {
+    const std::string text {
+        "POST /createaccount HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Accept: text/plain\r\n"
+        "Accept: application/json\r\n"
+        "Content-Length: 23\r\n\r\n"
+        "name=Rohit+Singh&age=47" };
+    const auto stream = MMS::make_const_fullstream(text.c_str(), text.size());
+    MMS::http::request_view view { stream };
+    EXPECT_EQ(view.GetMethod(), MMS::http::METHOD::POST);
+    EXPECT_EQ(view.GetPath(), "/createaccount");
+    EXPECT_EQ(view.GetVersion(), MMS::http::VERSION::VER_1_1);
+    EXPECT_EQ(view.GetField(MMS::http::FIELD::Host), "www.example.com");
+    EXPECT_EQ(view.GetField(MMS::http::FIELD::Accept), "application/json");
+    EXPECT_TRUE(view.GetField(MMS::http::FIELD::Cookie).empty());
+    EXPECT_EQ(view.GetBody(), "name=Rohit+Singh&age=47");
+    EXPECT_EQ(view.size(), 4);
+
+    // View must refer to parsed buffer without copy
+    EXPECT_EQ(view.GetPath().data(), text.data() + 5);
+
+    auto request = view.to_request();
+    EXPECT_EQ(request.GetMethod(), MMS::http::METHOD::POST);
+    EXPECT_EQ(request.GetPath(), "/createaccount");
+    EXPECT_EQ(request.GetField(MMS::http::FIELD::Accept), "application/json");
+    EXPECT_EQ(request.GetBody(), "name=Rohit+Singh&age=47");
+
+    std::string toomany { "GET / HTTP/1.1\r\n" };
+    for(size_t index { 0 }; index <= MMS::http::request_view::max_fields; ++index) {
+        toomany += MMS::http::to_string(static_cast<MMS::http::FIELD>(index));
+        toomany += ": value\r\n";
+    }
+    EXPECT_THROW(MMS::http::request_view { MMS::make_const_fullstream(toomany.c_str(), toomany.size()) }, MMS::http_parser_failed_t);
+    EXPECT_THROW(MMS::http::request_view { MMS::make_const_fullstream("FAIL / HTTP/1.1") }, MMS::http_parser_failed_t);
+}
+
+TEST(HttpRequestParserTest, RequestFramingTest) {
+    auto parse_message = [](MMS::http::request_view &view, const std::string_view text) {
+        return view.parse_message(reinterpret_cast<const uint8_t *>(text.data()), reinterpret_cast<const uint8_t *>(text.data() + text.size()));
+    };
+
+    // Pipelined requests, body is framed by Content-Length
+    const std::string first { "POST /api HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n\r\nhello" };
+    const std::string second { "GET /next HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n" };
+    const std::string pipelined { first + second };
+    std::string_view remaining { pipelined };
+    MMS::http::request_view view { };
+    EXPECT_EQ(parse_message(view, remaining), first.size());
+    EXPECT_EQ(view.GetBody(), "hello");
+    EXPECT_TRUE(view.keep_alive());
+    remaining.remove_prefix(first.size());
+    MMS::http::request_view next { };
+    EXPECT_EQ(parse_message(next, remaining), second.size());
+    EXPECT_EQ(next.GetPath(), "/next");
+    EXPECT_TRUE(next.GetBody().empty());
+    EXPECT_FALSE(next.keep_alive());
+
+    // Incomplete header or body
+    for(size_t size { 0 }; size < first.size(); ++size) {
+        MMS::http::request_view partial { };
+        EXPECT_EQ(parse_message(partial, std::string_view { first }.substr(0, size)), 0);
+    }
+
+    // Chunked body with extension and trailer, empty line before request is ignored
+    const std::string chunked {
+        "\r\nPOST /upload HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "Transfer-Encoding: gzip, Chunked\r\n"
+        "Connection: keep-alive, Close\r\n\r\n"
+        "5;name=value\r\nhello\r\n"
+        "7\r\n, world\r\n"
+        "0\r\n"
+        "Trailer-Field: value\r\n\r\n" };
+    MMS::http::request_view chunked_view { };
+    EXPECT_EQ(parse_message(chunked_view, chunked + "GET"), chunked.size());
+    EXPECT_EQ(chunked_view.GetBody(), "hello, world");
+    EXPECT_FALSE(chunked_view.keep_alive());
+    for(size_t size { 0 }; size < chunked.size(); ++size) {
+        MMS::http::request_view partial { };
+        EXPECT_EQ(parse_message(partial, std::string_view { chunked }.substr(0, size)), 0);
+    }
+
+    MMS::http::request_view invalid { };
+    EXPECT_THROW(parse_message(invalid, "GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n"), MMS::http_parser_failed_t);
+    EXPECT_THROW(parse_message(invalid, "GET / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n"), MMS::http_parser_failed_t);
+    EXPECT_THROW(parse_message(invalid, "GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n"), MMS::http_parser_failed_t);
+    // Differing Content-Length is rejected, same value repeated is accepted
+    EXPECT_THROW(parse_message(invalid, "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\nhello!"), MMS::http_parser_failed_t);
+    MMS::http::request_view repeated { };
+    EXPECT_EQ(parse_message(repeated, "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5\r\n\r\nhello"), 62);
+    EXPECT_EQ(repeated.GetBody(), "hello");
+    EXPECT_TRUE(repeated.keep_alive());
+
+    // Transfer-Encoding overrides Content-Length, connection is not kept alive
+    const std::string both { "POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n" };
+    MMS::http::request_view both_view { };
+    EXPECT_EQ(parse_message(both_view, both), both.size());
+    EXPECT_EQ(both_view.GetBody(), "hello");
+    EXPECT_FALSE(both_view.keep_alive());
+
+    EXPECT_EQ(parse_message(invalid, "GET / HTTP/1.1\r\n\r\n"), 18);
+    EXPECT_EQ(invalid.size(), 0);
+}
+
+TEST(HttpRequestParserTest, BodyDecoderTest) {
+    // Header is parsed before body is complete
+    const std::string head { "POST /upload HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n" };
+    const std::string body { "5;name=value\r\nhello\r\n7\r\n, world\r\n0\r\nTrailer-Field: value\r\n\r\n" };
+    const std::string request { head + body.substr(0, 10) };
+    MMS::http::request_view view { };
+    EXPECT_EQ(view.parse_message(reinterpret_cast<const uint8_t *>(request.data()), reinterpret_cast<const uint8_t *>(request.data() + request.size())), 0);
+    EXPECT_EQ(view.GetHeadSize(), head.size());
+    auto decoder = view.body_decoder();
+    EXPECT_TRUE(decoder.is_chunked());
+
+    // Body is given in every split, unconsumed input is kept by caller as partial line
+    for(size_t split { 1 }; split <= body.size(); ++split) {
+        MMS::http::body_decoder_t chunked { true, 0 };
+        std::string decoded { };
+        std::string input { };
+        for(size_t offset { 0 }; offset < body.size(); offset += split) {
+            input += body.substr(offset, split);
+            auto curr = reinterpret_cast<const uint8_t *>(input.data());
+            const auto end = curr + input.size();
+            std::string_view part { };
+            while(chunked.next(curr, end, part)) decoded += part;
+            input.erase(0, static_cast<size_t>(curr - reinterpret_cast<const uint8_t *>(input.data())));
+        }
+        EXPECT_TRUE(chunked.done());
+        EXPECT_TRUE(input.empty());
+        EXPECT_EQ(decoded, "hello, world");
+    }
+
+    // Content-Length body ends at length, next request is not consumed
+    const std::string content { "helloGET" };
+    MMS::http::body_decoder_t length { false, 5 };
+    auto curr = reinterpret_cast<const uint8_t *>(content.data());
+    std::string_view part { };
+    EXPECT_TRUE(length.next(curr, curr + 3, part));
+    EXPECT_EQ(part, "hel");
+    EXPECT_EQ(length.get_remaining(), 2);
+    EXPECT_TRUE(length.next(curr, reinterpret_cast<const uint8_t *>(content.data() + content.size()), part));
+    EXPECT_EQ(part, "lo");
+    EXPECT_TRUE(length.done());
+    EXPECT_FALSE(length.next(curr, reinterpret_cast<const uint8_t *>(content.data() + content.size()), part));
+    EXPECT_EQ(*curr, 'G');
+    EXPECT_TRUE(MMS::http::body_decoder_t { }.done());
+}
+
+TEST(HttpRequestParserTest, FieldsTest) {
+    using MMS::http::FIELD;
+    MMS::http::fields_t fields { };
+    EXPECT_TRUE(fields.add(FIELD::Host, "www.example.com"));
+    EXPECT_FALSE(fields.add(FIELD::Host, "ignored.example.com"));
+    EXPECT_TRUE(fields.add(FIELD::Path, "/index.html"));
+    EXPECT_TRUE(fields.add(FIELD::Method, "GET"));
+    fields.set(FIELD::Accept, "*/*");
+    fields.set(FIELD::Accept, "text/html");
+    EXPECT_EQ(fields.get(FIELD::Host), "www.example.com");
+    EXPECT_EQ(fields.get(FIELD::Accept), "text/html");
+    EXPECT_EQ(fields.get_method(), "GET");
+    EXPECT_EQ(fields.get_path(), "/index.html");
+    EXPECT_TRUE(fields.get(FIELD::Cookie).empty());
+    EXPECT_FALSE(fields.contains(FIELD::Cookie));
+    // Method and path are in dedicated slot
+    EXPECT_EQ(fields.size(), 2);
+
+    // Order is kept, spilled fields must remain same
+    const size_t count = MMS::http::fields_t::inline_count * 2;
+    const auto first = static_cast<size_t>(FIELD::Status) + 1;
+    MMS::http::fields_t many { };
+    for(size_t index { 0 }; index < count; ++index) {
+        many.add(static_cast<FIELD>(first + index), std::to_string(index));
+    }
+    EXPECT_EQ(many.size(), count);
+    size_t index { 0 };
+    for(auto [field, value]: many) {
+        EXPECT_EQ(field, static_cast<FIELD>(first + index));
+        EXPECT_EQ(value, std::to_string(index));
+        ++index;
+    }
+    EXPECT_EQ(index, count);
+    many.clear();
+    EXPECT_TRUE(many.empty());
+    EXPECT_FALSE(many.contains(FIELD::Path));
+
+    // Repeated field line replaces earlier one
+    auto request = MMS::http::request { MMS::make_const_fullstream(
+        "GET /repeat HTTP/1.1\r\n"
+        "Accept: */*\r\n"
+        "Accept: text/html\r\n"
+        "\r\n") };
+    EXPECT_EQ(request.GetMethod(), MMS::http::METHOD::GET);
+    EXPECT_EQ(request.GetMethodStr(), "GET");
+    EXPECT_EQ(request.GetPathBase(), "/repeat");
+    EXPECT_EQ(request.GetField(FIELD::Accept), "text/html");
+}
+
+TEST(HttpResponseParserTest, ErrorPageTest) {
+    using MMS::http::error_page_t;
+    using MMS::http::CODE;
+    const error_page_t error_page { "MicroMonolithServer" };
+    EXPECT_EQ(error_page_t::GetType("text/html,application/json"), error_page_t::type_t::HTML);
+    EXPECT_EQ(error_page_t::GetType("application/json"), error_page_t::type_t::JSON);
+    EXPECT_EQ(error_page_t::GetType(""), error_page_t::type_t::HTML);
+
+    const std::string html = error_page.to_string(error_page_t::type_t::HTML, CODE::Not_Found, "Path /missing not found");
+    EXPECT_EQ(html,
+        "<html><head><title>Not Found</title></head><h1>MicroMonolithServer</h1>"
+        "<h2>Not Found</h2><pre>Path /missing not found</pre></html>");
+    EXPECT_EQ(error_page.GetSize(error_page_t::type_t::HTML, CODE::Not_Found, "Path /missing not found"), html.size());
+
+    const std::string json = error_page.to_string(error_page_t::type_t::JSON, CODE::Method_Not_Allowed, "PUT");
+    EXPECT_EQ(json, "{\"error\": \"Method Not Allowed\", \"details\": \"PUT\"}");
+
+    auto response = MMS::http::response::CreateErrorResponse(CODE::Not_Found, "Path /missing not found", "MicroMonolithServer");
+    EXPECT_EQ(response.GetBody(), html);
+    EXPECT_EQ(response.GetField(MMS::http::FIELD::Content_Length), std::to_string(html.size()));
+    auto text = response.to_string();
+    EXPECT_TRUE(text.starts_with("HTTP/1.1 404 Not Found\r\n"));
+    EXPECT_TRUE(text.ends_with("\r\n\r\n" + html));
+}
+
+TEST(HttpDefTest, DateTest) {
+    auto format_date = [] {
+        char date_str[64];
+        const std::time_t now = std::time(nullptr);
+        std::tm now_tm { };
+        gmtime_r(&now, &now_tm);
+        return std::string { date_str, strftime(date_str, sizeof(date_str), "%a, %d %b %Y %H:%M:%S GMT", &now_tm) };
+    };
+
+    // Second may change while test runs
+    const auto before = format_date();
+    const std::string date { MMS::http::GetDate() };
+    const auto after = format_date();
+    EXPECT_TRUE(date == before || date == after) << date;
+    EXPECT_EQ(date.size(), 29);
+
+    const auto dateline = MMS::http::GetDateLine();
+    EXPECT_TRUE(dateline.starts_with("Date: "));
+    EXPECT_TRUE(dateline.ends_with(" GMT\r\n"));
+    EXPECT_EQ(dateline.size(), 37);
+}
+
+TEST(HttpScanTest, FindDelimitersTest) {
+    std::string text { };
+    for(size_t index { 0 }; index < 1000; ++index) {
+        text += static_cast<char>((index * 37 + index / 7) % 128);
+    }
+    text += "GET /index.html HTTP/1.1\r\nHost: www.example.com\r\n\r\n";
+
+    std::vector<uint32_t> expected(text.size());
+    expected.resize(MMS::http::scan::find_delimiters_scalar(reinterpret_cast<const uint8_t *>(text.data()), text.size(), 10, expected.data()));
+    for(auto position: expected) {
+        auto ch = text[position - 10];
+        EXPECT_TRUE(ch == ' ' || ch == ':' || ch == '\r' || ch == '\n');
+    }
+    const auto count = std::ranges::count_if(text, [](auto ch) { return ch == ' ' || ch == ':' || ch == '\r' || ch == '\n'; });
+    EXPECT_EQ(static_cast<size_t>(count), expected.size());
+
+    std::vector<std::pair<MMS::http::scan::find_delimiters_t, bool>> kernels {
+        { MMS::http::scan::find_delimiters, true },
+#if defined(__x86_64__)
+        { MMS::http::scan::find_delimiters_sse42, __builtin_cpu_supports("sse4.2") != 0 },
+        { MMS::http::scan::find_delimiters_avx2, __builtin_cpu_supports("avx2") != 0 },
+#endif
+    };
+    for(auto [kernel, supported]: kernels) {
+        if (!supported) continue;
+        std::vector<uint32_t> positions(text.size());
+        positions.resize(kernel(reinterpret_cast<const uint8_t *>(text.data()), text.size(), 10, positions.data()));
+        EXPECT_EQ(positions, expected);
+    }
+}
+
+TEST(HttpScanTest, DelimiterIndexTest) {
+    // Long value crosses index block
+    const std::string value(700, 'a');
+    const std::string text { "X-Forwarded-For: " + value + " \r\nHost: www.example.com\r\n" };
+    auto begin = reinterpret_cast<const uint8_t *>(text.data());
+    MMS::http::scan::delimiter_index_t index { begin, begin + text.size() };
+    auto pos = index.next_of<':'>(begin);
+    EXPECT_EQ(pos - begin, 15);
+    pos = index.next_of<'\r', '\n'>(pos + 1);
+    EXPECT_EQ(pos - begin, 17 + 701);
+    pos = index.next_of<':'>(pos);
+    EXPECT_EQ(pos - begin, 17 + 703 + 4);
+    EXPECT_EQ(index.next_of<'\r'>(pos + 1), begin + text.size() - 2);
+    EXPECT_EQ(index.next_of<':'>(pos + 1), begin + text.size());
+
+    const std::string request { "GET / HTTP/1.1\r\nX-Forwarded-For:   " + value + "  \r\nHost: www.example.com\r\n" };
+    MMS::http::request_view view { MMS::make_const_fullstream(request.c_str(), request.size()) };
+    EXPECT_EQ(view.GetField(MMS::http::FIELD::X_Forwarded_For), value);
+    EXPECT_EQ(view.GetField(MMS::http::FIELD::Host), "www.example.com");
+}
+
+TEST(HttpDefTest, LookupTest) {
+    for(size_t index { 0 }; index < MMS::http::field_count; ++index) {
+        const auto field = static_cast<MMS::http::FIELD>(index);
+        auto name = MMS::http::to_string(field);
+        EXPECT_EQ(MMS::http::to_field(name), field) << name;
+        std::ranges::transform(name, std::begin(name), [](unsigned char ch) { return std::tolower(ch); });
+        EXPECT_EQ(MMS::http::to_field(name), field) << name;
+        std::ranges::transform(name, std::begin(name), [](unsigned char ch) { return std::toupper(ch); });
+        EXPECT_EQ(MMS::http::to_field(name), field) << name;
+    }
+    EXPECT_EQ(MMS::http::to_field("X-Unknown-Field"), MMS::http::FIELD::IGNORE_THIS);
+    EXPECT_EQ(MMS::http::to_field(""), MMS::http::FIELD::IGNORE_THIS);
+    EXPECT_EQ(MMS::http::to_field("Hostx"), MMS::http::FIELD::IGNORE_THIS);
+
+    EXPECT_EQ(MMS::http::to_method("GET"), MMS::http::METHOD::GET);
+    EXPECT_EQ(MMS::http::to_method("OPTIONS"), MMS::http::METHOD::OPTIONS);
+    EXPECT_EQ(MMS::http::to_method("get"), MMS::http::METHOD::IGNORE_THIS);
+    EXPECT_EQ(MMS::http::to_method("GETS"), MMS::http::METHOD::IGNORE_THIS);
+
+    EXPECT_EQ(MMS::http::to_code_map("200"), MMS::http::CODE::OK);
+    EXPECT_EQ(MMS::http::to_code_map("404"), MMS::http::CODE::Not_Found);
+    EXPECT_EQ(MMS::http::to_code_map("299"), MMS::http::CODE::_0);
+    EXPECT_EQ(MMS::http::to_code_map("2000"), MMS::http::CODE::_0);
+    EXPECT_EQ(MMS::http::to_code_map("2a0"), MMS::http::CODE::_0);
+}
+
 TEST(HttpResponseParserTest, ResponseLineTest) {
     EXPECT_TRUE(http_response_parse(MMS::make_const_fullstream("HTTP/1.1 200 OK")));
     EXPECT_FALSE(http_response_parse(MMS::make_const_fullstream("GET /echotest HTTP/1.1")));
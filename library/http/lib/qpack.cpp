@@ -26,4 +26,428 @@ const static_table_t static_table = {
 #undef QPACK_STATIC_TABLE_ENTRY
 };
 
-} // namespace MMS::http::qpack
\ No newline at end of file
+namespace {
+
+// Instruction and field line are checked for completeness before decoding.
+// Instruction stream may split anywhere, false means more data is required.
+template <uint32_t N>
+bool has_integer(const Stream &stream) {
+    if (stream.full()) return false;
+    constexpr uint8_t mask { (1 << N) - 1 };
+    if ((*stream & mask) < mask) return true;
+    for(auto curr = stream.curr() + 1; curr < stream.end(); ++curr) {
+        if ((*curr & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+template <uint32_t N>
+bool read_integer(const Stream &stream, uint64_t &value) {
+    if (!has_integer<N>(stream)) return false;
+    value = hpack::decode_integer<N>(stream);
+    return true;
+}
+
+//! N must include H
+template <uint32_t N>
+bool read_string(const Stream &stream, std::string &value) {
+    if (!has_integer<N - 1>(stream)) return false;
+    auto peek = make_const_stream(stream.curr(), stream.remaining_buffer());
+    const size_t len = hpack::decode_integer<N - 1>(peek);
+    if (peek.remaining_buffer() < len) return false;
+    value = hpack::get_header_string<N>(stream);
+    return true;
+}
+
+inline void check_section(const bool valid) {
+    if (!valid) throw QPACKException { err_t::QPACK_DECOMPRESSION_FAILED };
+}
+
+} // namespace
+
+uint64_t DecodeRequiredInsertCount(const uint64_t encoded_insert_count, const uint64_t max_entries, const uint64_t total_inserts) {
+    if (encoded_insert_count == 0) return 0;
+    const uint64_t full_range = 2 * max_entries;
+    if (encoded_insert_count > full_range) throw QPACKException { err_t::QPACK_DECOMPRESSION_FAILED };
+
+    const uint64_t max_value = total_inserts + max_entries;
+    const uint64_t max_wrapped = (max_value / full_range) * full_range;
+    uint64_t required_insert_count = max_wrapped + encoded_insert_count - 1;
+    if (required_insert_count > max_value) {
+        if (required_insert_count <= full_range) throw QPACKException { err_t::QPACK_DECOMPRESSION_FAILED };
+        required_insert_count -= full_range;
+    }
+    if (required_insert_count == 0) throw QPACKException { err_t::QPACK_DECOMPRESSION_FAILED };
+    return required_insert_count;
+}
+
+size_t encoder_t::GetBlockedStreams() const {
+    size_t blocked_streams { 0 };
+    for(auto &stream_sections: outstanding) {
+        if (IsStreamBlocked(stream_sections.first)) ++blocked_streams;
+    }
+    return blocked_streams;
+}
+
+bool encoder_t::IsStreamBlocked(const uint64_t stream_id) const {
+    auto itr = outstanding.find(stream_id);
+    if (itr == outstanding.end()) return false;
+    return std::ranges::any_of(itr->second, [&](const auto &section) { return section.required_insert_count > known_received_count; });
+}
+
+uint64_t encoder_t::GetMinReference() const {
+    uint64_t min_reference = std::numeric_limits<uint64_t>::max();
+    for(auto &stream_sections: outstanding) {
+        for(auto &section: stream_sections.second) {
+            min_reference = std::min(min_reference, section.min_reference);
+        }
+    }
+    return min_reference;
+}
+
+void encoder_t::Encode(const uint64_t stream_id, const std::vector<std::pair<FIELD, std::string>> &fields, Stream &field_section, Stream &encoder_stream) {
+    enum class line_type_t {
+        Static,
+        Dynamic,
+        StaticName,
+        DynamicName,
+        Literal
+    };
+
+    struct line_t {
+        line_type_t type;
+        uint64_t index;
+        const std::pair<FIELD, std::string> *header_line;
+    };
+
+    // First pass decide representation and update dynamic table,
+    // prefix depends on entries referenced hence lines are written later.
+    std::vector<line_t> lines { };
+    lines.reserve(fields.size());
+
+    const bool can_block = IsStreamBlocked(stream_id) || GetBlockedStreams() < max_blocked_streams;
+    const uint64_t outstanding_min_reference = GetMinReference();
+    uint64_t min_reference = std::numeric_limits<uint64_t>::max();
+    uint64_t required_insert_count { 0 };
+
+    auto reference = [&](const uint64_t index) {
+        if (index >= known_received_count && !can_block) return false;
+        min_reference = std::min(min_reference, index);
+        required_insert_count = std::max(required_insert_count, index + 1);
+        return true;
+    };
+
+    for(auto &header_line: fields) {
+        if (header_line.first == FIELD::IGNORE_THIS) continue;
+
+        const size_t static_index = static_table[header_line];
+        if (static_index != static_cast<size_t>(-1)) {
+            lines.push_back({line_type_t::Static, static_index, &header_line});
+            continue;
+        }
+
+        const uint64_t dynamic_index = dynamic_table.find(header_line);
+        if (dynamic_index != static_cast<uint64_t>(-1) && reference(dynamic_index)) {
+            lines.push_back({line_type_t::Dynamic, dynamic_index, &header_line});
+            continue;
+        }
+
+        const size_t static_name_index = static_table[header_line.first];
+        if (preferred_capacity && !IsNeverIndexed(header_line.first)) {
+            const auto name = hpack::to_wire_name(header_line.first);
+            const size_t new_size = entry_size(name.size(), header_line.second.size());
+            // Large value would evict most of table for single entry
+            if (new_size * 4 <= preferred_capacity) {
+                if (dynamic_table.GetCapacity() != preferred_capacity) {
+                    // https://www.rfc-editor.org/rfc/rfc9204.html#name-set-dynamic-table-capacity
+                    hpack::encode_integer<5>(encoder_stream, 0x20, preferred_capacity);
+                    dynamic_table.SetCapacity(preferred_capacity);
+                }
+
+                if (dynamic_table.CanInsert(new_size, std::min(outstanding_min_reference, min_reference))) {
+                    if (static_name_index != static_cast<size_t>(-1)) {
+                        // https://www.rfc-editor.org/rfc/rfc9204.html#name-insert-with-name-reference
+                        hpack::encode_integer<6>(encoder_stream, 0xc0, static_name_index);
+                    } else {
+                        // https://www.rfc-editor.org/rfc/rfc9204.html#name-insert-with-literal-name
+                        hpack::add_header_string<6>(encoder_stream, 0x40, name);
+                    }
+                    hpack::add_header_string<8>(encoder_stream, 0x00, header_line.second);
+
+                    const uint64_t index = dynamic_table.insert(header_line, name.size());
+                    if (reference(index)) {
+                        lines.push_back({line_type_t::Dynamic, index, &header_line});
+                        continue;
+                    }
+                }
+            }
+        }
+
+        if (static_name_index != static_cast<size_t>(-1)) {
+            lines.push_back({line_type_t::StaticName, static_name_index, &header_line});
+            continue;
+        }
+
+        const uint64_t dynamic_name_index = dynamic_table.find(header_line.first);
+        if (dynamic_name_index != static_cast<uint64_t>(-1) && reference(dynamic_name_index)) {
+            lines.push_back({line_type_t::DynamicName, dynamic_name_index, &header_line});
+            continue;
+        }
+
+        lines.push_back({line_type_t::Literal, 0, &header_line});
+    }
+
+    // https://www.rfc-editor.org/rfc/rfc9204.html#name-encoded-field-section-prefi
+    // Base is insert count hence post-base index is never required and S is 0
+    const uint64_t base = required_insert_count ? dynamic_table.GetInsertCount() : 0;
+    hpack::encode_integer<8>(field_section, 0x00, EncodeRequiredInsertCount(required_insert_count, dynamic_table.GetMaxEntries()));
+    hpack::encode_integer<7>(field_section, 0x00, base - required_insert_count);
+
+    for(auto &line: lines) {
+        switch(line.type) {
+        case line_type_t::Static:
+            hpack::encode_integer<6>(field_section, 0xc0, line.index);
+            break;
+
+        case line_type_t::Dynamic:
+            hpack::encode_integer<6>(field_section, 0x80, base - 1 - line.index);
+            break;
+
+        case line_type_t::StaticName:
+            hpack::encode_integer<4>(field_section, 0x50, line.index);
+            hpack::add_header_string<8>(field_section, 0x00, line.header_line->second, &huffman_cache);
+            break;
+
+        case line_type_t::DynamicName:
+            hpack::encode_integer<4>(field_section, 0x40, base - 1 - line.index);
+            hpack::add_header_string<8>(field_section, 0x00, line.header_line->second, &huffman_cache);
+            break;
+
+        case line_type_t::Literal:
+            hpack::add_header_string<4>(field_section, 0x20, hpack::to_wire_name(line.header_line->first), &huffman_cache);
+            hpack::add_header_string<8>(field_section, 0x00, line.header_line->second, &huffman_cache);
+            break;
+        }
+    }
+
+    if (required_insert_count) {
+        outstanding[stream_id].push_back({required_insert_count, min_reference});
+    }
+}
+
+void encoder_t::ProcessDecoderInstructions(const Stream &input) {
+    pending_instructions.append(reinterpret_cast<const char *>(input.curr()), input.remaining_buffer());
+    input += input.remaining_buffer();
+
+    auto stream = make_const_stream(pending_instructions);
+    const auto start = stream.curr();
+    size_t consumed { 0 };
+    try {
+        while(!stream.full()) {
+            const uint8_t head = *stream;
+            uint64_t value;
+            if (head & 0x80) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-section-acknowledgment
+                if (!read_integer<7>(stream, value)) break;
+                auto itr = outstanding.find(value);
+                if (itr == outstanding.end()) throw QPACKException { err_t::QPACK_DECODER_STREAM_ERROR };
+                known_received_count = std::max(known_received_count, itr->second.front().required_insert_count);
+                itr->second.pop_front();
+                if (itr->second.empty()) outstanding.erase(itr);
+            } else if (head & 0x40) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-stream-cancellation
+                if (!read_integer<6>(stream, value)) break;
+                outstanding.erase(value);
+            } else {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-insert-count-increment
+                if (!read_integer<6>(stream, value)) break;
+                if (value == 0 || known_received_count + value > dynamic_table.GetInsertCount()) {
+                    throw QPACKException { err_t::QPACK_DECODER_STREAM_ERROR };
+                }
+                known_received_count += value;
+            }
+            consumed = stream.GetSizeFrom(start);
+        }
+    } catch(const HPACKException &) {
+        throw QPACKException { err_t::QPACK_DECODER_STREAM_ERROR };
+    }
+    pending_instructions.erase(0, consumed);
+}
+
+void decoder_t::Decode(const Stream &section, const uint64_t required_insert_count, const uint64_t base, const add_field_t &add_field) const {
+    auto relative = [&](const uint64_t index) {
+        check_section(index < base);
+        const uint64_t absolute = base - 1 - index;
+        check_section(absolute < required_insert_count);
+        return absolute;
+    };
+
+    auto post_base = [&](const uint64_t index) {
+        const uint64_t absolute = base + index;
+        check_section(absolute < required_insert_count);
+        return absolute;
+    };
+
+    try {
+        while(!section.full()) {
+            const uint8_t head = *section;
+            uint64_t index;
+            std::string value { };
+            if (head & 0x80) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-indexed-field-line
+                check_section(read_integer<6>(section, index));
+                add_field((head & 0x40) ? static_table[index] : dynamic_table[relative(index)]);
+            } else if (head & 0x40) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-literal-field-line-with-nam
+                check_section(read_integer<4>(section, index) && read_string<8>(section, value));
+                const auto &name = (head & 0x10) ? static_table[index] : dynamic_table[relative(index)];
+                add_field(std::make_pair(name.first, std::move(value)));
+            } else if (head & 0x20) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-literal-field-line-with-lit
+                std::string name { };
+                check_section(read_string<4>(section, name) && read_string<8>(section, value));
+                add_field(std::make_pair(hpack::wire_to_field(name), std::move(value)));
+            } else if (head & 0x10) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-indexed-field-line-with-pos
+                check_section(read_integer<4>(section, index));
+                add_field(dynamic_table[post_base(index)]);
+            } else {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-literal-field-line-with-pos
+                check_section(read_integer<3>(section, index) && read_string<8>(section, value));
+                add_field(std::make_pair(dynamic_table[post_base(index)].first, std::move(value)));
+            }
+        }
+    } catch(const HPACKException &) {
+        throw QPACKException { err_t::QPACK_DECOMPRESSION_FAILED };
+    }
+}
+
+void decoder_t::Acknowledge(const uint64_t stream_id, const uint64_t required_insert_count, Stream &decoder_stream) {
+    // Section without dynamic reference is not acknowledged
+    if (required_insert_count == 0) return;
+    // https://www.rfc-editor.org/rfc/rfc9204.html#name-section-acknowledgment
+    hpack::encode_integer<7>(decoder_stream, 0x80, stream_id);
+    acknowledged_count = std::max(acknowledged_count, required_insert_count);
+}
+
+void decoder_t::UnblockSections(Stream &decoder_stream) {
+    for(auto itr = blocked_sections.begin(); itr != blocked_sections.end(); ) {
+        if (itr->required_insert_count > dynamic_table.GetInsertCount()) {
+            ++itr;
+            continue;
+        }
+        Decode(make_const_stream(itr->section), itr->required_insert_count, itr->base, itr->add_field);
+        Acknowledge(itr->stream_id, itr->required_insert_count, decoder_stream);
+        itr = blocked_sections.erase(itr);
+    }
+}
+
+void decoder_t::ProcessEncoderInstructions(const Stream &input, Stream &decoder_stream) {
+    pending_instructions.append(reinterpret_cast<const char *>(input.curr()), input.remaining_buffer());
+    input += input.remaining_buffer();
+
+    auto dynamic_index = [&](const uint64_t index) {
+        if (index >= dynamic_table.GetInsertCount()) throw QPACKException { err_t::QPACK_ENCODER_STREAM_ERROR };
+        const uint64_t absolute = dynamic_table.GetInsertCount() - 1 - index;
+        if (!dynamic_table.contains(absolute)) throw QPACKException { err_t::QPACK_ENCODER_STREAM_ERROR };
+        return absolute;
+    };
+
+    auto stream = make_const_stream(pending_instructions);
+    const auto start = stream.curr();
+    size_t consumed { 0 };
+    try {
+        while(!stream.full()) {
+            const uint8_t head = *stream;
+            uint64_t index;
+            std::string value { };
+            if (head & 0x80) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-insert-with-name-reference
+                if (!read_integer<6>(stream, index) || !read_string<8>(stream, value)) break;
+                if (head & 0x40) {
+                    const auto field = static_table[index].first;
+                    dynamic_table.insert(std::make_pair(field, std::move(value)), hpack::to_wire_name(field).size());
+                } else {
+                    const uint64_t absolute = dynamic_index(index);
+                    const size_t name_size = dynamic_table.GetNameSize(absolute);
+                    dynamic_table.insert(std::make_pair(dynamic_table[absolute].first, std::move(value)), name_size);
+                }
+            } else if (head & 0x40) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-insert-with-literal-name
+                std::string name { };
+                if (!read_string<6>(stream, name) || !read_string<8>(stream, value)) break;
+                dynamic_table.insert(std::make_pair(hpack::wire_to_field(name), std::move(value)), name.size());
+            } else if (head & 0x20) {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-set-dynamic-table-capacity
+                if (!read_integer<5>(stream, index)) break;
+                dynamic_table.SetCapacity(index);
+            } else {
+                // https://www.rfc-editor.org/rfc/rfc9204.html#name-duplicate
+                if (!read_integer<5>(stream, index)) break;
+                const uint64_t absolute = dynamic_index(index);
+                const auto header_line = dynamic_table[absolute];
+                dynamic_table.insert(header_line, dynamic_table.GetNameSize(absolute));
+            }
+            consumed = stream.GetSizeFrom(start);
+        }
+    } catch(const HPACKException &) {
+        throw QPACKException { err_t::QPACK_ENCODER_STREAM_ERROR };
+    }
+    pending_instructions.erase(0, consumed);
+
+    UnblockSections(decoder_stream);
+
+    if (dynamic_table.GetInsertCount() > acknowledged_count) {
+        // https://www.rfc-editor.org/rfc/rfc9204.html#name-insert-count-increment
+        hpack::encode_integer<6>(decoder_stream, 0x00, dynamic_table.GetInsertCount() - acknowledged_count);
+        acknowledged_count = dynamic_table.GetInsertCount();
+    }
+}
+
+decoder_t::status_t decoder_t::DecodeFieldSection(const uint64_t stream_id, const Stream &section, Stream &decoder_stream, const add_field_t &add_field) {
+    // https://www.rfc-editor.org/rfc/rfc9204.html#name-encoded-field-section-prefi
+    uint64_t encoded_insert_count;
+    uint64_t delta_base;
+    try {
+        check_section(read_integer<8>(section, encoded_insert_count));
+        check_section(!section.full());
+        const bool S = *section & 0x80;
+        check_section(read_integer<7>(section, delta_base));
+
+        const uint64_t required_insert_count = DecodeRequiredInsertCount(encoded_insert_count, dynamic_table.GetMaxEntries(), dynamic_table.GetInsertCount());
+        uint64_t base;
+        if (S) {
+            check_section(delta_base < required_insert_count);
+            base = required_insert_count - delta_base - 1;
+        } else {
+            base = required_insert_count + delta_base;
+        }
+
+        if (required_insert_count > dynamic_table.GetInsertCount()) {
+            // https://www.rfc-editor.org/rfc/rfc9204.html#name-blocked-streams
+            check_section(blocked_sections.size() < max_blocked_streams);
+            blocked_sections.push_back({
+                stream_id, required_insert_count, base,
+                std::string { reinterpret_cast<const char *>(section.curr()), section.remaining_buffer() },
+                add_field
+            });
+            section += section.remaining_buffer();
+            return status_t::Blocked;
+        }
+
+        Decode(section, required_insert_count, base, add_field);
+        Acknowledge(stream_id, required_insert_count, decoder_stream);
+    } catch(const HPACKException &) {
+        throw QPACKException { err_t::QPACK_DECOMPRESSION_FAILED };
+    }
+    return status_t::Decoded;
+}
+
+void decoder_t::CancelStream(const uint64_t stream_id, Stream &decoder_stream) {
+    std::erase_if(blocked_sections, [&](const auto &blocked_section) { return blocked_section.stream_id == stream_id; });
+    // Decoder without dynamic table need not inform encoder
+    if (dynamic_table.GetMaxCapacity() == 0) return;
+    hpack::encode_integer<6>(decoder_stream, 0x40, stream_id);
+}
+
+} // namespace MMS::http::qpack
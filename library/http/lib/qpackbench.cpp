@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <http/qpack.h>
+#include <benchmark/benchmark.h>
+
+namespace qpack = MMS::http::qpack;
+using MMS::http::FIELD;
+
+using fields_t = std::vector<std::pair<FIELD, std::string>>;
+
+// Browser like request for a page resource
+const fields_t request_fields {
+    {FIELD::Method, "GET"},
+    {FIELD::Scheme, "https"},
+    {FIELD::Authority, "www.example.com"},
+    {FIELD::Path, "/static/js/application.bundle.js"},
+    {FIELD::User_Agent, "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36"},
+    {FIELD::Accept, "*/*"},
+    {FIELD::Accept_Encoding, "gzip, deflate, br"},
+    {FIELD::Accept_Language, "en-US,en;q=0.9"},
+    {FIELD::Referer, "https://www.example.com/index.html"},
+    {FIELD::Cookie, "session=4f2a9c1e7b3d; theme=dark"},
+};
+
+const fields_t response_fields {
+    {FIELD::Status, "200"},
+    {FIELD::Date, "Mon, 21 Oct 2024 07:28:00 GMT"},
+    {FIELD::Server, "MicroMonolithServer"},
+    {FIELD::Content_Type, "application/javascript"},
+    {FIELD::Content_Length, "48213"},
+    {FIELD::Cache_Control, "max-age=604800"},
+    {FIELD::ETag, "\"5e1f-63b2a1c4\""},
+    {FIELD::Last_Modified, "Sun, 20 Oct 2024 11:02:51 GMT"},
+    {FIELD::Vary, "accept-encoding"},
+};
+
+struct bench_peer_t {
+    qpack::encoder_t encoder;
+    qpack::decoder_t decoder;
+    MMS::FullStreamAutoAlloc section { 1024 };
+    MMS::FullStreamAutoAlloc encoder_stream { 1024 };
+    MMS::FullStreamAutoAlloc decoder_stream { 1024 };
+    uint64_t stream_id { 0 };
+
+    // Zero capacity makes static table only mode
+    bench_peer_t(size_t capacity) : encoder { capacity, 100 }, decoder { capacity, 100 } { }
+
+    void Encode(const fields_t &fields) {
+        section.Reset();
+        encoder_stream.Reset();
+        encoder.Encode(stream_id, fields, section, encoder_stream);
+    }
+
+    size_t Decode() {
+        size_t count { 0 };
+        decoder_stream.Reset();
+        decoder.ProcessEncoderInstructions(MMS::make_const_stream(encoder_stream.begin(), encoder_stream.index()), decoder_stream);
+        decoder.DecodeFieldSection(stream_id, MMS::make_const_stream(section.begin(), section.index()), decoder_stream, [&](const auto &) { ++count; });
+        encoder.ProcessDecoderInstructions(MMS::make_const_stream(decoder_stream.begin(), decoder_stream.index()));
+        stream_id += 4;
+        return count;
+    }
+};
+
+static void BM_QPACKEncode(benchmark::State &state, const fields_t &fields) {
+    bench_peer_t peer { static_cast<size_t>(state.range(0)) };
+    size_t bytes { 0 };
+    for (auto _ : state) {
+        peer.Encode(fields);
+        bytes += peer.section.index();
+        state.PauseTiming();
+        peer.Decode();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["section_bytes"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_QPACKEncode, request, request_fields)->Arg(0)->Arg(4096);
+BENCHMARK_CAPTURE(BM_QPACKEncode, response, response_fields)->Arg(0)->Arg(4096);
+
+static void BM_QPACKDecode(benchmark::State &state, const fields_t &fields) {
+    bench_peer_t peer { static_cast<size_t>(state.range(0)) };
+    for (auto _ : state) {
+        state.PauseTiming();
+        peer.Encode(fields);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(peer.Decode());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_QPACKDecode, request, request_fields)->Arg(0)->Arg(4096);
+BENCHMARK_CAPTURE(BM_QPACKDecode, response, response_fields)->Arg(0)->Arg(4096);
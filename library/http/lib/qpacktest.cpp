@@ -0,0 +1,304 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <http/qpack.h>
+#include <gtest/gtest.h>
+#include <mms/base/stream.h>
+
+namespace qpack = MMS::http::qpack;
+namespace hpack = MMS::http::hpack;
+using MMS::http::FIELD;
+
+using fields_t = std::vector<std::pair<FIELD, std::string>>;
+
+const fields_t request_fields {
+    {FIELD::Method, "GET"},
+    {FIELD::Scheme, "https"},
+    {FIELD::Authority, "www.example.com"},
+    {FIELD::Path, "/sample/path"},
+    {FIELD::User_Agent, "Mozilla/5.0 (X11; Linux x86_64)"},
+    {FIELD::Accept, "*/*"},
+    {FIELD::Accept_Language, "en-US,en;q=0.9"},
+};
+
+inline auto to_const_stream(const MMS::FullStream &stream) {
+    return MMS::make_const_stream(stream.begin(), stream.index());
+}
+
+inline auto to_const_stream(const std::vector<uint8_t> &data) {
+    return MMS::make_const_stream(data.data(), data.size());
+}
+
+TEST(HPACKCodingTest, Integer) {
+    // https://www.rfc-editor.org/rfc/rfc7541.html#appendix-C.1
+    MMS::FullStreamAutoAlloc stream { 16 };
+    hpack::encode_integer<5>(stream, 0x00, 1337u);
+    EXPECT_EQ(stream.index(), 3);
+    EXPECT_EQ(stream.begin()[0], 0x1f);
+    EXPECT_EQ(stream.begin()[1], 0x9a);
+    EXPECT_EQ(stream.begin()[2], 0x0a);
+
+    auto input = to_const_stream(stream);
+    EXPECT_EQ(hpack::decode_integer<5>(input), 1337);
+    EXPECT_TRUE(input.full());
+
+    const std::vector<uint8_t> truncated { 0x1f, 0x9a };
+    EXPECT_THROW(hpack::decode_integer<5>(to_const_stream(truncated)), MMS::HPACKException);
+}
+
+TEST(HPACKCodingTest, HuffmanString) {
+    // https://www.rfc-editor.org/rfc/rfc7541.html#appendix-C.4.1
+    const std::vector<uint8_t> expected { 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff };
+    MMS::FullStreamAutoAlloc stream { 4 };
+    hpack::add_header_string<8>(stream, 0x00, "www.example.com");
+    EXPECT_EQ(stream.index(), expected.size());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), stream.begin()));
+
+    auto input = to_const_stream(stream);
+    EXPECT_EQ(hpack::get_header_string<8>(input), "www.example.com");
+    EXPECT_TRUE(input.full());
+}
+
+TEST(HPACKCodingTest, HuffmanDecode) {
+    // Every octet round trip
+    std::string all { };
+    for(int ch { 0 }; ch < 256; ++ch) all.push_back(static_cast<char>(ch));
+    MMS::FullStreamAutoAlloc stream { 4 };
+    stream.Reserve(hpack::huffman_string_size(MMS::make_const_stream(all.data(), all.size())) + 1);
+    hpack::add_huffman_string(stream, MMS::make_const_stream(all.data(), all.size()));
+    EXPECT_EQ(hpack::get_huffman_string(to_const_stream(stream)), all);
+
+    // Padding must be at most 7 bits of EOS prefix https://www.rfc-editor.org/rfc/rfc7541.html#section-5.2
+    const std::vector<uint8_t> padded { 0x1f };
+    EXPECT_EQ(hpack::get_huffman_string(to_const_stream(padded)), "a");
+    EXPECT_EQ(hpack::get_huffman_string(MMS::make_const_stream(padded.data(), size_t { 0 })), "");
+    const std::vector<uint8_t> zero_padding { 0x18 };
+    EXPECT_THROW(hpack::get_huffman_string(to_const_stream(zero_padding)), MMS::HPACKException);
+    const std::vector<uint8_t> long_padding { 0x1f, 0xff };
+    EXPECT_THROW(hpack::get_huffman_string(to_const_stream(long_padding)), MMS::HPACKException);
+    const std::vector<uint8_t> eos { 0xff, 0xff, 0xff, 0xff };
+    EXPECT_THROW(hpack::get_huffman_string(to_const_stream(eos)), MMS::HPACKException);
+}
+
+TEST(HPACKCodingTest, HuffmanEncode) {
+    // Encoded size is same as bit count and string is encoded only if it is smaller
+    for(const std::string value: { "www.example.com", "no-cache", "custom-value", "\"5e1f-63b2a1c4\"", "a", "" }) {
+        const auto encoded = hpack::encode_huffman(value);
+        const auto size = hpack::huffman_string_size(MMS::make_const_stream(value.data(), value.size()));
+        EXPECT_EQ(encoded.size(), size < value.size() ? size : 0);
+        if (!encoded.empty()) {
+            EXPECT_EQ(hpack::get_huffman_string(MMS::make_const_stream(encoded.data(), encoded.size())), value);
+        }
+    }
+
+    // Control characters are 28 bits, encoding stops at limit
+    const std::string control(16, '\x01');
+    EXPECT_TRUE(hpack::encode_huffman(control).empty());
+    std::vector<uint8_t> output(4 + hpack::huffman_encode_slack);
+    auto begin = reinterpret_cast<const uint8_t *>(control.data());
+    EXPECT_EQ(hpack::encode_huffman(begin, begin + control.size(), output.data(), 4), 4);
+
+    // Cache gives same encoding, colliding value replaces entry
+    hpack::huffman_cache_t cache { };
+    EXPECT_EQ(cache.get("www.example.com").encoded, hpack::encode_huffman("www.example.com"));
+    EXPECT_EQ(cache.get("www.example.com").value, "www.example.com");
+    EXPECT_TRUE(cache.get(control).encoded.empty());
+    MMS::FullStreamAutoAlloc stream { 4 };
+    hpack::add_header_string<8>(stream, 0x00, "www.example.com", &cache);
+    auto input = to_const_stream(stream);
+    EXPECT_EQ(*input, 0x8c);
+    EXPECT_EQ(hpack::get_header_string<8>(input), "www.example.com");
+}
+
+TEST(QPACKTest, DecodeStaticOnly) {
+    // https://www.rfc-editor.org/rfc/rfc9204.html#appendix-B.1
+    const std::vector<uint8_t> section { 0x00, 0x00, 0x51, 0x0b, 0x2f, 0x69, 0x6e, 0x64, 0x65, 0x78, 0x2e, 0x68, 0x74, 0x6d, 0x6c };
+    qpack::decoder_t decoder { 0, 0 };
+    MMS::FullStreamAutoAlloc decoder_stream { 16 };
+    fields_t fields { };
+    auto status = decoder.DecodeFieldSection(0, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+    EXPECT_EQ(status, qpack::decoder_t::status_t::Decoded);
+    EXPECT_EQ(fields, (fields_t { {FIELD::Path, "/index.html"} }));
+    EXPECT_EQ(decoder_stream.index(), 0);
+}
+
+TEST(QPACKTest, DecodeBlockedPostBase) {
+    // https://www.rfc-editor.org/rfc/rfc9204.html#appendix-B.2
+    const std::vector<uint8_t> encoder_instructions {
+        0x3f, 0xbd, 0x01,
+        0xc0, 0x0f, 0x77, 0x77, 0x77, 0x2e, 0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d,
+        0xc1, 0x0c, 0x2f, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2f, 0x70, 0x61, 0x74, 0x68
+    };
+    const std::vector<uint8_t> section { 0x03, 0x81, 0x10, 0x11 };
+
+    qpack::decoder_t decoder { 220, 1 };
+    MMS::FullStreamAutoAlloc decoder_stream { 16 };
+    fields_t fields { };
+    auto status = decoder.DecodeFieldSection(4, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+    EXPECT_EQ(status, qpack::decoder_t::status_t::Blocked);
+    EXPECT_TRUE(fields.empty());
+    EXPECT_EQ(decoder.GetBlockedStreams(), 1);
+
+    // Second blocked stream is over the limit
+    EXPECT_THROW(decoder.DecodeFieldSection(8, to_const_stream(section), decoder_stream, [](const auto &) { }), MMS::QPACKException);
+
+    // Instructions arrive one byte at a time
+    for(auto &octet: encoder_instructions) {
+        decoder.ProcessEncoderInstructions(MMS::make_const_stream(&octet, 1), decoder_stream);
+    }
+
+    EXPECT_EQ(decoder.GetBlockedStreams(), 0);
+    EXPECT_EQ(fields, (fields_t { {FIELD::Authority, "www.example.com"}, {FIELD::Path, "/sample/path"} }));
+    EXPECT_EQ(decoder.GetDynamicTable().GetSize(), 106);
+    // Insert Count Increment for first insert, Section Acknowledgment for stream 4 covers second
+    ASSERT_EQ(decoder_stream.index(), 2);
+    EXPECT_EQ(decoder_stream.begin()[0], 0x01);
+    EXPECT_EQ(decoder_stream.begin()[1], 0x84);
+}
+
+TEST(QPACKTest, MalformedSection) {
+    qpack::decoder_t decoder { 4096, 16 };
+    MMS::FullStreamAutoAlloc decoder_stream { 16 };
+    auto add_field = [](const auto &) { };
+
+    // Static index out of range
+    const std::vector<uint8_t> bad_static { 0x00, 0x00, 0xff, 0x64 };
+    EXPECT_THROW(decoder.DecodeFieldSection(0, to_const_stream(bad_static), decoder_stream, add_field), MMS::QPACKException);
+
+    // Dynamic reference without required insert count
+    const std::vector<uint8_t> bad_dynamic { 0x00, 0x00, 0x80 };
+    EXPECT_THROW(decoder.DecodeFieldSection(0, to_const_stream(bad_dynamic), decoder_stream, add_field), MMS::QPACKException);
+
+    // Truncated literal
+    const std::vector<uint8_t> truncated { 0x00, 0x00, 0x51, 0x0b, 0x2f };
+    EXPECT_THROW(decoder.DecodeFieldSection(0, to_const_stream(truncated), decoder_stream, add_field), MMS::QPACKException);
+}
+
+TEST(QPACKTest, StaticOnlyRoundTrip) {
+    qpack::encoder_t encoder { 0, 0 };
+    qpack::decoder_t decoder { 0, 0 };
+    MMS::FullStreamAutoAlloc section { 64 };
+    MMS::FullStreamAutoAlloc encoder_stream { 64 };
+    MMS::FullStreamAutoAlloc decoder_stream { 64 };
+
+    encoder.Encode(0, request_fields, section, encoder_stream);
+    EXPECT_EQ(encoder_stream.index(), 0);
+
+    fields_t fields { };
+    auto status = decoder.DecodeFieldSection(0, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+    EXPECT_EQ(status, qpack::decoder_t::status_t::Decoded);
+    EXPECT_EQ(fields, request_fields);
+    EXPECT_EQ(decoder_stream.index(), 0);
+}
+
+TEST(QPACKTest, DynamicTableRoundTrip) {
+    qpack::encoder_t encoder { 4096, 16 };
+    qpack::decoder_t decoder { 4096, 16 };
+    MMS::FullStreamAutoAlloc section { 64 };
+    MMS::FullStreamAutoAlloc encoder_stream { 64 };
+    MMS::FullStreamAutoAlloc decoder_stream { 64 };
+
+    encoder.Encode(0, request_fields, section, encoder_stream);
+    const size_t first_size = section.index();
+    EXPECT_GT(encoder_stream.index(), 0);
+    EXPECT_EQ(encoder.GetOutstandingSections(0), 1);
+
+    // Section arrives before encoder stream
+    fields_t fields { };
+    auto status = decoder.DecodeFieldSection(0, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+    EXPECT_EQ(status, qpack::decoder_t::status_t::Blocked);
+    decoder.ProcessEncoderInstructions(to_const_stream(encoder_stream), decoder_stream);
+    EXPECT_EQ(fields, request_fields);
+
+    encoder.ProcessDecoderInstructions(to_const_stream(decoder_stream));
+    EXPECT_EQ(encoder.GetOutstandingSections(0), 0);
+    EXPECT_EQ(encoder.GetKnownReceivedCount(), encoder.GetDynamicTable().GetInsertCount());
+
+    // Same fields now refer existing entries without new insert
+    section.Reset();
+    encoder_stream.Reset();
+    decoder_stream.Reset();
+    encoder.Encode(4, request_fields, section, encoder_stream);
+    EXPECT_EQ(section.index(), first_size);
+    EXPECT_EQ(encoder_stream.index(), 0);
+
+    fields.clear();
+    status = decoder.DecodeFieldSection(4, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+    EXPECT_EQ(status, qpack::decoder_t::status_t::Decoded);
+    EXPECT_EQ(fields, request_fields);
+    EXPECT_EQ(encoder.GetDynamicTable().GetSize(), decoder.GetDynamicTable().GetSize());
+}
+
+TEST(QPACKTest, EncoderAvoidsBlocking) {
+    qpack::encoder_t encoder { 4096, 0 };
+    qpack::decoder_t decoder { 4096, 0 };
+    MMS::FullStreamAutoAlloc section { 64 };
+    MMS::FullStreamAutoAlloc encoder_stream { 64 };
+    MMS::FullStreamAutoAlloc decoder_stream { 64 };
+
+    encoder.Encode(0, request_fields, section, encoder_stream);
+    EXPECT_GT(encoder_stream.index(), 0);
+    EXPECT_EQ(encoder.GetOutstandingSections(0), 0);
+
+    // Decoder does not allow blocked streams, hence section must decode immediately
+    fields_t fields { };
+    auto status = decoder.DecodeFieldSection(0, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+    EXPECT_EQ(status, qpack::decoder_t::status_t::Decoded);
+    EXPECT_EQ(fields, request_fields);
+
+    // Insert Count Increment unlocks inserted entries
+    decoder.ProcessEncoderInstructions(to_const_stream(encoder_stream), decoder_stream);
+    encoder.ProcessDecoderInstructions(to_const_stream(decoder_stream));
+    EXPECT_EQ(encoder.GetKnownReceivedCount(), encoder.GetDynamicTable().GetInsertCount());
+
+    section.Reset();
+    encoder_stream.Reset();
+    encoder.Encode(4, request_fields, section, encoder_stream);
+    EXPECT_EQ(encoder.GetOutstandingSections(4), 1);
+    fields.clear();
+    status = decoder.DecodeFieldSection(4, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+    EXPECT_EQ(status, qpack::decoder_t::status_t::Decoded);
+    EXPECT_EQ(fields, request_fields);
+}
+
+TEST(QPACKTest, EvictionKeepsReferencedEntries) {
+    // Small table forces eviction after few inserts
+    qpack::encoder_t encoder { 256, 16 };
+    qpack::decoder_t decoder { 256, 16 };
+    MMS::FullStreamAutoAlloc section { 64 };
+    MMS::FullStreamAutoAlloc encoder_stream { 64 };
+    MMS::FullStreamAutoAlloc decoder_stream { 64 };
+
+    for(uint64_t stream_id = 0; stream_id < 64; stream_id += 4) {
+        const fields_t fields_in {
+            {FIELD::Path, "/resource/" + std::to_string(stream_id)},
+            {FIELD::ETag, "\"" + std::to_string(stream_id * 7919) + "\""},
+        };
+        section.Reset();
+        encoder_stream.Reset();
+        decoder_stream.Reset();
+        encoder.Encode(stream_id, fields_in, section, encoder_stream);
+        EXPECT_LE(encoder.GetDynamicTable().GetSize(), 256);
+
+        decoder.ProcessEncoderInstructions(to_const_stream(encoder_stream), decoder_stream);
+        fields_t fields { };
+        decoder.DecodeFieldSection(stream_id, to_const_stream(section), decoder_stream, [&](const auto &field) { fields.push_back(field); });
+        EXPECT_EQ(fields, fields_in);
+        encoder.ProcessDecoderInstructions(to_const_stream(decoder_stream));
+    }
+    EXPECT_GT(encoder.GetDynamicTable().GetDroppedCount(), 0);
+}
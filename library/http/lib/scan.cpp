@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+#include <http/scan.h>
+#include <array>
+#include <bit>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace MMS::http::scan {
+
+static constexpr std::array<bool, 256> delimiter_table = [] {
+    std::array<bool, 256> table { };
+    table[' '] = table[':'] = table['\r'] = table['\n'] = true;
+    return table;
+}();
+
+size_t find_delimiters_scalar(const uint8_t *data, const size_t size, const uint32_t base_offset, uint32_t *positions) {
+    size_t count { 0 };
+    for(size_t index { 0 }; index < size; ++index) {
+        if (delimiter_table[data[index]]) positions[count++] = base_offset + static_cast<uint32_t>(index);
+    }
+    return count;
+}
+
+static inline size_t add_mask(uint32_t mask, const uint32_t offset, uint32_t *positions, size_t count) {
+    while(mask) {
+        positions[count++] = offset + static_cast<uint32_t>(std::countr_zero(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+size_t find_delimiters_sse42(const uint8_t *data, const size_t size, const uint32_t base_offset, uint32_t *positions) {
+    const __m128i delimiters = _mm_setr_epi8(' ', ':', '\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t count { 0 };
+    size_t index { 0 };
+    for(; index + 16 <= size; index += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + index));
+        const __m128i match = _mm_cmpestrm(delimiters, 4, block, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        count = add_mask(static_cast<uint32_t>(_mm_cvtsi128_si32(match)), base_offset + static_cast<uint32_t>(index), positions, count);
+    }
+    return count + find_delimiters_scalar(data + index, size - index, base_offset + static_cast<uint32_t>(index), positions + count);
+}
+
+__attribute__((target("avx2")))
+size_t find_delimiters_avx2(const uint8_t *data, const size_t size, const uint32_t base_offset, uint32_t *positions) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    size_t count { 0 };
+    size_t index { 0 };
+    for(; index + 32 <= size; index += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + index));
+        const __m256i match = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, colon)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(block, lf)));
+        count = add_mask(static_cast<uint32_t>(_mm256_movemask_epi8(match)), base_offset + static_cast<uint32_t>(index), positions, count);
+    }
+    return count + find_delimiters_sse42(data + index, size - index, base_offset + static_cast<uint32_t>(index), positions + count);
+}
+#endif
+
+static find_delimiters_t select_find_delimiters() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return find_delimiters_avx2;
+    if (__builtin_cpu_supports("sse4.2")) return find_delimiters_sse42;
+#endif
+    return find_delimiters_scalar;
+}
+
+const find_delimiters_t find_delimiters = select_find_delimiters();
+
+const char *find_delimiters_name() {
+#if defined(__x86_64__)
+    if (find_delimiters == find_delimiters_avx2) return "avx2";
+    if (find_delimiters == find_delimiters_sse42) return "sse4.2";
+#endif
+    return "scalar";
+}
+
+} // namespace MMS::http::scan
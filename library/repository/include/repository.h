@@ -40,6 +40,8 @@ class Container {
     std::unordered_map<std::string, std::unique_ptr<server::ServiceBase>> services { };
     std::unordered_map<std::string, std::vector<std::string>> string_lists { };
     std::unordered_map<std::string, std::unordered_map<std::string, std::string>> string_maps { };
+    // Declared last, it completes its tasks before handlers and configurations are gone
+    std::unique_ptr<MMS::worker::pool_t> worker_pool { };
 
 
     bool ReadSystemConfiguration();
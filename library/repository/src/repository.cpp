@@ -91,6 +91,7 @@ bool Container::ReadHTTPConfiguration() {
             }
             auto &ServerName = ServerNameJson.GetString();
             auto ptrconf = new server::http::configuration_t  { ServerName };
+            ptrconf->worker_pool = worker_pool.get();
 
             auto &MaxFrameSizeJson = confjson["Max Frame Size"];
             if (!MaxFrameSizeJson.IsError()) {
@@ -288,7 +289,19 @@ bool Container::ReadHandlerConfiguration() {
                     std::cerr << "Unable to find map by name " << mimemap << std::endl;
                     return false;
                 }
-                auto handlerptr = new MMS::server::httpfilehandler { filecache, filepath, defaultfileitr->second, mimemapitr->second };
+                // Preload map is optional, its files are sent with 103 Early Hints
+                std::unordered_map<std::string, std::string> preloadmap { };
+                auto &preloadjson = handlerjson["Preload Map"];
+                if (!preloadjson.IsError()) {
+                    auto &preloadname = preloadjson.GetString();
+                    auto preloaditr = string_maps.find(preloadname);
+                    if (preloaditr == std::end(string_maps)) {
+                        std::cerr << "Unable to find map by name " << preloadname << std::endl;
+                        return false;
+                    }
+                    preloadmap = preloaditr->second;
+                }
+                auto handlerptr = new MMS::server::httpfilehandler { filecache, filepath, defaultfileitr->second, mimemapitr->second, preloadmap };
                 handlers.emplace(handlername, handlerptr);
             } else if (type_name == "REST") {
                 // TODO: Implement RESTCache
@@ -337,6 +350,14 @@ bool Container::ReadSystemConfiguration() {
     try {
         auto &json = ref["System"];
         if (json.IsError()) return true;
+
+        // Blocking handler is run in listener thread if there is no worker
+        auto &workercountjson = json["Worker Thread Count"];
+        if (!workercountjson.IsError()) {
+            auto workercount = static_cast<size_t>(workercountjson.GetInt());
+            if (workercount) worker_pool = std::make_unique<MMS::worker::pool_t>(workercount);
+        }
+
         auto &threadcountjson = json["Thread Count"];
         if (threadcountjson.IsError()) return true;
         auto threadcount = static_cast<size_t>(threadcountjson.GetInt());
@@ -17,9 +17,12 @@
 
 #pragma once
 #include <mms/net/base.h>
+#include <mms/worker.h>
 #include <mms/ds/prefixmap.h>
 #include <http/httpparser.h>
+#include <http/hpack.h>
 #include <unordered_map>
+#include <memory>
 
 namespace MMS::http::typecheck {
     template <typename T>
@@ -37,11 +40,40 @@ using MMS::http::response;
 class configuration_t;
 class protocol_t;
 
+// Request body given in parts as it is read, this is for large upload.
+// Connection owns it till body is complete.
+class body_reader_t {
+public:
+    virtual ~body_reader_t() = default;
+
+    // Part is valid only till this call returns.
+    // Returning false pauses read from connection till protocol_t::ResumeRead is called,
+    // data already read is still given.
+    virtual bool ProcessBody(const Stream &part) = 0;
+
+    // Body is complete, response is written here
+    virtual void ProcessBodyEnd(protocol_t *writer) = 0;
+};
+
 class handler_t {
 public:
     virtual ~handler_t() = default;
     virtual void ProcessRead(const MMS::http::request &request, const std::string &relative_path, protocol_t *writer) = 0;
 
+    // HTTP/1.1 request without copy, it is valid only till this call returns.
+    // Default implementation copies request, handler can override this to avoid copy.
+    virtual void ProcessRead(const MMS::http::request_view &request, const std::string &relative_path, protocol_t *writer) {
+        ProcessRead(request.to_request(), relative_path, writer);
+    }
+
+    // This is called when body is not complete once header is received, request has no body.
+    // Returning nullptr keeps body buffered till request is complete and ProcessRead is called.
+    virtual std::unique_ptr<body_reader_t> CreateBodyReader(const MMS::http::request &, const std::string &, protocol_t *) { return nullptr; }
+
+    // Handler that waits on backend or takes long is run on worker pool of configuration, HTTP/2 only.
+    // Such handler must be thread safe, writer of worker is valid only till ProcessRead returns.
+    virtual bool IsBlocking() const { return false; }
+
     // This is expected to return static list hence return type is const reference
     // Following must not be added to list PRI and OPTION
     virtual const std::vector<METHOD> &GetSupportedMethod() = 0;
@@ -52,6 +84,13 @@ public:
         }
         return false;
     }
+
+    // Allow field value with OPTIONS, this is created once when handler is added to configuration
+    const std::string &GetAllow() const { return allow; }
+
+private:
+    friend struct configuration_t;
+    std::string allow { };
 };
 
 struct configuration_t {
@@ -60,13 +99,33 @@ struct configuration_t {
     uint32_t max_frame_size { 16384 };
     MMS::http::http_version_t version { };
     MMS::http::http_limits_t limits { };
-    configuration_t(const std::string &ServerName) : ServerName { ServerName } { }
+
+    // Server and other fields same for every response, these are serialized once.
+    // HPACK form is encoded once, connection writes it indexed once it is in its dynamic table.
+    std::vector<std::pair<FIELD, std::string>> fixed_fields { };
+    std::string fixed_fields_http1 { };
+    std::vector<MMS::http::hpack::encoded_field_t> fixed_fields_hpack { };
+    // Error body with ServerName
+    MMS::http::error_page_t error_page;
+    // Blocking handler runs here, it is not owned by configuration
+    MMS::worker::pool_t *worker_pool { nullptr };
+
+    configuration_t(const std::string &ServerName) : ServerName { ServerName }, error_page { ServerName } { UpdateFixedFields(); }
     configuration_t(configuration_t &&configuration) 
-        : ServerName { std::move(configuration.ServerName) }, handlermap { std::move(configuration.handlermap) } { }
+        : ServerName { std::move(configuration.ServerName) }, handlermap { std::move(configuration.handlermap) },
+          fixed_fields { std::move(configuration.fixed_fields) }, fixed_fields_http1 { std::move(configuration.fixed_fields_http1) },
+          fixed_fields_hpack { std::move(configuration.fixed_fields_hpack) }, error_page { std::move(configuration.error_page) },
+          worker_pool { configuration.worker_pool } { }
 
-    void AddHandler(const std::string &path, handler_t *handler) {
-        handlermap.insert(path, handler);
+    void AddHandler(const std::string &path, handler_t *handler);
+
+    void AddFixedField(const FIELD field, const std::string &value) {
+        fixed_fields.emplace_back(field, value);
+        UpdateFixedFields();
     }
+
+    // Must be called if ServerName is changed
+    void UpdateFixedFields();
 };
 
 class protocol_t : public net::protocol_t {
@@ -81,16 +140,28 @@ public:
     using net::protocol_t::Write;
 
 
-    virtual void WriteError(const CODE code, const std::string &errortext) =  0;
+    virtual void WriteError(const CODE code, const std::string_view errortext) =  0;
     virtual void Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) = 0;
     virtual void Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) = 0;
 
+    // Body is referenced till it is written, owner keeps it valid.
+    // Default implementation copies body.
+    virtual void Write(const CODE code, const Stream &bodystream, const std::shared_ptr<const void> &, std::vector<std::pair<FIELD, std::string>> &fields) {
+        Write(code, bodystream, fields);
+    }
+
     template <MMS::http::typecheck::fieldentrypair... fieldlist>
     inline void Write(const CODE code, const Stream &bodystream, const fieldlist& ... field) {
         std::vector<std::pair<FIELD, std::string>> fields { field... };
         Write(code, bodystream, fields);
     }
 
+    template <MMS::http::typecheck::fieldentrypair... fieldlist>
+    inline void Write(const CODE code, const Stream &bodystream, const std::shared_ptr<const void> &owner, const fieldlist& ... field) {
+        std::vector<std::pair<FIELD, std::string>> fields { field... };
+        Write(code, bodystream, owner, fields);
+    }
+
     template <MMS::http::typecheck::fieldentrypair... fieldlist>
     inline void Write(const CODE code, const std::string &body, const fieldlist& ... field) {
         std::vector<std::pair<FIELD, std::string>> fields { field... };
@@ -104,6 +175,33 @@ public:
         Write(code, fields);
     }
 
+    // Streaming response, body is written in parts without knowing its length.
+    // HTTP/1.1 uses chunked transfer coding, HTTP/2 and HTTP/3 write DATA frames for each part.
+    // Written parts are flushed once limits.StreamFlushSize is buffered.
+    virtual void WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) = 0;
+    virtual void WriteChunk(const Stream &chunkstream) = 0;
+    virtual void WriteEnd() = 0;
+
+    template <MMS::http::typecheck::fieldentrypair... fieldlist>
+    inline void WriteBegin(const CODE code, const fieldlist& ... field) {
+        std::vector<std::pair<FIELD, std::string>> fields { field... };
+        WriteBegin(code, fields);
+    }
+
+    inline void WriteChunk(const std::string_view chunk) { WriteChunk(make_const_stream(chunk.data(), chunk.size())); }
+
+    // 103 Early Hints https://www.rfc-editor.org/rfc/rfc8297.html
+    // It is written before final response, fields are usually Link with rel=preload.
+    // Hints are flushed at once so that client can fetch resources while response is produced.
+    // Protocol that can not send it ignores it.
+    virtual void WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &) { }
+
+    template <MMS::http::typecheck::fieldentrypair... fieldlist>
+    inline void WriteEarlyHints(const fieldlist& ... field) {
+        const std::vector<std::pair<FIELD, std::string>> fields { field... };
+        WriteEarlyHints(fields);
+    }
+
     static constexpr void CreateSupportedMethodString(std::string &str, const std::vector<METHOD> &supportedmethods, const auto ...AdditionalMethod) {
         for(auto supportedmethod: supportedmethods) {
             str += to_string(supportedmethod);
@@ -114,13 +212,38 @@ public:
         str.pop_back();
     }
 
-    static constexpr std::string CreateSupportedMethodErrorString(const METHOD requestmethod, const std::vector<METHOD> &supportedmethods, const auto ...AdditionalMethod) {
-        std::string errmsg { "Method: " };
-        errmsg += to_string(requestmethod);
-        errmsg += " not allowed, follow methods are supported:";
-        CreateSupportedMethodString(errmsg, supportedmethods, AdditionalMethod...);
+    static std::string CreateNotFoundString(const std::string_view path) {
+        constexpr std::string_view path_text { "Path " };
+        constexpr std::string_view not_found_text { " not found" };
+        std::string errmsg { };
+        errmsg.reserve(path_text.size() + path.size() + not_found_text.size());
+        errmsg += path_text;
+        errmsg += path;
+        errmsg += not_found_text;
         return errmsg;
     }
+
+    static std::string CreateSupportedMethodErrorString(const METHOD requestmethod, const handler_t &handler) {
+        constexpr std::string_view method_text { "Method: " };
+        constexpr std::string_view supported_text { " not allowed, follow methods are supported:" };
+        const auto method = to_string_view(requestmethod);
+        std::string errmsg { };
+        errmsg.reserve(method_text.size() + method.size() + supported_text.size() + handler.GetAllow().size());
+        errmsg += method_text;
+        errmsg += method;
+        errmsg += supported_text;
+        errmsg += handler.GetAllow();
+        return errmsg;
+    }
+
+protected:
+    // Error body and Content-Type are written to buffer of thread, it is reused for every error.
+    // Returned buffer is valid till next error in same thread.
+    struct error_buffer_t {
+        FullStreamAutoAlloc body { 1024 };
+        std::vector<std::pair<FIELD, std::string>> fields { };
+    };
+    static error_buffer_t &CreateErrorBuffer(const configuration_t &configuration, const CODE code, const std::string_view errortext, const std::string_view accepttype);
 };
 
 class creator_t : public net::protocol_creator_t {
@@ -31,17 +31,50 @@ namespace MMS::server::http::v1 {
 
 class protocol_t : public MMS::server::http::protocol_t {
     static constexpr size_t response_buffer_initial_size = 1_kb;
-    MMS::http::request *current_request { nullptr };
+    const MMS::http::request_view *current_request { nullptr };
     FullStreamAutoAlloc response_buffer {response_buffer_initial_size};
+    // Incomplete request is kept till next read, pipelined requests are served in order
+    std::string pending { };
+    bool keep_alive { true };
+    bool closing { false };
+
+    // Body of current request is given to reader as it is read
+    std::unique_ptr<body_reader_t> body_reader { };
+    MMS::http::body_decoder_t body_decoder { };
+    // Handler did not give reader for current request, body is buffered till it is complete.
+    // Body decoder frames it as it is read, offset is from start of request in pending.
+    bool body_buffered { false };
+    size_t buffered_offset { 0 };
+
+    // Returns false when connection is moved to other protocol, tail is data after request
+    bool ProcessRequest(const MMS::http::request_view &request, const uint8_t *tail, const uint8_t *end);
+    // Returns true if handler gives reader for incomplete request
+    bool StartBodyReader(const MMS::http::request_view &request);
+    // Returns false when body is not complete, begin is moved till data consumed
+    bool ProcessBody(const uint8_t *&begin, const uint8_t *end);
+    // Returns true when buffered body of request starting at begin is complete
+    bool FrameBufferedBody(const uint8_t *begin, const uint8_t *end);
+    void WriteHeader(const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields);
+    void WriteResponseBuffer();
+    // Further requests are ignored and connection is closed after response is written
+    void CloseConnection();
+
 public:
     using MMS::server::http::protocol_t::protocol_t;
     protocol_t(const protocol_t &) = delete;
     protocol_t &operator=(const protocol_t &) = delete;
     using net::protocol_t::Write;
     void ProcessRead(const Stream &stream) override;
-    void WriteError(const CODE code, const std::string &errortext) override;
+    void WriteError(const CODE code, const std::string_view errortext) override;
     void Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) override;
     void Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    using MMS::server::http::protocol_t::WriteBegin;
+    using MMS::server::http::protocol_t::WriteChunk;
+    void WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    void WriteChunk(const Stream &chunkstream) override;
+    void WriteEnd() override;
+    using MMS::server::http::protocol_t::WriteEarlyHints;
+    void WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &fields) override;
 };
 
 class creator_t : public MMS::server::http::creator_t {
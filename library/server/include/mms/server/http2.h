@@ -21,7 +21,10 @@
 #include <mms/net/base.h>
 #include <mms/ds/prefixmap.h>
 #include <http/httpparser.h>
-#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 namespace MMS::server::http::v2 {
 using MMS::http::CODE;
@@ -30,32 +33,196 @@ using MMS::http::METHOD;
 using MMS::http::request;
 using MMS::http::response;
 
+class buffered_reader_t;
+class stream_writer_t;
+
+// Flow control state of a connection
+struct flow_stats_t {
+    std::chrono::steady_clock::duration rtt;
+    std::chrono::steady_clock::duration min_rtt;
+    uint64_t bdp;
+    // SETTINGS_INITIAL_WINDOW_SIZE advertised to peer
+    uint32_t receive_window;
+    uint32_t connection_receive_window;
+    int64_t connection_send_window;
+};
+
 class protocol_t : public MMS::server::http::protocol_t{
     static constexpr size_t response_buffer_initial_size = 1_kb;
+    // Smaller body is copied, copy costs less than separate buffers for its frames
+    static constexpr size_t body_reference_min = 4_kb;
+    // Frame headers of referenced body, block is reused once writes using it are done
+    static constexpr size_t frame_headers_block_size = 64 * sizeof(MMS::http::v2::frame);
     bool first_frame { true };
+    // Client SETTINGS follows preface, it is parsed before other frames
+    bool settings_expected { false };
     bool settings_responded { false };
     MMS::http::v2::header_request *header_request { nullptr };
+    // Stream for writes, body reader writes response after its request is gone
+    uint32_t stream_identifier { 0 };
+    // Last stream served, this is sent with GOAWAY
+    uint32_t last_stream_identifier { 0 };
     FullStreamAutoAlloc response_buffer { response_buffer_initial_size };
+    // Frame split across reads is kept till rest is read
+    std::string pending { };
+    void ProcessData(const uint32_t stream_id, const Stream &part, const bool end_stream);
+
+    // Flow control https://www.rfc-editor.org/rfc/rfc9113.html#name-flow-control
+    struct send_stream_t {
+        int64_t window;
+        MMS::http::v2::priority_t priority { };
+        // DATA waiting for window, pending_sent bytes from front are already written
+        std::string pending { };
+        size_t pending_sent { 0 };
+        // Body referenced in place of pending, owner keeps it valid
+        std::shared_ptr<const void> owner { };
+        std::string_view referenced { };
+        bool end_stream { false };
+
+        std::string_view GetPending() const { return owner ? referenced : std::string_view { pending }; }
+    };
+
+    // Stream state of connection https://www.rfc-editor.org/rfc/rfc9113.html#name-stream-states
+    // Record is kept while body, worker, DATA to send, priority or received count needs it.
+    struct stream_t {
+        uint32_t stream_identifier;
+        // END_STREAM is not read yet, HEADERS on stream are trailers
+        bool remote_open { false };
+        // Handler runs on worker, response is written after request is gone
+        bool dispatched { false };
+        // Send state is kept only when DATA is left for window or scheduler, or window is updated before response
+        bool sending { false };
+        send_stream_t send { 0 };
+        // Priority of stream without send state, PRIORITY_UPDATE may come before request
+        bool prioritized { false };
+        MMS::http::v2::priority_t priority { };
+        // DATA received since last WINDOW_UPDATE, window is given back once half is used
+        uint32_t received { 0 };
+        // Body given to reader as DATA is read
+        std::unique_ptr<body_reader_t> body_reader { };
+
+        stream_t(const uint32_t stream_identifier) : stream_identifier { stream_identifier } { }
+        // Pooled record is reused for new stream
+        void reset(const uint32_t stream_identifier) { *this = stream_t { stream_identifier }; }
+        bool IsIdle() const { return !remote_open && !dispatched && !sending && !prioritized && !received && !body_reader; }
+    };
+    // Records are owned by connection, address of record is stable till it is released
+    MMS::http::v2::stream_table_t<stream_t> streams { };
+    stream_t &GetStream(const uint32_t stream_id);
+    // Record without state is given back to table
+    void ReleaseStream(const uint32_t stream_id);
+    // Stream served before and not waiting for body or worker
+    bool IsClosed(const uint32_t stream_id, const stream_t *stream) const;
+
+    // Connection window does not change with SETTINGS_INITIAL_WINDOW_SIZE
+    int64_t connection_window { MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE };
+    // DATA received since last WINDOW_UPDATE, window is given back once half is used
+    uint32_t connection_received { 0 };
+    // Receive window follows bandwidth delay product within WindowsSizeMin and WindowsSizeMax.
+    // Stream window is changed with SETTINGS and connection window with WINDOW_UPDATE.
+    MMS::http::v2::window_estimator_t window_estimator { MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE, MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE, MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE };
+    uint32_t connection_receive_window { MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE };
+    // Connection window shrunk is not given back with WINDOW_UPDATE
+    uint32_t connection_withheld { 0 };
+
+    // Scheduler https://www.rfc-editor.org/rfc/rfc9218.html#name-server-scheduling
+    struct scheduled_t {
+        MMS::http::v2::priority_t priority;
+        uint32_t stream_id;
+        // This is reset once stream has nothing to write
+        stream_t *stream;
+
+        constexpr bool operator<(const scheduled_t &other) const {
+            return std::tie(priority.urgency, priority.incremental, stream_id) < std::tie(other.priority.urgency, other.priority.incremental, other.stream_id);
+        }
+    };
+    std::vector<scheduled_t> schedule { };
+    // Set while requests of one read are served, their DATA is written by scheduler afterwards
+    bool scheduling { false };
 
-    MMS::http::hpack::dynamic_table_t dynamic_table { };
+    std::shared_ptr<uint8_t[]> frame_headers { };
+    size_t frame_headers_used { 0 };
+
+    // Writes as much DATA as windows allow, rest is kept till WINDOW_UPDATE.
+    // Body with owner is referenced by writes and by pending, it is not copied.
+    void WriteData(const Stream &datastream, const bool end_stream, const std::shared_ptr<const void> &owner = { });
+    void WriteReferenced(const uint32_t stream_id, const Stream &datastream, const bool end_stream, const std::shared_ptr<const void> &owner);
+    size_t WriteAllowed(const uint32_t stream_id, send_stream_t &send_stream, const Stream &datastream, const bool end_stream);
+    void WritePending();
+    size_t WriteScheduled(scheduled_t &scheduled, const size_t limit);
+    MMS::http::v2::priority_t GetPriority(const uint32_t stream_id);
+    void ProcessPriorityUpdate(const uint32_t stream_id, const std::string_view value);
+    void ProcessWindowUpdate(const uint32_t stream_id, const uint32_t increment);
+    void ProcessReceived(const uint32_t stream_id, const uint32_t length, const bool end_stream);
+    void ProcessPingAck(const uint64_t opaque_data);
+    void UpdateReceiveWindow();
+    void CloseStream(const uint32_t stream_id);
+
+    // Each direction has its own table https://www.rfc-editor.org/rfc/rfc7541.html#section-2.2
+    MMS::http::hpack::dynamic_table_t decoder_table { MMS::http::v2::constant::SETTINGS_HEADER_TABLE_SIZE, false };
+    MMS::http::hpack::dynamic_table_t encoder_table { };
+    // Response fields repeat over a connection, they are encoded once and then indexed
+    MMS::http::hpack::encoder_cache_t encoder_cache { };
     MMS::http::v2::settings_store peer_settings { };
+    // Kept for connection, its stream table and requests are reused by every read
+    MMS::http::v2::request frame_parser { decoder_table, peer_settings };
+
+    // Blocking handler runs on worker, its writes are replayed here by listener thread.
+    // Hence HPACK, flow control and scheduler are used by one thread only.
+    struct completed_t;
+    struct dispatch_t;
+    std::shared_ptr<dispatch_t> dispatch { };
+
+    friend class buffered_reader_t;
+    friend class stream_writer_t;
+    bool DispatchToWorker(handler_t &handler, MMS::http::request &&request, std::string &&path);
 
 public:
     using MMS::server::http::protocol_t::protocol_t;
     using net::protocol_t::Write;
     protocol_t(const protocol_t &) = delete;
     protocol_t &operator=(const protocol_t &) = delete;
+    ~protocol_t() override;
 
     void AddSettingResponse();
-    void AddBase64Settings(const std::string &settings);
+    void AddBase64Settings(const std::string_view settings);
     void Upgrade(MMS::http::request &&);
     void ProcessRequest();
 
     void ProcessRead(const Stream &stream) override;
-    void WriteError(const CODE code, const std::string &errortext) override;
+    void ProcessNotify() override;
+    void WriteError(const CODE code, const std::string_view errortext) override;
     void Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) override;
     void Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    void Write(const CODE code, const Stream &bodystream, const std::shared_ptr<const void> &owner, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    using MMS::server::http::protocol_t::WriteBegin;
+    using MMS::server::http::protocol_t::WriteChunk;
+    void WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    void WriteChunk(const Stream &chunkstream) override;
+    void WriteEnd() override;
+    using MMS::server::http::protocol_t::WriteEarlyHints;
+    void WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &fields) override;
     void FinalizeWrite(); // this is required for HTTP v2
+
+    flow_stats_t GetFlowStats() const;
+    // Streams with state kept by connection
+    size_t GetStreamCount() const { return streams.size(); }
+};
+
+struct protocol_t::completed_t {
+    uint32_t stream_id;
+    // Response is complete with this write
+    bool end;
+    std::move_only_function<void(protocol_t &)> write;
+};
+
+struct protocol_t::dispatch_t {
+    std::mutex lock { };
+    // Reset once connection is gone, writes of worker after that are dropped
+    protocol_t *connection;
+    std::vector<completed_t> completed { };
+
+    dispatch_t(protocol_t *connection) : connection { connection } { }
 };
 
 } // namespace MMS::server::http
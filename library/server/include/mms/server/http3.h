@@ -0,0 +1,61 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <mms/server/http.h>
+#include <http/http3.h>
+
+namespace MMS::server::http::v3 {
+using MMS::http::CODE;
+using MMS::http::FIELD;
+using MMS::http::METHOD;
+
+// One HTTP/3 connection, QUIC connection delivers stream data to ProcessStream.
+// Requests are dispatched through configuration handlermap same as HTTP/1.1 and HTTP/2.
+class protocol_t : public MMS::server::http::protocol_t, public MMS::http::v3::session_t {
+    // Request stream being served by handler
+    MMS::http::v3::stream_t *current_stream { nullptr };
+    const MMS::http::v3::request *current_request { nullptr };
+
+    static MMS::http::v3::settings_store CreateSettings(const configuration_t *configuration);
+    // QPACK encoder decides representation, hence fixed fields are added as fields
+    void AddFixedFields(std::vector<std::pair<FIELD, std::string>> &fields) const;
+
+protected:
+    void ProcessRequest(MMS::http::v3::stream_t &stream, MMS::http::v3::request &request) override;
+
+public:
+    protocol_t(const configuration_t *configuration, MMS::http::v3::transport_t &transport)
+        : MMS::server::http::protocol_t { configuration }, MMS::http::v3::session_t { transport, CreateSettings(configuration), configuration->limits.MaxRequestSize } { }
+    protocol_t(const protocol_t &) = delete;
+    protocol_t &operator=(const protocol_t &) = delete;
+    using net::protocol_t::Write;
+
+    // HTTP/3 has no connection byte stream, data comes per QUIC stream to ProcessStream
+    void ProcessRead(const Stream &) override { }
+    void WriteError(const CODE code, const std::string_view errortext) override;
+    void Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    void Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    using MMS::server::http::protocol_t::WriteBegin;
+    using MMS::server::http::protocol_t::WriteChunk;
+    void WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override;
+    void WriteChunk(const Stream &chunkstream) override;
+    void WriteEnd() override;
+    using MMS::server::http::protocol_t::WriteEarlyHints;
+    void WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &fields) override;
+};
+
+} // namespace MMS::server::http::v3
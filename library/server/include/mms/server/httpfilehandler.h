@@ -19,7 +19,10 @@
 #include <mms/server/http.h>
 #include <mms/base/maths.h>
 #include <filesystem>
-#include <list>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <unordered_map>
 #include <map>
 #include <memory>
@@ -41,77 +44,63 @@ inline uint64_t get_etag(int fd) {
 }
 
 struct filecacheentry {
-    std::filesystem::path path { };
-    size_t size { 0 };
-    uint8_t *buffer { nullptr };
-    uint64_t etag { 0 };
-
-    filecacheentry() { }
-    filecacheentry(const filecacheentry &cc) = delete;
+    const std::filesystem::path path;
+    const size_t size;
+    // Response referring to buffer shares it, evicted entry is freed once it is written
+    const std::shared_ptr<uint8_t[]> buffer;
+    const uint64_t etag;
+    // Set on hit, eviction gives referenced entry a second chance
+    mutable std::atomic<bool> referenced { false };
+
+    filecacheentry(const std::filesystem::path &path, size_t size, std::shared_ptr<uint8_t[]> &&buffer, uint64_t etag) : path { path }, size { size }, buffer { std::move(buffer) }, etag { etag } { }
+    filecacheentry(const filecacheentry &) = delete;
     filecacheentry &operator=(const filecacheentry &) = delete;
-    filecacheentry(filecacheentry &&cacheentry) : path { std::move(cacheentry.path) }, size { cacheentry.size }, buffer { cacheentry.buffer }, etag { cacheentry.etag } {
-        cacheentry.buffer = nullptr;
-        cacheentry.size = 0;
-        cacheentry.etag = 0;
-    }
-
-    filecacheentry(const std::filesystem::path &path, size_t size, uint8_t *buffer, uint64_t etag) : path { path }, size { size }, buffer { buffer }, etag { etag } { }
-
-    ~filecacheentry() {
-        if (buffer) free(buffer);
-    }
 };
 
-using filepairlist = std::list<filecacheentry>;
-
+// File cache shared by all listener threads.
+// Entries are sharded by path hash, each shard table is replaced as whole on insert and eviction.
+// Hit only reads current table of shard, shard lock is taken only on miss.
+// Entry is shared, it remains valid while request has it even if it is evicted.
 class filecache {
+public:
+    using entry_t = std::shared_ptr<const filecacheentry>;
+    static constexpr size_t shard_count { 16 };
+
+    struct stats_t {
+        size_t misses;
+        size_t entries;
+        size_t size;
+    };
+
+private:
+    using table_t = std::unordered_map<std::filesystem::path, entry_t>;
+
+    struct alignas(64) shard_t {
+        std::atomic<std::shared_ptr<const table_t>> table { std::make_shared<const table_t>() };
+        std::mutex lock { };
+        // Insertion order, eviction is CLOCK over it
+        std::deque<entry_t> clock { };
+        size_t size { 0 };
+        std::atomic<size_t> misses { 0 };
+    };
+
     const size_t max_size;
-    filepairlist cachelist { };
-    std::unordered_map<std::filesystem::path, filepairlist::iterator> cachemap { };
-    size_t current_size { 0 };
+    // Entry is evicted from shard it is inserted to, size is over limit only if that shard has nothing to evict
+    std::atomic<size_t> current_size { 0 };
+    std::array<shard_t, shard_count> shards { };
+
+    shard_t &GetShard(const std::filesystem::path &path) { return shards[std::hash<std::filesystem::path> { }(path) % shard_count]; }
+    static entry_t ReadFile(const std::filesystem::path &path);
 
 public:
     filecache(const size_t max_memory_size = std::numeric_limits<size_t>::max()) : max_size { max_memory_size } { }
+    filecache(const filecache &) = delete;
+    filecache &operator=(const filecache &) = delete;
 
-    const filecacheentry &GetCache(const std::filesystem::path &path) {
-        auto cacheitr = cachemap.find(path);
-        if (cacheitr == std::end(cachemap)) {
-            if (!std::filesystem::is_regular_file(path)) {
-                return empty;
-            }
-            int fd = open(path.c_str(), O_RDONLY);
-            if ( fd == -1 ) {
-                perror("Unable to open file");
-                return empty;
-            }
+    // This is thread safe, nullptr is returned if path is not a readable file
+    entry_t GetCache(const std::filesystem::path &path);
 
-            struct stat bufstat;
-            fstat(fd, &bufstat);
-
-            size_t size = bufstat.st_size;
-            auto buffer = malloc(size);
-            const auto read_size = read(fd, buffer, size);
-            const auto etag = get_etag(fd);
-            close(fd);
-            current_size += read_size;
-            if (current_size > max_size) {
-                auto &cacheback = cachelist.back();
-                cachelist.pop_back();
-                cachemap.erase(cacheback.path);
-                current_size -= cacheback.size;
-            }
-            auto bufferentry = filecacheentry {path, size, reinterpret_cast<uint8_t *>(buffer), etag};
-            cachelist.push_front(std::move(bufferentry));
-            auto cachelistitr = std::begin(cachelist);
-            cachemap.insert(std::pair(path, cachelistitr));
-            return *cachelistitr;
-        } else {
-            auto bufferentry = cacheitr->second;
-            return *bufferentry;
-        }
-    }
-
-    static const filecacheentry empty;
+    stats_t GetStats();
 };
 
 
@@ -120,25 +109,36 @@ class httpfilehandler : public http::handler_t {
     const std::filesystem::path rootpath;
     const std::vector<std::string> &defaultlist;
     const std::unordered_map<std::string, std::string> &mimemap;
+    // Link field value for file, it is sent as 103 Early Hints before file
+    std::unordered_map<std::filesystem::path, std::string> preloadmap { };
+
+    // Same implementation for HTTP/1.1 request view and HTTP/2 request
+    template <typename request_t>
+    void ProcessRequest(const request_t &request, const std::string &relative_path, http::protocol_t *writer);
 
 public:
-    httpfilehandler(filecache &cache, const std::filesystem::path &rootpath, const std::vector<std::string> &defaultlist, const std::unordered_map<std::string, std::string> &mimemap)
-        : cache { cache }, rootpath { std::filesystem::canonical(rootpath) }, defaultlist { defaultlist }, mimemap { mimemap } { }
+    // Key of preload map is file path relative to root, value is Link field value e.g. "</style.css>; rel=preload; as=style"
+    httpfilehandler(filecache &cache, const std::filesystem::path &rootpath, const std::vector<std::string> &defaultlist, const std::unordered_map<std::string, std::string> &mimemap, const std::unordered_map<std::string, std::string> &preloadmap = { })
+        : cache { cache }, rootpath { std::filesystem::canonical(rootpath) }, defaultlist { defaultlist }, mimemap { mimemap } {
+        for(auto &[path, link]: preloadmap) {
+            this->preloadmap.emplace((this->rootpath / std::filesystem::path { path }.relative_path()).lexically_normal(), link);
+        }
+    }
 
-    const filecacheentry &GetFromfileCahce(const std::filesystem::path &fullpath) {
+    filecache::entry_t GetFromfileCahce(const std::filesystem::path &fullpath) {
         if (std::filesystem::is_directory(fullpath)) {
             for(const auto &defaultfile: defaultlist) {
                 auto newpath = fullpath;
                 newpath /= defaultfile;
                 return cache.GetCache(newpath);
             }
-            return filecache::empty;
+            return nullptr;
         } else {
             return cache.GetCache(fullpath);
         }
     }
 
-    static constexpr inline bool match_etag(const std::string &etag_match_list, const char *etag) {
+    static constexpr inline bool match_etag(const std::string_view etag_match_list, const char *etag) {
         auto listitr = std::begin(etag_match_list);
         const auto listend = std::end(etag_match_list);
         if (listitr == listend) return false;
@@ -178,6 +178,7 @@ public:
     }
 
     void ProcessRead(const MMS::http::request &request, const std::string &relative_path, http::protocol_t *writer) override;
+    void ProcessRead(const MMS::http::request_view &request, const std::string &relative_path, http::protocol_t *writer) override;
 
     constexpr const std::vector<http::METHOD> &GetSupportedMethod() override {
         static const std::vector<http::METHOD> supported_methods {
@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+// File cache shared by listener threads, requests follow Zipf like distribution over files.
+// Argument is cache size as percent of all files, hit_rate is share of requests served from cache.
+
+#include <mms/server/httpfilehandler.h>
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <random>
+#include <unistd.h>
+
+namespace MMS::server::bench {
+
+constexpr size_t file_count { 512 };
+constexpr size_t file_size { 4096 };
+constexpr size_t request_count { 65536 };
+
+// Files are created once for all benchmarks and removed at exit
+struct bench_files_t {
+    const std::filesystem::path root { std::filesystem::temp_directory_path() / ("mms_filecache_bench_" + std::to_string(getpid())) };
+    std::vector<std::filesystem::path> paths { };
+    std::vector<uint32_t> requests { };
+
+    bench_files_t() {
+        std::filesystem::create_directories(root);
+        const std::string content(file_size, 'x');
+        for(size_t index { 0 }; index < file_count; ++index) {
+            paths.push_back(root / (std::to_string(index) + ".html"));
+            std::ofstream { paths.back() } << content;
+        }
+        std::vector<double> weights { };
+        for(size_t index { 0 }; index < file_count; ++index) weights.push_back(1.0 / static_cast<double>(index + 1));
+        std::discrete_distribution<uint32_t> distribution { weights.begin(), weights.end() };
+        std::mt19937 generator { 42 };
+        for(size_t index { 0 }; index < request_count; ++index) requests.push_back(distribution(generator));
+    }
+    bench_files_t(const bench_files_t &) = delete;
+    bench_files_t &operator=(const bench_files_t &) = delete;
+
+    ~bench_files_t() { std::filesystem::remove_all(root); }
+};
+
+static bench_files_t &GetFiles() {
+    static bench_files_t files { };
+    return files;
+}
+
+static void BM_FileCacheGet(benchmark::State &state) {
+    static std::unique_ptr<filecache> cache { };
+    auto &files = GetFiles();
+    // Thread 0 prepares cache before threads start the loop
+    if (state.thread_index() == 0) cache = std::make_unique<filecache>(file_count * file_size * static_cast<size_t>(state.range(0)) / 100);
+
+    size_t index { static_cast<size_t>(state.thread_index()) * request_count / static_cast<size_t>(state.threads()) };
+    for (auto _ : state) {
+        auto entry = cache->GetCache(files.paths[files.requests[index++ % request_count]]);
+        benchmark::DoNotOptimize(entry);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    // Every thread runs same iterations, all are done once loop is over
+    if (state.thread_index() == 0) {
+        const auto stats = cache->GetStats();
+        const auto requests = static_cast<double>(state.iterations() * static_cast<size_t>(state.threads()));
+        state.counters["hit_rate"] = 1.0 - static_cast<double>(stats.misses) / requests;
+        state.counters["entries"] = static_cast<double>(stats.entries);
+    }
+}
+BENCHMARK(BM_FileCacheGet)->Arg(25)->Arg(100)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace MMS::server::bench
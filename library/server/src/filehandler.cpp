@@ -20,9 +20,85 @@
 
 namespace MMS::server {
 
-const filecacheentry filecache::empty { };
+filecache::entry_t filecache::ReadFile(const std::filesystem::path &path) {
+    if (!std::filesystem::is_regular_file(path)) {
+        return nullptr;
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    if ( fd == -1 ) {
+        perror("Unable to open file");
+        return nullptr;
+    }
 
-void httpfilehandler::ProcessRead(const MMS::http::request &request, const std::string &relative_path, http::protocol_t *writer) {
+    struct stat bufstat;
+    fstat(fd, &bufstat);
+
+    size_t size = bufstat.st_size;
+    std::shared_ptr<uint8_t[]> buffer { new uint8_t[size] };
+    const auto read_size = read(fd, buffer.get(), size);
+    const auto etag = get_etag(fd);
+    close(fd);
+    if (read_size != static_cast<ssize_t>(size)) return nullptr;
+    return std::make_shared<const filecacheentry>(path, size, std::move(buffer), etag);
+}
+
+filecache::entry_t filecache::GetCache(const std::filesystem::path &path) {
+    auto &shard = GetShard(path);
+    {
+        const auto table = shard.table.load(std::memory_order_acquire);
+        auto cacheitr = table->find(path);
+        if (cacheitr != std::end(*table)) {
+            auto &entry = cacheitr->second;
+            // Hot entry is not written on every hit
+            if (!entry->referenced.load(std::memory_order_relaxed)) entry->referenced.store(true, std::memory_order_relaxed);
+            return entry;
+        }
+    }
+
+    // File is read without lock, other thread may read same file meanwhile
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    auto entry = ReadFile(path);
+    if (!entry) return nullptr;
+
+    std::lock_guard guard { shard.lock };
+    const auto table = shard.table.load(std::memory_order_acquire);
+    auto cacheitr = table->find(path);
+    if (cacheitr != std::end(*table)) return cacheitr->second;
+
+    auto newtable = std::make_shared<table_t>(*table);
+    shard.size += entry->size;
+    current_size.fetch_add(entry->size, std::memory_order_relaxed);
+    // Each entry is visited at most twice, once to clear its referenced and once to evict it
+    for(auto visits = 2 * shard.clock.size(); current_size.load(std::memory_order_relaxed) > max_size && visits; --visits) {
+        auto victim = std::move(shard.clock.front());
+        shard.clock.pop_front();
+        if (victim->referenced.exchange(false, std::memory_order_relaxed)) {
+            shard.clock.push_back(std::move(victim));
+            continue;
+        }
+        newtable->erase(victim->path);
+        shard.size -= victim->size;
+        current_size.fetch_sub(victim->size, std::memory_order_relaxed);
+    }
+    newtable->emplace(path, entry);
+    shard.clock.push_back(entry);
+    shard.table.store(std::move(newtable), std::memory_order_release);
+    return entry;
+}
+
+filecache::stats_t filecache::GetStats() {
+    stats_t stats { 0, 0, 0 };
+    for(auto &shard: shards) {
+        std::lock_guard guard { shard.lock };
+        stats.misses += shard.misses.load(std::memory_order_relaxed);
+        stats.entries += shard.clock.size();
+        stats.size += shard.size;
+    }
+    return stats;
+}
+
+template <typename request_t>
+void httpfilehandler::ProcessRequest(const request_t &request, const std::string &relative_path, http::protocol_t *writer) {
     auto method = request.GetMethod();
 
 #if defined(DEBUG) || defined(NDEBUG)
@@ -46,10 +122,9 @@ void httpfilehandler::ProcessRead(const MMS::http::request &request, const std::
         return;
     }
 
-    auto &filecacheentry = GetFromfileCahce(fullpath);
-    auto &newpath = filecacheentry.path;
+    const auto filecacheentry = GetFromfileCahce(fullpath);
 
-    if (filecacheentry.buffer == nullptr) {
+    if (!filecacheentry) {
         std::string errortext { "File: "};
         errortext += request.GetPath();
         errortext += " not found";
@@ -59,7 +134,7 @@ void httpfilehandler::ProcessRead(const MMS::http::request &request, const std::
 
     auto etag_match_list = request.GetField(MMS::http::FIELD::If_None_Match);
     char etag_str[etag_size];
-    to_string64_hash(filecacheentry.etag, etag_str);
+    to_string64_hash(filecacheentry->etag, etag_str);
     if (!etag_match_list.empty()) {
         bool matchetag = match_etag(etag_match_list, etag_str);
         if (matchetag) {
@@ -68,6 +143,7 @@ void httpfilehandler::ProcessRead(const MMS::http::request &request, const std::
         }
     }
 
+    auto &newpath = filecacheentry->path;
     const auto extension = newpath.extension().string();
     auto contenttype = mimemap.find(extension);
     if (contenttype == std::end(mimemap)) {
@@ -79,8 +155,14 @@ void httpfilehandler::ProcessRead(const MMS::http::request &request, const std::
         return;
     }
     if (method == http::METHOD::GET) {
-        auto stream = make_const_stream(filecacheentry.buffer, filecacheentry.size);
-        writer->Write(http::CODE::OK, stream, 
+        if (!preloadmap.empty()) {
+            auto preload = preloadmap.find(newpath.lexically_normal());
+            if (preload != std::end(preloadmap)) {
+                writer->WriteEarlyHints(std::pair<http::FIELD, std::string> { MMS::http::FIELD::Link, preload->second });
+            }
+        }
+        auto stream = make_const_stream(filecacheentry->buffer.get(), filecacheentry->size);
+        writer->Write(http::CODE::OK, stream, filecacheentry->buffer,
             std::pair<http::FIELD, std::string> { MMS::http::FIELD::Cache_Control, { "private, max-age=2592000" } },
             std::pair<http::FIELD, std::string> { MMS::http::FIELD::Content_Type, contenttype->second },
             std::pair<http::FIELD, std::string> { MMS::http::FIELD::ETag, { etag_str } }
@@ -89,11 +171,19 @@ void httpfilehandler::ProcessRead(const MMS::http::request &request, const std::
         writer->Write(http::CODE::OK, 
             std::pair<http::FIELD, std::string> { MMS::http::FIELD::Cache_Control, { "private, max-age=2592000" } },
             std::pair<http::FIELD, std::string> { MMS::http::FIELD::Content_Type, contenttype->second },
-            std::pair<http::FIELD, std::string> { MMS::http::FIELD::Content_Length, std::to_string(filecacheentry.size) },
+            std::pair<http::FIELD, std::string> { MMS::http::FIELD::Content_Length, std::to_string(filecacheentry->size) },
             std::pair<http::FIELD, std::string> { MMS::http::FIELD::ETag, { etag_str } }
         );
     }
 
 }
 
+void httpfilehandler::ProcessRead(const MMS::http::request &request, const std::string &relative_path, http::protocol_t *writer) {
+    ProcessRequest(request, relative_path, writer);
+}
+
+void httpfilehandler::ProcessRead(const MMS::http::request_view &request, const std::string &relative_path, http::protocol_t *writer) {
+    ProcessRequest(request, relative_path, writer);
+}
+
 } // namespace MMS::server
\ No newline at end of file
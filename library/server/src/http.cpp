@@ -16,8 +16,38 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <mms/server/http.h>
-#include <format>
+#include <http/http2.h>
 
 namespace MMS::server::http {
 
+void configuration_t::UpdateFixedFields() {
+    FullStreamAutoAlloc http1 { 256 };
+    MMS::http::WriteFieldLine(http1, FIELD::Server, ServerName);
+    MMS::http::WriteFieldLine(http1, fixed_fields);
+    fixed_fields_http1.assign(reinterpret_cast<const char *>(http1.begin()), http1.index());
+
+    fixed_fields_hpack.clear();
+    fixed_fields_hpack.emplace_back(std::make_pair(FIELD::Server, ServerName));
+    for(auto &field: fixed_fields) fixed_fields_hpack.emplace_back(field);
+
+    error_page = MMS::http::error_page_t { ServerName };
+}
+
+void configuration_t::AddHandler(const std::string &path, handler_t *handler) {
+    if (handler->allow.empty()) protocol_t::CreateSupportedMethodString(handler->allow, handler->GetSupportedMethod(), METHOD::OPTIONS);
+    handlermap.insert(path, handler);
+}
+
+protocol_t::error_buffer_t &protocol_t::CreateErrorBuffer(const configuration_t &configuration, const CODE code, const std::string_view errortext, const std::string_view accepttype) {
+    thread_local error_buffer_t error_buffer { };
+    const auto type = MMS::http::error_page_t::GetType(accepttype);
+    error_buffer.body.Reset();
+    configuration.error_page.Write(error_buffer.body, type, code, errortext);
+    // Strings of fields keep capacity, hence assign does not allocate after first error
+    error_buffer.fields.resize(1);
+    error_buffer.fields[0].first = FIELD::Content_Type;
+    error_buffer.fields[0].second.assign(MMS::http::error_page_t::GetContentType(type));
+    return error_buffer;
+}
+
 } // namespace MMS::server::http
\ No newline at end of file
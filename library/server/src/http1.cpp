@@ -19,7 +19,7 @@
 #include <mms/server/http1.h>
 #include <mms/server/http2.h>
 #include <mms/net/tcpcommon.h>
-#include <format>
+#include <charconv>
 
 namespace MMS::server::http::v1 {
 
@@ -45,112 +45,283 @@ net::protocol_t *creator_t::create_protocol(int fd, const std::string_view &prot
 }
 
 void protocol_t::ProcessRead(const Stream &stream) {
-    try {
-        // Check for HTTP 2.0 Pri
-        if (configuration->version.http2pri) {
-            if (stream == std::string_view { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size }) {
-                log<log_t::HTTP2_PRI_KNOWLEDGE>(GetFD());
-                // Move to http2
-                auto http2_upgrade = new v2::protocol_t { configuration };
-                http2_upgrade->SetProcessor(processor);
-                http2_upgrade->ProcessRead(stream);
-                auto connection = dynamic_cast<MMS::net::tcp::connection_base_t *>(processor);
-                assert(connection);
-                /* -------------------IMP------------------------*/
-                // This will free up current running class. Hence no class variable must be used beyond this point.
-                connection->SetProtocol(http2_upgrade);
-                /* -------------------IMP------------------------*/
-                return;
-            }
-        }
+    // Response with close is already written, data after that is ignored
+    if (closing) return;
 
-        if (!configuration->version.http1) {
-            WriteError(CODE::_505, { "HTTP1 not supported" });
+    // Check for HTTP 2.0 Pri
+    if (configuration->version.http2pri && pending.empty() && !body_reader) {
+        if (stream == std::string_view { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size }) {
+            log<log_t::HTTP2_PRI_KNOWLEDGE>(GetFD());
+            // Move to http2
+            auto http2_upgrade = new v2::protocol_t { configuration };
+            http2_upgrade->SetProcessor(processor);
+            http2_upgrade->ProcessRead(stream);
+            auto connection = dynamic_cast<MMS::net::tcp::connection_base_t *>(processor);
+            assert(connection);
+            /* -------------------IMP------------------------*/
+            // This will free up current running class. Hence no class variable must be used beyond this point.
+            connection->SetProtocol(http2_upgrade);
+            /* -------------------IMP------------------------*/
             return;
         }
-        MMS::http::request request { make_const_fullstream(stream.curr(), stream.end())};
-        if (configuration->version.http2) {
-            if (request.upgrade_version() == VERSION::VER_2) {
-                log<log_t::HTTP2_UPGRADE>(GetFD());
-                auto settingbase64 = request.GetField(FIELD::HTTP2_Settings);
-                if (!settingbase64.empty())  {
-                    // Time to move to HTTP2.
-                    auto http2_upgrade = new v2::protocol_t { configuration };
-                    http2_upgrade->AddBase64Settings(settingbase64);
-                    http2_upgrade->SetProcessor(processor);
-                    http2_upgrade->Upgrade(std::move(request));
-                    /* -------------------IMP------------------------*/
-                    // This will free up current running class. Hence no class variable must be used beyond this point.
-                    auto connection = dynamic_cast<MMS::net::tcp::connection_base_t *>(processor);
-                    assert(connection);
-                    connection->SetProtocol(http2_upgrade);
-                    /* -------------------IMP------------------------*/
+    }
+
+    if (!configuration->version.http1) {
+        keep_alive = false;
+        WriteError(CODE::_505, "HTTP1 not supported");
+        return;
+    }
+
+    // Read buffer is used directly, it is copied only when request is incomplete
+    auto begin = stream.curr();
+    auto end = stream.end();
+    if (!pending.empty()) {
+        pending.append(reinterpret_cast<const char *>(begin), stream.remaining_buffer());
+        begin = reinterpret_cast<const uint8_t *>(pending.data());
+        end = begin + pending.size();
+    }
+    const auto buffer_begin = begin;
+
+    try {
+        while(begin != end) {
+            if (body_reader) {
+                if (!ProcessBody(begin, end)) break;
+                if (closing) return;
+                continue;
+            }
+
+            // Framing of buffered body resumes where last read stopped, request is parsed once it is complete
+            if (body_buffered && !FrameBufferedBody(begin, end)) {
+                if (static_cast<size_t>(end - begin) > configuration->limits.MaxRequestSize) {
+                    keep_alive = false;
+                    WriteError(CODE::Request_Entity_Too_Large, "Request size exceeds limit");
                     return;
                 }
+                break;
             }
-        }
-        std::string newpath { };
-        auto &handler = configuration->handlermap.search(request.GetPath(), newpath);
-        if (handler == nullptr) {
-            WriteError(CODE::Not_Found,  std::format("Path {} not found", request.GetPath()));
-        }
-        else {
-            current_request = &request;
-            auto method = request.GetMethod();
-            if (handler->IsSupported(method)) {
-                handler->ProcessRead(request, newpath, this);
-            } else if (method == METHOD::OPTIONS) {
-                std::string optionsstr {};
-                CreateSupportedMethodString(optionsstr, handler->GetSupportedMethod(), http::METHOD::PRI, http::METHOD::OPTIONS);
-                std::vector<std::pair<FIELD, std::string>> fields {
-                    std::pair<FIELD, std::string> {http::FIELD::Allow, optionsstr}
-                };
-                Write(http::CODE::No_Content, fields);
-            } else {
-                const std::string errstr = CreateSupportedMethodErrorString(method, handler->GetSupportedMethod(), http::METHOD::PRI, http::METHOD::OPTIONS);
-                WriteError(http::CODE::Method_Not_Allowed, errstr);
+
+            // Request refers buffer, it is valid till this iteration
+            MMS::http::request_view request { };
+            const auto size = request.parse_message(begin, end);
+            if (size == 0) {
+                if (request.GetHeadSize() && !body_buffered) {
+                    if (StartBodyReader(request)) {
+                        begin += request.GetHeadSize();
+                        continue;
+                    }
+                    body_decoder = request.body_decoder();
+                    buffered_offset = request.GetHeadSize();
+                    body_buffered = true;
+                    continue;
+                }
+                if (static_cast<size_t>(end - begin) > configuration->limits.MaxRequestSize) {
+                    keep_alive = false;
+                    WriteError(CODE::Request_Entity_Too_Large, "Request size exceeds limit");
+                    return;
+                }
+                break;
             }
-            current_request = nullptr;
+
+            body_buffered = false;
+            begin += size;
+            if (!ProcessRequest(request, begin, end)) return;
+            if (closing) return;
         }
     }
     catch(exception_t &failed) {
+        // Message boundary is not known after failure, hence connection is closed
+        current_request = nullptr;
+        body_reader = nullptr;
+        body_buffered = false;
+        keep_alive = false;
         WriteError(CODE::Bad_Request, failed.to_string());
+        return;
     }
+
+    if (pending.empty()) pending.assign(reinterpret_cast<const char *>(begin), static_cast<size_t>(end - begin));
+    else pending.erase(0, static_cast<size_t>(begin - buffer_begin));
 }
 
-void protocol_t::WriteError(const CODE code, const std::string &errortext) {
-    if (current_request) {
-        auto res = current_request->CreateErrorResponse(code, errortext, configuration->ServerName);
-        Write(res.to_string());
-    } else {
-        auto res = response::CreateErrorResponse(code, errortext, configuration->ServerName);
-        Write(res.to_string());
+bool protocol_t::ProcessRequest(const MMS::http::request_view &request, const uint8_t *tail, const uint8_t *end) {
+    if (configuration->version.http2) {
+        if (request.upgrade_version() == VERSION::VER_2) {
+            log<log_t::HTTP2_UPGRADE>(GetFD());
+            auto settingbase64 = request.GetField(FIELD::HTTP2_Settings);
+            if (!settingbase64.empty())  {
+                // Time to move to HTTP2.
+                auto http2_upgrade = new v2::protocol_t { configuration };
+                http2_upgrade->AddBase64Settings(settingbase64);
+                http2_upgrade->SetProcessor(processor);
+                http2_upgrade->Upgrade(request.to_request());
+                // Client preface may follow upgrade request in same read
+                if (tail != end) http2_upgrade->ProcessRead(make_const_stream(tail, end));
+                /* -------------------IMP------------------------*/
+                // This will free up current running class. Hence no class variable must be used beyond this point.
+                auto connection = dynamic_cast<MMS::net::tcp::connection_base_t *>(processor);
+                assert(connection);
+                connection->SetProtocol(http2_upgrade);
+                /* -------------------IMP------------------------*/
+                return false;
+            }
+        }
+    }
+
+    current_request = &request;
+    keep_alive = request.keep_alive();
+    std::string newpath { };
+    auto &handler = configuration->handlermap.search(request.GetPath(), newpath);
+    if (handler == nullptr) {
+        WriteError(CODE::Not_Found, CreateNotFoundString(request.GetPath()));
+    }
+    else {
+        auto method = request.GetMethod();
+        if (handler->IsSupported(method)) {
+            handler->ProcessRead(request, newpath, this);
+        } else if (method == METHOD::OPTIONS) {
+            std::vector<std::pair<FIELD, std::string>> fields {
+                std::pair<FIELD, std::string> {http::FIELD::Allow, handler->GetAllow()}
+            };
+            Write(http::CODE::No_Content, fields);
+        } else {
+            WriteError(http::CODE::Method_Not_Allowed, CreateSupportedMethodErrorString(method, *handler));
+        }
     }
+    current_request = nullptr;
+    return true;
 }
 
-void protocol_t::Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) {
+bool protocol_t::StartBodyReader(const MMS::http::request_view &request) {
+    // Upgrade is done with complete request
+    if (request.upgrade_version() == VERSION::VER_2) return false;
+    std::string newpath { };
+    auto &handler = configuration->handlermap.search(request.GetPath(), newpath);
+    if (handler == nullptr || !handler->IsSupported(request.GetMethod())) return false;
+
+    const auto decoder = request.body_decoder();
+    current_request = &request;
+    keep_alive = request.keep_alive();
+    body_reader = handler->CreateBodyReader(request.to_request(), newpath, this);
+    current_request = nullptr;
+    if (!body_reader) return false;
+    body_decoder = decoder;
+    return true;
+}
+
+bool protocol_t::ProcessBody(const uint8_t *&begin, const uint8_t *end) {
+    std::string_view part { };
+    while(body_decoder.next(begin, end, part)) {
+        if (!body_reader->ProcessBody(make_const_stream(part))) PauseRead();
+    }
+    if (!body_decoder.done()) return false;
+
+    // Reader is released before response, response may close connection
+    auto reader = std::move(body_reader);
+    reader->ProcessBodyEnd(this);
+    return true;
+}
+
+bool protocol_t::FrameBufferedBody(const uint8_t *begin, const uint8_t *end) {
+    auto curr = begin + buffered_offset;
+    std::string_view part { };
+    while(body_decoder.next(curr, end, part)) { }
+    buffered_offset = static_cast<size_t>(curr - begin);
+    return body_decoder.done();
+}
+
+void protocol_t::CloseConnection() {
+    closing = true;
+    pending.clear();
+    CloseAfterWrite();
+}
+
+void protocol_t::WriteError(const CODE code, const std::string_view errortext) {
+    const auto accepttype = current_request ? current_request->GetField(FIELD::Accept) : std::string_view { };
+
+    // Body is written in place from template, its size is known before
+    const auto &error_page = configuration->error_page;
+    const auto type = MMS::http::error_page_t::GetType(accepttype);
+    WriteHeader(code, { });
+    MMS::http::WriteFieldLine(response_buffer, FIELD::Content_Type, MMS::http::error_page_t::GetContentType(type));
+    MMS::http::WriteFieldLine(response_buffer, FIELD::Content_Length, error_page.GetSize(type, code, errortext));
+    response_buffer.Write("\r\n");
+    error_page.Write(response_buffer, type, code, errortext);
+    WriteResponseBuffer();
+    if (!keep_alive) CloseConnection();
+}
+
+void protocol_t::WriteHeader(const CODE code, const std::vector<std::pair<FIELD, std::string>> &fields) {
     MMS::http::WriteResponseLine(response_buffer, code);
     MMS::http::WriteDateLine(response_buffer);
-    MMS::http::WriteFieldLine(response_buffer, FIELD::Server, configuration->ServerName);
+    response_buffer.Copy(configuration->fixed_fields_http1);
     MMS::http::WriteFieldLine(response_buffer, fields);
+    if (!keep_alive) MMS::http::WriteFieldLine(response_buffer, FIELD::Connection, "close");
+}
+
+void protocol_t::Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) {
+    WriteHeader(code, fields);
     MMS::http::WriteFieldLine(response_buffer, FIELD::Content_Length, std::to_string(bodystream.remaining_buffer()));
     response_buffer.Write("\r\n");
     response_buffer.Copy(bodystream);
-    auto writestream = response_buffer.ReturnOldAndAlloc(response_buffer_initial_size);
-    FixedBuffer writebuffer { std::move(writestream) };
-    WriteNoCopy(std::move(writebuffer));
+    WriteResponseBuffer();
+    if (!keep_alive) CloseConnection();
 }
 
 void protocol_t::Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) {
-    MMS::http::WriteResponseLine(response_buffer, code);
-    MMS::http::WriteDateLine(response_buffer);
-    MMS::http::WriteFieldLine(response_buffer, FIELD::Server, configuration->ServerName);
-    MMS::http::WriteFieldLine(response_buffer, fields);
+    WriteHeader(code, fields);
+    // Persistent connection requires length, 1xx, 204 and 304 never have body
+    const auto status = static_cast<unsigned short>(code);
+    if (status >= 200 && status != 204 && status != 304
+            && std::ranges::none_of(fields, [](const auto &field) { return field.first == FIELD::Content_Length; })) {
+        MMS::http::WriteFieldLine(response_buffer, FIELD::Content_Length, "0");
+    }
+    response_buffer.Write("\r\n");
+    WriteResponseBuffer();
+    if (!keep_alive) CloseConnection();
+}
+
+void protocol_t::WriteResponseBuffer() {
     auto writestream = response_buffer.ReturnOldAndAlloc(response_buffer_initial_size);
     FixedBuffer writebuffer { std::move(writestream) };
     WriteNoCopy(std::move(writebuffer));
 }
 
+// https://www.rfc-editor.org/rfc/rfc9112.html#name-chunked-transfer-coding
+void protocol_t::WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) {
+    WriteHeader(code, fields);
+    MMS::http::WriteFieldLine(response_buffer, FIELD::Transfer_Encoding, "chunked");
+    response_buffer.Write("\r\n");
+}
+
+void protocol_t::WriteChunk(const Stream &chunkstream) {
+    // Zero size chunk is last chunk, hence empty part is not written
+    if (chunkstream.full()) return;
+    char size_str[sizeof(size_t) * 2];
+    const auto size_end = std::to_chars(std::begin(size_str), std::end(size_str), chunkstream.remaining_buffer(), 16).ptr;
+    response_buffer.Copy(size_str, size_end);
+    response_buffer.Write("\r\n");
+    response_buffer.Copy(chunkstream);
+    response_buffer.Write("\r\n");
+    if (response_buffer.index() >= configuration->limits.StreamFlushSize) {
+        WriteResponseBuffer();
+        Flush();
+    }
+}
+
+void protocol_t::WriteEnd() {
+    response_buffer.Write("0\r\n\r\n");
+    WriteResponseBuffer();
+    if (!keep_alive) CloseConnection();
+}
+
+void protocol_t::WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &fields) {
+    // Only HTTP/1.1 request is parsed, hence client can read 1xx
+    MMS::http::WriteResponseLine(response_buffer, CODE::Early_Hints);
+    MMS::http::WriteFieldLine(response_buffer, fields);
+    response_buffer.Write("\r\n");
+    WriteResponseBuffer();
+    Flush();
+}
+
 } // namespace MMS::server::http
 
 namespace MMS::client::http::v1 {
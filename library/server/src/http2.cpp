@@ -17,44 +17,481 @@
 
 #include <mms/server/http2.h>
 #include <http/http2.h>
-#include <format>
 
 namespace MMS::server::http::v2 {
 
-void protocol_t::WriteError(const CODE code, const std::string &errortext) {
-    std::vector<std::pair<FIELD, std::string>> fields {
-        { FIELD::Content_Type, std::string { "text/html" } }
-    };
+// Body for handler without reader is kept till END_STREAM, then request is given to handler
+class buffered_reader_t : public body_reader_t {
+    protocol_t &connection;
+    handler_t &handler;
+    MMS::http::v2::header_request request;
+    std::string path;
+    const size_t size_limit;
+    bool too_large { false };
+
+public:
+    buffered_reader_t(protocol_t &connection, handler_t &handler, MMS::http::v2::header_request &request, std::string &&path, const size_t size_limit)
+        : connection { connection }, handler { handler }, request { std::move(static_cast<MMS::http::request &>(request)) }, path { std::move(path) }, size_limit { size_limit } {
+        this->request.stream_identifier = request.stream_identifier;
+        too_large = this->request.GetBody().size() > size_limit;
+    }
+
+    bool ProcessBody(const Stream &part) override {
+        if (too_large || request.GetBody().size() + part.remaining_buffer() > size_limit) {
+            too_large = true;
+            return true;
+        }
+        request.append_body(part);
+        return true;
+    }
+
+    void ProcessBodyEnd(MMS::server::http::protocol_t *writer) override {
+        if (too_large) writer->WriteError(CODE::Request_Entity_Too_Large, "Request size exceeds limit");
+        else if (!connection.DispatchToWorker(handler, std::move(request), std::move(path))) handler.ProcessRead(request, path, writer);
+    }
+};
+
+// Writer of handler running on worker, each write is copied and replayed on connection in listener thread.
+// Writes of a stream are replayed in order, streams complete in any order.
+class stream_writer_t : public MMS::server::http::protocol_t {
+    using write_t = std::move_only_function<void(v2::protocol_t &)>;
+    const std::shared_ptr<v2::protocol_t::dispatch_t> dispatch;
+    const uint32_t stream_id;
+
+    void Post(write_t &&write, const bool end) {
+        std::lock_guard guard { dispatch->lock };
+        if (!dispatch->connection) return;
+        dispatch->completed.push_back(v2::protocol_t::completed_t { stream_id, end, std::move(write) });
+        dispatch->connection->Notify();
+    }
+
+public:
+    stream_writer_t(const configuration_t *configuration, const std::shared_ptr<v2::protocol_t::dispatch_t> &dispatch, const uint32_t stream_id)
+        : MMS::server::http::protocol_t { configuration }, dispatch { dispatch }, stream_id { stream_id } { }
+
+    void ProcessRead(const Stream &) override { }
+
+    void WriteError(const CODE code, const std::string_view errortext) override {
+        Post([code, errortext = std::string { errortext }](v2::protocol_t &connection) { connection.WriteError(code, errortext); }, true);
+    }
+
+    void Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) override {
+        Post([code, body = std::string { bodystream.curr(), bodystream.end() }, fields](v2::protocol_t &connection) mutable {
+            connection.Write(code, make_const_stream(body), fields);
+        }, true);
+    }
+
+    void Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override {
+        Post([code, fields](v2::protocol_t &connection) mutable { connection.Write(code, fields); }, true);
+    }
+
+    // Owner keeps body valid, it is not copied
+    void Write(const CODE code, const Stream &bodystream, const std::shared_ptr<const void> &owner, std::vector<std::pair<FIELD, std::string>> &fields) override {
+        Post([code, body = bodystream.curr(), size = bodystream.remaining_buffer(), owner, fields](v2::protocol_t &connection) mutable {
+            connection.Write(code, make_const_stream(body, size), owner, fields);
+        }, true);
+    }
+
+    void WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) override {
+        Post([code, fields](v2::protocol_t &connection) mutable { connection.WriteBegin(code, fields); }, false);
+    }
+
+    void WriteChunk(const Stream &chunkstream) override {
+        Post([chunk = std::string { chunkstream.curr(), chunkstream.end() }](v2::protocol_t &connection) { connection.WriteChunk(make_const_stream(chunk)); }, false);
+    }
+
+    void WriteEnd() override {
+        Post([](v2::protocol_t &connection) { connection.WriteEnd(); }, true);
+    }
 
-    auto body = std::format(
-        "<html>"
-        "<head><title>{0}</title></head>"
-        "<h1>{2}</h1>"
-        "<h2>{0}</h2>"
-        "<pre>{1}</pre>"
-        "</html>",
-        MMS::http::to_string(code), errortext, configuration->ServerName
-    );
+    void WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &fields) override {
+        Post([fields](v2::protocol_t &connection) { connection.WriteEarlyHints(fields); }, false);
+    }
+};
 
-    auto icode = static_cast<uint16_t>(code);
-    if (icode >= 400 && icode <= 599) fields.emplace_back( FIELD::Connection, std::string { "close" } );
-    if (icode == 405) fields.emplace_back( FIELD::Connection, std::string { "GET, PRI" } );
+protocol_t::~protocol_t() {
+    if (dispatch) {
+        std::lock_guard guard { dispatch->lock };
+        dispatch->connection = nullptr;
+    }
+}
+
+bool protocol_t::DispatchToWorker(handler_t &handler, MMS::http::request &&request, std::string &&path) {
+    if (!configuration->worker_pool || !handler.IsBlocking()) return false;
+    if (!dispatch) dispatch = std::make_shared<dispatch_t>(this);
+    // Response is written after request is gone, PRIORITY_UPDATE already read is kept
+    auto &stream = GetStream(stream_identifier);
+    if (!std::exchange(stream.prioritized, true)) stream.priority = MMS::http::v2::parse_priority(request.GetField(FIELD::Priority));
+    stream.dispatched = true;
+    configuration->worker_pool->Submit(
+        [dispatch = dispatch, stream_id = stream_identifier, &handler, request = MMS::http::request { std::move(request) }, path = std::move(path), configuration = configuration]() {
+            stream_writer_t writer { configuration, dispatch, stream_id };
+            try {
+                handler.ProcessRead(request, path, &writer);
+            }
+            catch(exception_t &failed) {
+                writer.WriteError(CODE::Internal_Server_Error, failed.to_string());
+            }
+        });
+    return true;
+}
+
+void protocol_t::ProcessNotify() {
+    if (!dispatch) return;
+    std::vector<completed_t> completed { };
+    {
+        std::lock_guard guard { dispatch->lock };
+        completed.swap(dispatch->completed);
+    }
+    // DATA of more than one response is interleaved as per priority
+    scheduling = completed.size() > 1;
+    for(auto &[stream_id, end, write]: completed) {
+        auto stream = streams.find(stream_id);
+        // Stream closed while worker was writing it
+        if (stream == nullptr || !stream->dispatched) continue;
+        stream_identifier = stream_id;
+        write(*this);
+        if (end) {
+            stream->dispatched = false;
+            stream->prioritized = false;
+            ReleaseStream(stream_id);
+        }
+    }
+    stream_identifier = 0;
+    if (std::exchange(scheduling, false)) WritePending();
+    FinalizeWrite();
+}
 
-    Write(code, make_const_stream(body), fields);
+// Connection specific fields are not allowed in HTTP/2 https://www.rfc-editor.org/rfc/rfc9113.html#name-connection-specific-header-
+void protocol_t::WriteError(const CODE code, const std::string_view errortext) {
+    // Error without stream is connection error https://www.rfc-editor.org/rfc/rfc9113.html#name-connection-error-handling
+    if (stream_identifier == 0) {
+        log<log_t::HTTP2_CONNECTION_ERROR>(GetFD());
+        MMS::http::v2::goaway::add_frame(response_buffer, last_stream_identifier, MMS::http::v2::frame::error_t::PROTOCOL_ERROR, "Connection error");
+        CloseAfterWrite();
+        return;
+    }
+    const auto accepttype = header_request ? header_request->GetField(FIELD::Accept) : std::string_view { };
+    auto &error_buffer = CreateErrorBuffer(*configuration, code, errortext, accepttype);
+    Write(code, make_const_stream(error_buffer.body.begin(), error_buffer.body.index()), error_buffer.fields);
 }
 
 void protocol_t::Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) {
-    fields.emplace_back(FIELD::Server, configuration->ServerName);
     fields.emplace_back(FIELD::Content_Length, std::to_string(bodystream.remaining_buffer()));
-    MMS::http::v2::CreateHeaderFrame(dynamic_table, response_buffer, header_request->stream_identifier, code, fields);
-    auto bodysize = bodystream.remaining_buffer();
-    response_buffer.Reserve(bodysize + (bodysize / (configuration->max_frame_size - sizeof(MMS::http::v2::frame)) * sizeof(MMS::http::v2::frame)));
-    MMS::http::v2::CreateBodyFrame(response_buffer, configuration->max_frame_size, bodystream, header_request->stream_identifier);
+    MMS::http::v2::CreateHeaderFrame(encoder_table, response_buffer, stream_identifier, code, fields, configuration->fixed_fields_hpack, &encoder_cache);
+    WriteData(bodystream, true);
 }
 
 void protocol_t::Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) {
-    fields.emplace_back(FIELD::Server, configuration->ServerName);
-    MMS::http::v2::CreateHeaderFrame(dynamic_table, response_buffer, header_request->stream_identifier, code, fields);
+    MMS::http::v2::CreateHeaderFrame(encoder_table, response_buffer, stream_identifier, code, fields, configuration->fixed_fields_hpack, &encoder_cache, true);
+    // Stream ends with HEADERS, window kept by WINDOW_UPDATE is not needed
+    auto stream = streams.find(stream_identifier);
+    if (stream != nullptr && stream->sending) {
+        stream->send = send_stream_t { 0 };
+        stream->sending = false;
+        ReleaseStream(stream_identifier);
+    }
+}
+
+void protocol_t::Write(const CODE code, const Stream &bodystream, const std::shared_ptr<const void> &owner, std::vector<std::pair<FIELD, std::string>> &fields) {
+    fields.emplace_back(FIELD::Content_Length, std::to_string(bodystream.remaining_buffer()));
+    MMS::http::v2::CreateHeaderFrame(encoder_table, response_buffer, stream_identifier, code, fields, configuration->fixed_fields_hpack, &encoder_cache);
+    WriteData(bodystream, true, owner);
+}
+
+void protocol_t::WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) {
+    MMS::http::v2::CreateHeaderFrame(encoder_table, response_buffer, stream_identifier, code, fields, configuration->fixed_fields_hpack, &encoder_cache);
+}
+
+void protocol_t::WriteChunk(const Stream &chunkstream) {
+    if (chunkstream.full()) return;
+    WriteData(chunkstream, false);
+    // Frames of other streams written before are also flushed, order of frames is kept
+    if (response_buffer.index() >= configuration->limits.StreamFlushSize) {
+        FinalizeWrite();
+        Flush();
+    }
+}
+
+// Interim HEADERS without END_STREAM, final response follows on same stream
+void protocol_t::WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &fields) {
+    MMS::http::v2::CreateHeaderFrame(encoder_table, response_buffer, stream_identifier, CODE::Early_Hints, fields, { }, &encoder_cache);
+    FinalizeWrite();
+    Flush();
+}
+
+void protocol_t::WriteEnd() {
+    WriteData(make_const_stream(response_buffer.curr(), size_t { 0 }), true);
+}
+
+size_t protocol_t::WriteAllowed(const uint32_t stream_id, send_stream_t &send_stream, const Stream &datastream, const bool end_stream) {
+    const auto window = std::min(send_stream.window, connection_window);
+    const size_t size = window > 0 ? std::min(static_cast<size_t>(window), datastream.remaining_buffer()) : 0;
+    const bool end = end_stream && size == datastream.remaining_buffer();
+    // Empty DATA is written only to end stream, it is not flow controlled
+    if (size || end) {
+        const auto allowedstream = make_const_stream(datastream.curr(), size);
+        if (send_stream.owner && size >= body_reference_min) WriteReferenced(stream_id, allowedstream, end, send_stream.owner);
+        else MMS::http::v2::CreateDataFrame(response_buffer, configuration->max_frame_size, allowedstream, stream_id, end);
+        send_stream.window -= static_cast<int64_t>(size);
+        connection_window -= static_cast<int64_t>(size);
+    }
+    return size;
+}
+
+// Frame headers are written to shared block and body is given to connection as is
+void protocol_t::WriteReferenced(const uint32_t stream_id, const Stream &datastream, const bool end_stream, const std::shared_ptr<const void> &owner) {
+    const size_t max_body_size { configuration->max_frame_size - sizeof(MMS::http::v2::frame) };
+    // Frames before this are written first
+    FinalizeWrite();
+    while(!datastream.full()) {
+        // Block is only appended while any header in it waits for write
+        if (frame_headers.use_count() == 1) frame_headers_used = 0;
+        if (!frame_headers || frame_headers_used == frame_headers_block_size) {
+            frame_headers = std::make_shared_for_overwrite<uint8_t[]>(frame_headers_block_size);
+            frame_headers_used = 0;
+        }
+        const auto frame_body_size = static_cast<uint32_t>(std::min(max_body_size, datastream.remaining_buffer()));
+        const auto flags = end_stream && frame_body_size == datastream.remaining_buffer() ? MMS::http::v2::frame::flags_t::END_STREAM : MMS::http::v2::frame::flags_t::NONE;
+        const auto frame_buffer = frame_headers.get() + frame_headers_used;
+        new (frame_buffer) MMS::http::v2::frame { frame_body_size, MMS::http::v2::frame::type_t::DATA, flags, stream_id };
+        frame_headers_used += sizeof(MMS::http::v2::frame);
+        WriteNoCopy(FixedBuffer { frame_buffer, sizeof(MMS::http::v2::frame), frame_headers });
+        WriteNoCopy(FixedBuffer { datastream.GetCurrAndIncrease(frame_body_size), frame_body_size, owner });
+    }
+}
+
+void protocol_t::WriteData(const Stream &datastream, const bool end_stream, const std::shared_ptr<const void> &owner) {
+    const std::string_view data { reinterpret_cast<const char *>(datastream.curr()), datastream.remaining_buffer() };
+    // Body with owner is kept as reference, it is valid till stream is done
+    auto set_pending = [&data](send_stream_t &send_stream, const size_t written) {
+        if (send_stream.owner) send_stream.referenced = data.substr(written);
+        else send_stream.pending.assign(data.substr(written));
+    };
+    auto stream = streams.find(stream_identifier);
+    if (stream == nullptr || !stream->sending) {
+        // Send state is kept only when data is left for window or scheduler
+        send_stream_t send_stream { peer_settings.SETTINGS_INITIAL_WINDOW_SIZE };
+        send_stream.owner = owner;
+        const auto written = scheduling ? 0 : WriteAllowed(stream_identifier, send_stream, datastream, end_stream);
+        if (!scheduling && written == data.size() && end_stream) return;
+        send_stream.priority = GetPriority(stream_identifier);
+        if (stream == nullptr) stream = streams.insert(stream_identifier);
+        stream->send = std::move(send_stream);
+        stream->sending = true;
+        set_pending(stream->send, written);
+    } else if (stream->send.GetPending().empty() && !scheduling) {
+        stream->send.owner = owner;
+        const auto written = WriteAllowed(stream_identifier, stream->send, datastream, end_stream);
+        if (written == data.size() && end_stream) {
+            stream->send = send_stream_t { 0 };
+            stream->sending = false;
+            ReleaseStream(stream_identifier);
+            return;
+        }
+        set_pending(stream->send, written);
+    } else {
+        auto &send_stream = stream->send;
+        // Referenced body is copied once more data follows it
+        if (send_stream.owner) {
+            send_stream.pending.assign(send_stream.referenced);
+            send_stream.owner.reset();
+            send_stream.referenced = { };
+        }
+        send_stream.pending.append(data);
+    }
+    stream->send.end_stream = end_stream;
+}
+
+size_t protocol_t::WriteScheduled(scheduled_t &scheduled, const size_t limit) {
+    auto &send_stream = scheduled.stream->send;
+    const auto pending = send_stream.GetPending();
+    const auto remaining = pending.size() - send_stream.pending_sent;
+    const auto size = std::min(remaining, limit);
+    const auto pendingstream = make_const_stream(pending.data() + send_stream.pending_sent, size);
+    const auto written = WriteAllowed(scheduled.stream_id, send_stream, pendingstream, send_stream.end_stream && size == remaining);
+    send_stream.pending_sent += written;
+    if (written == remaining) {
+        if (send_stream.end_stream) {
+            send_stream = send_stream_t { 0 };
+            scheduled.stream->sending = false;
+            ReleaseStream(scheduled.stream_id);
+        } else {
+            send_stream.pending.clear();
+            send_stream.pending_sent = 0;
+            send_stream.owner.reset();
+            send_stream.referenced = { };
+        }
+        scheduled.stream = nullptr;
+    }
+    return written;
+}
+
+// Lower urgency is written first, a blocked stream does not stop streams after it
+void protocol_t::WritePending() {
+    schedule.clear();
+    streams.for_each([this](stream_t &stream) {
+        if (stream.sending && (!stream.send.GetPending().empty() || stream.send.end_stream)) schedule.push_back(scheduled_t { stream.send.priority, stream.stream_identifier, &stream });
+    });
+    std::sort(schedule.begin(), schedule.end());
+
+    const size_t quantum { configuration->max_frame_size - sizeof(MMS::http::v2::frame) };
+    for(auto level_begin = schedule.begin(); level_begin != schedule.end();) {
+        const auto urgency = level_begin->priority.urgency;
+        const auto level_end = std::find_if(level_begin, schedule.end(), [urgency](const scheduled_t &scheduled) { return scheduled.priority.urgency != urgency; });
+        // Non incremental response is of use only when complete, hence written whole in stream order
+        for(; level_begin != level_end && !level_begin->priority.incremental; ++level_begin) {
+            WriteScheduled(*level_begin, std::numeric_limits<size_t>::max());
+        }
+        // Incremental responses are round robin, one frame each turn
+        for(bool written { true }; written;) {
+            written = false;
+            for(auto scheduled_itr = level_begin; scheduled_itr != level_end; ++scheduled_itr) {
+                if (scheduled_itr->stream && WriteScheduled(*scheduled_itr, quantum) && scheduled_itr->stream) written = true;
+            }
+        }
+        level_begin = level_end;
+    }
+}
+
+MMS::http::v2::priority_t protocol_t::GetPriority(const uint32_t stream_id) {
+    // PRIORITY_UPDATE overrides Priority field of request
+    auto stream = streams.find(stream_id);
+    if (stream != nullptr && std::exchange(stream->prioritized, false)) return stream->priority;
+    if (header_request && header_request->stream_identifier == stream_id) return MMS::http::v2::parse_priority(header_request->GetField(FIELD::Priority));
+    return { };
+}
+
+void protocol_t::ProcessPriorityUpdate(const uint32_t stream_id, const std::string_view value) {
+    const auto priority = MMS::http::v2::parse_priority(value);
+    auto stream = streams.find(stream_id);
+    if (stream != nullptr && stream->sending) {
+        stream->send.priority = priority;
+        return;
+    }
+    // Closed stream is ignored, records of streams not served yet are limited to concurrent streams
+    if (IsClosed(stream_id, stream)) return;
+    if (stream == nullptr) {
+        if (streams.size() >= peer_settings.SETTINGS_MAX_CONCURRENT_STREAMS) return;
+        stream = streams.insert(stream_id);
+    }
+    stream->prioritized = true;
+    stream->priority = priority;
+}
+
+void protocol_t::ProcessWindowUpdate(const uint32_t stream_id, const uint32_t increment) {
+    if (stream_id == 0) {
+        connection_window += increment;
+        if (connection_window > MMS::http::v2::constant::MAX_WINDOW_SIZE) {
+            log<log_t::HTTP2_CONNECTION_ERROR>(GetFD());
+            MMS::http::v2::goaway::add_frame(response_buffer, last_stream_identifier, MMS::http::v2::frame::error_t::FLOW_CONTROL_ERROR, "Window overflow");
+            CloseAfterWrite();
+            return;
+        }
+    } else {
+        auto stream = streams.find(stream_id);
+        if (stream == nullptr || !stream->sending) {
+            // Closed stream is ignored, stream not served yet keeps its window till response
+            if (IsClosed(stream_id, stream)) return;
+            if (stream == nullptr) stream = streams.insert(stream_id);
+            stream->send = send_stream_t { peer_settings.SETTINGS_INITIAL_WINDOW_SIZE };
+            stream->sending = true;
+        }
+        stream->send.window += increment;
+        if (stream->send.window > MMS::http::v2::constant::MAX_WINDOW_SIZE) {
+            MMS::http::v2::CreateResetFrame(response_buffer, stream_id, MMS::http::v2::frame::error_t::FLOW_CONTROL_ERROR);
+            CloseStream(stream_id);
+            return;
+        }
+    }
+    WritePending();
+}
+
+void protocol_t::ProcessReceived(const uint32_t stream_id, const uint32_t length, const bool end_stream) {
+    connection_received += length;
+    if (connection_received >= connection_receive_window / 2) {
+        const auto withheld = std::min(connection_received, connection_withheld);
+        connection_withheld -= withheld;
+        if (connection_received > withheld) MMS::http::v2::CreateWindowUpdateFrame(response_buffer, 0, connection_received - withheld);
+        connection_received = 0;
+    }
+    if (window_estimator.Received(length)) {
+        MMS::http::v2::CreatePingFrame(response_buffer, MMS::http::v2::window_estimator_t::ping_data);
+        window_estimator.PingSent(MMS::http::v2::window_estimator_t::clock::now());
+    }
+    auto stream = streams.find(stream_id);
+    // Peer does not send more on ended stream
+    if (end_stream) {
+        if (stream != nullptr) {
+            stream->received = 0;
+            ReleaseStream(stream_id);
+        }
+        return;
+    }
+    if (stream == nullptr) {
+        // Closed stream is not given window. Parser rejects idle stream, new stream has HEADERS in this read.
+        if (stream_id <= last_stream_identifier) return;
+        stream = streams.insert(stream_id);
+    }
+    stream->received += length;
+    if (stream->received >= window_estimator.GetWindow() / 2) {
+        MMS::http::v2::CreateWindowUpdateFrame(response_buffer, stream_id, stream->received);
+        stream->received = 0;
+    }
+}
+
+void protocol_t::ProcessPingAck(const uint64_t opaque_data) {
+    if (window_estimator.PingAck(opaque_data, MMS::http::v2::window_estimator_t::clock::now())) UpdateReceiveWindow();
+}
+
+// Stream windows of peer change by difference of SETTINGS_INITIAL_WINDOW_SIZE https://www.rfc-editor.org/rfc/rfc9113.html#section-6.9.2
+void protocol_t::UpdateReceiveWindow() {
+    const auto window = window_estimator.GetWindow();
+    MMS::http::v2::settings::add_frame(response_buffer, MMS::http::v2::settings::identifier_t::SETTINGS_INITIAL_WINDOW_SIZE, window);
+    if (window > connection_receive_window) {
+        // Window withheld is given back first
+        auto increment = window - connection_receive_window;
+        const auto withheld = std::min(increment, connection_withheld);
+        connection_withheld -= withheld;
+        increment -= withheld;
+        if (increment) MMS::http::v2::CreateWindowUpdateFrame(response_buffer, 0, increment);
+    } else {
+        connection_withheld += connection_receive_window - window;
+    }
+    connection_receive_window = window;
+}
+
+flow_stats_t protocol_t::GetFlowStats() const {
+    return flow_stats_t {
+        window_estimator.GetRTT(),
+        window_estimator.GetMinRTT(),
+        window_estimator.GetBDP(),
+        window_estimator.GetWindow(),
+        connection_receive_window,
+        connection_window
+    };
+}
+
+protocol_t::stream_t &protocol_t::GetStream(const uint32_t stream_id) {
+    auto stream = streams.find(stream_id);
+    return stream != nullptr ? *stream : *streams.insert(stream_id);
+}
+
+void protocol_t::ReleaseStream(const uint32_t stream_id) {
+    auto stream = streams.find(stream_id);
+    if (stream != nullptr && stream->IsIdle()) streams.erase(stream_id);
+}
+
+bool protocol_t::IsClosed(const uint32_t stream_id, const stream_t *stream) const {
+    return stream_id <= last_stream_identifier && (stream == nullptr || (!stream->body_reader && !stream->dispatched));
+}
+
+void protocol_t::CloseStream(const uint32_t stream_id) {
+    auto stream = streams.find(stream_id);
+    if (stream == nullptr) return;
+    // Reader and DATA to send are released before record is pooled
+    stream->reset(stream_id);
+    streams.erase(stream_id);
 }
 
 void protocol_t::FinalizeWrite() {
@@ -65,20 +502,29 @@ void protocol_t::FinalizeWrite() {
     }
 }
 
-void protocol_t::AddBase64Settings(const std::string &settings) {
-    peer_settings.parse_base64(make_const_stream(settings.c_str(), settings.size()), &configuration->limits);
+void protocol_t::AddBase64Settings(const std::string_view settings) {
+    peer_settings.parse_base64(make_const_stream(settings.data(), settings.size()), &configuration->limits);
+    encoder_table.set_size_limit(peer_settings.SETTINGS_HEADER_TABLE_SIZE);
 }
 
 void protocol_t::AddSettingResponse() {
     if (!settings_responded) {
+        const auto window = configuration->limits.GetWindowsSize(peer_settings.SETTINGS_INITIAL_WINDOW_SIZE);
+        window_estimator = MMS::http::v2::window_estimator_t { window, configuration->limits.WindowsSizeMin, configuration->limits.WindowsSizeMax };
         MMS::http::v2::settings::add_frame(response_buffer,
             MMS::http::v2::settings::identifier_t::SETTINGS_ENABLE_PUSH, peer_settings.SETTINGS_ENABLE_PUSH,
             MMS::http::v2::settings::identifier_t::SETTINGS_MAX_CONCURRENT_STREAMS, peer_settings.SETTINGS_MAX_CONCURRENT_STREAMS,
-            MMS::http::v2::settings::identifier_t::SETTINGS_INITIAL_WINDOW_SIZE, peer_settings.SETTINGS_INITIAL_WINDOW_SIZE,
+            MMS::http::v2::settings::identifier_t::SETTINGS_INITIAL_WINDOW_SIZE, window,
             MMS::http::v2::settings::identifier_t::SETTINGS_HEADER_TABLE_SIZE, peer_settings.SETTINGS_HEADER_TABLE_SIZE,
             MMS::http::v2::settings::identifier_t::SETTINGS_MAX_HEADER_LIST_SIZE, peer_settings.SETTINGS_MAX_HEADER_LIST_SIZE,
-            MMS::http::v2::settings::identifier_t::SETTINGS_MAX_FRAME_SIZE, peer_settings.SETTINGS_MAX_FRAME_SIZE
+            MMS::http::v2::settings::identifier_t::SETTINGS_MAX_FRAME_SIZE, peer_settings.SETTINGS_MAX_FRAME_SIZE,
+            MMS::http::v2::settings::identifier_t::SETTINGS_NO_RFC7540_PRIORITIES, 1
         );
+        // SETTINGS does not change connection window, it starts at default size
+        if (window > connection_receive_window) {
+            MMS::http::v2::CreateWindowUpdateFrame(response_buffer, 0, window - connection_receive_window);
+            connection_receive_window = window;
+        }
         settings_responded = true;
     }
 }
@@ -89,6 +535,7 @@ void protocol_t::Upgrade(MMS::http::request &&request) {
         AddSettingResponse();
         MMS::http::v2::settings::add_ack_frame(response_buffer);
         MMS::http::v2::header_request newreq { std::move(request) };
+        frame_parser.upgrade();
         header_request = &newreq;
         ProcessRequest();
         header_request = nullptr;
@@ -96,64 +543,174 @@ void protocol_t::Upgrade(MMS::http::request &&request) {
     catch(http_parser_failed_t &parser_failed) {
         WriteError(CODE::Bad_Request, parser_failed.to_string());
     }
+    stream_identifier = 0;
     FinalizeWrite();
 }
 
 void protocol_t::ProcessRequest() {
+    stream_identifier = header_request->stream_identifier;
+    // Stream reset by peer is not served
+    if (header_request->error != MMS::http::v2::frame::error_t::NO_ERROR) {
+        CloseStream(stream_identifier);
+        return;
+    }
+    if (stream_identifier > last_stream_identifier) last_stream_identifier = stream_identifier;
+    auto stream = streams.find(stream_identifier);
+    if (!header_request->end_stream) {
+        // DATA and trailers follow, record is kept till END_STREAM
+        if (stream == nullptr) stream = streams.insert(stream_identifier);
+        stream->remote_open = true;
+    } else if (stream != nullptr) {
+        // Peer does not send more, DATA after END_STREAM in this read is not given window
+        stream->received = 0;
+    }
+
     std::string newpath { };
     auto &handler = configuration->handlermap.search(header_request->GetPath(), newpath);
     if (handler == nullptr) {
-        WriteError(CODE::Not_Found,  std::format("Path {} not found", header_request->GetPath()));
+        WriteError(CODE::Not_Found, CreateNotFoundString(header_request->GetPath()));
     }
     else {
         auto method = header_request->GetMethod();
         if (handler->IsSupported(method)) {
+            if (!header_request->end_stream) {
+                // Response is written after request is gone, PRIORITY_UPDATE already read is kept
+                if (!std::exchange(stream->prioritized, true)) stream->priority = MMS::http::v2::parse_priority(header_request->GetField(FIELD::Priority));
+                auto reader = handler->CreateBodyReader(*header_request, newpath, this);
+                if (reader) {
+                    // DATA read with HEADERS is buffered in request
+                    const auto &body = header_request->GetBody();
+                    if (!body.empty() && !reader->ProcessBody(make_const_stream(body))) PauseRead();
+                } else {
+                    // Request with DATA read till now is moved to reader
+                    reader = std::make_unique<buffered_reader_t>(*this, *handler, *header_request, std::move(newpath), configuration->limits.MaxRequestSize);
+                }
+                stream->body_reader = std::move(reader);
+                return;
+            }
+            if (DispatchToWorker(*handler, std::move(*header_request), std::move(newpath))) return;
             handler->ProcessRead(*header_request, newpath, this);
         }
         else if (method == METHOD::OPTIONS) {
-            std::string optionsstr {};
-            CreateSupportedMethodString(optionsstr, handler->GetSupportedMethod(), http::METHOD::PRI, http::METHOD::OPTIONS);
             std::vector<std::pair<FIELD, std::string>> fields {
-                std::pair<FIELD, std::string> {http::FIELD::Allow, optionsstr}
+                std::pair<FIELD, std::string> {http::FIELD::Allow, handler->GetAllow()}
             };
             Write(http::CODE::No_Content, fields);
         } else {
-            const std::string errstr = CreateSupportedMethodErrorString(method, handler->GetSupportedMethod(), http::METHOD::PRI, http::METHOD::OPTIONS);
-            WriteError(http::CODE::Method_Not_Allowed, errstr);
+            WriteError(http::CODE::Method_Not_Allowed, CreateSupportedMethodErrorString(method, *handler));
         }
     }
+    // Priority is of no use once response is written
+    stream = streams.find(stream_identifier);
+    if (stream != nullptr) {
+        stream->prioritized = false;
+        ReleaseStream(stream_identifier);
+    }
+}
+
+void protocol_t::ProcessData(const uint32_t stream_id, const Stream &part, const bool end_stream) {
+    auto stream = streams.find(stream_id);
+    if (stream == nullptr) return;
+    if (end_stream) {
+        stream->remote_open = false;
+        stream->received = 0;
+    }
+    // Body of stream without reader is ignored
+    if (!stream->body_reader) {
+        ReleaseStream(stream_id);
+        return;
+    }
+
+    stream_identifier = stream_id;
+    if (!part.full() && !stream->body_reader->ProcessBody(part)) PauseRead();
+    if (end_stream) {
+        // Response may release record, it is looked up again
+        auto reader = std::move(stream->body_reader);
+        reader->ProcessBodyEnd(this);
+        // Priority is of no use once response is written, worker clears it when done
+        stream = streams.find(stream_id);
+        if (stream != nullptr && !stream->dispatched) stream->prioritized = false;
+        ReleaseStream(stream_id);
+    }
+    stream_identifier = 0;
 }
 
 void protocol_t::ProcessRead(const Stream &stream) {
     response_buffer.Reset();
+    auto begin = stream.curr();
+    auto end = stream.end();
+    if (!pending.empty()) {
+        pending.append(reinterpret_cast<const char *>(begin), stream.remaining_buffer());
+        begin = reinterpret_cast<const uint8_t *>(pending.data());
+        end = begin + pending.size();
+    }
+    const auto buffer_begin = begin;
+
     try {
-        MMS::http::v2::request request { dynamic_table, peer_settings };
-        if (first_frame) {
-            if (stream == std::string_view { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size }) {
-                stream += MMS::http::v2::connection_preface_size;
-                auto acksettings = request.CheckAndParseSetting(stream, &configuration->limits);
-                AddSettingResponse();
-                if (acksettings) MMS::http::v2::settings::add_ack_frame(response_buffer);
+        if (first_frame && static_cast<size_t>(end - begin) >= MMS::http::v2::connection_preface_size) {
+            frame_parser.data_handler = [this](const uint32_t stream_id, const Stream &part, const bool end_stream) { ProcessData(stream_id, part, end_stream); };
+            frame_parser.stream_open_handler = [this](const uint32_t stream_id) {
+                auto stream = streams.find(stream_id);
+                return stream != nullptr && stream->remote_open;
+            };
+            frame_parser.received_handler = [this](const uint32_t stream_id, const uint32_t length, const bool end_stream) { ProcessReceived(stream_id, length, end_stream); };
+            frame_parser.window_update_handler = [this](const uint32_t stream_id, const uint32_t increment) { ProcessWindowUpdate(stream_id, increment); };
+            frame_parser.priority_update_handler = [this](const uint32_t stream_id, const std::string_view value) { ProcessPriorityUpdate(stream_id, value); };
+            frame_parser.ping_ack_handler = [this](const uint64_t opaque_data) { ProcessPingAck(opaque_data); };
+            if (make_const_stream(begin, end) == std::string_view { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size }) {
+                begin += MMS::http::v2::connection_preface_size;
+                settings_expected = true;
             }
             first_frame = false;
         }
-        auto ret = request.parse(stream, response_buffer);
-        if (ret != err_t::HTTP2_INITIATE_GOAWAY) {
-            header_request = request.get_first_header();
-            while(header_request) {
-                ProcessRequest();
-                header_request = header_request->get_next();
+
+        if (!first_frame) {
+            const auto frames_end = MMS::http::v2::GetFramesEnd(begin, end);
+            if (settings_expected && frames_end != begin) {
+                const auto framestream = make_const_stream(begin, frames_end);
+                auto acksettings = frame_parser.CheckAndParseSetting(framestream, &configuration->limits);
+                encoder_table.set_size_limit(peer_settings.SETTINGS_HEADER_TABLE_SIZE);
+                AddSettingResponse();
+                if (acksettings) MMS::http::v2::settings::add_ack_frame(response_buffer);
+                begin = framestream.curr();
+                settings_expected = false;
+            }
+
+            const auto framestream = make_const_stream(begin, frames_end);
+            begin = frames_end;
+            auto ret = frame_parser.parse(framestream, response_buffer);
+            if (ret != err_t::HTTP2_INITIATE_GOAWAY) {
+                header_request = frame_parser.get_first_header();
+                // DATA of more than one response is interleaved as per priority
+                scheduling = header_request && header_request->get_next();
+                while(header_request) {
+                    ProcessRequest();
+                    header_request = header_request->get_next();
+                }
+                if (std::exchange(scheduling, false)) WritePending();
             }
         }
+
+        // Frame is not allowed to be larger than advertised size, header block may have more frames
+        if (static_cast<size_t>(end - begin) > sizeof(MMS::http::v2::frame) + configuration->limits.FrameSizeMax + configuration->limits.HeaderBlockSizeMax) {
+            throw MMS::http_parser_failed_t(make_const_fullstream(begin, end));
+        }
     }
     catch(exception_t &failed) {
+        header_request = nullptr;
+        stream_identifier = 0;
+        if (std::exchange(scheduling, false)) WritePending();
+        begin = end;
         WriteError(CODE::Bad_Request, failed.to_string());
     }
 
     header_request = nullptr;
+    stream_identifier = 0;
+
+    if (pending.empty()) pending.assign(reinterpret_cast<const char *>(begin), static_cast<size_t>(end - begin));
+    else pending.erase(0, static_cast<size_t>(begin - buffer_begin));
 
     FinalizeWrite();
 }
 
-
 } // namespace MMS::server::http
\ No newline at end of file
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+#include <mms/server/http3.h>
+
+namespace MMS::server::http::v3 {
+
+MMS::http::v3::settings_store protocol_t::CreateSettings(const configuration_t *configuration) {
+    MMS::http::v3::settings_store settings { };
+    settings.SETTINGS_QPACK_MAX_TABLE_CAPACITY = configuration->limits.HeaderTableSizeMax;
+    settings.SETTINGS_QPACK_BLOCKED_STREAMS = configuration->limits.ConcurrentStreamsMax;
+    settings.SETTINGS_MAX_FIELD_SECTION_SIZE = configuration->limits.HeaderBlockSizeMax;
+    return settings;
+}
+
+void protocol_t::AddFixedFields(std::vector<std::pair<FIELD, std::string>> &fields) const {
+    fields.emplace_back(FIELD::Server, configuration->ServerName);
+    fields.insert(fields.end(), configuration->fixed_fields.begin(), configuration->fixed_fields.end());
+}
+
+void protocol_t::WriteError(const CODE code, const std::string_view errortext) {
+    const auto accepttype = current_request ? current_request->GetField(FIELD::Accept) : std::string_view { };
+    auto &error_buffer = CreateErrorBuffer(*configuration, code, errortext, accepttype);
+    Write(code, make_const_stream(error_buffer.body.begin(), error_buffer.body.index()), error_buffer.fields);
+}
+
+void protocol_t::Write(const CODE code, const Stream &bodystream, std::vector<std::pair<FIELD, std::string>> &fields) {
+    AddFixedFields(fields);
+    fields.emplace_back(FIELD::Content_Length, std::to_string(bodystream.remaining_buffer()));
+    WriteResponse(*current_stream, code, fields, bodystream);
+}
+
+void protocol_t::Write(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) {
+    AddFixedFields(fields);
+    WriteResponse(*current_stream, code, fields);
+}
+
+void protocol_t::WriteBegin(const CODE code, std::vector<std::pair<FIELD, std::string>> &fields) {
+    AddFixedFields(fields);
+    WriteResponseBegin(*current_stream, code, fields);
+}
+
+void protocol_t::WriteChunk(const Stream &chunkstream) {
+    WriteResponseData(*current_stream, chunkstream);
+}
+
+void protocol_t::WriteEnd() {
+    WriteResponseEnd(*current_stream);
+}
+
+// Interim HEADERS frame, final response follows on same stream
+void protocol_t::WriteEarlyHints(const std::vector<std::pair<FIELD, std::string>> &fields) {
+    WriteResponseBegin(*current_stream, CODE::Early_Hints, fields);
+}
+
+void protocol_t::ProcessRequest(MMS::http::v3::stream_t &stream, MMS::http::v3::request &request) {
+    current_stream = &stream;
+    current_request = &request;
+    try {
+        std::string newpath { };
+        auto &handler = configuration->handlermap.search(request.GetPath(), newpath);
+        if (handler == nullptr) {
+            WriteError(CODE::Not_Found, CreateNotFoundString(request.GetPath()));
+        }
+        else {
+            auto method = request.GetMethod();
+            if (handler->IsSupported(method)) {
+                handler->ProcessRead(request, newpath, this);
+            }
+            else if (method == METHOD::OPTIONS) {
+                std::vector<std::pair<FIELD, std::string>> fields {
+                    std::pair<FIELD, std::string> {http::FIELD::Allow, handler->GetAllow()}
+                };
+                Write(http::CODE::No_Content, fields);
+            } else {
+                WriteError(http::CODE::Method_Not_Allowed, CreateSupportedMethodErrorString(method, *handler));
+            }
+        }
+    }
+    catch(exception_t &failed) {
+        WriteError(CODE::Bad_Request, failed.to_string());
+    }
+    current_stream = nullptr;
+    current_request = nullptr;
+}
+
+} // namespace MMS::server::http::v3
@@ -0,0 +1,555 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+// Per request latency of HTTP/1.1, HTTP/2 and HTTP/3 server path.
+// All are driven in memory, HTTP/1.1 and HTTP/2 through a dummy processor and HTTP/3 through loopback transport,
+// hence only framing, header compression and dispatch are measured.
+
+#include <mms/server/http1.h>
+#include <mms/server/http2.h>
+#include <mms/server/http3.h>
+#include <mms/listener.h>
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <thread>
+
+namespace MMS::server::http::bench {
+
+class fixed_handler_t : public handler_t {
+    const std::string body { "<html><body>MicroMonolithServer</body></html>" };
+
+public:
+    using handler_t::ProcessRead;
+    void ProcessRead(const MMS::http::request &, const std::string &, protocol_t *writer) override {
+        writer->Write(CODE::OK, body, std::pair<FIELD, std::string> { FIELD::Content_Type, "text/html" });
+    }
+
+    const std::vector<METHOD> &GetSupportedMethod() override {
+        static const std::vector<METHOD> methods { METHOD::GET };
+        return methods;
+    }
+};
+
+// Body of given size, large body is written as per peer flow control window.
+// Body is shared like file cache entry, it is copied only when referenced is not set.
+class sized_handler_t : public handler_t {
+public:
+    const size_t size;
+    const std::shared_ptr<uint8_t[]> body;
+    bool referenced { true };
+
+    sized_handler_t(const size_t size) : size { size }, body { std::make_shared<uint8_t[]>(size, 'x') } { }
+
+    using handler_t::ProcessRead;
+    void ProcessRead(const MMS::http::request &, const std::string &, protocol_t *writer) override {
+        const auto bodystream = make_const_stream(body.get(), size);
+        const std::pair<FIELD, std::string> content_type { FIELD::Content_Type, "application/octet-stream" };
+        if (referenced) writer->Write(CODE::OK, bodystream, body, content_type);
+        else writer->Write(CODE::OK, bodystream, content_type);
+    }
+
+    const std::vector<METHOD> &GetSupportedMethod() override {
+        static const std::vector<METHOD> methods { METHOD::GET };
+        return methods;
+    }
+};
+
+// Counts upload, body is given in parts only when streamed is set
+class upload_handler_t : public handler_t {
+    class reader_t : public body_reader_t {
+    public:
+        size_t size { 0 };
+        bool ProcessBody(const Stream &part) override { size += part.remaining_buffer(); return true; }
+        void ProcessBodyEnd(protocol_t *writer) override {
+            std::vector<std::pair<FIELD, std::string>> fields { };
+            writer->Write(CODE::No_Content, fields);
+        }
+    };
+
+public:
+    bool streamed { true };
+
+    using handler_t::ProcessRead;
+    void ProcessRead(const MMS::http::request &, const std::string &, protocol_t *writer) override {
+        std::vector<std::pair<FIELD, std::string>> fields { };
+        writer->Write(CODE::No_Content, fields);
+    }
+
+    std::unique_ptr<body_reader_t> CreateBodyReader(const MMS::http::request &, const std::string &, protocol_t *) override {
+        if (!streamed) return nullptr;
+        return std::make_unique<reader_t>();
+    }
+
+    const std::vector<METHOD> &GetSupportedMethod() override {
+        static const std::vector<METHOD> methods { METHOD::POST };
+        return methods;
+    }
+};
+
+// Waits like a handler calling other service, it runs on worker once configuration has pool
+class blocking_handler_t : public handler_t {
+    const std::string body { "{\"status\":\"ok\"}" };
+
+public:
+    std::atomic<size_t> served { 0 };
+
+    using handler_t::ProcessRead;
+    void ProcessRead(const MMS::http::request &, const std::string &, protocol_t *writer) override {
+        std::this_thread::sleep_for(std::chrono::microseconds { 200 });
+        writer->Write(CODE::OK, body, std::pair<FIELD, std::string> { FIELD::Content_Type, "application/json" });
+        ++served;
+    }
+
+    bool IsBlocking() const override { return true; }
+
+    const std::vector<METHOD> &GetSupportedMethod() override {
+        static const std::vector<METHOD> methods { METHOD::GET };
+        return methods;
+    }
+};
+
+// Discards response and count bytes written
+class null_processor_t : public listener::processor_t {
+public:
+    size_t written { 0 };
+    size_t largest_write { 0 };
+    // Writes are appended only when set
+    bool capture { false };
+    std::string captured { };
+
+    null_processor_t() : listener::processor_t { 0 } { }
+    err_t ProcessRead() override { return err_t::SUCCESS; }
+    void WriteNoCopy(FixedBuffer &&buffer) override {
+        written += buffer.size();
+        largest_write = std::max(largest_write, buffer.size());
+        if (capture) captured.append(reinterpret_cast<const char *>(buffer.begin()), buffer.size());
+    }
+};
+
+struct bench_configuration_t : public configuration_t {
+    fixed_handler_t handler { };
+    upload_handler_t upload_handler { };
+    sized_handler_t large_handler { 16 * MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE };
+    // Page resources
+    sized_handler_t image_handler { 128 * 1024 };
+    sized_handler_t script_handler { 8 * 1024 };
+    blocking_handler_t blocking_handler { };
+    bench_configuration_t() : configuration_t { "MicroMonolithServer" } {
+        AddHandler("/", &handler);
+        AddHandler("/upload", &upload_handler);
+        AddHandler("/large", &large_handler);
+        AddHandler("/img", &image_handler);
+        AddHandler("/js", &script_handler);
+        AddHandler("/api", &blocking_handler);
+    }
+};
+
+constexpr std::string_view authority { "www.example.com" };
+
+// Argument is number of pipelined requests in one read
+static void BM_HTTP1Request(benchmark::State &state) {
+    bench_configuration_t configuration { };
+    null_processor_t processor { };
+    v1::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    std::string requests { };
+    for(int64_t index { 0 }; index < state.range(0); ++index) {
+        requests += "GET / HTTP/1.1\r\nHost: ";
+        requests += authority;
+        requests += "\r\nAccept: text/html\r\n\r\n";
+    }
+
+    for (auto _ : state) {
+        protocol.ProcessRead(make_const_stream(requests));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["response_bytes"] = benchmark::Counter(static_cast<double>(processor.written), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HTTP1Request)->Arg(1)->Arg(16);
+
+// Method not allowed, error page is written for each request
+static void BM_HTTP1Error(benchmark::State &state) {
+    bench_configuration_t configuration { };
+    null_processor_t processor { };
+    v1::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    std::string request { "POST / HTTP/1.1\r\nHost: " };
+    request += authority;
+    request += "\r\nAccept: text/html\r\nContent-Length: 0\r\n\r\n";
+
+    for (auto _ : state) {
+        protocol.ProcessRead(make_const_stream(request));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["response_bytes"] = benchmark::Counter(static_cast<double>(processor.written), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HTTP1Error);
+
+// 1MB upload in reads of 8KB, argument selects streamed body or body buffered till complete
+// Arguments are streamed to reader and chunked transfer coding
+static void BM_HTTP1Upload(benchmark::State &state) {
+    constexpr size_t body_size { 1048576 - 1024 };
+    constexpr size_t read_size { 8192 };
+    // Chunk framing is counted in request size limit
+    constexpr size_t chunk_count { 1000 };
+    bench_configuration_t configuration { };
+    configuration.upload_handler.streamed = state.range(0);
+    null_processor_t processor { };
+    v1::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    std::string request { "POST /upload HTTP/1.1\r\nHost: " };
+    request += authority;
+    if (state.range(1)) {
+        request += "\r\nTransfer-Encoding: chunked\r\n\r\n";
+        for(size_t chunk { 0 }; chunk < chunk_count; ++chunk) {
+            request += "400\r\n";
+            request.append(1024, 'x');
+            request += "\r\n";
+        }
+        request += "0\r\n\r\n";
+    } else {
+        request += "\r\nContent-Length: ";
+        request += std::to_string(body_size);
+        request += "\r\n\r\n";
+        request.append(body_size, 'x');
+    }
+
+    for (auto _ : state) {
+        for(size_t offset { 0 }; offset < request.size(); offset += read_size) {
+            protocol.ProcessRead(make_const_stream(std::string_view { request }.substr(offset, read_size)));
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * request.size()));
+}
+BENCHMARK(BM_HTTP1Upload)->Args({ 0, 0 })->Args({ 1, 0 })->Args({ 0, 1 })->Args({ 1, 1 });
+
+static void BM_HTTP2Request(benchmark::State &state) {
+    bench_configuration_t configuration { };
+    null_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    // :method GET, :scheme https, :path /, :authority literal with incremental indexing
+    std::string header_block { "\x82\x87\x84\x41" };
+    header_block += static_cast<char>(authority.size());
+    header_block += authority;
+
+    auto make_headers_frame = [&header_block](const uint32_t stream_id) {
+        std::string frame_str(sizeof(MMS::http::v2::frame), '\0');
+        auto pframe = reinterpret_cast<MMS::http::v2::frame *>(frame_str.data());
+        pframe->init_frame(header_block.size(), MMS::http::v2::frame::type_t::HEADERS,
+            MMS::http::v2::frame::flags_t::END_HEADERS, MMS::http::v2::frame::flags_t::END_STREAM, stream_id);
+        return frame_str + header_block;
+    };
+
+    // Preface, empty SETTINGS and largest connection window so that body is never held for window
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    std::string settings_frame(sizeof(MMS::http::v2::frame), '\0');
+    reinterpret_cast<MMS::http::v2::frame *>(settings_frame.data())->init_frame(0, MMS::http::v2::frame::type_t::SETTINGS, MMS::http::v2::frame::flags_t::NONE, 0);
+    first_read += settings_frame;
+    MMS::FullStreamAutoAlloc connection_update { 16 };
+    MMS::http::v2::CreateWindowUpdateFrame(connection_update, 0, MMS::http::v2::constant::MAX_WINDOW_SIZE - MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE);
+    first_read.append(reinterpret_cast<const char *>(connection_update.begin()), connection_update.index());
+    first_read += make_headers_frame(1);
+    protocol.ProcessRead(make_const_stream(first_read));
+
+    uint32_t stream_id { 3 };
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto request = make_headers_frame(stream_id);
+        stream_id += 2;
+        state.ResumeTiming();
+        protocol.ProcessRead(make_const_stream(request));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["response_bytes"] = benchmark::Counter(static_cast<double>(processor.written), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HTTP2Request);
+
+// Same upload as HTTP/1.1, header block is split in CONTINUATION and DATA frames are split across reads
+static void BM_HTTP2Upload(benchmark::State &state) {
+    constexpr size_t body_size { 1048576 - 1024 };
+    constexpr size_t read_size { 8192 };
+    constexpr size_t data_size { 16384 - sizeof(MMS::http::v2::frame) };
+    bench_configuration_t configuration { };
+    configuration.upload_handler.streamed = state.range(0);
+    null_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    std::string settings_frame(sizeof(MMS::http::v2::frame), '\0');
+    reinterpret_cast<MMS::http::v2::frame *>(settings_frame.data())->init_frame(0, MMS::http::v2::frame::type_t::SETTINGS, MMS::http::v2::frame::flags_t::NONE, 0);
+    first_read += settings_frame;
+    protocol.ProcessRead(make_const_stream(first_read));
+
+    auto make_frame = [](const MMS::http::v2::frame::type_t type, const MMS::http::v2::frame::flags_t flags, const uint32_t stream_id, const std::string_view payload) {
+        std::string frame_str(sizeof(MMS::http::v2::frame), '\0');
+        reinterpret_cast<MMS::http::v2::frame *>(frame_str.data())->init_frame(static_cast<uint32_t>(payload.size()), type, flags, stream_id);
+        return frame_str + std::string { payload };
+    };
+
+    // :method POST, :scheme https, :path /upload and :authority literal without indexing
+    std::string header_block { "\x83\x87\x04\x07/upload\x01" };
+    header_block += static_cast<char>(authority.size());
+    header_block += authority;
+    const std::string body(body_size, 'x');
+
+    uint32_t stream_id { 1 };
+    size_t request_size { 0 };
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto request = make_frame(MMS::http::v2::frame::type_t::HEADERS, MMS::http::v2::frame::flags_t::NONE, stream_id, std::string_view { header_block }.substr(0, 8));
+        request += make_frame(MMS::http::v2::frame::type_t::CONTINUATION, MMS::http::v2::frame::flags_t::END_HEADERS, stream_id, std::string_view { header_block }.substr(8));
+        for(size_t offset { 0 }; offset < body_size; offset += data_size) {
+            const auto flags = offset + data_size >= body_size ? MMS::http::v2::frame::flags_t::END_STREAM : MMS::http::v2::frame::flags_t::NONE;
+            request += make_frame(MMS::http::v2::frame::type_t::DATA, flags, stream_id, std::string_view { body }.substr(offset, data_size));
+        }
+        request_size = request.size();
+        stream_id += 2;
+        state.ResumeTiming();
+        for(size_t offset { 0 }; offset < request.size(); offset += read_size) {
+            protocol.ProcessRead(make_const_stream(std::string_view { request }.substr(offset, read_size)));
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * request_size));
+    state.counters["response_bytes"] = benchmark::Counter(static_cast<double>(processor.written), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HTTP2Upload)->Arg(0)->Arg(1);
+
+// Client grants window in default window size steps, largest write stays near one window.
+// Connection window is granted along with request so it is same at start of each iteration.
+// Argument 1 refers to body in writes, argument 0 copies it.
+static void BM_HTTP2LargeResponse(benchmark::State &state) {
+    bench_configuration_t configuration { };
+    configuration.large_handler.referenced = state.range(0);
+    null_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    // :method GET, :scheme https, :path /large literal without indexing, :authority literal with incremental indexing
+    std::string header_block { "\x82\x87\x04\x06/large\x41" };
+    header_block += static_cast<char>(authority.size());
+    header_block += authority;
+
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    std::string settings_frame(sizeof(MMS::http::v2::frame), '\0');
+    reinterpret_cast<MMS::http::v2::frame *>(settings_frame.data())->init_frame(0, MMS::http::v2::frame::type_t::SETTINGS, MMS::http::v2::frame::flags_t::NONE, 0);
+    first_read += settings_frame;
+    protocol.ProcessRead(make_const_stream(first_read));
+
+    constexpr uint32_t increment { MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE };
+    auto make_window_update = [](const uint32_t stream_id) {
+        MMS::FullStreamAutoAlloc update { 32 };
+        MMS::http::v2::CreateWindowUpdateFrame(update, 0, increment);
+        MMS::http::v2::CreateWindowUpdateFrame(update, stream_id, increment);
+        return std::string { reinterpret_cast<const char *>(update.begin()), update.index() };
+    };
+
+    uint32_t stream_id { 1 };
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string request(sizeof(MMS::http::v2::frame), '\0');
+        reinterpret_cast<MMS::http::v2::frame *>(request.data())->init_frame(header_block.size(), MMS::http::v2::frame::type_t::HEADERS,
+            MMS::http::v2::frame::flags_t::END_HEADERS, MMS::http::v2::frame::flags_t::END_STREAM, stream_id);
+        request += header_block;
+        // Connection window for initial window of stream
+        MMS::FullStreamAutoAlloc connection_update { 16 };
+        MMS::http::v2::CreateWindowUpdateFrame(connection_update, 0, increment);
+        request.append(reinterpret_cast<const char *>(connection_update.begin()), connection_update.index());
+        const auto window_update = make_window_update(stream_id);
+        stream_id += 2;
+        state.ResumeTiming();
+        protocol.ProcessRead(make_const_stream(request));
+        for(size_t granted { increment }; granted < configuration.large_handler.size; granted += increment) {
+            protocol.ProcessRead(make_const_stream(window_update));
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * configuration.large_handler.size));
+    state.counters["largest_write"] = static_cast<double>(processor.largest_write);
+}
+BENCHMARK(BM_HTTP2LargeResponse)->Arg(0)->Arg(1);
+
+// Page load, images are requested before scripts in one read.
+// Argument 1 sends RFC 9218 Priority, scripts are urgent and images incremental, argument 0 sends none.
+// critical_bytes is bytes written till last script is complete.
+static void BM_HTTP2PageLoad(benchmark::State &state) {
+    bench_configuration_t configuration { };
+    null_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    constexpr size_t image_count { 6 };
+    constexpr size_t script_count { 4 };
+    const bool prioritized { state.range(0) != 0 };
+
+    // :method GET, :scheme https, :path and :authority literal without indexing, priority literal name without indexing
+    auto make_headers_frame = [prioritized](const uint32_t stream_id, const std::string &path, const std::string_view priority) {
+        std::string header_block { "\x82\x87\x04" };
+        header_block += static_cast<char>(path.size());
+        header_block += path;
+        header_block += '\x01';
+        header_block += static_cast<char>(authority.size());
+        header_block += authority;
+        if (prioritized) {
+            header_block += std::string_view { "\x00\x08priority", 10 };
+            header_block += static_cast<char>(priority.size());
+            header_block += priority;
+        }
+        std::string frame_str(sizeof(MMS::http::v2::frame), '\0');
+        reinterpret_cast<MMS::http::v2::frame *>(frame_str.data())->init_frame(header_block.size(), MMS::http::v2::frame::type_t::HEADERS,
+            MMS::http::v2::frame::flags_t::END_HEADERS, MMS::http::v2::frame::flags_t::END_STREAM, stream_id);
+        return frame_str + header_block;
+    };
+
+    // Stream window is large, connection window is granted for each page
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    MMS::FullStreamAutoAlloc settings_frame { 16 };
+    MMS::http::v2::settings::add_frame(settings_frame, MMS::http::v2::settings::identifier_t::SETTINGS_INITIAL_WINDOW_SIZE, MMS::http::v2::constant::MAX_WINDOW_SIZE);
+    first_read.append(reinterpret_cast<const char *>(settings_frame.begin()), settings_frame.index());
+    protocol.ProcessRead(make_const_stream(first_read));
+    processor.capture = true;
+
+    const size_t page_size { image_count * configuration.image_handler.size + script_count * configuration.script_handler.size };
+    MMS::FullStreamAutoAlloc connection_update { 16 };
+    MMS::http::v2::CreateWindowUpdateFrame(connection_update, 0, static_cast<uint32_t>(page_size));
+    const std::string window_update { reinterpret_cast<const char *>(connection_update.begin()), connection_update.index() };
+
+    uint32_t stream_id { 1 };
+    size_t critical_bytes { 0 };
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string page { window_update };
+        const auto first_script = stream_id + 2 * image_count;
+        for(size_t index { 0 }; index < image_count; ++index, stream_id += 2) {
+            page += make_headers_frame(stream_id, "/img/" + std::to_string(index) + ".png", "u=5, i");
+        }
+        for(size_t index { 0 }; index < script_count; ++index, stream_id += 2) {
+            page += make_headers_frame(stream_id, "/js/" + std::to_string(index) + ".js", "u=1");
+        }
+        processor.captured.clear();
+        state.ResumeTiming();
+        protocol.ProcessRead(make_const_stream(page));
+        state.PauseTiming();
+        size_t scripts_end { 0 };
+        for(size_t offset { 0 }; offset + sizeof(MMS::http::v2::frame) <= processor.captured.size();) {
+            const auto pframe = reinterpret_cast<const MMS::http::v2::frame *>(processor.captured.data() + offset);
+            offset += sizeof(MMS::http::v2::frame) + pframe->get_length();
+            if (pframe->get_type() == MMS::http::v2::frame::type_t::DATA && pframe->contains(MMS::http::v2::frame::flags_t::END_STREAM)
+                    && pframe->get_stream_identifier() >= first_script) {
+                scripts_end = offset;
+            }
+        }
+        critical_bytes += scripts_end;
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * page_size));
+    state.counters["critical_bytes"] = benchmark::Counter(static_cast<double>(critical_bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HTTP2PageLoad)->Arg(0)->Arg(1);
+
+// Requests of one read to handler that blocks, argument is worker thread count and 0 runs them in listener thread.
+// There is no listener, hence completed responses are taken by calling ProcessNotify.
+static void BM_HTTP2BlockingRequest(benchmark::State &state) {
+    constexpr size_t request_count { 8 };
+    bench_configuration_t configuration { };
+    std::unique_ptr<MMS::worker::pool_t> pool { };
+    if (state.range(0)) {
+        pool = std::make_unique<MMS::worker::pool_t>(static_cast<size_t>(state.range(0)));
+        configuration.worker_pool = pool.get();
+    }
+    null_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    // :method GET, :scheme https, :path /api and :authority literal without indexing
+    std::string header_block { "\x82\x87\x04\x04/api\x01" };
+    header_block += static_cast<char>(authority.size());
+    header_block += authority;
+
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    std::string settings_frame(sizeof(MMS::http::v2::frame), '\0');
+    reinterpret_cast<MMS::http::v2::frame *>(settings_frame.data())->init_frame(0, MMS::http::v2::frame::type_t::SETTINGS, MMS::http::v2::frame::flags_t::NONE, 0);
+    first_read += settings_frame;
+    protocol.ProcessRead(make_const_stream(first_read));
+
+    uint32_t stream_id { 1 };
+    size_t served { 0 };
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string requests { };
+        for(size_t index { 0 }; index < request_count; ++index, stream_id += 2) {
+            std::string frame_str(sizeof(MMS::http::v2::frame), '\0');
+            reinterpret_cast<MMS::http::v2::frame *>(frame_str.data())->init_frame(header_block.size(), MMS::http::v2::frame::type_t::HEADERS,
+                MMS::http::v2::frame::flags_t::END_HEADERS, MMS::http::v2::frame::flags_t::END_STREAM, stream_id);
+            requests += frame_str + header_block;
+        }
+        served += request_count;
+        state.ResumeTiming();
+        protocol.ProcessRead(make_const_stream(requests));
+        while(configuration.blocking_handler.served < served) std::this_thread::yield();
+        protocol.ProcessNotify();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * request_count));
+    state.counters["response_bytes"] = benchmark::Counter(static_cast<double>(processor.written), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HTTP2BlockingRequest)->Arg(0)->Arg(4)->UseRealTime();
+
+static void BM_HTTP3Request(benchmark::State &state) {
+    bench_configuration_t configuration { };
+    MMS::http::v3::loopback_transport_t transport { };
+    v3::protocol_t protocol { &configuration, transport };
+    protocol.Start();
+
+    // Client control stream with same QPACK limit as HTTP/2 header table
+    FullStreamAutoAlloc control { 64 };
+    MMS::net::quic::EncodeUnsignedInteger(static_cast<uint64_t>(MMS::http::v3::stream_type_t::CONTROL), control);
+    MMS::http::v3::settings_store { configuration.limits.HeaderTableSizeMax, std::numeric_limits<uint64_t>::max(), 16 }.add_frame(control);
+    protocol.ProcessStream(*transport.GetStream(2), make_const_stream(control.begin(), control.index()), false);
+
+    // Static table only field section does not depend on stream
+    const std::vector<std::pair<FIELD, std::string>> fields {
+        {FIELD::Method, "GET"},
+        {FIELD::Scheme, "https"},
+        {FIELD::Path, "/"},
+        {FIELD::Authority, std::string { authority }},
+    };
+    MMS::http::qpack::encoder_t encoder { 0, 0 };
+    FullStreamAutoAlloc section { 64 };
+    FullStreamAutoAlloc encoder_stream { 64 };
+    encoder.Encode(0, fields, section, encoder_stream);
+    FullStreamAutoAlloc headers_frame { 64 };
+    MMS::http::v3::AddHeadersFrame(headers_frame, make_const_stream(section.begin(), section.index()));
+
+    size_t written { 0 };
+    uint64_t stream_id { 0 };
+    for (auto _ : state) {
+        protocol.ProcessStream(*transport.GetStream(stream_id), make_const_stream(headers_frame.begin(), headers_frame.index()), true);
+        state.PauseTiming();
+        written += transport.GetStream(stream_id)->data.size();
+        transport.streams.erase(stream_id);
+        stream_id += 4;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["response_bytes"] = benchmark::Counter(static_cast<double>(written), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HTTP3Request);
+
+} // namespace MMS::server::http::bench
@@ -0,0 +1,213 @@
+//////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2024  Rohit Jairaj Singh (rohit@singh.org.in)          //
+//                                                                      //
+// This program is free software: you can redistribute it and/or modify //
+// it under the terms of the GNU General Public License as published by //
+// the Free Software Foundation, either version 3 of the License, or    //
+// (at your option) any later version.                                  //
+//                                                                      //
+// This program is distributed in the hope that it will be useful,      //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of       //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        //
+// GNU General Public License for more details.                         //
+//                                                                      //
+// You should have received a copy of the GNU General Public License    //
+// along with this program.  If not, see <https://www.gnu.org/licenses/>//
+//////////////////////////////////////////////////////////////////////////
+
+#include <mms/server/http1.h>
+#include <mms/server/http2.h>
+#include <mms/listener.h>
+#include <gtest/gtest.h>
+
+namespace MMS::server::http::test {
+
+// Keeps all writes of protocol
+class capture_processor_t : public listener::processor_t {
+public:
+    std::string captured { };
+
+    capture_processor_t() : listener::processor_t { 0 } { }
+    err_t ProcessRead() override { return err_t::SUCCESS; }
+    void WriteNoCopy(FixedBuffer &&buffer) override {
+        captured.append(reinterpret_cast<const char *>(buffer.begin()), buffer.size());
+    }
+};
+
+// Keeps body of request, it has no body reader hence body is buffered by connection
+class body_handler_t : public handler_t {
+public:
+    std::vector<std::string> bodies { };
+
+    using handler_t::ProcessRead;
+    void ProcessRead(const MMS::http::request &request, const std::string &, protocol_t *writer) override {
+        bodies.emplace_back(request.GetBody());
+        std::vector<std::pair<FIELD, std::string>> fields { };
+        writer->Write(CODE::No_Content, fields);
+    }
+
+    const std::vector<METHOD> &GetSupportedMethod() override {
+        static const std::vector<METHOD> methods { METHOD::POST };
+        return methods;
+    }
+};
+
+TEST(HTTP1ProtocolTest, BufferedChunkedBody) {
+    configuration_t configuration { "MicroMonolithServer" };
+    body_handler_t handler { };
+    configuration.AddHandler("/upload", &handler);
+    capture_processor_t processor { };
+    v1::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    std::string request { "POST /upload HTTP/1.1\r\nHost: www.example.com\r\nTransfer-Encoding: chunked\r\n\r\n" };
+    std::string body { };
+    for(char chunk { 'a' }; chunk <= 'z'; ++chunk) {
+        request += "10\r\n";
+        request.append(16, chunk);
+        request += "\r\n";
+        body.append(16, chunk);
+    }
+    request += "0\r\n\r\n";
+    // Pipelined request follows in same reads
+    request += "POST /upload HTTP/1.1\r\nHost: www.example.com\r\nContent-Length: 4\r\n\r\nlast";
+
+    // Reads split head, chunk lines and chunk data
+    for(size_t offset { 0 }; offset < request.size(); offset += 7) {
+        protocol.ProcessRead(make_const_stream(std::string_view { request }.substr(offset, 7)));
+    }
+    ASSERT_EQ(handler.bodies.size(), 2);
+    EXPECT_EQ(handler.bodies[0], body);
+    EXPECT_EQ(handler.bodies[1], "last");
+}
+
+TEST(HTTP2ProtocolTest, ConnectionWindowAtSettings) {
+    configuration_t configuration { "MicroMonolithServer" };
+    configuration.limits.WindowsSizeMin = 262144;
+    capture_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    std::string settings_frame(sizeof(MMS::http::v2::frame), '\0');
+    reinterpret_cast<MMS::http::v2::frame *>(settings_frame.data())->init_frame(0, MMS::http::v2::frame::type_t::SETTINGS, MMS::http::v2::frame::flags_t::NONE, 0);
+    first_read += settings_frame;
+    protocol.ProcessRead(make_const_stream(first_read));
+
+    // Connection window is raised to advertised stream window just after SETTINGS
+    uint32_t increment { 0 };
+    for(size_t offset { 0 }; offset + sizeof(MMS::http::v2::frame) <= processor.captured.size(); ) {
+        const auto pframe = reinterpret_cast<const MMS::http::v2::frame *>(processor.captured.data() + offset);
+        if (pframe->get_type() == MMS::http::v2::frame::type_t::WINDOW_UPDATE && pframe->get_stream_identifier() == 0) {
+            increment = reinterpret_cast<const MMS::http::v2::window_update *>(pframe + 1)->get_window_size_increment();
+        }
+        offset += sizeof(MMS::http::v2::frame) + pframe->get_length();
+    }
+    EXPECT_EQ(increment, 262144 - MMS::http::v2::constant::SETTINGS_INITIAL_WINDOW_SIZE);
+
+    const auto stats = protocol.GetFlowStats();
+    EXPECT_EQ(stats.receive_window, 262144);
+    EXPECT_EQ(stats.connection_receive_window, 262144);
+}
+
+TEST(HTTP2ProtocolTest, TrailersOnOpenStream) {
+    configuration_t configuration { "MicroMonolithServer" };
+    capture_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    // HEADERS is complete in one frame
+    auto make_frame = [](const MMS::http::v2::frame::type_t type, const uint32_t stream_identifier, const std::string_view payload, const bool end_stream) {
+        std::string frame(sizeof(MMS::http::v2::frame), '\0');
+        auto pframe = reinterpret_cast<MMS::http::v2::frame *>(frame.data());
+        pframe->init_frame(static_cast<uint32_t>(payload.size()), type, MMS::http::v2::frame::flags_t::NONE, stream_identifier);
+        if (type == MMS::http::v2::frame::type_t::HEADERS) pframe->set_flag(MMS::http::v2::frame::flags_t::END_HEADERS);
+        if (end_stream) pframe->set_flag(MMS::http::v2::frame::flags_t::END_STREAM);
+        return frame.append(payload);
+    };
+    // POST without END_STREAM, path has no handler
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    first_read += make_frame(MMS::http::v2::frame::type_t::SETTINGS, 0, { }, false);
+    first_read += make_frame(MMS::http::v2::frame::type_t::HEADERS, 1, "\x83\x86\x84\x41\x0fwww.example.com", false);
+    protocol.ProcessRead(make_const_stream(first_read));
+    // Trailers end stream in later read
+    protocol.ProcessRead(make_const_stream(make_frame(MMS::http::v2::frame::type_t::HEADERS, 1, "\x40\x07x-check\x02ok", true)));
+
+    // Trailers are not a new request, only one response is written
+    size_t responses { 0 };
+    for(size_t offset { 0 }; offset + sizeof(MMS::http::v2::frame) <= processor.captured.size(); ) {
+        const auto pframe = reinterpret_cast<const MMS::http::v2::frame *>(processor.captured.data() + offset);
+        EXPECT_NE(pframe->get_type(), MMS::http::v2::frame::type_t::GOAWAY);
+        if (pframe->get_type() == MMS::http::v2::frame::type_t::HEADERS && pframe->get_stream_identifier() == 1) ++responses;
+        offset += sizeof(MMS::http::v2::frame) + pframe->get_length();
+    }
+    EXPECT_EQ(responses, 1);
+}
+
+TEST(HTTP2ProtocolTest, HeadersOnlyResponse) {
+    configuration_t configuration { "MicroMonolithServer" };
+    body_handler_t handler { };
+    configuration.AddHandler("/upload", &handler);
+    capture_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    auto make_frame = [](const MMS::http::v2::frame::type_t type, const uint32_t stream_identifier, const std::string_view payload, const bool end_stream) {
+        std::string frame(sizeof(MMS::http::v2::frame), '\0');
+        auto pframe = reinterpret_cast<MMS::http::v2::frame *>(frame.data());
+        pframe->init_frame(static_cast<uint32_t>(payload.size()), type, MMS::http::v2::frame::flags_t::NONE, stream_identifier);
+        if (type == MMS::http::v2::frame::type_t::HEADERS) pframe->set_flag(MMS::http::v2::frame::flags_t::END_HEADERS);
+        if (end_stream) pframe->set_flag(MMS::http::v2::frame::flags_t::END_STREAM);
+        return frame.append(payload);
+    };
+    // POST /upload, WINDOW_UPDATE keeps send state of stream before body ends
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    first_read += make_frame(MMS::http::v2::frame::type_t::SETTINGS, 0, { }, false);
+    first_read += make_frame(MMS::http::v2::frame::type_t::HEADERS, 1, "\x83\x86\x44\x07/upload\x41\x0fwww.example.com", false);
+    MMS::FullStreamAutoAlloc window_update { 16 };
+    MMS::http::v2::CreateWindowUpdateFrame(window_update, 1, 1000);
+    first_read.append(reinterpret_cast<const char *>(window_update.begin()), window_update.index());
+    protocol.ProcessRead(make_const_stream(first_read));
+    processor.captured.clear();
+    protocol.ProcessRead(make_const_stream(make_frame(MMS::http::v2::frame::type_t::DATA, 1, "body", true)));
+    ASSERT_EQ(handler.bodies.size(), 1);
+    EXPECT_EQ(handler.bodies[0], "body");
+
+    // 204 is HEADERS with END_STREAM, stream is released
+    bool end_stream { false };
+    for(size_t offset { 0 }; offset + sizeof(MMS::http::v2::frame) <= processor.captured.size(); ) {
+        const auto pframe = reinterpret_cast<const MMS::http::v2::frame *>(processor.captured.data() + offset);
+        if (pframe->get_type() == MMS::http::v2::frame::type_t::HEADERS && pframe->get_stream_identifier() == 1) {
+            end_stream = pframe->contains(MMS::http::v2::frame::flags_t::END_STREAM);
+        }
+        offset += sizeof(MMS::http::v2::frame) + pframe->get_length();
+    }
+    EXPECT_TRUE(end_stream);
+    EXPECT_EQ(protocol.GetStreamCount(), 0);
+}
+
+TEST(HTTP2ProtocolTest, IdleStreamFlood) {
+    configuration_t configuration { "MicroMonolithServer" };
+    capture_processor_t processor { };
+    v2::protocol_t protocol { &configuration };
+    protocol.SetProcessor(&processor);
+
+    std::string first_read { MMS::http::v2::connection_preface, MMS::http::v2::connection_preface_size };
+    std::string settings_frame(sizeof(MMS::http::v2::frame), '\0');
+    reinterpret_cast<MMS::http::v2::frame *>(settings_frame.data())->init_frame(0, MMS::http::v2::frame::type_t::SETTINGS, MMS::http::v2::frame::flags_t::NONE, 0);
+    first_read += settings_frame;
+    protocol.ProcessRead(make_const_stream(first_read));
+
+    // One WINDOW_UPDATE for each idle stream
+    MMS::FullStreamAutoAlloc flood { 1024 };
+    for(uint32_t stream_id { 1 }; stream_id < 2000; stream_id += 2) MMS::http::v2::CreateWindowUpdateFrame(flood, stream_id, 1000);
+    processor.captured.clear();
+    protocol.ProcessRead(make_const_stream(flood.begin(), flood.index()));
+
+    // Connection is closed on first idle stream, no stream state is kept
+    EXPECT_EQ(protocol.GetStreamCount(), 0);
+    ASSERT_GE(processor.captured.size(), sizeof(MMS::http::v2::frame));
+    EXPECT_EQ(reinterpret_cast<const MMS::http::v2::frame *>(processor.captured.data())->get_type(), MMS::http::v2::frame::type_t::GOAWAY);
+}
+
+} // namespace MMS::server::http::test